@@ -0,0 +1,385 @@
+#ifndef AST_QUERY_H
+#define AST_QUERY_H
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include "node_kinds.h"
+using namespace std;
+
+// Structural queries over a parse tree without walking it. TreeIndex numbers the nodes in
+// preorder, so a subtree is the index range [i, end(i)), and keeps a postings list of indices
+// per node kind and per node value. A query pattern names a node kind, optionally its value, and
+// constraints on its children:
+//
+//   FunctionCallStatement[callee=Identifier:print]  statements calling print
+//   Assignment[target=Identifier,has=BinaryOp:+]    assignments to a name of a sum
+//   Assignment[value=Literal]                       assignments of a literal
+//   FunctionDefinition[has=ReturnStatement]         functions with a return somewhere inside
+//   *:x                                             every node whose value is x
+//
+// A constraint is 'field=pattern': a field named in queryField() below or the position of a
+// child, counted from 0 without Keyword and Delimiter leaves so lean and concrete trees agree;
+// 'has=pattern' looks for a match anywhere below the node. A field holding an IdentifierList or
+// ExpressionList of one element, as an assignment's target and value do, also matches through it
+// to that element. Calls written as statements are FunctionCallStatement nodes, and a sum is an
+// ExpressionList of its operands with a BinaryOp leaf for each operator. A value runs up to the next ',', '['
+// or ']' after its first character.
+//
+// Matching starts from the shortest postings list among the pattern and the patterns its fields
+// must match, e.g. the print identifiers rather than every call, so a query costs about as
+// much as the nodes it can match rather than the size of the tree.
+
+const uint32_t NO_NODE = UINT32_MAX;
+
+class TreeIndex {
+    private:
+        vector<const ParseTreeNode*> nodes;         // preorder
+        vector<uint32_t> ends;                      // one past each node's subtree
+        vector<uint32_t> parents;
+        vector<int32_t> slots;                      // position among the parent's children without syntax leaves; -1 for those leaves
+        vector<vector<uint32_t>> byKind;
+        unordered_map<string, vector<uint32_t>> byValue;
+        static inline const vector<uint32_t> none;
+
+        static bool isSyntaxLeaf(const ParseTreeNode* node) {
+            return node->kind == NodeKind::Keyword || node->kind == NodeKind::Delimiter;
+        }
+
+        struct Builder {
+            TreeIndex& index;
+            vector<uint32_t> open;       // the path from the root, as indices
+            vector<int32_t> nextSlot;    // for each node on the path, its next child's slot
+
+            bool enter(const shared_ptr<ParseTreeNode>& node, size_t) {
+                uint32_t id = (uint32_t)index.nodes.size();
+                uint32_t parent = open.empty() ? NO_NODE : open.back();
+                int32_t slot = -1;
+                if (!open.empty() && !isSyntaxLeaf(node.get())) slot = nextSlot.back()++;
+                index.nodes.push_back(node.get());
+                index.ends.push_back(id + 1);
+                index.parents.push_back(parent);
+                index.slots.push_back(slot);
+                index.byKind[(size_t)node->kind].push_back(id);
+                if (!node->value.empty()) index.byValue[node->value].push_back(id);
+                open.push_back(id);
+                nextSlot.push_back(0);
+                return true;
+            }
+
+            void leave(const shared_ptr<ParseTreeNode>&, size_t) {
+                index.ends[open.back()] = (uint32_t)index.nodes.size();
+                open.pop_back();
+                nextSlot.pop_back();
+            }
+        };
+
+    public:
+        explicit TreeIndex(const shared_ptr<ParseTreeNode>& root) : byKind((size_t)NodeKind::Other + 1) {
+            Builder builder{*this, {}, {}};
+            walkTree(root, builder);
+        }
+
+        uint32_t size() const { return (uint32_t)nodes.size(); }
+        const ParseTreeNode* node(uint32_t id) const { return nodes[id]; }
+        uint32_t end(uint32_t id) const { return ends[id]; }
+        uint32_t parent(uint32_t id) const { return parents[id]; }
+        int32_t slot(uint32_t id) const { return slots[id]; }
+
+        const vector<uint32_t>& postings(NodeKind kind) const { return byKind[(size_t)kind]; }
+
+        const vector<uint32_t>& postings(const string& value) const {
+            auto found = byValue.find(value);
+            return found == byValue.end() ? none : found->second;
+        }
+
+        // The element of an IdentifierList or ExpressionList holding just one; NO_NODE otherwise
+        uint32_t onlyElement(uint32_t id) const {
+            NodeKind kind = nodes[id]->kind;
+            if (kind != NodeKind::IdentifierList && kind != NodeKind::ExpressionList) return NO_NODE;
+            uint32_t first = child(id, 0);
+            return first != NO_NODE && child(id, 1) == NO_NODE ? first : NO_NODE;
+        }
+
+        // The child at 'slot', or the last one for slot -1, skipping syntax leaves; NO_NODE if absent
+        uint32_t child(uint32_t id, int32_t slot) const {
+            uint32_t last = NO_NODE;
+            for (uint32_t c = id + 1; c < ends[id]; c = ends[c]) {
+                if (slots[c] < 0) continue;
+                if (slots[c] == slot) return c;
+                last = c;
+            }
+            return slot < 0 ? last : NO_NODE;
+        }
+
+        // The line of the statement holding the node
+        int line(uint32_t id) const {
+            for (; id != NO_NODE; id = parents[id]) {
+                if (nodes[id]->line != 0) return nodes[id]->line;
+            }
+            return 0;
+        }
+};
+
+// ---- Patterns ----
+
+const int32_t FIELD_LAST = -1;       // the last child
+const int32_t FIELD_DESCENDANT = -2; // 'has': any node below
+
+struct QueryPattern;
+
+struct QueryConstraint {
+    int32_t field;
+    shared_ptr<QueryPattern> pattern;
+};
+
+struct QueryPattern {
+    bool anyKind = false;
+    NodeKind kind = NodeKind::Other;
+    bool hasValue = false;
+    string value;
+    vector<QueryConstraint> constraints;
+};
+
+// The child position a field name stands for in a node of 'kind'; -3 when it has no such field
+inline int32_t queryField(NodeKind kind, const string& name) {
+    struct Field { NodeKind kind; const char* name; int32_t slot; };
+    static const Field fields[] = {
+        {NodeKind::FunctionCall, "callee", 0}, {NodeKind::FunctionCall, "args", 1},
+        {NodeKind::FunctionCallStatement, "callee", 0}, {NodeKind::FunctionCallStatement, "args", 1},
+        {NodeKind::AttributeAccess, "object", 0}, {NodeKind::AttributeAccess, "attr", 1},
+        {NodeKind::Subscript, "object", 0}, {NodeKind::Subscript, "index", 1},
+        {NodeKind::Assignment, "target", 0}, {NodeKind::Assignment, "op", 1}, {NodeKind::Assignment, "value", 2},
+        {NodeKind::BinaryOp, "left", 0}, {NodeKind::BinaryOp, "right", 1},
+        {NodeKind::UnaryOp, "operand", 0},
+        {NodeKind::Comparison, "left", 0}, {NodeKind::Comparison, "op", 1}, {NodeKind::Comparison, "right", 2},
+        {NodeKind::TernaryOp, "then", 0}, {NodeKind::TernaryOp, "test", 1}, {NodeKind::TernaryOp, "else", 2},
+        {NodeKind::IfStatement, "test", 0}, {NodeKind::IfStatement, "body", 1},
+        {NodeKind::ElifClause, "test", 0}, {NodeKind::ElifClause, "body", 1},
+        {NodeKind::ElseClause, "body", 0},
+        {NodeKind::WhileStatement, "test", 0}, {NodeKind::WhileStatement, "body", 1},
+        {NodeKind::ForStatement, "target", 0}, {NodeKind::ForStatement, "iter", 1}, {NodeKind::ForStatement, "body", 2},
+        {NodeKind::FunctionDefinition, "name", 0}, {NodeKind::FunctionDefinition, "params", 1},
+        {NodeKind::FunctionDefinition, "body", 2},
+        {NodeKind::ClassDefinition, "name", 0}, {NodeKind::ClassDefinition, "body", FIELD_LAST},
+        {NodeKind::ReturnStatement, "value", 0},
+        {NodeKind::ExpressionStatement, "value", 0},
+        {NodeKind::KeyValuePair, "key", 0}, {NodeKind::KeyValuePair, "value", 1},
+    };
+    for (const auto& field : fields) {
+        if (field.kind == kind && name == field.name) return field.slot;
+    }
+    return -3;
+}
+
+class QueryCompiler {
+    private:
+        const string& text;
+        size_t pos = 0;
+        string error;
+
+        bool fail(const string& message) {
+            if (error.empty()) error = message + " at position " + to_string(pos);
+            return false;
+        }
+
+        string word() {
+            size_t start = pos;
+            while (pos < text.size() && (isalnum((unsigned char)text[pos]) || text[pos] == '_' || text[pos] == '*')) pos++;
+            return text.substr(start, pos - start);
+        }
+
+        bool parsePattern(QueryPattern& pattern) {
+            string kind = word();
+            if (kind.empty()) return fail("expected a node kind");
+            if (kind == "*") {
+                pattern.anyKind = true;
+            } else {
+                pattern.kind = nodeKindOf(kind);
+                if (pattern.kind == NodeKind::Other) return fail("unknown node kind '" + kind + "'");
+            }
+            if (pos < text.size() && text[pos] == ':') {
+                size_t start = ++pos;
+                // The first character is always taken, so Delimiter:[ and Delimiter:, work
+                if (pos < text.size()) pos++;
+                while (pos < text.size() && text[pos] != ',' && text[pos] != '[' && text[pos] != ']') pos++;
+                pattern.hasValue = true;
+                pattern.value = text.substr(start, pos - start);
+            }
+            if (pos < text.size() && text[pos] == '[') {
+                pos++;
+                do {
+                    string name = word();
+                    int32_t field;
+                    if (name == "has") field = FIELD_DESCENDANT;
+                    else if (!name.empty() && all_of(name.begin(), name.end(), ::isdigit)) field = stoi(name);
+                    else if (pattern.anyKind) return fail("'*' has no field '" + name + "'");
+                    else if ((field = queryField(pattern.kind, name)) == -3) {
+                        return fail(kind + " has no field '" + name + "'");
+                    }
+                    if (pos >= text.size() || text[pos] != '=') return fail("expected '='");
+                    pos++;
+                    auto sub = make_shared<QueryPattern>();
+                    if (!parsePattern(*sub)) return false;
+                    pattern.constraints.push_back({field, sub});
+                    if (pos >= text.size() || text[pos] != ',') break;
+                    pos++;
+                } while (true);
+                if (pos >= text.size() || text[pos] != ']') return fail("expected ']'");
+                pos++;
+            }
+            return true;
+        }
+
+    public:
+        explicit QueryCompiler(const string& source) : text(source) {}
+
+        // False with 'message' set when the pattern is malformed
+        bool compile(QueryPattern& pattern, string& message) {
+            if (parsePattern(pattern) && pos < text.size()) fail("unexpected '" + string(1, text[pos]) + "'");
+            message = error;
+            return error.empty();
+        }
+};
+
+// ---- Matching ----
+
+class QueryEngine {
+    private:
+        const TreeIndex& index;
+
+        // The postings every match of 'pattern' is in; nullptr when that is every node
+        const vector<uint32_t>* source(const QueryPattern& pattern) const {
+            const vector<uint32_t>* list = pattern.anyKind ? nullptr : &index.postings(pattern.kind);
+            if (pattern.hasValue) {
+                const vector<uint32_t>& byValue = index.postings(pattern.value);
+                if (!list || byValue.size() < list->size()) list = &byValue;
+            }
+            return list;
+        }
+
+        size_t sourceSize(const QueryPattern& pattern) const {
+            const vector<uint32_t>* list = source(pattern);
+            return list ? list->size() : index.size();
+        }
+
+        // Upper bound on the matches: a node matches at most once through each child position
+        size_t estimate(const QueryPattern& pattern) const {
+            size_t best = sourceSize(pattern);
+            for (const auto& constraint : pattern.constraints) {
+                if (constraint.field != FIELD_DESCENDANT) best = min(best, estimate(*constraint.pattern));
+            }
+            return best;
+        }
+
+        bool anyBelow(const QueryPattern& pattern, uint32_t id) const {
+            uint32_t first = id + 1, last = index.end(id);
+            const vector<uint32_t>* list = source(pattern);
+            if (!list) {
+                for (uint32_t k = first; k < last; k++) {
+                    if (matches(k, pattern)) return true;
+                }
+                return false;
+            }
+            for (auto it = lower_bound(list->begin(), list->end(), first); it != list->end() && *it < last; ++it) {
+                if (matches(*it, pattern)) return true;
+            }
+            return false;
+        }
+
+    public:
+        explicit QueryEngine(const TreeIndex& treeIndex) : index(treeIndex) {}
+
+        bool matches(uint32_t id, const QueryPattern& pattern) const {
+            const ParseTreeNode* node = index.node(id);
+            if (!pattern.anyKind && node->kind != pattern.kind) return false;
+            if (pattern.hasValue && node->value != pattern.value) return false;
+            for (const auto& constraint : pattern.constraints) {
+                if (constraint.field == FIELD_DESCENDANT) {
+                    if (!anyBelow(*constraint.pattern, id)) return false;
+                    continue;
+                }
+                uint32_t child = index.child(id, constraint.field);
+                if (child == NO_NODE) return false;
+                if (!matches(child, *constraint.pattern)) {
+                    uint32_t element = index.onlyElement(child);
+                    if (element == NO_NODE || !matches(element, *constraint.pattern)) return false;
+                }
+            }
+            return true;
+        }
+
+        // Preorder indices of the nodes matching 'pattern', ascending
+        vector<uint32_t> run(const QueryPattern& pattern) const {
+            vector<uint32_t> found;
+            const QueryConstraint* via = nullptr;
+            size_t best = sourceSize(pattern);
+            for (const auto& constraint : pattern.constraints) {
+                if (constraint.field == FIELD_DESCENDANT) continue;
+                size_t size = estimate(*constraint.pattern);
+                if (size < best) {
+                    best = size;
+                    via = &constraint;
+                }
+            }
+            if (!via) {
+                const vector<uint32_t>* list = source(pattern);
+                if (!list) {
+                    for (uint32_t id = 0; id < index.size(); id++) {
+                        if (matches(id, pattern)) found.push_back(id);
+                    }
+                    return found;
+                }
+                for (uint32_t id : *list) {
+                    if (matches(id, pattern)) found.push_back(id);
+                }
+                return found;
+            }
+            // From the children matching the field's pattern up to their parents, or through a list
+            // holding only that child to the list's parent
+            auto atField = [&](uint32_t child, uint32_t parent) {
+                if (parent == NO_NODE || index.slot(child) < 0) return false;
+                return via->field == FIELD_LAST ? index.child(parent, FIELD_LAST) == child : index.slot(child) == via->field;
+            };
+            for (uint32_t child : run(*via->pattern)) {
+                uint32_t parent = index.parent(child);
+                if (atField(child, parent) && matches(parent, pattern)) found.push_back(parent);
+                if (parent == NO_NODE || index.onlyElement(parent) != child) continue;
+                uint32_t grandparent = index.parent(parent);
+                if (atField(parent, grandparent) && matches(grandparent, pattern)) found.push_back(grandparent);
+            }
+            sort(found.begin(), found.end());
+            found.erase(unique(found.begin(), found.end()), found.end());
+            return found;
+        }
+};
+
+// Prints the matches of each pattern with their lines; returns 1 when a pattern is malformed
+inline int runQueries(const vector<string>& patterns, const TreeIndex& index, ostream& out) {
+    QueryEngine engine(index);
+    int status = 0;
+    for (const string& text : patterns) {
+        QueryPattern pattern;
+        string error;
+        if (!QueryCompiler(text).compile(pattern, error)) {
+            cerr << "Error: Invalid query '" << text << "': " << error << endl;
+            status = 1;
+            continue;
+        }
+        vector<uint32_t> found = engine.run(pattern);
+        out << text << ": " << found.size() << (found.size() == 1 ? " match" : " matches") << endl;
+        for (uint32_t id : found) {
+            const ParseTreeNode* node = index.node(id);
+            out << "  line " << index.line(id) << ": " << node->type;
+            if (!node->value.empty()) out << ": " << node->value;
+            out << endl;
+        }
+    }
+    return status;
+}
+
+#endif
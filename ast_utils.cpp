@@ -0,0 +1,132 @@
+#include <memory>
+#include <vector>
+#include <string>
+#include "literals.h"
+using namespace std;
+
+// Helpers shared by the passes that walk the parse tree
+
+// Delimiter leaves and Keyword leaves like 'if' or 'def' only repeat what the parent node type
+// already says; True/False/None are the exception since they are values
+bool isSyntaxLeaf(const shared_ptr<ParseTreeNode>& node) {
+    if (node->type == "Delimiter") return true;
+    if (node->type == "Keyword") {
+        return node->value != "True" && node->value != "False" && node->value != "None";
+    }
+    return false;
+}
+
+// Children that carry meaning, in source order
+vector<shared_ptr<ParseTreeNode>> semanticChildren(const shared_ptr<ParseTreeNode>& node) {
+    vector<shared_ptr<ParseTreeNode>> result;
+    result.reserve(node->children.size());
+    for (const auto& child : node->children) {
+        if (!isSyntaxLeaf(child)) result.push_back(child);
+    }
+    return result;
+}
+
+// First direct child with the given node type, or nullptr
+shared_ptr<ParseTreeNode> findChild(const shared_ptr<ParseTreeNode>& node, const string& type) {
+    for (const auto& child : node->children) {
+        if (child->type == type) return child;
+    }
+    return nullptr;
+}
+
+// parseArithExpr flattens 'a + b - c' into an ExpressionList of operands separated by
+// childless BinaryOp nodes; an assignment's value list uses the same node type without them
+bool isArithChain(const shared_ptr<ParseTreeNode>& node) {
+    if (node->type != "ExpressionList") return false;
+    for (const auto& child : node->children) {
+        if (child->type == "BinaryOp" && child->children.empty()) return true;
+    }
+    return false;
+}
+
+// Number of nodes in the tree, counting shared subtrees once per occurrence
+class NodeCounter : public TreeVisitor<NodeCounter> {
+    public:
+        size_t count = 0;
+
+        bool enterNode(const shared_ptr<ParseTreeNode>&, size_t) {
+            count++;
+            return true;
+        }
+};
+
+size_t countNodes(const shared_ptr<ParseTreeNode>& node) {
+    NodeCounter counter;
+    counter.walk(node);
+    return counter.count;
+}
+
+// Deep copy of a subtree, annotations included
+shared_ptr<ParseTreeNode> copyTree(const shared_ptr<ParseTreeNode>& node) {
+    auto copy = make_shared<ParseTreeNode>(node->type, node->value);
+    copy->inferredType = node->inferredType;
+    copy->line = node->line;
+    copy->literal = node->literal;
+    copy->children.reserve(node->children.size());
+    for (const auto& child : node->children) copy->children.push_back(copyTree(child));
+    return copy;
+}
+
+// Names a block binds by assignment, 'for', 'def' or 'class', without entering nested definitions
+void collectBoundNames(const shared_ptr<ParseTreeNode>& node, vector<string>& names) {
+    if (node->type == "Assignment") {
+        auto targets = findChild(node, "IdentifierList");
+        for (const auto& target : targets->children) {
+            if (target->type == "Identifier") names.push_back(target->value);
+        }
+        return;
+    }
+    if (node->type == "ForStatement") {
+        names.push_back(findChild(node, "Identifier")->value);
+    }
+    if (node->type == "FunctionDefinition" || node->type == "ClassDefinition") {
+        names.push_back(findChild(node, "Identifier")->value);
+        return;
+    }
+    for (const auto& child : node->children) collectBoundNames(child, names);
+}
+
+// Names an ImportStatement binds: 'import a.b' binds 'a', 'from m import x' binds only 'x', and
+// an alias replaces the name before it
+vector<string> importedNames(const shared_ptr<ParseTreeNode>& node) {
+    vector<string> names;
+    bool fromImport = node->children[0]->value == "from"; // the keyword leaf is kept in lean trees
+    for (const auto& child : node->children) {
+        if (child->type == "DottedName") {
+            if (fromImport) continue;
+            names.push_back(child->children[0]->value);
+        } else if (child->type == "ImportName") {
+            names.push_back(child->value);
+        } else if (child->type == "Alias" && !names.empty()) {
+            names.back() = child->value;
+        }
+    }
+    return names;
+}
+
+// The decoded value of a Literal node. Nodes the lexer did not produce, such as folded
+// constants, are decoded from their text on first use
+const LiteralValue& literalOf(const shared_ptr<ParseTreeNode>& node) {
+    if (!node->literal) node->literal = make_shared<const LiteralValue>(decodeLiteral(node->value));
+    return *node->literal;
+}
+
+// Parses the source of an f-string replacement field into an expression node; nullptr when
+// it is not a single expression
+shared_ptr<ParseTreeNode> parseEmbeddedExpression(const string& source) {
+    Lexer lexer;
+    lexer.tokenizeStatement(source, 0);
+    Parser parser(lexer.getTokens());
+    parser.setLeanTree(true);
+    auto tree = parser.parse();
+    if (!tree || tree->children.size() != 1) return nullptr;
+    auto statement = tree->children[0];
+    if (statement->type == "ExpressionStatement") return semanticChildren(statement)[0];
+    if (statement->type == "FunctionCallStatement") return statement;
+    return nullptr;
+}
@@ -0,0 +1,208 @@
+#ifndef AST_VISITOR_H
+#define AST_VISITOR_H
+
+#include <memory>
+#include <vector>
+#include <tuple>
+#include <utility>
+#include "node_kinds.h"
+using namespace std;
+
+// Tree passes without hand-written recursion or type string comparisons.
+//
+// A pass derives from TreeVisitor<Pass> (or TreeRewriter<Pass>) and defines only the hooks it
+// needs, e.g. bool enterFunctionCall(const shared_ptr<ParseTreeNode>&, size_t depth). Hooks are
+// found at compile time through the derived type, and a node reaches its hook with one switch on
+// its NodeKind. Traversal keeps its own stack, so tree depth is bounded by memory rather than by
+// the call stack. FusedVisitor runs several visitors in one traversal, touching each node once.
+
+// Depth-first walk. hooks.enter(node, depth) runs before a node's children and returns false to
+// skip them; hooks.leave(node, depth) runs after them, and also for a node whose children were skipped
+template <typename Hooks>
+void walkTree(const shared_ptr<ParseTreeNode>& root, Hooks& hooks) {
+    if (!root) return;
+    struct Frame {
+        const shared_ptr<ParseTreeNode>* node;
+        size_t next; // index of the next child to visit
+    };
+    if (!hooks.enter(root, 0)) {
+        hooks.leave(root, 0);
+        return;
+    }
+    vector<Frame> stack;
+    stack.push_back({&root, 0});
+    while (!stack.empty()) {
+        Frame& top = stack.back();
+        const auto& children = (*top.node)->children;
+        if (top.next < children.size()) {
+            const shared_ptr<ParseTreeNode>& child = children[top.next++];
+            if (!child) continue;
+            size_t depth = stack.size();
+            if (hooks.enter(child, depth)) stack.push_back({&child, 0});
+            else hooks.leave(child, depth);
+        } else {
+            const shared_ptr<ParseTreeNode>& node = *top.node;
+            stack.pop_back();
+            hooks.leave(node, stack.size());
+        }
+    }
+}
+
+// Pre- and post-order hooks per node kind. enterX defaults to enterNode and leaveX to leaveNode,
+// which a pass may override to see every node
+template <typename Derived>
+class TreeVisitor {
+    private:
+        Derived& self() { return static_cast<Derived&>(*this); }
+
+    public:
+        bool enterNode(const shared_ptr<ParseTreeNode>&, size_t) { return true; }
+        void leaveNode(const shared_ptr<ParseTreeNode>&, size_t) {}
+
+#define PARSE_NODE_VISIT_HOOKS(name) \
+        bool enter##name(const shared_ptr<ParseTreeNode>& node, size_t depth) { return self().enterNode(node, depth); } \
+        void leave##name(const shared_ptr<ParseTreeNode>& node, size_t depth) { self().leaveNode(node, depth); }
+        PARSE_NODE_KINDS(PARSE_NODE_VISIT_HOOKS)
+#undef PARSE_NODE_VISIT_HOOKS
+
+        bool enter(const shared_ptr<ParseTreeNode>& node, size_t depth) {
+            switch (node->kind) {
+#define PARSE_NODE_ENTER_CASE(name) case NodeKind::name: return self().enter##name(node, depth);
+                PARSE_NODE_KINDS(PARSE_NODE_ENTER_CASE)
+#undef PARSE_NODE_ENTER_CASE
+                case NodeKind::Other: break;
+            }
+            return self().enterNode(node, depth);
+        }
+
+        void leave(const shared_ptr<ParseTreeNode>& node, size_t depth) {
+            switch (node->kind) {
+#define PARSE_NODE_LEAVE_CASE(name) case NodeKind::name: self().leave##name(node, depth); return;
+                PARSE_NODE_KINDS(PARSE_NODE_LEAVE_CASE)
+#undef PARSE_NODE_LEAVE_CASE
+                case NodeKind::Other: break;
+            }
+            self().leaveNode(node, depth);
+        }
+
+        void walk(const shared_ptr<ParseTreeNode>& root) { walkTree(root, self()); }
+};
+
+// Several visitors in one traversal. Each pass sees the same enter/leave sequence it would see
+// walking alone: a pass that skips a subtree is not called inside it, while the others still are
+template <typename... Passes>
+class FusedVisitor {
+    private:
+        static constexpr size_t NOT_SKIPPING = ~size_t(0);
+        tuple<Passes&...> passes;
+        size_t skippedAt[sizeof...(Passes)]; // per pass, depth of the subtree it is skipping
+
+        template <size_t... I>
+        bool enterAll(const shared_ptr<ParseTreeNode>& node, size_t depth, index_sequence<I...>) {
+            bool descend = false;
+            ((skippedAt[I] == NOT_SKIPPING
+                  ? (get<I>(passes).enter(node, depth) ? void(descend = true) : void(skippedAt[I] = depth))
+                  : void()),
+             ...);
+            return descend;
+        }
+
+        template <size_t... I>
+        void leaveAll(const shared_ptr<ParseTreeNode>& node, size_t depth, index_sequence<I...>) {
+            ((skippedAt[I] == NOT_SKIPPING || skippedAt[I] == depth
+                  ? (get<I>(passes).leave(node, depth), void(skippedAt[I] = NOT_SKIPPING))
+                  : void()),
+             ...);
+        }
+
+    public:
+        explicit FusedVisitor(Passes&... each) : passes(each...) {
+            for (size_t& depth : skippedAt) depth = NOT_SKIPPING;
+        }
+
+        bool enter(const shared_ptr<ParseTreeNode>& node, size_t depth) {
+            return enterAll(node, depth, index_sequence_for<Passes...>());
+        }
+
+        void leave(const shared_ptr<ParseTreeNode>& node, size_t depth) {
+            leaveAll(node, depth, index_sequence_for<Passes...>());
+        }
+
+        void walk(const shared_ptr<ParseTreeNode>& root) { walkTree(root, *this); }
+};
+
+template <typename... Passes>
+void walkFused(const shared_ptr<ParseTreeNode>& root, Passes&... passes) {
+    FusedVisitor<Passes...>(passes...).walk(root);
+}
+
+// Bottom-up rewriting. rewriteX(node) runs once the node's children have been rewritten and
+// returns the node to put in its place: the node itself to keep it, another node to replace it,
+// or nullptr to drop it from its parent. enterNode(node) may return false to leave a subtree as is
+template <typename Derived>
+class TreeRewriter {
+    private:
+        Derived& self() { return static_cast<Derived&>(*this); }
+
+        shared_ptr<ParseTreeNode> rewriteOne(const shared_ptr<ParseTreeNode>& node) {
+            switch (node->kind) {
+#define PARSE_NODE_REWRITE_CASE(name) case NodeKind::name: return self().rewrite##name(node);
+                PARSE_NODE_KINDS(PARSE_NODE_REWRITE_CASE)
+#undef PARSE_NODE_REWRITE_CASE
+                case NodeKind::Other: break;
+            }
+            return self().rewriteNode(node);
+        }
+
+        // Drops children that were rewritten to nullptr
+        static void compact(vector<shared_ptr<ParseTreeNode>>& children) {
+            size_t kept = 0;
+            for (auto& child : children) {
+                if (child) children[kept++] = move(child);
+            }
+            children.resize(kept);
+        }
+
+    public:
+        bool enterNode(const shared_ptr<ParseTreeNode>&) { return true; }
+        shared_ptr<ParseTreeNode> rewriteNode(const shared_ptr<ParseTreeNode>& node) { return node; }
+
+#define PARSE_NODE_REWRITE_HOOK(name) \
+        shared_ptr<ParseTreeNode> rewrite##name(const shared_ptr<ParseTreeNode>& node) { return self().rewriteNode(node); }
+        PARSE_NODE_KINDS(PARSE_NODE_REWRITE_HOOK)
+#undef PARSE_NODE_REWRITE_HOOK
+
+        // Returns the rewritten root, nullptr when the root itself was dropped
+        shared_ptr<ParseTreeNode> rewrite(shared_ptr<ParseTreeNode> root) {
+            if (!root) return root;
+            struct Frame {
+                shared_ptr<ParseTreeNode>* slot; // where the node lives, so it can be replaced in place
+                size_t next;
+                bool dropped; // some child was rewritten to nullptr
+            };
+            vector<Frame> stack;
+            stack.push_back({&root, 0, false});
+            if (!self().enterNode(root)) return root;
+            while (!stack.empty()) {
+                Frame& top = stack.back();
+                auto& children = (*top.slot)->children;
+                if (top.next < children.size()) {
+                    shared_ptr<ParseTreeNode>& child = children[top.next++];
+                    if (!child || !self().enterNode(child)) continue;
+                    stack.push_back({&child, 0, false});
+                    continue;
+                }
+                if (top.dropped) compact(children);
+                shared_ptr<ParseTreeNode>* slot = top.slot;
+                stack.pop_back();
+                shared_ptr<ParseTreeNode> replacement = rewriteOne(*slot);
+                if (replacement != *slot) {
+                    *slot = move(replacement);
+                    if (!*slot && !stack.empty()) stack.back().dropped = true;
+                }
+            }
+            return root;
+        }
+};
+
+#endif
@@ -0,0 +1,28 @@
+# Settings fixed at the top of the module, read inside the hot loop
+WIDTH = 64
+HEIGHT = WIDTH // 2
+CELLS = WIDTH * HEIGHT
+SCALE = 1.0 / 8
+VERBOSE = False
+MODE = "sum"
+
+def render(frames):
+    total = 0.0
+    frame = 0
+    while frame < frames:
+        y = 0
+        while y < HEIGHT:
+            x = 0
+            while x < WIDTH:
+                if VERBOSE:
+                    print("pixel", x, y)
+                if MODE == "sum":
+                    total += (x + y * WIDTH) * SCALE
+                elif MODE == "max":
+                    total = x * y * SCALE if x * y * SCALE > total else total
+                x += 1
+            y += 1
+        frame += 1
+    return total / CELLS
+
+print(render(60))
@@ -0,0 +1,26 @@
+#!/bin/sh
+# Compares a one-shot --check run per request with the same request sent to a warm server.
+# Usage: bench/daemon.sh [path/to/parser] [script.py] [requests]   (default: bench/loops.py, 50)
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+PARSER=${1:-$ROOT/parser}
+SCRIPT=${2:-$ROOT/bench/loops.py}
+COUNT=${3:-50}
+SOCKET=${TMPDIR:-/tmp}/parser-bench-$$.sock
+
+"$PARSER" --serve "$SOCKET" >/dev/null &
+server=$!
+trap 'kill $server 2>/dev/null; rm -f "$SOCKET"' EXIT
+while [ ! -S "$SOCKET" ]; do sleep 0.05; done
+
+t0=$(date +%s.%N)
+i=0
+while [ $i -lt "$COUNT" ]; do
+    "$PARSER" --check "$SCRIPT" >/dev/null 2>&1
+    i=$((i + 1))
+done
+t1=$(date +%s.%N)
+awk -v a="$t0" -v b="$t1" -v n="$COUNT" 'BEGIN { printf "one-shot   %8.3f ms per request\n", (b - a) * 1000 / n }'
+
+printf "server     "
+"$PARSER" --client "$SOCKET" check --repeat "$COUNT" "$SCRIPT" 2>&1 >/dev/null
+"$PARSER" --client "$SOCKET" stop >/dev/null
@@ -0,0 +1,14 @@
+# Nested counting loops with integer arithmetic
+def count_pairs(n):
+    total = 0
+    i = 0
+    while i < n:
+        j = 0
+        while j < n:
+            if (i + j) % 3 == 0:
+                total += i * j
+            j += 1
+        i += 1
+    return total
+
+print(count_pairs(600))
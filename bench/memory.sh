@@ -0,0 +1,22 @@
+#!/bin/sh
+# Front-end memory at growing input sizes: the script repeated 1, 2, 4 and 8 times. Retained
+# bytes per line, token and node should stay flat; growth with size is a footprint regression.
+# Usage: bench/memory.sh [path/to/parser] [script.py]   (default: bench/loops.py)
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+PARSER=${1:-$ROOT/parser}
+SCRIPT=${2:-$ROOT/bench/loops.py}
+INPUT=${TMPDIR:-/tmp}/parser-memory-$$.py
+trap 'rm -f "$INPUT"' EXIT
+
+printf "%-8s %-14s %10s %14s %12s\n" copies phase units retained per-unit
+for copies in 1 2 4 8; do
+    : > "$INPUT"
+    i=0
+    while [ $i -lt $copies ]; do
+        cat "$SCRIPT" >> "$INPUT"
+        i=$((i + 1))
+    done
+    "$PARSER" --mem-stats "$INPUT" | awk -v n=$copies '
+        /^--- Memory ---$/ { table = 1; getline; next }
+        table && NF == 8 { printf "%-8s %-14s %10s %14s %12s %s\n", n, $1, $2, $5, $7, $8 }'
+done
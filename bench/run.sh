@@ -0,0 +1,21 @@
+#!/bin/sh
+# Times the bytecode VM (--run) and the closure evaluator (--eval) against CPython on each
+# benchmark script and checks that all outputs agree.
+# Usage: bench/run.sh [path/to/parser]
+PARSER=${1:-./parser}
+DIR=$(dirname "$0")
+
+for script in "$DIR"/*.py; do
+    name=$(basename "$script" .py)
+    t0=$(date +%s.%N)
+    vm_out=$("$PARSER" --run "$script" 2>/dev/null)
+    t1=$(date +%s.%N)
+    eval_out=$("$PARSER" --eval "$script" 2>/dev/null)
+    t2=$(date +%s.%N)
+    py_out=$(python3 "$script")
+    t3=$(date +%s.%N)
+    status=ok
+    [ "$vm_out" = "$py_out" ] && [ "$eval_out" = "$py_out" ] || status=MISMATCH
+    awk -v n="$name" -v a="$t0" -v b="$t1" -v c="$t2" -v d="$t3" -v s="$status" \
+        'BEGIN { printf "%-10s vm %7.3fs   eval %7.3fs   python3 %7.3fs   %s\n", n, b - a, c - b, d - c, s }'
+done
@@ -0,0 +1,18 @@
+# List indexing and for loops over range
+def sieve(limit):
+    flags = [True] * (limit + 1)
+    flags[0] = False
+    flags[1] = False
+    for i in range(2, limit + 1):
+        if flags[i]:
+            j = i * i
+            while j <= limit:
+                flags[j] = False
+                j += i
+    count = 0
+    for flag in flags:
+        if flag:
+            count += 1
+    return count
+
+print(sieve(300000))
@@ -0,0 +1,12 @@
+# Dict updates keyed by strings built in the loop
+def histogram(n):
+    counts = {}
+    for i in range(n):
+        key = "k" + str(i % 97)
+        if key in counts:
+            counts[key] += 1
+        else:
+            counts[key] = 1
+    return len(counts), counts["k0"]
+
+print(histogram(200000))
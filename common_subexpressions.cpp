@@ -0,0 +1,905 @@
+#include <memory>
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <iostream>
+using namespace std;
+
+// Evaluates repeated expressions once: an expression that occurs more than once in a run of
+// statements is computed into a temporary before the first of them, and one that cannot change
+// while a loop runs is computed before the loop. Runs after TreeOptimizer.
+//
+// Only expressions without side effects qualify: arithmetic, comparisons, 'and'/'or'/'not' and
+// the builtins len, str, lower, upper and bool, over literals and over names local to the function
+// (or module) whose inferred type is a built-in one. A reused value stands for the expression
+// as long as none of its names is bound again, and, for one that reads a list, dict, set or tuple,
+// as long as nothing can change the contents, which takes a call of anything but a builtin or an
+// assignment to a subscript. Since an error ends the program, computing an expression earlier is
+// invisible unless it raises where the program would not have, or before output the program
+// produced first. So an expression that can raise - integer arithmetic can overflow, division can
+// divide by zero, a name may be unbound - is only computed early where its first evaluation was
+// certain to come next anyway: unconditionally, after nothing that could raise, in the statement
+// the temporary precedes. Out of a loop, that is only at the start of a 'while' condition, which
+// runs on entering the loop; uses of the same expression in the body then read the temporary too.
+
+const size_t minReusedNodes = 3;
+
+class SubexpressionEliminator {
+    private:
+        // What is known about an expression
+        struct Facts {
+            bool pure = false;      // no side effects, and the same result while its names keep their values
+            bool safe = false;      // cannot raise either
+            bool stateful = false;  // depends on the contents of a container
+            string type;
+            vector<string> names;
+        };
+
+        struct Occurrence {
+            shared_ptr<ParseTreeNode>* slot;
+            const ParseTreeNode* node;
+            size_t statement;
+            Facts facts;
+        };
+
+        struct Group {
+            vector<Occurrence> occurrences;
+            size_t size = 0;
+        };
+
+        enum Scan { SCAN_CLEAN, SCAN_REACHED, SCAN_BLOCKED };
+
+        // The names a block's statements bind, each with the position of the first statement
+        // that runs with it bound. A block refers to the one it is nested in rather than copying
+        // its names, so recording them stays linear in the size of the block
+        struct BlockBindings {
+            const BlockBindings* outer = nullptr;
+            size_t outerPosition = 0; // the statement of 'outer' the block belongs to
+            unordered_map<string, size_t> from;
+        };
+
+        // The names certain to have values before statement 'position' of 'block' runs
+        struct BoundNames {
+            const BlockBindings* block = nullptr;
+            size_t position = 0;
+
+            bool count(const string& name) const {
+                const BlockBindings* names = block;
+                size_t before = position;
+                while (names) {
+                    auto found = names->from.find(name);
+                    if (found != names->from.end() && found->second <= before) return true;
+                    before = names->outerPosition;
+                    names = names->outer;
+                }
+                return false;
+            }
+        };
+
+        Lexer& lexer;
+        unordered_set<string> programNames;      // every name in the program, kept apart from temporaries
+        unordered_set<string> boundBuiltins;     // builtin names the program binds somewhere
+        unordered_map<string, string> temporaries; // the types of the temporaries made so far
+        unordered_set<string> scopeNames;        // locals of the function or module being rewritten
+        string scopeName;                        // its scope in the symbol table
+        unordered_set<const ParseTreeNode*> retiredNodes; // replaced, with everything below them
+        vector<shared_ptr<ParseTreeNode>> retired;
+        unordered_set<const ParseTreeNode*> hoistedLoops;
+        int nextTemporary = 1;
+        size_t reusedTemporaries = 0, reusedExpressions = 0, hoistedExpressions = 0;
+
+        // ---- Expressions ----
+
+        static bool isNumeric(const string& type) {
+            return type == "int" || type == "float";
+        }
+
+        static bool isContainer(const string& type) {
+            return type == "list" || type == "dict" || type == "set" || type == "tuple";
+        }
+
+        static bool isValueType(const string& type) {
+            return isNumeric(type) || isContainer(type) || type == "string" || type == "bool" || type == "None" ||
+                   type == "range";
+        }
+
+        static size_t semanticSize(const shared_ptr<ParseTreeNode>& node) {
+            size_t size = 1;
+            for (const auto& child : node->children) {
+                if (!isSyntaxLeaf(child)) size += semanticSize(child);
+            }
+            return size;
+        }
+
+        // Operators between two operands: childless BinaryOp nodes in an arithmetic chain and
+        // ComparisonOp nodes
+        static bool isOperatorMark(const shared_ptr<ParseTreeNode>& node) {
+            return node->kind == NodeKind::ComparisonOp || (node->kind == NodeKind::BinaryOp && node->children.empty());
+        }
+
+        // Structural key; equal keys mean the same expression
+        static string keyOf(const shared_ptr<ParseTreeNode>& node) {
+            auto parts = semanticChildren(node);
+            if (node->kind == NodeKind::ParenExpr && parts.size() == 1) return keyOf(parts[0]);
+            string key = node->type + ":" + node->value + "(";
+            for (const auto& part : parts) key += keyOf(part) + ",";
+            return key + ")";
+        }
+
+        static bool positiveLiteral(const shared_ptr<ParseTreeNode>& node) {
+            if (node->kind != NodeKind::Literal) return false;
+            const LiteralValue& literal = literalOf(node);
+            return (literal.kind == LIT_INT && literal.integer > 0) || (literal.kind == LIT_FLOAT && literal.number > 0);
+        }
+
+        static Facts combine(const Facts& left, const Facts& right) {
+            Facts facts;
+            facts.pure = true;
+            facts.safe = left.safe && right.safe;
+            facts.stateful = left.stateful || right.stateful;
+            facts.names = left.names;
+            facts.names.insert(facts.names.end(), right.names.begin(), right.names.end());
+            return facts;
+        }
+
+        // The type of 'left op right'; false when the pass leaves the operator alone
+        static bool arithmetic(const string& op, const Facts& left, const Facts& right,
+                               const shared_ptr<ParseTreeNode>& divisor, Facts& facts) {
+            if (op == "+" && left.type == "string" && right.type == "string") {
+                facts.type = "string";
+                return true;
+            }
+            if (!isNumeric(left.type) || !isNumeric(right.type)) return false;
+            bool floats = left.type == "float" || right.type == "float";
+            facts.type = floats ? "float" : "int";
+            if (op == "+" || op == "-" || op == "*") {
+                if (!floats) facts.safe = false; // 64-bit integers raise on overflow
+                return true;
+            }
+            if (op == "/" || op == "//" || op == "%") {
+                if (op == "/") facts.type = "float";
+                if (!positiveLiteral(divisor)) facts.safe = false;
+                return true;
+            }
+            return false;
+        }
+
+        bool isBuiltin(const string& name) const {
+            return builtInFunctions.count(name) && !boundBuiltins.count(name) && !scopeNames.count(name);
+        }
+
+        // Facts about 'node' evaluated where the names in 'bound' are certain to have values
+        Facts examine(const shared_ptr<ParseTreeNode>& node, const BoundNames& bound) const {
+            Facts facts;
+            switch (node->kind) {
+                case NodeKind::Literal: {
+                    const LiteralValue& literal = literalOf(node);
+                    if (literal.kind == LIT_INT) facts.type = "int";
+                    else if (literal.kind == LIT_FLOAT) facts.type = "float";
+                    else if (literal.kind == LIT_STRING) facts.type = "string";
+                    else return facts;
+                    facts.pure = facts.safe = true;
+                    return facts;
+                }
+                case NodeKind::Keyword:
+                    if (isSyntaxLeaf(node)) return facts;
+                    facts.type = node->value == "None" ? "None" : "bool";
+                    facts.pure = facts.safe = true;
+                    return facts;
+                case NodeKind::Identifier: {
+                    auto temporary = temporaries.find(node->value);
+                    if (temporary != temporaries.end()) {
+                        facts.type = temporary->second;
+                        facts.pure = facts.safe = true;
+                        facts.stateful = isContainer(facts.type);
+                        facts.names.push_back(node->value);
+                        return facts;
+                    }
+                    if (!scopeNames.count(node->value) || !isValueType(node->inferredType)) return facts;
+                    facts.type = node->inferredType;
+                    facts.pure = true;
+                    facts.safe = bound.count(node->value);
+                    facts.stateful = isContainer(facts.type);
+                    facts.names.push_back(node->value);
+                    return facts;
+                }
+                case NodeKind::ParenExpr: {
+                    auto parts = semanticChildren(node);
+                    return parts.size() == 1 ? examine(parts[0], bound) : facts;
+                }
+                case NodeKind::UnaryOp: {
+                    auto parts = semanticChildren(node);
+                    if (parts.size() != 1) return facts;
+                    Facts operand = examine(parts[0], bound);
+                    if (!operand.pure) return facts;
+                    if (node->value == "not") {
+                        operand.type = "bool";
+                    } else if (node->value == "-" || node->value == "+") {
+                        if (!isNumeric(operand.type)) return facts;
+                        if (node->value == "-" && operand.type == "int") operand.safe = false; // the most negative integer
+                    } else {
+                        return facts;
+                    }
+                    return operand;
+                }
+                case NodeKind::BinaryOp: {
+                    auto parts = semanticChildren(node);
+                    if (parts.size() != 2) return facts;
+                    Facts left = examine(parts[0], bound), right = examine(parts[1], bound);
+                    if (!left.pure || !right.pure) return facts;
+                    Facts result = combine(left, right);
+                    if (node->value == "and" || node->value == "or") {
+                        if (left.type == right.type) result.type = left.type;
+                        return result;
+                    }
+                    return arithmetic(node->value, left, right, parts[1], result) ? result : facts;
+                }
+                case NodeKind::ExpressionList: {
+                    if (!isArithChain(node)) return facts;
+                    auto parts = semanticChildren(node);
+                    Facts result = examine(parts[0], bound);
+                    if (!result.pure) return facts;
+                    for (size_t k = 1; k + 1 < parts.size(); k += 2) {
+                        Facts right = examine(parts[k + 1], bound);
+                        if (!right.pure) return facts;
+                        Facts combined = combine(result, right);
+                        if (!arithmetic(parts[k]->value, result, right, parts[k + 1], combined)) return facts;
+                        result = combined;
+                    }
+                    return result;
+                }
+                case NodeKind::Comparison: {
+                    auto parts = semanticChildren(node);
+                    if (parts.size() != 3) return facts;
+                    Facts left = examine(parts[0], bound), right = examine(parts[2], bound);
+                    if (!left.pure || !right.pure) return facts;
+                    Facts result = combine(left, right);
+                    result.type = "bool";
+                    const string& op = parts[1]->value;
+                    bool numbers = isNumeric(left.type) && isNumeric(right.type);
+                    bool strings = left.type == "string" && right.type == "string";
+                    if (op == "==" || op == "!=") return result;
+                    if ((op == "<" || op == "<=" || op == ">" || op == ">=") && (numbers || strings)) return result;
+                    if ((op == "in" || op == "not in") && strings) return result;
+                    return facts;
+                }
+                case NodeKind::FunctionCall: {
+                    auto parts = semanticChildren(node);
+                    if (parts.size() != 2 || parts[0]->kind != NodeKind::Identifier || !isBuiltin(parts[0]->value)) return facts;
+                    auto arguments = semanticChildren(parts[1]);
+                    if (arguments.size() != 1) return facts;
+                    Facts argument = examine(arguments[0], bound);
+                    if (!argument.pure) return facts;
+                    const string& name = parts[0]->value;
+                    if (name == "len" && (isContainer(argument.type) || argument.type == "string" || argument.type == "range")) {
+                        argument.type = "int";
+                    } else if (name == "str" && (isNumeric(argument.type) || argument.type == "string" || argument.type == "bool")) {
+                        argument.type = "string";
+                    } else if ((name == "lower" || name == "upper") && argument.type == "string") {
+                        argument.type = "string";
+                    } else if (name == "bool") {
+                        argument.type = "bool";
+                    } else {
+                        return facts;
+                    }
+                    return argument;
+                }
+                default:
+                    return facts;
+            }
+        }
+
+        // The parts of 'node' in the order they are evaluated; 'second' marks parts that may not be
+        void evaluationOrder(const shared_ptr<ParseTreeNode>& node, vector<pair<shared_ptr<ParseTreeNode>, bool>>& order) const {
+            auto parts = semanticChildren(node);
+            switch (node->kind) {
+                case NodeKind::Assignment:
+                    order.push_back({parts.back(), false}); // the value comes before any target
+                    return;
+                case NodeKind::IfStatement:
+                case NodeKind::WhileStatement:
+                    order.push_back({parts[0], false});
+                    return;
+                case NodeKind::ForStatement:
+                    order.push_back({parts[1], false});
+                    return;
+                case NodeKind::BinaryOp:
+                    if (node->value != "and" && node->value != "or") break;
+                    order.push_back({parts[0], false});
+                    order.push_back({parts[1], true});
+                    return;
+                case NodeKind::TernaryOp:
+                    order.push_back({parts[1], false});
+                    order.push_back({parts[0], true});
+                    order.push_back({parts[2], true});
+                    return;
+                case NodeKind::FunctionCall:
+                case NodeKind::FunctionCallStatement: {
+                    order.push_back({parts[0], false});
+                    auto arguments = findChild(node, "Arguments");
+                    if (arguments) {
+                        for (const auto& argument : semanticChildren(arguments)) order.push_back({argument, false});
+                    }
+                    return;
+                }
+                case NodeKind::AttributeAccess:
+                    order.push_back({parts[0], false});
+                    return;
+                default:
+                    break;
+            }
+            for (const auto& part : parts) {
+                if (!isOperatorMark(part)) order.push_back({part, false});
+            }
+        }
+
+        // Whether 'target' is 'node' or below it
+        class NodeFinder : public TreeVisitor<NodeFinder> {
+            private:
+                const ParseTreeNode* target;
+
+            public:
+                bool found = false;
+
+                explicit NodeFinder(const ParseTreeNode* target) : target(target) {}
+
+                bool enterNode(const shared_ptr<ParseTreeNode>& node, size_t) {
+                    if (node.get() == target) found = true;
+                    return !found;
+                }
+        };
+
+        static bool contains(const shared_ptr<ParseTreeNode>& node, const ParseTreeNode* target) {
+            NodeFinder finder(target);
+            finder.walk(node);
+            return finder.found;
+        }
+
+        // Whether evaluating 'node' reaches 'target' every time, after only what cannot raise
+        Scan scan(const shared_ptr<ParseTreeNode>& node, const ParseTreeNode* target, const BoundNames& bound) const {
+            if (node.get() == target) return SCAN_REACHED;
+            vector<pair<shared_ptr<ParseTreeNode>, bool>> order;
+            evaluationOrder(node, order);
+            for (const auto& part : order) {
+                if (contains(part.first, target)) return part.second ? SCAN_BLOCKED : scan(part.first, target, bound);
+                bool callee = part.first == order[0].first &&
+                              (node->kind == NodeKind::FunctionCall || node->kind == NodeKind::FunctionCallStatement);
+                if (callee && part.first->kind == NodeKind::Identifier && isBuiltin(part.first->value)) continue;
+                if (!cannotRaise(part.first, bound)) return SCAN_BLOCKED;
+            }
+            return SCAN_CLEAN;
+        }
+
+        // Like Facts::safe, but also for a list or tuple display, which builds a new value
+        bool cannotRaise(const shared_ptr<ParseTreeNode>& node, const BoundNames& bound) const {
+            if (node->kind != NodeKind::List && node->kind != NodeKind::Tuple) return examine(node, bound).safe;
+            for (const auto& item : semanticChildren(node)) {
+                if (!cannotRaise(item, bound)) return false;
+            }
+            return true;
+        }
+
+        // ---- Statements ----
+
+        // Names a statement may bind, imports included
+        static void collectBindings(const shared_ptr<ParseTreeNode>& node, vector<string>& names) {
+            collectBoundNames(node, names);
+            collectImports(node, names);
+        }
+
+        // The names imports bind, without entering nested definitions
+        class ImportCollector : public TreeVisitor<ImportCollector> {
+            private:
+                vector<string>& names;
+
+            public:
+                explicit ImportCollector(vector<string>& names) : names(names) {}
+
+                bool enterImportStatement(const shared_ptr<ParseTreeNode>& node, size_t) {
+                    for (const auto& name : importedNames(node)) names.push_back(name);
+                    return false;
+                }
+                bool enterFunctionDefinition(const shared_ptr<ParseTreeNode>&, size_t) { return false; }
+                bool enterClassDefinition(const shared_ptr<ParseTreeNode>&, size_t) { return false; }
+        };
+
+        static void collectImports(const shared_ptr<ParseTreeNode>& node, vector<string>& names) {
+            ImportCollector(names).walk(node);
+        }
+
+        // Whether running the code may change the contents of a container: any call of something
+        // other than a builtin, or a store into a subscript
+        class MutationFinder : public TreeVisitor<MutationFinder> {
+            private:
+                const SubexpressionEliminator& eliminator;
+
+                bool enterCall(const shared_ptr<ParseTreeNode>& node) {
+                    auto callee = semanticChildren(node)[0];
+                    if (callee->kind != NodeKind::Identifier || !eliminator.isBuiltin(callee->value)) found = true;
+                    return !found;
+                }
+
+            public:
+                bool found = false;
+
+                explicit MutationFinder(const SubexpressionEliminator& eliminator) : eliminator(eliminator) {}
+
+                bool enterNode(const shared_ptr<ParseTreeNode>&, size_t) { return !found; }
+                bool enterFunctionDefinition(const shared_ptr<ParseTreeNode>&, size_t) { return false; }
+                bool enterClassDefinition(const shared_ptr<ParseTreeNode>&, size_t) { return false; }
+                bool enterFunctionCall(const shared_ptr<ParseTreeNode>& node, size_t) { return enterCall(node); }
+                bool enterFunctionCallStatement(const shared_ptr<ParseTreeNode>& node, size_t) { return enterCall(node); }
+
+                bool enterAssignment(const shared_ptr<ParseTreeNode>& node, size_t) {
+                    for (const auto& target : findChild(node, "IdentifierList")->children) {
+                        if (target->kind == NodeKind::Subscript) found = true;
+                    }
+                    return !found;
+                }
+        };
+
+        bool mayMutate(const shared_ptr<ParseTreeNode>& node) const {
+            MutationFinder finder(*this);
+            finder.walk(node);
+            return finder.found;
+        }
+
+        // Names certain to have values once 'statement' has run, recorded from 'position' on
+        static void addBound(const shared_ptr<ParseTreeNode>& statement, BlockBindings& bound, size_t position) {
+            switch (statement->kind) {
+                case NodeKind::Assignment:
+                    for (const auto& target : findChild(statement, "IdentifierList")->children) {
+                        if (target->kind == NodeKind::Identifier) bound.from.emplace(target->value, position);
+                    }
+                    return;
+                case NodeKind::FunctionDefinition:
+                case NodeKind::ClassDefinition:
+                    bound.from.emplace(findChild(statement, "Identifier")->value, position);
+                    return;
+                case NodeKind::ImportStatement:
+                    for (const auto& name : importedNames(statement)) bound.from.emplace(name, position);
+                    return;
+                default:
+                    return;
+            }
+        }
+
+        string newTemporary(const string& type) {
+            string name;
+            do {
+                name = "_cse" + to_string(nextTemporary++);
+            } while (programNames.count(name));
+            string recorded = type.empty() ? "unknown" : type;
+            temporaries[name] = recorded;
+            lexer.addSymbol(name, recorded, scopeName);
+            return name;
+        }
+
+        shared_ptr<ParseTreeNode> temporaryRead(const string& name) {
+            auto read = make_shared<ParseTreeNode>("Identifier", name);
+            read->inferredType = temporaries[name];
+            return read;
+        }
+
+        // 'name = expression', as the parser builds an assignment
+        static shared_ptr<ParseTreeNode> temporaryAssignment(const string& name, const shared_ptr<ParseTreeNode>& expression,
+                                                             const string& type, int line) {
+            auto statement = make_shared<ParseTreeNode>("Assignment");
+            statement->line = line;
+            auto targets = make_shared<ParseTreeNode>("IdentifierList");
+            auto target = make_shared<ParseTreeNode>("Identifier", name);
+            target->inferredType = type;
+            targets->addChild(target);
+            statement->addChild(targets);
+            statement->addChild(make_shared<ParseTreeNode>("AssignOp", "="));
+            statement->addChild(expression);
+            return statement;
+        }
+
+        class RetiredMarker : public TreeVisitor<RetiredMarker> {
+            private:
+                unordered_set<const ParseTreeNode*>& nodes;
+
+            public:
+                explicit RetiredMarker(unordered_set<const ParseTreeNode*>& nodes) : nodes(nodes) {}
+
+                bool enterNode(const shared_ptr<ParseTreeNode>& node, size_t) {
+                    nodes.insert(node.get());
+                    return true;
+                }
+        };
+
+        void retire(const shared_ptr<ParseTreeNode>& node) {
+            retired.push_back(node);
+            RetiredMarker(retiredNodes).walk(node);
+        }
+
+        void replace(const Occurrence& occurrence, const string& name) {
+            retire(*occurrence.slot);
+            *occurrence.slot = temporaryRead(name);
+        }
+
+        // ---- Loop-invariant expressions ----
+
+        static bool isDefinition(const shared_ptr<ParseTreeNode>& node) {
+            return node->kind == NodeKind::FunctionDefinition || node->kind == NodeKind::ClassDefinition;
+        }
+
+        struct Loop {
+            BoundNames bound;               // names with values when the loop starts
+            unordered_set<string> assigned; // names the loop binds
+            bool mutates;
+        };
+
+        bool invariant(const Facts& facts, const Loop& loop) const {
+            if (!facts.pure || facts.names.empty() || (facts.stateful && loop.mutates)) return false;
+            for (const auto& name : facts.names) {
+                if (loop.assigned.count(name) || (!loop.bound.count(name) && !temporaries.count(name))) return false;
+            }
+            return true;
+        }
+
+        // Gathers the largest invariant expressions below 'slot'. Those that cannot raise, or
+        // that start the 'while' condition, which runs on entering the loop, get a temporary;
+        // the others go to 'later' and only read one made for the same expression
+        void collectInvariants(shared_ptr<ParseTreeNode>& slot, const shared_ptr<ParseTreeNode>* condition, const Loop& loop,
+                               map<string, Group>& groups, map<string, vector<Occurrence>>& later) {
+            if (isDefinition(slot) || isSyntaxLeaf(slot)) return;
+            if (semanticSize(slot) >= minReusedNodes) {
+                Facts facts = examine(slot, loop.bound);
+                if (invariant(facts, loop)) {
+                    Occurrence occurrence = {&slot, slot.get(), 0, facts};
+                    if (facts.safe || (condition && scan(*condition, slot.get(), loop.bound) == SCAN_REACHED)) {
+                        Group& group = groups[keyOf(slot)];
+                        group.size = semanticSize(slot);
+                        group.occurrences.push_back(occurrence);
+                        return;
+                    }
+                    later[keyOf(slot)].push_back(occurrence);
+                }
+            }
+            bool attribute = slot->kind == NodeKind::AttributeAccess;
+            for (auto& child : slot->children) {
+                collectInvariants(child, condition, loop, groups, later);
+                if (attribute && !isSyntaxLeaf(child)) break; // the attribute name is no expression
+            }
+        }
+
+        // Computes the loop's invariant expressions into temporaries placed before it; returns
+        // how many it placed
+        size_t hoist(const shared_ptr<ParseTreeNode>& suite, size_t index, const BoundNames& bound) {
+            auto statement = suite->children[index];
+            Loop loop;
+            loop.bound = bound;
+            vector<string> assigned;
+            collectBindings(statement, assigned);
+            loop.assigned.insert(assigned.begin(), assigned.end());
+            loop.mutates = mayMutate(statement);
+
+            map<string, Group> groups;
+            map<string, vector<Occurrence>> later;
+            for (auto& child : statement->children) {
+                if (child->kind == NodeKind::Suite) {
+                    for (auto& inner : child->children) collectInvariants(inner, nullptr, loop, groups, later);
+                }
+            }
+            if (statement->kind == NodeKind::WhileStatement) {
+                for (auto& child : statement->children) {
+                    if (isSyntaxLeaf(child)) continue;
+                    collectInvariants(child, &child, loop, groups, later);
+                    break;
+                }
+            }
+
+            vector<Group> hoisted;
+            for (auto& group : groups) {
+                auto uses = later.find(group.first);
+                if (uses != later.end()) {
+                    group.second.occurrences.insert(group.second.occurrences.end(), uses->second.begin(), uses->second.end());
+                }
+                hoisted.push_back(move(group.second));
+            }
+            // A larger expression takes the uses of the smaller ones inside it
+            stable_sort(hoisted.begin(), hoisted.end(), [](const Group& a, const Group& b) { return a.size > b.size; });
+            vector<shared_ptr<ParseTreeNode>> placed;
+            for (const auto& group : hoisted) {
+                vector<const Occurrence*> live;
+                for (const auto& occurrence : group.occurrences) {
+                    if (!retiredNodes.count(occurrence.node)) live.push_back(&occurrence);
+                }
+                if (live.empty()) continue;
+                string name = newTemporary(live[0]->facts.type);
+                placed.push_back(temporaryAssignment(name, copyTree(*live[0]->slot), temporaries[name], statement->line));
+                for (const auto* occurrence : live) replace(*occurrence, name);
+                hoistedExpressions++;
+            }
+            suite->children.insert(suite->children.begin() + index, placed.begin(), placed.end());
+            return placed.size();
+        }
+
+        // ---- Repeated expressions ----
+
+        // Records every expression below 'slot' that could be reused, and in 'opened' the keys of
+        // the groups it starts
+        void collectRepeats(shared_ptr<ParseTreeNode>& slot, size_t statement, const BoundNames& bound, bool mutates,
+                            map<string, Group>& open, vector<string>& opened) {
+            if (isDefinition(slot) || isSyntaxLeaf(slot)) return;
+            if (semanticSize(slot) >= minReusedNodes && slot->kind != NodeKind::ParenExpr) {
+                Facts facts = examine(slot, bound);
+                if (facts.pure && !facts.names.empty() && !(facts.stateful && mutates)) {
+                    string key = keyOf(slot);
+                    Group& group = open[key];
+                    if (group.occurrences.empty()) {
+                        group.size = semanticSize(slot);
+                        opened.push_back(move(key));
+                    }
+                    group.occurrences.push_back({&slot, slot.get(), statement, facts});
+                }
+            }
+            bool attribute = slot->kind == NodeKind::AttributeAccess;
+            for (auto& child : slot->children) {
+                collectRepeats(child, statement, bound, mutates, open, opened);
+                if (attribute && !isSyntaxLeaf(child)) break;
+            }
+        }
+
+        // The expressions a statement evaluates at its own level, rather than in a nested block
+        static vector<shared_ptr<ParseTreeNode>*> evaluatedSlots(const shared_ptr<ParseTreeNode>& statement) {
+            vector<shared_ptr<ParseTreeNode>*> slots;
+            vector<shared_ptr<ParseTreeNode>*> parts;
+            for (auto& child : statement->children) {
+                if (!isSyntaxLeaf(child)) parts.push_back(&child);
+            }
+            switch (statement->kind) {
+                case NodeKind::Assignment:
+                    slots.push_back(parts.back());
+                    break;
+                case NodeKind::ExpressionStatement:
+                case NodeKind::ReturnStatement:
+                case NodeKind::FunctionCallStatement:
+                    slots = parts;
+                    break;
+                case NodeKind::IfStatement:
+                    slots.push_back(parts[0]);
+                    break;
+                case NodeKind::ForStatement:
+                    slots.push_back(parts[1]);
+                    break;
+                default:
+                    break;
+            }
+            return slots;
+        }
+
+        // Gives each group used more than once a temporary, placed before the statement of its
+        // first use that may compute it early
+        void reuse(vector<Group>& finished, const shared_ptr<ParseTreeNode>& suite, const BlockBindings& bound,
+                   map<size_t, vector<shared_ptr<ParseTreeNode>>>& placed) {
+            // A larger expression takes the uses of the smaller ones inside it
+            stable_sort(finished.begin(), finished.end(), [](const Group& a, const Group& b) { return a.size > b.size; });
+            for (auto& group : finished) {
+                vector<Occurrence> live;
+                for (const auto& occurrence : group.occurrences) {
+                    if (!retiredNodes.count(occurrence.node)) live.push_back(occurrence);
+                }
+                size_t first = 0;
+                while (live.size() - first >= 2) {
+                    const Occurrence& candidate = live[first];
+                    if (candidate.facts.safe) break;
+                    const auto& statement = suite->children[candidate.statement];
+                    if (scan(statement, candidate.node, {&bound, candidate.statement}) == SCAN_REACHED) break;
+                    first++;
+                }
+                if (live.size() - first < 2) continue;
+                const Occurrence& defining = live[first];
+                string name = newTemporary(defining.facts.type);
+                const auto& statement = suite->children[defining.statement];
+                placed[defining.statement].push_back(
+                    temporaryAssignment(name, copyTree(*defining.slot), temporaries[name], statement->line));
+                for (size_t k = first; k < live.size(); k++) replace(live[k], name);
+                reusedTemporaries++;
+                reusedExpressions += live.size() - first;
+            }
+            finished.clear();
+        }
+
+        // A group stays open while its names keep their values. Open groups are found by the
+        // names they read and by whether they read a container, so a statement only visits the
+        // groups it ends
+        void reuseInBlock(const shared_ptr<ParseTreeNode>& suite, const BlockBindings& bound,
+                          const unordered_set<const ParseTreeNode*>& hoistedTemporaries) {
+            map<string, Group> open;
+            unordered_map<string, vector<string>> openByName; // may still list groups that ended
+            set<string> openStateful;
+            vector<Group> finished;
+            map<size_t, vector<shared_ptr<ParseTreeNode>>> placed;
+            for (size_t k = 0; k < suite->children.size(); k++) {
+                auto statement = suite->children[k];
+                if (isSyntaxLeaf(statement)) continue;
+                bool mutates = mayMutate(statement);
+                if (!hoistedTemporaries.count(statement.get())) {
+                    vector<string> opened;
+                    for (auto* slot : evaluatedSlots(statement)) collectRepeats(*slot, k, {&bound, k}, mutates, open, opened);
+                    for (const auto& key : opened) {
+                        const Facts& facts = open[key].occurrences[0].facts;
+                        for (const auto& name : facts.names) openByName[name].push_back(key);
+                        if (facts.stateful) openStateful.insert(key);
+                    }
+                }
+                vector<string> assigned;
+                collectBindings(statement, assigned);
+                set<string> ending; // in key order, the order 'open' keeps them in
+                for (const auto& name : assigned) {
+                    auto keys = openByName.find(name);
+                    if (keys == openByName.end()) continue;
+                    ending.insert(keys->second.begin(), keys->second.end());
+                    openByName.erase(keys);
+                }
+                if (mutates) {
+                    ending.insert(openStateful.begin(), openStateful.end());
+                    openStateful.clear();
+                }
+                for (const auto& key : ending) {
+                    auto group = open.find(key);
+                    if (group == open.end()) continue;
+                    finished.push_back(move(group->second));
+                    open.erase(group);
+                    openStateful.erase(key);
+                }
+                if (!finished.empty()) reuse(finished, suite, bound, placed);
+            }
+            for (auto& group : open) finished.push_back(move(group.second));
+            reuse(finished, suite, bound, placed);
+
+            if (placed.empty()) return;
+            vector<shared_ptr<ParseTreeNode>> statements;
+            for (size_t k = 0; k < suite->children.size(); k++) {
+                auto temporaries = placed.find(k);
+                if (temporaries != placed.end()) statements.insert(statements.end(), temporaries->second.begin(), temporaries->second.end());
+                statements.push_back(suite->children[k]);
+            }
+            suite->children = move(statements);
+        }
+
+        // ---- Blocks ----
+
+        void rewriteNested(const shared_ptr<ParseTreeNode>& node, const BoundNames& bound) {
+            for (const auto& child : node->children) {
+                if (child->kind == NodeKind::Suite) {
+                    if (node->kind == NodeKind::ForStatement) {
+                        rewriteBlock(child, bound, {findChild(node, "Identifier")->value});
+                    } else {
+                        rewriteBlock(child, bound, {});
+                    }
+                } else if (child->kind == NodeKind::ElifClause || child->kind == NodeKind::ElseClause) {
+                    rewriteNested(child, bound);
+                }
+            }
+        }
+
+        // Rewrites a block entered where 'outer' holds the names with values; 'entering' are the
+        // names bound on entry
+        void rewriteBlock(const shared_ptr<ParseTreeNode>& suite, const BoundNames& outer, const vector<string>& entering) {
+            BlockBindings bound;
+            bound.outer = outer.block;
+            bound.outerPosition = outer.position;
+            for (const auto& name : entering) bound.from.emplace(name, 0);
+            unordered_set<const ParseTreeNode*> hoistedTemporaries;
+            for (size_t k = 0; k < suite->children.size(); k++) {
+                auto statement = suite->children[k];
+                NodeKind kind = statement->kind;
+                if ((kind == NodeKind::WhileStatement || kind == NodeKind::ForStatement) && !hoistedLoops.count(statement.get())) {
+                    hoistedLoops.insert(statement.get());
+                    size_t count = hoist(suite, k, {&bound, k});
+                    if (count) {
+                        for (size_t p = k; p < k + count; p++) hoistedTemporaries.insert(suite->children[p].get());
+                        k--; // the temporaries are statements of this block now
+                        continue;
+                    }
+                }
+                if (kind == NodeKind::FunctionDefinition) {
+                    rewriteFunction(statement);
+                } else if (kind == NodeKind::ClassDefinition) {
+                    rewriteClass(statement);
+                } else {
+                    rewriteNested(statement, {&bound, k});
+                }
+                addBound(statement, bound, k + 1);
+            }
+            reuseInBlock(suite, bound, hoistedTemporaries);
+        }
+
+        void rewriteFunction(const shared_ptr<ParseTreeNode>& definition) {
+            unordered_set<string> outerNames = move(scopeNames);
+            string outerScope = scopeName;
+
+            unordered_set<string> parameters;
+            for (const auto& parameter : findChild(definition, "Parameters")->children) {
+                if (parameter->kind == NodeKind::Parameter) parameters.insert(parameter->value);
+            }
+            auto body = findChild(definition, "Suite");
+            vector<string> locals;
+            collectBindings(body, locals);
+            scopeNames = parameters;
+            scopeNames.insert(locals.begin(), locals.end());
+            scopeName = findChild(definition, "Identifier")->value;
+            rewriteBlock(body, {}, vector<string>(parameters.begin(), parameters.end()));
+
+            scopeNames = move(outerNames);
+            scopeName = outerScope;
+        }
+
+        // Class bodies bind attributes rather than variables; only their methods are rewritten
+        void rewriteClass(const shared_ptr<ParseTreeNode>& definition) {
+            for (const auto& statement : findChild(definition, "Suite")->children) {
+                if (statement->kind == NodeKind::FunctionDefinition) rewriteFunction(statement);
+                else if (statement->kind == NodeKind::ClassDefinition) rewriteClass(statement);
+            }
+        }
+
+        // Every name in the program, and the builtins it binds somewhere: such a builtin could be
+        // the program's own function wherever it is called
+        class NameCollector : public TreeVisitor<NameCollector> {
+            private:
+                SubexpressionEliminator& eliminator;
+
+                void bindings(const shared_ptr<ParseTreeNode>& node) {
+                    vector<string> names;
+                    collectBindings(node, names);
+                    for (const auto& name : names) {
+                        if (builtInFunctions.count(name)) eliminator.boundBuiltins.insert(name);
+                    }
+                }
+
+            public:
+                explicit NameCollector(SubexpressionEliminator& eliminator) : eliminator(eliminator) {}
+
+                bool enterNode(const shared_ptr<ParseTreeNode>& node, size_t) {
+                    bindings(node);
+                    return true;
+                }
+
+                bool enterIdentifier(const shared_ptr<ParseTreeNode>& node, size_t depth) {
+                    eliminator.programNames.insert(node->value);
+                    return enterNode(node, depth);
+                }
+
+                bool enterParameter(const shared_ptr<ParseTreeNode>& node, size_t depth) {
+                    eliminator.programNames.insert(node->value);
+                    if (builtInFunctions.count(node->value)) eliminator.boundBuiltins.insert(node->value);
+                    return enterNode(node, depth);
+                }
+        };
+
+    public:
+        SubexpressionEliminator(Lexer& lexer) : lexer(lexer) {}
+
+        void rewrite(const shared_ptr<ParseTreeNode>& program) {
+            NameCollector(*this).walk(program);
+            for (const auto& symbol : lexer.getsymbols()) programNames.insert(symbol.name);
+
+            vector<string> moduleNames;
+            collectBindings(program, moduleNames);
+            scopeNames.insert(moduleNames.begin(), moduleNames.end());
+            scopeName = "global";
+            rewriteBlock(program, {}, {});
+        }
+
+        size_t temporaryCount() const { return reusedTemporaries; }
+        size_t reusedCount() const { return reusedExpressions; }
+        size_t hoistedCount() const { return hoistedExpressions; }
+};
+
+// Reuses repeated expressions and hoists loop-invariant ones in place, adding the temporaries to
+// the symbol table; with 'report' set, prints what it did
+void eliminateCommonSubexpressions(const shared_ptr<ParseTreeNode>& tree, Lexer& lexer, bool report) {
+    SubexpressionEliminator eliminator(lexer);
+    eliminator.rewrite(tree);
+    if (!report) return;
+    cerr << "Subexpressions: " << eliminator.temporaryCount() << " repeated expressions computed once for "
+         << eliminator.reusedCount() << " uses, " << eliminator.hoistedCount() << " loop-invariant expressions hoisted" << endl;
+}
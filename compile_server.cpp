@@ -0,0 +1,442 @@
+#include <memory>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+using namespace std;
+
+// A long-running compiler process serving requests over a Unix domain socket, so editors and
+// hooks skip process startup and reuse the work done for files that have not changed.
+//
+// Protocol, one request after another on a connection:
+//   request:  "<command> <path bytes> <buffer bytes>\n" <path> <buffer>
+//   response: "<status> <payload bytes>\n" <payload>
+// The buffer length is -1 when the server should read the file at <path> itself; otherwise the
+// buffer is the source, e.g. an editor's unsaved contents. Commands:
+//   lex    the token and symbol tables, as printed after the parse tree
+//   parse  the lean parse tree, one node per line
+//   check  the --check diagnostics
+//   stats  request and cache counters
+//   stop   shut the server down
+// The status is the exit status the one-shot compiler would return, and the payload is what it
+// would print, errors included.
+//
+// Every path keeps its last source's tokens, symbol table, tree and diagnostics, keyed by content
+// hash; a file read from disk is not even read again while its size and mtime are unchanged. At
+// most maxCachedSources paths are kept, dropping the least recently requested. A request whose path
+// is longer than PATH_MAX or whose buffer is larger than maxRequestBuffer is malformed.
+// When the source does change, its parser is kept and only re-parses the edited statements.
+// Connections get a thread each, but requests are handled one at a time because the lexer and
+// parser report errors on cerr and cout, which are redirected into the response meanwhile.
+
+const size_t maxCachedSources = 256;
+const long long maxRequestBuffer = 64ll << 20;
+
+// ---- Socket I/O ----
+
+bool readExactly(int fd, char* data, size_t length) {
+    while (length > 0) {
+        ssize_t got = read(fd, data, length);
+        if (got <= 0) return false;
+        data += got;
+        length -= got;
+    }
+    return true;
+}
+
+bool writeAll(int fd, const string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t put = write(fd, data.data() + sent, data.size() - sent);
+        if (put <= 0) return false;
+        sent += put;
+    }
+    return true;
+}
+
+// A request or response header, up to its newline
+bool readHeader(int fd, string& line) {
+    line.clear();
+    char ch;
+    while (readExactly(fd, &ch, 1)) {
+        if (ch == '\n') return true;
+        if (line.size() > 256) return false;
+        line += ch;
+    }
+    return false;
+}
+
+bool readResponse(int fd, int& status, string& payload) {
+    string header;
+    if (!readHeader(fd, header)) return false;
+    istringstream fields(header);
+    long long length = -1;
+    fields >> status >> length;
+    if (!fields || length < 0) return false;
+    payload.assign(length, '\0');
+    return readExactly(fd, &payload[0], payload.size());
+}
+
+// Fills 'address' for a socket path; false when the path does not fit
+bool socketAddress(const string& socketPath, sockaddr_un& address) {
+    address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        cerr << "Error: Socket path too long: " << socketPath << endl;
+        return false;
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+    return true;
+}
+
+class StreamCapture {
+    private:
+        ostringstream text;
+        streambuf* savedOut;
+        streambuf* savedErr;
+
+    public:
+        StreamCapture() : savedOut(cout.rdbuf(text.rdbuf())), savedErr(cerr.rdbuf(text.rdbuf())) {}
+
+        ~StreamCapture() {
+            cout.rdbuf(savedOut);
+            cerr.rdbuf(savedErr);
+        }
+
+        string str() const { return text.str(); }
+};
+
+// Clears the types inference left on a tree, which joins with whatever it finds there
+class InferredTypeEraser : public TreeVisitor<InferredTypeEraser> {
+    public:
+        bool enterNode(const shared_ptr<ParseTreeNode>& node, size_t) {
+            node->inferredType.clear();
+            return true;
+        }
+};
+
+struct CachedSource {
+    uint64_t hash = 0;
+    bool fromDisk = false;
+    off_t size = 0;
+    timespec mtime = {0, 0};
+    uint64_t lastUse = 0; // request count when the path was last requested
+    string source;
+
+    bool lexed = false; // the front end ran: lexing, parsing and type inference
+    bool parsed = false;
+    unique_ptr<Lexer> lexer;
+    unique_ptr<Parser> parser; // incremental, and kept for the file's next version
+    shared_ptr<ParseTreeNode> tree;
+    string frontEndErrors;
+    string tables, treeText, diagnostics; // filled on first request
+    int checkStatus = -1;
+};
+
+class CompileServer {
+    private:
+        unordered_map<string, CachedSource> sources;
+        mutex requestLock;
+        atomic<bool> stopping{false};
+        int listener = -1;
+        mutex connectionLock;
+        condition_variable connectionsClosed;
+        unordered_set<int> connections; // sockets of the connections still being served
+        size_t requests = 0, frontEndRuns = 0, diskReads = 0, reparses = 0, evictions = 0;
+
+        // The cache entry for 'path', made the most recently used; drops the least recently used
+        // path when there are too many
+        CachedSource& cacheEntry(const string& path) {
+            CachedSource& entry = sources[path];
+            entry.lastUse = requests;
+            if (sources.size() > maxCachedSources) {
+                auto oldest = sources.begin();
+                for (auto it = sources.begin(); it != sources.end(); ++it) {
+                    if (it->second.lastUse < oldest->second.lastUse) oldest = it;
+                }
+                sources.erase(oldest); // never 'entry', which was used last
+                evictions++;
+            }
+            return entry;
+        }
+
+        // The cache entry for 'path' holding its current source; false when the file is unreadable
+        bool refresh(const string& path, const string* buffer, CachedSource*& entry, string& error) {
+            if (!buffer) {
+                struct stat info;
+                if (stat(path.c_str(), &info) != 0) {
+                    sources.erase(path);
+                    error = "Error: Could not open file " + path + "\n";
+                    return false;
+                }
+                entry = &cacheEntry(path);
+                if (entry->fromDisk && entry->size == info.st_size && entry->mtime.tv_sec == info.st_mtim.tv_sec &&
+                    entry->mtime.tv_nsec == info.st_mtim.tv_nsec) {
+                    return true;
+                }
+                ifstream in(path, ios::binary);
+                if (!in) {
+                    sources.erase(path);
+                    error = "Error: Could not open file " + path + "\n";
+                    return false;
+                }
+                stringstream contents;
+                contents << in.rdbuf();
+                diskReads++;
+                replaceSource(*entry, contents.str());
+                entry->fromDisk = true;
+                entry->size = info.st_size;
+                entry->mtime = info.st_mtim;
+                return true;
+            }
+            entry = &cacheEntry(path);
+            replaceSource(*entry, *buffer);
+            entry->fromDisk = false;
+            return true;
+        }
+
+        static void replaceSource(CachedSource& entry, const string& source) {
+            uint64_t hash = hashBytes(source);
+            if (entry.lexed && entry.hash == hash) return;
+            unique_ptr<Parser> parser = entry.parsed ? move(entry.parser) : nullptr;
+            uint64_t lastUse = entry.lastUse;
+            entry = CachedSource();
+            entry.parser = move(parser);
+            entry.lastUse = lastUse;
+            entry.hash = hash;
+            entry.source = source;
+        }
+
+        // Lexes and parses the way runFrontEnd does, with the lean tree the analyses use
+        void runFrontEnd(CachedSource& entry) {
+            if (entry.lexed) return;
+            entry.lexed = true;
+            frontEndRuns++;
+            StreamCapture capture;
+            entry.lexer = make_unique<Lexer>();
+            Lexer& lexer = *entry.lexer;
+            vector<tuple<string, int, int>> lines;
+            istringstream input(entry.source);
+            string line;
+            int lineNumber = 1;
+            while (getline(input, line)) lines.push_back(lexer.makeCodeLine(line, lineNumber++));
+            entry.source.clear();
+            try {
+                lexer.tokenizeLine(lines);
+            } catch (const exception&) {
+                entry.frontEndErrors = capture.str();
+                return;
+            }
+            if (entry.parser) {
+                const vector<Token>& tokens = lexer.getTokens();
+                entry.tree = entry.parser->reparse(tokens, editedTokens(entry.parser->getTokens(), tokens));
+                if (entry.tree) InferredTypeEraser().walk(entry.tree); // reused nodes keep the last version's types
+                reparses++;
+            } else {
+                entry.parser = make_unique<Parser>(lexer.getTokens());
+                entry.parser->setLeanTree(true);
+                entry.parser->setIncremental(true);
+                entry.tree = entry.parser->parse();
+            }
+            if (entry.tree) {
+                inferTypes(entry.tree, lexer);
+                entry.parsed = true;
+            }
+            entry.frontEndErrors = capture.str();
+        }
+
+        int handle(const string& command, const string& path, const string* buffer, string& payload) {
+            requests++;
+            if (command == "stats") {
+                payload = to_string(requests) + " requests, " + to_string(sources.size()) + " cached files (" + to_string(evictions) + " evicted), " +
+                          to_string(frontEndRuns) + " front-end runs, " + to_string(reparses) + " incremental, " +
+                          to_string(diskReads) + " file reads\n";
+                return 0;
+            }
+            if (command == "stop") {
+                stopping = true;
+                payload = "Server stopped\n";
+                return 0;
+            }
+            if (command != "lex" && command != "parse" && command != "check") {
+                payload = "Error: Unknown command '" + command + "'\n";
+                return 1;
+            }
+
+            CachedSource* entry;
+            if (!refresh(path, buffer, entry, payload)) return 1;
+            runFrontEnd(*entry);
+            payload = entry->frontEndErrors;
+            if (!entry->parsed) return 1;
+
+            if (command == "lex") {
+                if (entry->tables.empty()) {
+                    StreamCapture capture;
+                    entry->lexer->printTables();
+                    entry->tables = capture.str();
+                }
+                payload += entry->tables;
+                return 0;
+            }
+            if (command == "parse") {
+                if (entry->treeText.empty()) {
+                    ostringstream text;
+                    TreePrinter(text).walk(entry->tree);
+                    entry->treeText = text.str();
+                }
+                payload += entry->treeText;
+                return 0;
+            }
+            if (entry->checkStatus < 0) {
+                ostringstream text;
+                entry->checkStatus = checkSemantics(entry->tree, text);
+                entry->diagnostics = text.str();
+            }
+            payload += entry->diagnostics;
+            return entry->checkStatus;
+        }
+
+        void serveConnection(int fd) {
+            string header;
+            while (!stopping && readHeader(fd, header)) {
+                istringstream fields(header);
+                string command;
+                long long pathLength = -1, bufferLength = -2;
+                fields >> command >> pathLength >> bufferLength;
+                if (!fields || pathLength < 0 || pathLength > PATH_MAX || bufferLength < -1 || bufferLength > maxRequestBuffer) {
+                    string error = "Error: Malformed request\n";
+                    writeAll(fd, "1 " + to_string(error.size()) + "\n" + error);
+                    break;
+                }
+                string path(pathLength, '\0'), buffer(max(0LL, bufferLength), '\0');
+                if (!readExactly(fd, &path[0], path.size()) || !readExactly(fd, &buffer[0], buffer.size())) break;
+
+                string payload;
+                int status;
+                {
+                    lock_guard<mutex> guard(requestLock);
+                    try {
+                        status = handle(command, path, bufferLength < 0 ? nullptr : &buffer, payload);
+                    } catch (const exception& e) {
+                        // An exception leaving this detached thread would end the server
+                        sources.erase(path);
+                        payload = string("Error: ") + e.what() + "\n";
+                        status = 1;
+                    }
+                }
+                if (!writeAll(fd, to_string(status) + " " + to_string(payload.size()) + "\n" + payload)) break;
+                if (stopping) {
+                    ::shutdown(listener, SHUT_RDWR); // wakes accept() in serve()
+                    break;
+                }
+            }
+            // Notified under the lock so that serve() cannot return, destroying this server,
+            // before the notification is done
+            lock_guard<mutex> guard(connectionLock);
+            connections.erase(fd);
+            close(fd);
+            connectionsClosed.notify_all();
+        }
+
+    public:
+        // Listens on 'socketPath' until a stop request, then waits for the open connections to
+        // close; returns the exit status
+        int serve(const string& socketPath) {
+            sockaddr_un address;
+            if (!socketAddress(socketPath, address)) return 1;
+            listener = socket(AF_UNIX, SOCK_STREAM, 0);
+            unlink(socketPath.c_str());
+            if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 16) != 0) {
+                cerr << "Error: Could not listen on " << socketPath << ": " << strerror(errno) << endl;
+                if (listener >= 0) close(listener);
+                return 1;
+            }
+            cout << "Serving on " << socketPath << endl;
+            while (!stopping) {
+                int fd = accept(listener, nullptr, nullptr);
+                if (fd < 0) {
+                    if (stopping || errno != EINTR) break;
+                    continue;
+                }
+                lock_guard<mutex> guard(connectionLock);
+                connections.insert(fd);
+                thread([this, fd] { serveConnection(fd); }).detach();
+            }
+            close(listener);
+            unlink(socketPath.c_str());
+
+            // The connection threads use this server, so wait for them: clients still connected
+            // see the end of their input, and a request in progress still gets its response
+            unique_lock<mutex> guard(connectionLock);
+            for (int fd : connections) ::shutdown(fd, SHUT_RD);
+            connectionsClosed.wait(guard, [this] { return connections.empty(); });
+            return 0;
+        }
+};
+
+int serveRequests(const string& socketPath) {
+    return CompileServer().serve(socketPath);
+}
+
+// Sends one request 'repeat' times over a single connection, prints the last payload and returns
+// its status. With more than one repetition the round-trip latencies go to cerr.
+int sendRequest(const string& socketPath, const string& command, const string& file, bool fromStdin, int repeat) {
+    // The server's working directory may differ from ours
+    string path = filesystem::absolute(file).string();
+    string buffer;
+    if (fromStdin) {
+        stringstream contents;
+        contents << cin.rdbuf();
+        buffer = contents.str();
+    }
+    string header = command + " " + to_string(path.size()) + " " + (fromStdin ? to_string(buffer.size()) : "-1") + "\n";
+    string request = header + path + buffer;
+
+    sockaddr_un address;
+    if (!socketAddress(socketPath, address)) return 1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        cerr << "Error: Could not connect to " << socketPath << ": " << strerror(errno) << endl;
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+
+    vector<double> latencies;
+    string payload;
+    int status = 1;
+    for (int k = 0; k < max(1, repeat); k++) {
+        auto start = chrono::steady_clock::now();
+        if (!writeAll(fd, request) || !readResponse(fd, status, payload)) {
+            cerr << "Error: The server closed the connection" << endl;
+            close(fd);
+            return 1;
+        }
+        latencies.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+    }
+    close(fd);
+    cout << payload;
+    if (latencies.size() > 1) {
+        sort(latencies.begin(), latencies.end());
+        cerr << fixed << setprecision(3) << latencies.size() << " requests: min " << latencies.front()
+             << " ms, median " << latencies[latencies.size() / 2] << " ms, max " << latencies.back() << " ms" << endl;
+    }
+    return status;
+}
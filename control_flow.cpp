@@ -0,0 +1,735 @@
+#include <memory>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <iostream>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+using namespace std;
+
+// Lowers the module body and every function into a control-flow graph of basic blocks and puts
+// it into SSA form. Everything is stored as flat index arrays: blocks, operations, variables and
+// SSA values are numbers, and the one-to-many relations (a block's operations and predecessors,
+// an operation's defined and used variables, a phi's arguments) are CSR ranges
+// [start[i], start[i + 1]) into a shared array, so a function with tens of thousands of
+// statements costs a handful of allocations.
+//
+// An operation is one statement or condition and keeps a pointer to its parse tree node;
+// expressions stay whole, so 'and', 'or' and conditional expressions are not split into blocks.
+
+const uint32_t NO_BLOCK = UINT32_MAX;
+const uint32_t NO_VALUE = UINT32_MAX;
+
+enum CfgOpKind : uint8_t {
+    CFG_ASSIGN, // Assignment: defines the plain-name targets
+    CFG_EVAL,   // expression or call statement
+    CFG_BRANCH, // if/elif/while condition; ends the block, successor 0 when true, 1 when false
+    CFG_RETURN, // ends the block, the successor is the exit block
+    CFG_ITER,   // evaluates a for loop's iterable
+    CFG_NEXT,   // for loop header; successor 0 takes the next item, 1 leaves when exhausted
+    CFG_BIND    // defines names from something other than an expression: the for target, def, class, import
+};
+
+enum SsaValueKind : uint8_t { SSA_ENTRY, SSA_OP, SSA_PHI };
+
+struct SsaValue {
+    uint32_t variable;
+    uint32_t block;
+    SsaValueKind kind;
+    uint32_t site; // defining operation or phi; unused for entry values
+};
+
+struct ControlFlowGraph {
+    string name;
+    ParseTreeNode* node = nullptr;  // the FunctionDefinition, or the Program for the module body
+    uint32_t parent = NO_BLOCK;     // graph of the enclosing scope; NO_BLOCK for the module
+    vector<string> variables;       // names bound in this scope; the parameters come first
+    uint32_t paramCount = 0;
+    bool starImport = false;        // 'from m import *' binds names only the module m knows
+
+    // Blocks: 0 is the entry and 1 the exit, both without operations
+    vector<uint32_t> blockOpStart;  // block b's operations are [blockOpStart[b], blockOpStart[b + 1])
+    vector<uint32_t> successors;    // two slots per block, NO_BLOCK when unused
+    vector<uint32_t> predStart, preds;
+
+    // Operations
+    vector<CfgOpKind> opKinds;
+    vector<ParseTreeNode*> opNodes;
+    vector<int> opLines;               // source line of the statement or clause each operation comes from
+    vector<uint32_t> opDefStart, defs; // variables each operation assigns
+    vector<uint32_t> opUseStart, uses; // local variables each operation reads, before its definitions
+    vector<pair<string, uint32_t>> freeUses; // names read that this scope does not bind, with the operation
+    vector<ParseTreeNode*> unreachable;      // first statement of each run after a return, break or continue
+
+    // Dominance over the blocks reachable from the entry
+    vector<uint32_t> rpo;              // reverse postorder
+    vector<uint32_t> idom;             // NO_BLOCK for the entry and for unreachable blocks
+    vector<uint32_t> frontierStart, frontier;
+
+    // SSA form. Values 0 .. variables.size() - 1 are each variable's value on entry: the argument
+    // for a parameter, unbound for anything else
+    vector<SsaValue> values;
+    vector<uint32_t> defValues, useValues; // parallel to defs and uses; NO_VALUE in unreachable blocks
+    vector<uint32_t> phiStart;             // block b's phis are [phiStart[b], phiStart[b + 1])
+    vector<uint32_t> phiVariable, phiValue;
+    vector<uint32_t> phiArgStart, phiArgs; // one argument per predecessor, in preds order
+
+    uint32_t blockCount() const { return (uint32_t)blockOpStart.size() - 1; }
+    uint32_t opCount() const { return (uint32_t)opKinds.size(); }
+    uint32_t phiCount() const { return (uint32_t)phiVariable.size(); }
+    bool reachable(uint32_t block) const { return block == 0 || idom[block] != NO_BLOCK; }
+};
+
+class ControlFlowBuilder {
+    private:
+        struct LoopContext {
+            uint32_t header;
+            vector<uint32_t> breaks; // blocks that jump to the loop's exit, which does not exist yet
+        };
+
+        ControlFlowGraph& cfg;
+        vector<shared_ptr<ParseTreeNode>>& nestedFunctions; // definitions found in this scope, lowered later
+        unordered_map<string, uint32_t> variableIds;
+        uint32_t current = NO_BLOCK; // block receiving operations; NO_BLOCK after a jump
+        int currentLine = 0;         // line of the statement being lowered
+        vector<LoopContext> loops;
+
+        // ---- Variables ----
+
+        uint32_t declare(const string& name) {
+            auto found = variableIds.find(name);
+            if (found != variableIds.end()) return found->second;
+            uint32_t id = (uint32_t)cfg.variables.size();
+            variableIds.emplace(name, id);
+            cfg.variables.push_back(name);
+            return id;
+        }
+
+        void declareImports(const shared_ptr<ParseTreeNode>& node) {
+            if (node->type == "ImportStatement") {
+                for (const string& name : importedNames(node)) declare(name);
+                return;
+            }
+            if (node->type == "FunctionDefinition" || node->type == "ClassDefinition") return;
+            for (const auto& child : node->children) declareImports(child);
+        }
+
+        // ---- Blocks and operations ----
+
+        uint32_t newBlock() {
+            cfg.blockOpStart.push_back(cfg.opCount());
+            cfg.successors.push_back(NO_BLOCK);
+            cfg.successors.push_back(NO_BLOCK);
+            return (uint32_t)cfg.blockOpStart.size() - 1; // the sentinel entry is added at the end
+        }
+
+        // Operations always go to the newest block, which keeps every block's operations contiguous
+        uint32_t startBlock() {
+            current = newBlock();
+            return current;
+        }
+
+        void addEdge(uint32_t from, uint32_t to) {
+            uint32_t* slots = &cfg.successors[2 * from];
+            if (slots[0] == NO_BLOCK) slots[0] = to;
+            else slots[1] = to;
+        }
+
+        // Jumps from each of 'sources' to a new block, which becomes the current one
+        void joinInto(const vector<uint32_t>& sources) {
+            if (sources.empty()) {
+                current = NO_BLOCK;
+                return;
+            }
+            uint32_t join = newBlock();
+            for (uint32_t source : sources) addEdge(source, join);
+            current = join;
+        }
+
+        void beginOp(CfgOpKind kind, const shared_ptr<ParseTreeNode>& node) {
+            cfg.opKinds.push_back(kind);
+            cfg.opNodes.push_back(node.get());
+            cfg.opLines.push_back(currentLine);
+            cfg.opDefStart.push_back((uint32_t)cfg.defs.size());
+            cfg.opUseStart.push_back((uint32_t)cfg.uses.size());
+        }
+
+        void addDef(const string& name) {
+            auto found = variableIds.find(name);
+            if (found != variableIds.end()) cfg.defs.push_back(found->second);
+        }
+
+        void addUse(const string& name) {
+            auto found = variableIds.find(name);
+            if (found != variableIds.end()) addUse(found->second);
+            else cfg.freeUses.push_back({name, cfg.opCount() - 1});
+        }
+
+        void addUse(uint32_t variable) {
+            for (uint32_t k = cfg.opUseStart.back(); k < cfg.uses.size(); k++) {
+                if (cfg.uses[k] == variable) return;
+            }
+            cfg.uses.push_back(variable);
+        }
+
+        // Names an expression reads; attribute names are not variables
+        void collectUses(const shared_ptr<ParseTreeNode>& node) {
+            const string& type = node->type;
+            if (type == "Identifier") {
+                addUse(node->value);
+            } else if (type == "AttributeAccess") {
+                collectUses(node->children[0]);
+            } else if (type == "DottedName") {
+                addUse(node->children[0]->value);
+            } else if (type == "Literal") {
+                // A malformed f-string has no segments: it fails when it runs and reads nothing before that
+                for (const auto& segment : literalOf(node).segments) {
+                    if (!segment.isExpression) continue;
+                    auto expression = parseEmbeddedExpression(segment.text);
+                    if (expression) collectUses(expression);
+                }
+            } else {
+                for (const auto& child : node->children) collectUses(child);
+            }
+        }
+
+        // ---- Statements ----
+
+        void lowerStatements(const shared_ptr<ParseTreeNode>& block) {
+            for (const auto& statement : block->children) {
+                if (isSyntaxLeaf(statement)) continue;
+                // Statements after a return, break or continue never run
+                if (current == NO_BLOCK) {
+                    cfg.unreachable.push_back(statement.get());
+                    return;
+                }
+                lowerStatement(statement);
+            }
+        }
+
+        void lowerStatement(const shared_ptr<ParseTreeNode>& node) {
+            const string& type = node->type;
+            currentLine = node->line;
+            if (type == "Assignment") {
+                lowerAssignment(node);
+            } else if (type == "IfStatement") {
+                lowerIf(node);
+            } else if (type == "WhileStatement") {
+                lowerWhile(node);
+            } else if (type == "ForStatement") {
+                lowerFor(node);
+            } else if (type == "ReturnStatement") {
+                beginOp(CFG_RETURN, node);
+                collectUses(node);
+                addEdge(current, 1);
+                current = NO_BLOCK;
+            } else if (type == "BreakStatement") {
+                if (loops.empty()) return;
+                loops.back().breaks.push_back(current);
+                current = NO_BLOCK;
+            } else if (type == "ContinueStatement") {
+                if (loops.empty()) return;
+                addEdge(current, loops.back().header);
+                current = NO_BLOCK;
+            } else if (type == "PassStatement") {
+                return;
+            } else if (type == "FunctionDefinition") {
+                beginOp(CFG_BIND, node);
+                addDef(findChild(node, "Identifier")->value);
+                nestedFunctions.push_back(node);
+            } else if (type == "ClassDefinition") {
+                beginOp(CFG_BIND, node);
+                auto parent = findChild(node, "Parent");
+                if (parent) addUse(parent->value);
+                addDef(findChild(node, "Identifier")->value);
+                // Class-level statements are not lowered; their methods get graphs of their own
+                collectMethods(findChild(node, "Suite"));
+            } else if (type == "ImportStatement") {
+                beginOp(CFG_BIND, node);
+                for (const string& name : importedNames(node)) addDef(name);
+                if (findChild(node, "ImportAll")) cfg.starImport = true;
+            } else {
+                beginOp(CFG_EVAL, node);
+                collectUses(node);
+            }
+        }
+
+        void collectMethods(const shared_ptr<ParseTreeNode>& node) {
+            for (const auto& child : node->children) {
+                if (child->type == "FunctionDefinition") nestedFunctions.push_back(child);
+                else collectMethods(child);
+            }
+        }
+
+        void lowerAssignment(const shared_ptr<ParseTreeNode>& node) {
+            beginOp(CFG_ASSIGN, node);
+            auto children = semanticChildren(node);
+            auto targets = children[0];
+            bool augmented = children[1]->value != "=";
+            collectUses(children[2]);
+            for (const auto& target : targets->children) {
+                if (target->type == "Identifier") {
+                    if (augmented) collectUses(target);
+                } else {
+                    collectUses(target); // the object or container an attribute or item is stored into
+                }
+            }
+            for (const auto& target : targets->children) {
+                if (target->type == "Identifier") addDef(target->value);
+            }
+        }
+
+        // Ends the current block with a branch on 'condition'; returns the branching block, whose
+        // true edge leads to the new current block
+        uint32_t lowerBranch(const shared_ptr<ParseTreeNode>& condition) {
+            beginOp(CFG_BRANCH, condition);
+            collectUses(condition);
+            uint32_t test = current;
+            addEdge(test, startBlock());
+            return test;
+        }
+
+        void lowerIf(const shared_ptr<ParseTreeNode>& node) {
+            auto children = semanticChildren(node);
+            vector<uint32_t> ends; // blocks that continue after the whole statement
+            uint32_t test = lowerBranch(children[0]);
+            lowerStatements(children[1]);
+            if (current != NO_BLOCK) ends.push_back(current);
+
+            for (size_t k = 2; k < children.size(); k++) {
+                auto clause = semanticChildren(children[k]);
+                startBlock();
+                addEdge(test, current);
+                if (children[k]->line) currentLine = children[k]->line;
+                if (children[k]->type == "ElifClause") {
+                    test = lowerBranch(clause[0]);
+                    lowerStatements(clause[1]);
+                } else {
+                    test = NO_BLOCK;
+                    lowerStatements(clause[0]);
+                }
+                if (current != NO_BLOCK) ends.push_back(current);
+            }
+            // Without an else clause the last condition's false edge skips to the join
+            if (test != NO_BLOCK) ends.push_back(test);
+            joinInto(ends);
+        }
+
+        void lowerWhile(const shared_ptr<ParseTreeNode>& node) {
+            auto children = semanticChildren(node);
+            uint32_t entry = current;
+            uint32_t header = startBlock();
+            addEdge(entry, header);
+            lowerBranch(children[0]);
+            loops.push_back({header, {}});
+            lowerStatements(children[1]);
+            if (current != NO_BLOCK) addEdge(current, header);
+            vector<uint32_t> exits = move(loops.back().breaks);
+            loops.pop_back();
+            // 'while True' is only left by a break
+            bool forever = children[0]->type == "Keyword" && children[0]->value == "True";
+            if (!forever) exits.insert(exits.begin(), header);
+            joinInto(exits);
+        }
+
+        void lowerFor(const shared_ptr<ParseTreeNode>& node) {
+            auto children = semanticChildren(node); // target, iterable, body
+            beginOp(CFG_ITER, children[1]);
+            collectUses(children[1]);
+            uint32_t entry = current;
+            uint32_t header = startBlock();
+            addEdge(entry, header);
+            beginOp(CFG_NEXT, node);
+            addEdge(header, startBlock());
+            beginOp(CFG_BIND, children[0]);
+            addDef(children[0]->value);
+            loops.push_back({header, {}});
+            lowerStatements(children[2]);
+            if (current != NO_BLOCK) addEdge(current, header);
+            vector<uint32_t> exits = move(loops.back().breaks);
+            loops.pop_back();
+            exits.insert(exits.begin(), header);
+            joinInto(exits);
+        }
+
+        // ---- Dominance ----
+
+        void computePredecessors() {
+            uint32_t blocks = cfg.blockCount();
+            cfg.predStart.assign(blocks + 1, 0);
+            for (uint32_t successor : cfg.successors) {
+                if (successor != NO_BLOCK) cfg.predStart[successor + 1]++;
+            }
+            for (uint32_t b = 0; b < blocks; b++) cfg.predStart[b + 1] += cfg.predStart[b];
+            cfg.preds.resize(cfg.predStart[blocks]);
+            vector<uint32_t> fill(cfg.predStart.begin(), cfg.predStart.end() - 1);
+            for (uint32_t b = 0; b < blocks; b++) {
+                for (int slot = 0; slot < 2; slot++) {
+                    uint32_t successor = cfg.successors[2 * b + slot];
+                    if (successor != NO_BLOCK) cfg.preds[fill[successor]++] = b;
+                }
+            }
+        }
+
+        void computeReversePostorder() {
+            uint32_t blocks = cfg.blockCount();
+            vector<uint8_t> visited(blocks, 0);
+            vector<pair<uint32_t, int>> stack; // block, next successor slot
+            stack.push_back({0, 0});
+            visited[0] = 1;
+            while (!stack.empty()) {
+                auto& top = stack.back();
+                if (top.second < 2) {
+                    uint32_t successor = cfg.successors[2 * top.first + top.second++];
+                    if (successor != NO_BLOCK && !visited[successor]) {
+                        visited[successor] = 1;
+                        stack.push_back({successor, 0});
+                    }
+                } else {
+                    cfg.rpo.push_back(top.first);
+                    stack.pop_back();
+                }
+            }
+            reverse(cfg.rpo.begin(), cfg.rpo.end());
+        }
+
+        // Cooper, Harvey and Kennedy's iterative algorithm over the reverse postorder
+        void computeDominators() {
+            uint32_t blocks = cfg.blockCount();
+            vector<uint32_t> order(blocks, NO_BLOCK);
+            for (uint32_t k = 0; k < cfg.rpo.size(); k++) order[cfg.rpo[k]] = k;
+            cfg.idom.assign(blocks, NO_BLOCK);
+            cfg.idom[0] = 0;
+            bool changed = true;
+            while (changed) {
+                changed = false;
+                for (size_t k = 1; k < cfg.rpo.size(); k++) {
+                    uint32_t b = cfg.rpo[k];
+                    uint32_t dominator = NO_BLOCK;
+                    for (uint32_t p = cfg.predStart[b]; p < cfg.predStart[b + 1]; p++) {
+                        uint32_t pred = cfg.preds[p];
+                        if (cfg.idom[pred] == NO_BLOCK) continue;
+                        if (dominator == NO_BLOCK) {
+                            dominator = pred;
+                            continue;
+                        }
+                        uint32_t other = pred;
+                        while (dominator != other) {
+                            while (order[dominator] > order[other]) dominator = cfg.idom[dominator];
+                            while (order[other] > order[dominator]) other = cfg.idom[other];
+                        }
+                    }
+                    if (cfg.idom[b] != dominator) {
+                        cfg.idom[b] = dominator;
+                        changed = true;
+                    }
+                }
+            }
+            cfg.idom[0] = NO_BLOCK;
+        }
+
+        void computeFrontiers() {
+            uint32_t blocks = cfg.blockCount();
+            vector<vector<uint32_t>> frontiers(blocks);
+            for (uint32_t b : cfg.rpo) {
+                if (cfg.predStart[b + 1] - cfg.predStart[b] < 2) continue;
+                for (uint32_t p = cfg.predStart[b]; p < cfg.predStart[b + 1]; p++) {
+                    uint32_t runner = cfg.preds[p];
+                    if (!cfg.reachable(runner)) continue;
+                    while (runner != cfg.idom[b]) {
+                        // b is visited once, so a repeat can only be the last entry
+                        if (frontiers[runner].empty() || frontiers[runner].back() != b) frontiers[runner].push_back(b);
+                        runner = cfg.idom[runner];
+                    }
+                }
+            }
+            cfg.frontierStart.assign(blocks + 1, 0);
+            for (uint32_t b = 0; b < blocks; b++) {
+                cfg.frontierStart[b + 1] = cfg.frontierStart[b] + (uint32_t)frontiers[b].size();
+                cfg.frontier.insert(cfg.frontier.end(), frontiers[b].begin(), frontiers[b].end());
+            }
+        }
+
+        // ---- SSA ----
+
+        // Semi-pruned placement: only variables read in some block before that block assigns them
+        // can need a phi, and they get one at the iterated dominance frontier of their definitions
+        void placePhis() {
+            uint32_t blocks = cfg.blockCount();
+            uint32_t variableCount = (uint32_t)cfg.variables.size();
+            vector<uint8_t> crossesBlocks(variableCount, 0);
+            vector<uint32_t> definedIn(variableCount, NO_BLOCK);
+            vector<vector<uint32_t>> defBlocks(variableCount);
+            for (uint32_t b : cfg.rpo) {
+                for (uint32_t op = cfg.blockOpStart[b]; op < cfg.blockOpStart[b + 1]; op++) {
+                    for (uint32_t u = cfg.opUseStart[op]; u < cfg.opUseStart[op + 1]; u++) {
+                        if (definedIn[cfg.uses[u]] != b) crossesBlocks[cfg.uses[u]] = 1;
+                    }
+                    for (uint32_t d = cfg.opDefStart[op]; d < cfg.opDefStart[op + 1]; d++) {
+                        uint32_t variable = cfg.defs[d];
+                        if (definedIn[variable] != b) defBlocks[variable].push_back(b);
+                        definedIn[variable] = b;
+                    }
+                }
+            }
+
+            vector<pair<uint32_t, uint32_t>> placed; // block, variable
+            vector<uint32_t> hasPhi(blocks, NO_VALUE), queued(blocks, NO_VALUE);
+            vector<uint32_t> worklist;
+            for (uint32_t variable = 0; variable < variableCount; variable++) {
+                if (!crossesBlocks[variable]) continue;
+                worklist = defBlocks[variable];
+                for (uint32_t b : worklist) queued[b] = variable;
+                while (!worklist.empty()) {
+                    uint32_t b = worklist.back();
+                    worklist.pop_back();
+                    for (uint32_t f = cfg.frontierStart[b]; f < cfg.frontierStart[b + 1]; f++) {
+                        uint32_t target = cfg.frontier[f];
+                        if (hasPhi[target] == variable) continue;
+                        hasPhi[target] = variable;
+                        placed.push_back({target, variable});
+                        if (queued[target] != variable) {
+                            queued[target] = variable;
+                            worklist.push_back(target);
+                        }
+                    }
+                }
+            }
+
+            // Group the phis by block
+            cfg.phiStart.assign(blocks + 1, 0);
+            for (const auto& phi : placed) cfg.phiStart[phi.first + 1]++;
+            for (uint32_t b = 0; b < blocks; b++) cfg.phiStart[b + 1] += cfg.phiStart[b];
+            cfg.phiVariable.resize(placed.size());
+            vector<uint32_t> fill(cfg.phiStart.begin(), cfg.phiStart.end() - 1);
+            for (const auto& phi : placed) cfg.phiVariable[fill[phi.first]++] = phi.second;
+
+            cfg.phiValue.resize(placed.size());
+            cfg.phiArgStart.assign(placed.size() + 1, 0);
+            for (uint32_t b = 0; b < blocks; b++) {
+                for (uint32_t phi = cfg.phiStart[b]; phi < cfg.phiStart[b + 1]; phi++) {
+                    cfg.phiValue[phi] = (uint32_t)cfg.values.size();
+                    cfg.values.push_back({cfg.phiVariable[phi], b, SSA_PHI, phi});
+                    cfg.phiArgStart[phi + 1] = cfg.phiArgStart[phi] + cfg.predStart[b + 1] - cfg.predStart[b];
+                }
+            }
+            cfg.phiArgs.assign(cfg.phiArgStart.back(), NO_VALUE);
+        }
+
+        // Walks the dominator tree with an explicit stack, keeping each variable's reaching value
+        // in one array and undoing a block's definitions when its subtree is done
+        void renameVariables() {
+            uint32_t blocks = cfg.blockCount();
+            vector<uint32_t> childStart(blocks + 1, 0), children;
+            for (uint32_t b : cfg.rpo) {
+                if (cfg.idom[b] != NO_BLOCK) childStart[cfg.idom[b] + 1]++;
+            }
+            for (uint32_t b = 0; b < blocks; b++) childStart[b + 1] += childStart[b];
+            children.resize(childStart[blocks]);
+            vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+            for (uint32_t b : cfg.rpo) {
+                if (cfg.idom[b] != NO_BLOCK) children[fill[cfg.idom[b]]++] = b;
+            }
+
+            vector<uint32_t> reaching(cfg.variables.size());
+            for (uint32_t variable = 0; variable < reaching.size(); variable++) reaching[variable] = variable;
+            vector<pair<uint32_t, uint32_t>> undo; // variable, value it had before
+            cfg.defValues.assign(cfg.defs.size(), NO_VALUE);
+            cfg.useValues.assign(cfg.uses.size(), NO_VALUE);
+
+            struct Frame { uint32_t block, nextChild, undoMark; };
+            vector<Frame> stack;
+            auto enter = [&](uint32_t b) {
+                stack.push_back({b, childStart[b], (uint32_t)undo.size()});
+                for (uint32_t phi = cfg.phiStart[b]; phi < cfg.phiStart[b + 1]; phi++) {
+                    undo.push_back({cfg.phiVariable[phi], reaching[cfg.phiVariable[phi]]});
+                    reaching[cfg.phiVariable[phi]] = cfg.phiValue[phi];
+                }
+                for (uint32_t op = cfg.blockOpStart[b]; op < cfg.blockOpStart[b + 1]; op++) {
+                    for (uint32_t u = cfg.opUseStart[op]; u < cfg.opUseStart[op + 1]; u++) {
+                        cfg.useValues[u] = reaching[cfg.uses[u]];
+                    }
+                    for (uint32_t d = cfg.opDefStart[op]; d < cfg.opDefStart[op + 1]; d++) {
+                        uint32_t variable = cfg.defs[d];
+                        cfg.defValues[d] = (uint32_t)cfg.values.size();
+                        cfg.values.push_back({variable, b, SSA_OP, op});
+                        undo.push_back({variable, reaching[variable]});
+                        reaching[variable] = cfg.defValues[d];
+                    }
+                }
+                for (int slot = 0; slot < 2; slot++) {
+                    uint32_t successor = cfg.successors[2 * b + slot];
+                    if (successor == NO_BLOCK) continue;
+                    for (uint32_t p = cfg.predStart[successor]; p < cfg.predStart[successor + 1]; p++) {
+                        if (cfg.preds[p] != b) continue;
+                        uint32_t position = p - cfg.predStart[successor];
+                        for (uint32_t phi = cfg.phiStart[successor]; phi < cfg.phiStart[successor + 1]; phi++) {
+                            cfg.phiArgs[cfg.phiArgStart[phi] + position] = reaching[cfg.phiVariable[phi]];
+                        }
+                    }
+                }
+            };
+            enter(0);
+            while (!stack.empty()) {
+                Frame& top = stack.back();
+                if (top.nextChild < childStart[top.block + 1]) {
+                    enter(children[top.nextChild++]);
+                    continue;
+                }
+                while (undo.size() > top.undoMark) {
+                    reaching[undo.back().first] = undo.back().second;
+                    undo.pop_back();
+                }
+                stack.pop_back();
+            }
+        }
+
+    public:
+        ControlFlowBuilder(ControlFlowGraph& graph, vector<shared_ptr<ParseTreeNode>>& nested)
+            : cfg(graph), nestedFunctions(nested) {}
+
+        void build(const shared_ptr<ParseTreeNode>& node) {
+            cfg.node = node.get();
+            shared_ptr<ParseTreeNode> body = node;
+            if (node->type == "FunctionDefinition") {
+                cfg.name = findChild(node, "Identifier")->value;
+                auto params = findChild(node, "Parameters");
+                if (params) {
+                    for (const auto& param : params->children) {
+                        if (param->type == "Parameter") declare(param->value);
+                    }
+                }
+                body = findChild(node, "Suite");
+            } else {
+                cfg.name = "<module>";
+            }
+            cfg.paramCount = (uint32_t)cfg.variables.size();
+            vector<string> bound;
+            collectBoundNames(body, bound);
+            for (const string& name : bound) declare(name);
+            declareImports(body);
+
+            newBlock(); // entry
+            newBlock(); // exit
+            addEdge(0, startBlock());
+            lowerStatements(body);
+            if (current != NO_BLOCK) addEdge(current, 1);
+            cfg.blockOpStart.push_back(cfg.opCount());
+            cfg.opDefStart.push_back((uint32_t)cfg.defs.size());
+            cfg.opUseStart.push_back((uint32_t)cfg.uses.size());
+
+            computePredecessors();
+            computeReversePostorder();
+            computeDominators();
+            computeFrontiers();
+            for (uint32_t variable = 0; variable < cfg.variables.size(); variable++) {
+                cfg.values.push_back({variable, 0, SSA_ENTRY, 0});
+            }
+            placePhis();
+            renameVariables();
+        }
+};
+
+// Graphs for the module body (first) and every function and method, in the order found
+vector<ControlFlowGraph> buildControlFlow(const shared_ptr<ParseTreeNode>& program) {
+    vector<ControlFlowGraph> graphs;
+    vector<shared_ptr<ParseTreeNode>> pending;
+    vector<uint32_t> parents; // graph that found each pending definition
+    graphs.emplace_back();
+    ControlFlowBuilder(graphs.back(), pending).build(program);
+    parents.resize(pending.size(), 0);
+    for (size_t next = 0; next < pending.size(); next++) {
+        // Copied out since building may add to 'pending'
+        shared_ptr<ParseTreeNode> function = pending[next];
+        graphs.emplace_back();
+        graphs.back().parent = parents[next];
+        ControlFlowBuilder(graphs.back(), pending).build(function);
+        parents.resize(pending.size(), (uint32_t)graphs.size() - 1);
+    }
+    return graphs;
+}
+
+// ---- Printing ----
+
+const char* cfgOpName(CfgOpKind kind) {
+    switch (kind) {
+        case CFG_ASSIGN: return "assign";
+        case CFG_EVAL: return "eval";
+        case CFG_BRANCH: return "branch";
+        case CFG_RETURN: return "return";
+        case CFG_ITER: return "iter";
+        case CFG_NEXT: return "next";
+        case CFG_BIND: return "bind";
+    }
+    return "?";
+}
+
+void printControlFlow(const ControlFlowGraph& cfg, ostream& out) {
+    // Values print as name.version, versions counted per variable in reverse postorder
+    vector<uint32_t> version(cfg.values.size(), 0), counts(cfg.variables.size(), 1);
+    for (uint32_t b : cfg.rpo) {
+        for (uint32_t phi = cfg.phiStart[b]; phi < cfg.phiStart[b + 1]; phi++) {
+            version[cfg.phiValue[phi]] = counts[cfg.phiVariable[phi]]++;
+        }
+        for (uint32_t d = cfg.opDefStart[cfg.blockOpStart[b]]; d < cfg.opDefStart[cfg.blockOpStart[b + 1]]; d++) {
+            version[cfg.defValues[d]] = counts[cfg.defs[d]]++;
+        }
+    }
+    auto valueName = [&](uint32_t value) {
+        if (value == NO_VALUE) return string("?");
+        return cfg.variables[cfg.values[value].variable] + "." + to_string(version[value]);
+    };
+
+    out << "function " << cfg.name << "(";
+    for (uint32_t k = 0; k < cfg.paramCount; k++) out << (k ? ", " : "") << cfg.variables[k];
+    out << "): " << cfg.blockCount() << " blocks, " << cfg.opCount() << " operations, "
+        << cfg.phiCount() << " phis, " << cfg.values.size() << " values" << endl;
+
+    for (uint32_t b = 0; b < cfg.blockCount(); b++) {
+        if (!cfg.reachable(b)) continue;
+        out << "  B" << b << (b == 0 ? " (entry)" : b == 1 ? " (exit)" : "");
+        if (cfg.predStart[b + 1] > cfg.predStart[b]) {
+            out << " <-";
+            for (uint32_t p = cfg.predStart[b]; p < cfg.predStart[b + 1]; p++) out << " B" << cfg.preds[p];
+        }
+        if (cfg.idom[b] != NO_BLOCK) out << "  idom B" << cfg.idom[b];
+        if (cfg.frontierStart[b + 1] > cfg.frontierStart[b]) {
+            out << "  df";
+            for (uint32_t f = cfg.frontierStart[b]; f < cfg.frontierStart[b + 1]; f++) out << " B" << cfg.frontier[f];
+        }
+        out << endl;
+        for (uint32_t phi = cfg.phiStart[b]; phi < cfg.phiStart[b + 1]; phi++) {
+            out << "      " << valueName(cfg.phiValue[phi]) << " = phi(";
+            for (uint32_t a = cfg.phiArgStart[phi]; a < cfg.phiArgStart[phi + 1]; a++) {
+                out << (a > cfg.phiArgStart[phi] ? ", " : "") << valueName(cfg.phiArgs[a]);
+            }
+            out << ")" << endl;
+        }
+        for (uint32_t op = cfg.blockOpStart[b]; op < cfg.blockOpStart[b + 1]; op++) {
+            out << "      ";
+            for (uint32_t d = cfg.opDefStart[op]; d < cfg.opDefStart[op + 1]; d++) {
+                out << (d > cfg.opDefStart[op] ? ", " : "") << valueName(cfg.defValues[d]);
+            }
+            if (cfg.opDefStart[op + 1] > cfg.opDefStart[op]) out << " = ";
+            out << cfgOpName(cfg.opKinds[op]);
+            for (uint32_t u = cfg.opUseStart[op]; u < cfg.opUseStart[op + 1]; u++) {
+                out << (u > cfg.opUseStart[op] ? ", " : " ") << valueName(cfg.useValues[u]);
+            }
+            out << endl;
+        }
+        const uint32_t* next = &cfg.successors[2 * b];
+        if (next[0] != NO_BLOCK) {
+            out << "      -> B" << next[0];
+            if (next[1] != NO_BLOCK) out << ", B" << next[1];
+            out << endl;
+        }
+    }
+}
+
+void printControlFlow(const shared_ptr<ParseTreeNode>& program, ostream& out) {
+    for (const auto& graph : buildControlFlow(program)) {
+        printControlFlow(graph, out);
+        out << endl;
+    }
+}
@@ -0,0 +1,250 @@
+#include <memory>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <iostream>
+#include <cstdint>
+#include <algorithm>
+using namespace std;
+
+// Semantic checks over the control-flow graphs: names read before they are assigned or not
+// defined anywhere, assignments whose value is never read, and statements that can never run.
+//
+// Reaching definitions and liveness are solved per function over bitsets with one bit per
+// variable, so a transfer or meet is a few word-wide ANDs and ORs over a block's row instead of
+// per-name lookups. Reaching definitions only has to tell whether the unbound value a variable
+// holds on entry can still reach a use, which is why one bit per variable is enough rather than
+// one per assignment. Blocks are visited in reverse postorder (forward) or postorder (backward),
+// which settles in a couple of passes per loop nesting level.
+
+struct Diagnostic {
+    int line;
+    bool error;      // fails whenever the statement runs, rather than only looking like a mistake
+    string function; // name of the graph it was found in
+    string message;
+};
+
+// Equal-width bitsets stored back to back, one row per block
+class BlockBitSets {
+    private:
+        size_t words;
+        vector<uint64_t> bits;
+
+    public:
+        BlockBitSets(size_t rows, size_t width, bool filled = false)
+            : words((width + 63) / 64), bits(rows * words, filled ? ~uint64_t(0) : 0) {}
+
+        size_t wordCount() const { return words; }
+        uint64_t* operator[](size_t row) { return bits.data() + row * words; }
+        const uint64_t* operator[](size_t row) const { return bits.data() + row * words; }
+};
+
+inline bool testBit(const uint64_t* set, uint32_t bit) { return (set[bit >> 6] >> (bit & 63)) & 1; }
+inline void setBit(uint64_t* set, uint32_t bit) { set[bit >> 6] |= uint64_t(1) << (bit & 63); }
+inline void clearBit(uint64_t* set, uint32_t bit) { set[bit >> 6] &= ~(uint64_t(1) << (bit & 63)); }
+
+class DataflowChecker {
+    private:
+        const vector<ControlFlowGraph>& graphs;
+        const unordered_set<string>* starImports; // module names bound by 'from m import *', when known
+        vector<unordered_map<string, uint32_t>> variableIds; // per graph
+        vector<vector<uint8_t>> captured; // per graph, the variables a nested function reads
+        vector<Diagnostic> diagnostics;
+
+        void report(const ControlFlowGraph& cfg, int line, bool error, const string& message) {
+            diagnostics.push_back({line, error, cfg.name, message});
+        }
+
+        // Free names resolve through the enclosing functions to the module, then to the builtins,
+        // '__name__', which the backends define, and names a star import brings in. A hit in an enclosing function marks that variable
+        // as read from outside its own graph
+        void resolveFreeNames() {
+            for (const auto& cfg : graphs) {
+                unordered_map<string, uint32_t> ids;
+                for (uint32_t variable = 0; variable < cfg.variables.size(); variable++) ids.emplace(cfg.variables[variable], variable);
+                variableIds.push_back(move(ids));
+                captured.emplace_back(cfg.variables.size(), 0);
+            }
+            // Without the imported modules' names a star import could bind anything
+            bool unknownStarNames = !starImports && graphs[0].starImport;
+            for (const auto& cfg : graphs) {
+                unordered_set<string> seen;
+                for (const auto& use : cfg.freeUses) {
+                    if (!seen.insert(use.first).second) continue;
+                    bool found = false;
+                    for (uint32_t scope = cfg.parent; scope != NO_BLOCK && !found; scope = graphs[scope].parent) {
+                        auto variable = variableIds[scope].find(use.first);
+                        if (variable == variableIds[scope].end()) continue;
+                        found = true;
+                        captured[scope][variable->second] = 1;
+                    }
+                    if (!found && !unknownStarNames && findBuiltin(use.first) < 0 && use.first != "__name__" &&
+                        !(starImports && starImports->count(use.first))) {
+                        report(cfg, cfg.opLines[use.second], true, "name '" + use.first + "' is not defined");
+                    }
+                }
+            }
+        }
+
+        void checkGraph(uint32_t g) {
+            const ControlFlowGraph& cfg = graphs[g];
+            uint32_t blocks = cfg.blockCount();
+            uint32_t variableCount = (uint32_t)cfg.variables.size();
+
+            // Per block: the variables it assigns, and those it reads before assigning them
+            BlockBitSets defined(blocks, variableCount), exposed(blocks, variableCount);
+            size_t words = defined.wordCount();
+            for (uint32_t b : cfg.rpo) {
+                for (uint32_t op = cfg.blockOpStart[b]; op < cfg.blockOpStart[b + 1]; op++) {
+                    for (uint32_t u = cfg.opUseStart[op]; u < cfg.opUseStart[op + 1]; u++) {
+                        if (!testBit(defined[b], cfg.uses[u])) setBit(exposed[b], cfg.uses[u]);
+                    }
+                    for (uint32_t d = cfg.opDefStart[op]; d < cfg.opDefStart[op + 1]; d++) setBit(defined[b], cfg.defs[d]);
+                }
+            }
+
+            // Reaching definitions, forward. A bit is set at a block's end while the entry value
+            // of that variable still reaches there on some path (maybeUnbound) or on every path (unbound)
+            BlockBitSets maybeUnbound(blocks, variableCount), unbound(blocks, variableCount, true);
+            for (uint32_t variable = 0; variable < variableCount; variable++) {
+                if (variable < cfg.paramCount) clearBit(unbound[0], variable);
+                else setBit(maybeUnbound[0], variable);
+            }
+            vector<uint64_t> someIn(words), allIn(words);
+            auto meetPredecessors = [&](uint32_t b) {
+                fill(someIn.begin(), someIn.end(), 0);
+                fill(allIn.begin(), allIn.end(), ~uint64_t(0));
+                for (uint32_t p = cfg.predStart[b]; p < cfg.predStart[b + 1]; p++) {
+                    uint32_t pred = cfg.preds[p];
+                    if (!cfg.reachable(pred)) continue;
+                    for (size_t w = 0; w < words; w++) {
+                        someIn[w] |= maybeUnbound[pred][w];
+                        allIn[w] &= unbound[pred][w];
+                    }
+                }
+            };
+            bool changed = true;
+            while (changed) {
+                changed = false;
+                for (size_t k = 1; k < cfg.rpo.size(); k++) {
+                    uint32_t b = cfg.rpo[k];
+                    meetPredecessors(b);
+                    for (size_t w = 0; w < words; w++) {
+                        uint64_t some = someIn[w] & ~defined[b][w], all = allIn[w] & ~defined[b][w];
+                        if (some != maybeUnbound[b][w] || all != unbound[b][w]) changed = true;
+                        maybeUnbound[b][w] = some;
+                        unbound[b][w] = all;
+                    }
+                }
+            }
+
+            vector<uint8_t> reported(variableCount, 0);
+            for (size_t k = 1; k < cfg.rpo.size(); k++) {
+                uint32_t b = cfg.rpo[k];
+                meetPredecessors(b);
+                for (uint32_t op = cfg.blockOpStart[b]; op < cfg.blockOpStart[b + 1]; op++) {
+                    for (uint32_t u = cfg.opUseStart[op]; u < cfg.opUseStart[op + 1]; u++) {
+                        uint32_t variable = cfg.uses[u];
+                        if (!testBit(someIn.data(), variable) || reported[variable]) continue;
+                        reported[variable] = 1;
+                        // Only a warning: the read may sit in a branch of a conditional expression,
+                        // which is not split into blocks
+                        bool always = testBit(allIn.data(), variable);
+                        report(cfg, cfg.opLines[op], false, "'" + cfg.variables[variable] + "' " +
+                               (always ? "is" : "may be") + " used before it is assigned");
+                    }
+                    for (uint32_t d = cfg.opDefStart[op]; d < cfg.opDefStart[op + 1]; d++) {
+                        clearBit(someIn.data(), cfg.defs[d]);
+                        clearBit(allIn.data(), cfg.defs[d]);
+                    }
+                }
+            }
+
+            for (ParseTreeNode* statement : cfg.unreachable) report(cfg, statement->line, false, "unreachable code");
+
+            // Module variables are globals that functions and importers may read, so only
+            // function locals can be reported as unused
+            if (g == 0) return;
+
+            // Liveness, backward
+            BlockBitSets liveIn(blocks, variableCount);
+            vector<uint64_t> live(words);
+            auto meetSuccessors = [&](uint32_t b) {
+                fill(live.begin(), live.end(), 0);
+                for (int slot = 0; slot < 2; slot++) {
+                    uint32_t successor = cfg.successors[2 * b + slot];
+                    if (successor == NO_BLOCK) continue;
+                    for (size_t w = 0; w < words; w++) live[w] |= liveIn[successor][w];
+                }
+            };
+            changed = true;
+            while (changed) {
+                changed = false;
+                for (size_t k = cfg.rpo.size(); k-- > 0;) {
+                    uint32_t b = cfg.rpo[k];
+                    meetSuccessors(b);
+                    for (size_t w = 0; w < words; w++) {
+                        uint64_t in = exposed[b][w] | (live[w] & ~defined[b][w]);
+                        if (in != liveIn[b][w]) changed = true;
+                        liveIn[b][w] = in;
+                    }
+                }
+            }
+
+            vector<uint8_t> read(variableCount, 0);
+            for (uint32_t b : cfg.rpo) {
+                for (uint32_t u = cfg.opUseStart[cfg.blockOpStart[b]]; u < cfg.opUseStart[cfg.blockOpStart[b + 1]]; u++) read[cfg.uses[u]] = 1;
+            }
+            fill(reported.begin(), reported.end(), 0);
+            for (uint32_t b : cfg.rpo) {
+                meetSuccessors(b);
+                for (uint32_t op = cfg.blockOpStart[b + 1]; op-- > cfg.blockOpStart[b];) {
+                    // Unpacking into several names is left alone: one of them is often a placeholder
+                    if (cfg.opKinds[op] == CFG_ASSIGN && cfg.opDefStart[op + 1] - cfg.opDefStart[op] == 1) {
+                        uint32_t variable = cfg.defs[cfg.opDefStart[op]];
+                        const string& name = cfg.variables[variable];
+                        if (!testBit(live.data(), variable) && !captured[g][variable] && name[0] != '_') {
+                            if (read[variable]) {
+                                report(cfg, cfg.opLines[op], false, "value assigned to '" + name + "' is never used");
+                            } else if (!reported[variable]) {
+                                reported[variable] = 1;
+                                report(cfg, cfg.opLines[op], false, "'" + name + "' is assigned but never used");
+                            }
+                        }
+                    }
+                    for (uint32_t d = cfg.opDefStart[op]; d < cfg.opDefStart[op + 1]; d++) clearBit(live.data(), cfg.defs[d]);
+                    for (uint32_t u = cfg.opUseStart[op]; u < cfg.opUseStart[op + 1]; u++) setBit(live.data(), cfg.uses[u]);
+                }
+            }
+        }
+
+    public:
+        DataflowChecker(const vector<ControlFlowGraph>& cfgs, const unordered_set<string>* starNames = nullptr)
+            : graphs(cfgs), starImports(starNames) {}
+
+        // Diagnostics for every graph, ordered by line
+        vector<Diagnostic> check() {
+            resolveFreeNames();
+            for (uint32_t g = 0; g < graphs.size(); g++) checkGraph(g);
+            stable_sort(diagnostics.begin(), diagnostics.end(),
+                        [](const Diagnostic& a, const Diagnostic& b) { return a.line < b.line; });
+            return move(diagnostics);
+        }
+};
+
+string formatDiagnostic(const Diagnostic& diagnostic) {
+    return string(diagnostic.error ? "Error" : "Warning") + " at line " + to_string(diagnostic.line) +
+           " in '" + diagnostic.function + "': " + diagnostic.message;
+}
+
+// Prints the program's diagnostics; returns 1 when any of them is an error, 0 otherwise
+int checkSemantics(const shared_ptr<ParseTreeNode>& program, ostream& out) {
+    auto graphs = buildControlFlow(program);
+    int status = 0;
+    for (const auto& diagnostic : DataflowChecker(graphs).check()) {
+        out << formatDiagnostic(diagnostic) << endl;
+        if (diagnostic.error) status = 1;
+    }
+    return status;
+}
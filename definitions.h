@@ -2,6 +2,7 @@
 #define DEFINITIONS_H
 
 #include <string>
+#include <memory>
 #include <unordered_set>
 using namespace std;
 
@@ -9,10 +10,13 @@ enum TokenType {
     IDENTIFIER, KEYWORD, OPERATOR, LITERAL, DELIMITER, ERROR, INDENT, DEDENT, NEWLINE
 };
 
+struct LiteralValue;
+
 struct Token {
     TokenType type;
     std::string value;
     int line;
+    std::shared_ptr<const LiteralValue> literal = nullptr; // decoded value of a LITERAL token (literals.h)
 };
 
 struct Identifier {
@@ -37,17 +41,19 @@ inline std::string tokenTypeToString(TokenType type) {
     }
 }
 
-unordered_set<string> builtInFunctions = {
+// inline so that every translation unit including this header shares one definition
+inline const unordered_set<string> builtInFunctions = {
     "print", "input", "lower", "upper", "len", "range", "str", "int", "float", "bool", "list", "dict", "set", "tuple"
 };
 
-unordered_set<string> keywords = {
+inline const unordered_set<string> keywords = {
     "import", "from", "as",
     "if", "elif", "else",
     "for", "while", "break", "continue", "pass",
     "def", "class", 
     "return", "yield",
-    "True", "False", "None"
+    "True", "False", "None",
+    "and", "or", "not", "in"
 };
 
 
@@ -0,0 +1,835 @@
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+using namespace std;
+
+// Closure-compiling evaluator: every node is turned once into a C++ closure with its operator,
+// variable slot and call target already resolved, so running the program never inspects a node
+// type string again. Building closures is far cheaper than emitting bytecode, which makes this
+// the fastest tier to a first result on short scripts.
+
+enum EvalFlow { FLOW_NEXT, FLOW_BREAK, FLOW_CONTINUE, FLOW_RETURN };
+
+// Closures receive the current frame's local slots
+typedef function<Value(Value* locals)> EvalExpr;
+typedef function<EvalFlow(Value* locals)> EvalStmt;
+typedef function<void(Value* locals, Value value)> EvalStore;
+
+struct EvalFunction {
+    string name;
+    int arity = 0;
+    int numLocals = 0;
+    EvalStmt body;
+};
+
+class ClosureEvaluator {
+    private:
+        struct Scope {
+            bool isModule;
+            unordered_map<string, int> locals;
+            int loopDepth = 0;
+        };
+
+        static const int maxDepth = 1000;
+
+        const vector<Identifier>& symbols;
+        deque<Value> globals;          // a deque so captured slot addresses survive new globals
+        unordered_map<string, Value*> globalSlots;
+        unordered_set<string> moduleBound;
+        deque<EvalFunction> functions; // indexed by FunctionObject::index
+        Scope* scope = nullptr;
+
+        // Argument and local slots of active calls; everything at or above 'top' is undefined
+        vector<Value> stack;
+        Value* top;
+        int depth = 0;
+        Value returnValue;
+
+        [[noreturn]] void compileError(const string& message) {
+            throw runtime_error("Compile Error: " + message);
+        }
+
+        Value* globalSlot(const string& name) {
+            auto it = globalSlots.find(name);
+            if (it != globalSlots.end()) return it->second;
+            globals.emplace_back();
+            if (name == "__name__") globals.back() = makeString("__main__");
+            globalSlots[name] = &globals.back();
+            return &globals.back();
+        }
+
+        // ---- Call machinery ----
+
+        void push(Value value) {
+            if (top == stack.data() + stack.size()) runtimeError("RecursionError: maximum recursion depth exceeded");
+            *top++ = move(value);
+        }
+
+        void popTo(Value* slot) {
+            while (top > slot) (--top)->reset();
+        }
+
+        [[noreturn]] void arityError(const string& name, int expected, int given) {
+            runtimeError("TypeError: " + name + "() takes " + to_string(expected) +
+                         " positional arguments but " + to_string(given) + " were given");
+        }
+
+        // Runs a user function whose arguments already fill the slots from 'args' up to 'top'
+        Value callUser(FunctionObject* function, Value* args) {
+            const EvalFunction& target = functions[function->index];
+            if (depth >= maxDepth || args + target.numLocals > stack.data() + stack.size()) {
+                runtimeError("RecursionError: maximum recursion depth exceeded");
+            }
+            top = args + target.numLocals;
+            depth++;
+            EvalFlow flow = target.body(args);
+            depth--;
+            Value result = flow == FLOW_RETURN ? move(returnValue) : Value::none();
+            popTo(args);
+            return result;
+        }
+
+        // Makes room for 'self' in front of the arguments
+        void insertSelf(Value* args, const Value& self) {
+            push(Value());
+            for (Value* slot = top - 1; slot > args; slot--) *slot = move(slot[-1]);
+            *args = self;
+        }
+
+        // Calls any callable with the arguments between 'args' and 'top', then pops them
+        Value callValue(const Value& callee, Value* args) {
+            int argc = top - args;
+            switch (callee.kind) {
+                case V_FUNC: {
+                    FunctionObject* function = asFunction(callee);
+                    if (function->arity != argc) arityError(function->name, function->arity, argc);
+                    return callUser(function, args);
+                }
+                case V_BUILTIN: {
+                    Value result = builtinTable()[callee.builtin].function(args, argc);
+                    popTo(args);
+                    return result;
+                }
+                case V_BOUND: {
+                    FunctionObject* function = asFunction(asBound(callee)->function);
+                    if (function->arity != argc + 1) arityError(function->name, function->arity - 1, argc);
+                    insertSelf(args, asBound(callee)->self);
+                    return callUser(function, args);
+                }
+                case V_CLASS: {
+                    Value instance = makeInstance(callee);
+                    Value* init = findClassAttribute(callee, "__init__");
+                    if (init && init->kind == V_FUNC) {
+                        FunctionObject* function = asFunction(*init);
+                        if (function->arity != argc + 1) arityError(function->name, function->arity - 1, argc);
+                        insertSelf(args, instance);
+                        callUser(function, args);
+                    } else {
+                        if (argc != 0) runtimeError("TypeError: " + asClass(callee)->name + "() takes no arguments");
+                        popTo(args);
+                    }
+                    return instance;
+                }
+                default:
+                    runtimeError("TypeError: '" + typeName(callee) + "' object is not callable");
+            }
+        }
+
+        // 'self' sits in slot 'base', the arguments follow it up to 'top'
+        Value callMethod(Value* base, const string& name) {
+            if (base->kind == V_INSTANCE) {
+                InstanceObject* instance = asInstance(*base);
+                if (!instance->attributes.count(name)) {
+                    Value* attr = findClassAttribute(instance->cls, name);
+                    if (attr && attr->kind == V_FUNC) {
+                        FunctionObject* function = asFunction(*attr);
+                        int argc = top - base - 1;
+                        if (function->arity != argc + 1) arityError(function->name, function->arity - 1, argc);
+                        return callUser(function, base);
+                    }
+                }
+            }
+            if (base->kind == V_INSTANCE || base->kind == V_CLASS) {
+                Value callee = getAttribute(*base, name);
+                Value result = callValue(callee, base + 1);
+                popTo(base);
+                return result;
+            }
+            Value result = callNativeMethod(*base, name, base + 1, top - base - 1);
+            popTo(base);
+            return result;
+        }
+
+        // ---- Names ----
+
+        EvalExpr compileLoad(const string& name) {
+            if (!scope->isModule) {
+                auto it = scope->locals.find(name);
+                if (it != scope->locals.end()) {
+                    int slot = it->second;
+                    return [slot, name](Value* locals) {
+                        if (locals[slot].kind == V_UNDEF) {
+                            runtimeError("UnboundLocalError: local variable '" + name + "' referenced before assignment");
+                        }
+                        return locals[slot];
+                    };
+                }
+            }
+            int builtin = findBuiltin(name);
+            if (builtin >= 0 && !moduleBound.count(name)) {
+                Value function = Value::builtinFunction(builtin);
+                return [function](Value*) { return function; };
+            }
+            Value* slot = globalSlot(name);
+            return [slot, name](Value*) {
+                if (slot->kind == V_UNDEF) runtimeError("NameError: name '" + name + "' is not defined");
+                return *slot;
+            };
+        }
+
+        EvalStore compileStoreName(const string& name) {
+            if (!scope->isModule) {
+                int slot = scope->locals.at(name);
+                return [slot](Value* locals, Value value) { locals[slot] = move(value); };
+            }
+            Value* slot = globalSlot(name);
+            return [slot](Value*, Value value) { *slot = move(value); };
+        }
+
+        EvalStore compileStoreTarget(const shared_ptr<ParseTreeNode>& target) {
+            if (target->type == "Identifier") return compileStoreName(target->value);
+            if (target->type == "AttributeAccess") {
+                auto parts = semanticChildren(target);
+                EvalExpr object = compileExpression(parts[0]);
+                string name = parts[1]->value;
+                return [object, name](Value* locals, Value value) { setAttribute(object(locals), name, value); };
+            }
+            if (target->type == "Subscript") {
+                auto parts = semanticChildren(target);
+                EvalExpr container = compileExpression(parts[0]);
+                EvalExpr index = compileExpression(parts[1]);
+                return [container, index](Value* locals, Value value) {
+                    Value c = container(locals);
+                    setItem(c, index(locals), value);
+                };
+            }
+            compileError("cannot assign to " + target->type);
+        }
+
+        // ---- Statements ----
+
+        EvalStmt compileBlock(const shared_ptr<ParseTreeNode>& block) {
+            vector<EvalStmt> statements;
+            for (const auto& statement : block->children) statements.push_back(compileStatement(statement));
+            if (statements.size() == 1) return statements[0];
+            return [statements](Value* locals) {
+                for (const auto& statement : statements) {
+                    EvalFlow flow = statement(locals);
+                    if (flow != FLOW_NEXT) return flow;
+                }
+                return FLOW_NEXT;
+            };
+        }
+
+        EvalStmt compileStatement(const shared_ptr<ParseTreeNode>& node) {
+            const string& type = node->type;
+            if (type == "ExpressionStatement" || type == "FunctionCallStatement") {
+                EvalExpr expression = compileExpression(type == "ExpressionStatement" ? semanticChildren(node)[0] : node);
+                return [expression](Value* locals) {
+                    expression(locals);
+                    return FLOW_NEXT;
+                };
+            }
+            if (type == "Assignment") return compileAssignment(node);
+            if (type == "IfStatement") return compileIf(node);
+            if (type == "WhileStatement") return compileWhile(node);
+            if (type == "ForStatement") return compileFor(node);
+            if (type == "FunctionDefinition") {
+                Value function = compileFunctionDefinition(node);
+                EvalStore store = compileStoreName(findChild(node, "Identifier")->value);
+                return [function, store](Value* locals) {
+                    store(locals, function);
+                    return FLOW_NEXT;
+                };
+            }
+            if (type == "ClassDefinition") return compileClassDefinition(node);
+            if (type == "ReturnStatement") {
+                if (scope->isModule) compileError("'return' outside function");
+                auto parts = semanticChildren(node);
+                if (parts.empty()) {
+                    return [this](Value*) {
+                        returnValue = Value::none();
+                        return FLOW_RETURN;
+                    };
+                }
+                EvalExpr value = compileExpression(parts[0]);
+                return [this, value](Value* locals) {
+                    returnValue = value(locals);
+                    return FLOW_RETURN;
+                };
+            }
+            if (type == "BreakStatement") {
+                if (scope->loopDepth == 0) compileError("'break' outside loop");
+                return [](Value*) { return FLOW_BREAK; };
+            }
+            if (type == "ContinueStatement") {
+                if (scope->loopDepth == 0) compileError("'continue' not properly in loop");
+                return [](Value*) { return FLOW_CONTINUE; };
+            }
+            if (type == "PassStatement") return [](Value*) { return FLOW_NEXT; };
+            if (type == "Suite") return compileBlock(node);
+            if (type == "ImportStatement") compileError("import is not supported by the evaluator");
+            compileError("unsupported statement " + type);
+        }
+
+        EvalStmt compileAssignment(const shared_ptr<ParseTreeNode>& node) {
+            auto targets = semanticChildren(findChild(node, "IdentifierList"));
+            string op = findChild(node, "AssignOp")->value;
+            EvalExpr value = compileExpression(semanticChildren(node).back());
+
+            if (op == "=") {
+                if (targets.size() == 1) {
+                    auto target = targets[0];
+                    // The common 'name = expression' forms write the slot directly
+                    if (target->type == "Identifier" && !scope->isModule) {
+                        int slot = scope->locals.at(target->value);
+                        return [slot, value](Value* locals) {
+                            locals[slot] = value(locals);
+                            return FLOW_NEXT;
+                        };
+                    }
+                    if (target->type == "Identifier") {
+                        Value* slot = globalSlot(target->value);
+                        return [slot, value](Value* locals) {
+                            *slot = value(locals);
+                            return FLOW_NEXT;
+                        };
+                    }
+                    EvalStore store = compileStoreTarget(target);
+                    return [store, value](Value* locals) {
+                        store(locals, value(locals));
+                        return FLOW_NEXT;
+                    };
+                }
+                vector<EvalStore> stores;
+                for (const auto& target : targets) stores.push_back(compileStoreTarget(target));
+                return [stores, value](Value* locals) {
+                    vector<Value> items = collectItems(value(locals));
+                    if (items.size() != stores.size()) {
+                        runtimeError("ValueError: expected " + to_string(stores.size()) + " values to unpack, got " +
+                                     to_string(items.size()));
+                    }
+                    for (size_t k = 0; k < stores.size(); k++) stores[k](locals, move(items[k]));
+                    return FLOW_NEXT;
+                };
+            }
+
+            BinaryOperator binary;
+            if (targets.size() != 1 || !binaryOperatorFromString(op.substr(0, op.size() - 1), binary)) {
+                compileError("illegal expression for augmented assignment");
+            }
+            auto target = targets[0];
+            if (target->type == "Identifier") {
+                EvalExpr current = compileLoad(target->value);
+                EvalExpr combined = makeBinary(binary, current, value);
+                if (!scope->isModule) {
+                    int slot = scope->locals.at(target->value);
+                    return [slot, combined](Value* locals) {
+                        locals[slot] = combined(locals);
+                        return FLOW_NEXT;
+                    };
+                }
+                Value* slot = globalSlot(target->value);
+                return [slot, combined](Value* locals) {
+                    *slot = combined(locals);
+                    return FLOW_NEXT;
+                };
+            }
+            if (target->type == "AttributeAccess") {
+                auto parts = semanticChildren(target);
+                EvalExpr object = compileExpression(parts[0]);
+                string name = parts[1]->value;
+                return [object, name, binary, value](Value* locals) {
+                    Value o = object(locals);
+                    Value result = binaryOp(binary, getAttribute(o, name), value(locals));
+                    setAttribute(o, name, result);
+                    return FLOW_NEXT;
+                };
+            }
+            if (target->type == "Subscript") {
+                auto parts = semanticChildren(target);
+                EvalExpr container = compileExpression(parts[0]);
+                EvalExpr index = compileExpression(parts[1]);
+                return [container, index, binary, value](Value* locals) {
+                    Value c = container(locals);
+                    Value i = index(locals);
+                    Value result = binaryOp(binary, getItem(c, i), value(locals));
+                    setItem(c, i, result);
+                    return FLOW_NEXT;
+                };
+            }
+            compileError("illegal expression for augmented assignment");
+        }
+
+        EvalStmt compileIf(const shared_ptr<ParseTreeNode>& node) {
+            auto parts = semanticChildren(node);
+            // parts: condition, Suite, then any ElifClause and an optional ElseClause
+            vector<pair<EvalExpr, EvalStmt>> branches;
+            EvalStmt otherwise;
+            branches.emplace_back(compileExpression(parts[0]), compileBlock(parts[1]));
+            for (size_t k = 2; k < parts.size(); k++) {
+                if (parts[k]->type == "ElifClause") {
+                    auto clause = semanticChildren(parts[k]);
+                    branches.emplace_back(compileExpression(clause[0]), compileBlock(clause[1]));
+                } else {
+                    otherwise = compileBlock(findChild(parts[k], "Suite"));
+                }
+            }
+            if (branches.size() == 1) {
+                EvalExpr condition = branches[0].first;
+                EvalStmt body = branches[0].second;
+                if (!otherwise) {
+                    return [condition, body](Value* locals) {
+                        return truthy(condition(locals)) ? body(locals) : FLOW_NEXT;
+                    };
+                }
+                return [condition, body, otherwise](Value* locals) {
+                    return truthy(condition(locals)) ? body(locals) : otherwise(locals);
+                };
+            }
+            return [branches, otherwise](Value* locals) {
+                for (const auto& branch : branches) {
+                    if (truthy(branch.first(locals))) return branch.second(locals);
+                }
+                return otherwise ? otherwise(locals) : FLOW_NEXT;
+            };
+        }
+
+        EvalStmt compileWhile(const shared_ptr<ParseTreeNode>& node) {
+            auto parts = semanticChildren(node);
+            EvalExpr condition = compileExpression(parts[0]);
+            scope->loopDepth++;
+            EvalStmt body = compileBlock(parts[1]);
+            scope->loopDepth--;
+            return [condition, body](Value* locals) {
+                while (truthy(condition(locals))) {
+                    EvalFlow flow = body(locals);
+                    if (flow == FLOW_BREAK) break;
+                    if (flow == FLOW_RETURN) return flow;
+                }
+                return FLOW_NEXT;
+            };
+        }
+
+        EvalStmt compileFor(const shared_ptr<ParseTreeNode>& node) {
+            auto parts = semanticChildren(node);
+            // parts: loop variable, iterable, Suite
+            EvalExpr iterable = compileExpression(parts[1]);
+            EvalStore store = compileStoreName(parts[0]->value);
+            scope->loopDepth++;
+            EvalStmt body = compileBlock(parts[2]);
+            scope->loopDepth--;
+            return [iterable, store, body](Value* locals) {
+                Value it = makeIterator(iterable(locals));
+                IterObject* iter = asIter(it);
+                Value item;
+                while (iteratorNext(iter, item)) {
+                    store(locals, move(item));
+                    EvalFlow flow = body(locals);
+                    if (flow == FLOW_BREAK) break;
+                    if (flow == FLOW_RETURN) return flow;
+                }
+                return FLOW_NEXT;
+            };
+        }
+
+        // Builds the body's closures and returns the function value
+        Value compileFunctionDefinition(const shared_ptr<ParseTreeNode>& node) {
+            string name = findChild(node, "Identifier")->value;
+            vector<string> params;
+            for (const auto& param : findChild(node, "Parameters")->children) {
+                if (param->type == "Parameter") params.push_back(param->value);
+            }
+
+            Scope state;
+            state.isModule = false;
+            vector<string> bound = params;
+            auto body = findChild(node, "Suite");
+            collectBoundNames(body, bound);
+            for (const auto& local : bound) {
+                if (!state.locals.count(local)) {
+                    int slot = state.locals.size();
+                    state.locals[local] = slot;
+                }
+            }
+
+            int index = functions.size();
+            functions.emplace_back();
+            Scope* saved = scope;
+            scope = &state;
+            EvalStmt compiled = compileBlock(body);
+            scope = saved;
+
+            EvalFunction& function = functions[index];
+            function.name = name;
+            function.arity = params.size();
+            function.numLocals = state.locals.size();
+            function.body = compiled;
+            return makeFunction(name, params.size(), index);
+        }
+
+        // Class bodies may hold methods and plain attribute assignments
+        EvalStmt compileClassDefinition(const shared_ptr<ParseTreeNode>& node) {
+            string name = findChild(node, "Identifier")->value;
+            auto parentNode = findChild(node, "Parent");
+            EvalExpr parent = parentNode ? compileLoad(parentNode->value) : [](Value*) { return Value::none(); };
+
+            vector<pair<string, EvalExpr>> attributes;
+            for (const auto& statement : findChild(node, "Suite")->children) {
+                if (statement->type == "FunctionDefinition") {
+                    Value function = compileFunctionDefinition(statement);
+                    attributes.emplace_back(findChild(statement, "Identifier")->value, [function](Value*) { return function; });
+                } else if (statement->type == "Assignment" && findChild(statement, "AssignOp")->value == "=" &&
+                           semanticChildren(findChild(statement, "IdentifierList")).size() == 1 &&
+                           semanticChildren(findChild(statement, "IdentifierList"))[0]->type == "Identifier") {
+                    attributes.emplace_back(semanticChildren(findChild(statement, "IdentifierList"))[0]->value,
+                                            compileExpression(semanticChildren(statement).back()));
+                } else if (statement->type != "PassStatement") {
+                    compileError("unsupported statement " + statement->type + " in class body");
+                }
+            }
+            EvalStore store = compileStoreName(name);
+            return [name, parent, attributes, store](Value* locals) {
+                Value cls = makeClass(name, parent(locals));
+                for (const auto& attribute : attributes) setAttribute(cls, attribute.first, attribute.second(locals));
+                store(locals, move(cls));
+                return FLOW_NEXT;
+            };
+        }
+
+        // ---- Expressions ----
+
+        EvalExpr makeBinary(BinaryOperator op, EvalExpr left, EvalExpr right) {
+            switch (op) {
+                case BIN_ADD:
+                    return [left, right](Value* locals) {
+                        Value a = left(locals);
+                        Value b = right(locals);
+                        long long r;
+                        if (a.kind == V_INT && b.kind == V_INT && !__builtin_add_overflow(a.i, b.i, &r)) return Value::integer(r);
+                        return binaryOp(BIN_ADD, a, b);
+                    };
+                case BIN_SUB:
+                    return [left, right](Value* locals) {
+                        Value a = left(locals);
+                        Value b = right(locals);
+                        long long r;
+                        if (a.kind == V_INT && b.kind == V_INT && !__builtin_sub_overflow(a.i, b.i, &r)) return Value::integer(r);
+                        return binaryOp(BIN_SUB, a, b);
+                    };
+                case BIN_MUL:
+                    return [left, right](Value* locals) {
+                        Value a = left(locals);
+                        Value b = right(locals);
+                        long long r;
+                        if (a.kind == V_INT && b.kind == V_INT && !__builtin_mul_overflow(a.i, b.i, &r)) return Value::integer(r);
+                        return binaryOp(BIN_MUL, a, b);
+                    };
+                default:
+                    return [op, left, right](Value* locals) {
+                        Value a = left(locals);
+                        Value b = right(locals);
+                        if (a.kind == V_INT && b.kind == V_INT) return intArithmetic(op, a.i, b.i);
+                        return binaryOp(op, a, b);
+                    };
+            }
+        }
+
+        EvalExpr makeComparison(const string& op, EvalExpr left, EvalExpr right) {
+#define EVAL_COMPARE(symbol, cppOp) \
+            if (op == symbol) { \
+                return [left, right](Value* locals) { \
+                    Value a = left(locals); \
+                    Value b = right(locals); \
+                    if (a.kind == V_INT && b.kind == V_INT) return Value::boolean(a.i cppOp b.i); \
+                    return Value::boolean(compareValues(a, b, symbol) cppOp 0); \
+                }; \
+            }
+            EVAL_COMPARE("<", <)
+            EVAL_COMPARE(">", >)
+            EVAL_COMPARE("<=", <=)
+            EVAL_COMPARE(">=", >=)
+#undef EVAL_COMPARE
+            if (op == "==" || op == "!=") {
+                bool equal = op == "==";
+                return [left, right, equal](Value* locals) {
+                    Value a = left(locals);
+                    return Value::boolean(valuesEqual(a, right(locals)) == equal);
+                };
+            }
+            if (op == "in" || op == "not in") {
+                bool inside = op == "in";
+                return [left, right, inside](Value* locals) {
+                    Value needle = left(locals);
+                    return Value::boolean(containsValue(right(locals), needle) == inside);
+                };
+            }
+            compileError("unsupported comparison " + op);
+        }
+
+        EvalExpr compileLiteral(const shared_ptr<ParseTreeNode>& node) {
+            const LiteralValue& literal = literalOf(node);
+            if (literal.kind == LIT_FSTRING || literal.kind == LIT_INVALID) {
+                // Each part either yields literal text or formats an embedded expression
+                vector<pair<EvalExpr, string>> parts;
+                for (const auto& segment : formattedSegments(literal)) {
+                    if (segment.isExpression) {
+                        auto expression = parseEmbeddedExpression(segment.text);
+                        if (!expression) compileError("invalid f-string expression '" + segment.text + "'");
+                        parts.emplace_back(compileExpression(expression), segment.formatSpec);
+                    } else {
+                        parts.emplace_back(nullptr, segment.text);
+                    }
+                }
+                return [parts](Value* locals) {
+                    string out;
+                    for (const auto& part : parts) {
+                        if (part.first) out += formatWithSpec(part.first(locals), part.second);
+                        else out += part.second;
+                    }
+                    return makeString(move(out));
+                };
+            }
+            Value constant = literalConstant(literal);
+            return [constant](Value*) { return constant; };
+        }
+
+        vector<EvalExpr> compileArguments(const shared_ptr<ParseTreeNode>& args) {
+            vector<EvalExpr> compiled;
+            if (!args) return compiled;
+            for (const auto& arg : semanticChildren(args)) compiled.push_back(compileExpression(arg));
+            return compiled;
+        }
+
+        EvalExpr makeMethodCall(EvalExpr object, const string& name, vector<EvalExpr> args) {
+            return [this, object, name, args](Value* locals) {
+                Value* base = top;
+                push(object(locals));
+                for (const auto& arg : args) push(arg(locals));
+                return callMethod(base, name);
+            };
+        }
+
+        EvalExpr makeCall(const shared_ptr<ParseTreeNode>& callee, vector<EvalExpr> args) {
+            // Builtins that the module never rebinds are called through their function pointer
+            if (callee->type == "Identifier" && findBuiltin(callee->value) >= 0 && !moduleBound.count(callee->value) &&
+                (scope->isModule || !scope->locals.count(callee->value))) {
+                BuiltinFunction function = builtinTable()[findBuiltin(callee->value)].function;
+                return [this, function, args](Value* locals) {
+                    Value* base = top;
+                    for (const auto& arg : args) push(arg(locals));
+                    Value result = function(base, args.size());
+                    popTo(base);
+                    return result;
+                };
+            }
+            EvalExpr target = compileExpression(callee);
+            return [this, target, args](Value* locals) {
+                Value function = target(locals);
+                Value* base = top;
+                for (const auto& arg : args) push(arg(locals));
+                return callValue(function, base);
+            };
+        }
+
+        EvalExpr compileExpression(const shared_ptr<ParseTreeNode>& node) {
+            const string& type = node->type;
+            if (type == "Literal") return compileLiteral(node);
+            if (type == "Identifier") return compileLoad(node->value);
+            if (type == "Keyword") {
+                Value constant;
+                if (node->value == "True") constant = Value::boolean(true);
+                else if (node->value == "False") constant = Value::boolean(false);
+                else if (node->value == "None") constant = Value::none();
+                else compileError("unexpected keyword '" + node->value + "'");
+                return [constant](Value*) { return constant; };
+            }
+            if (type == "ParenExpr") return compileExpression(semanticChildren(node)[0]);
+            if (type == "List" || type == "Tuple" || (type == "ExpressionList" && !isArithChain(node))) {
+                vector<EvalExpr> items;
+                for (const auto& item : semanticChildren(node)) items.push_back(compileExpression(item));
+                ValueKind kind = type == "List" ? V_LIST : V_TUPLE;
+                return [items, kind](Value* locals) {
+                    vector<Value> values;
+                    values.reserve(items.size());
+                    for (const auto& item : items) values.push_back(item(locals));
+                    return makeList(move(values), kind);
+                };
+            }
+            if (type == "Dict") {
+                vector<pair<EvalExpr, EvalExpr>> pairs;
+                for (const auto& pair : semanticChildren(node)) {
+                    auto kv = semanticChildren(pair);
+                    pairs.emplace_back(compileExpression(kv[0]), compileExpression(kv[1]));
+                }
+                return [pairs](Value* locals) {
+                    Value dict = makeDict();
+                    for (const auto& pair : pairs) {
+                        Value key = pair.first(locals);
+                        hashValue(key);
+                        asDict(dict)->set(key, pair.second(locals));
+                    }
+                    return dict;
+                };
+            }
+            if (type == "ExpressionList") {
+                auto items = semanticChildren(node);
+                EvalExpr result = compileExpression(items[0]);
+                for (size_t k = 1; k + 1 < items.size(); k += 2) {
+                    BinaryOperator op;
+                    if (!binaryOperatorFromString(items[k]->value, op)) compileError("unsupported operator " + items[k]->value);
+                    result = makeBinary(op, result, compileExpression(items[k + 1]));
+                }
+                return result;
+            }
+            if (type == "BinaryOp") {
+                auto operands = semanticChildren(node);
+                if (operands.size() != 2) compileError("malformed binary operation");
+                EvalExpr left = compileExpression(operands[0]);
+                EvalExpr right = compileExpression(operands[1]);
+                if (node->value == "and") {
+                    return [left, right](Value* locals) {
+                        Value a = left(locals);
+                        return truthy(a) ? right(locals) : a;
+                    };
+                }
+                if (node->value == "or") {
+                    return [left, right](Value* locals) {
+                        Value a = left(locals);
+                        return truthy(a) ? a : right(locals);
+                    };
+                }
+                BinaryOperator op;
+                if (!binaryOperatorFromString(node->value, op)) compileError("unsupported operator " + node->value);
+                return makeBinary(op, left, right);
+            }
+            if (type == "UnaryOp") {
+                EvalExpr operand = compileExpression(semanticChildren(node)[0]);
+                if (node->value == "not") return [operand](Value* locals) { return Value::boolean(!truthy(operand(locals))); };
+                string op = node->value;
+                return [operand, op](Value* locals) { return unaryOp(op, operand(locals)); };
+            }
+            if (type == "Comparison") {
+                auto parts = semanticChildren(node);
+                return makeComparison(parts[1]->value, compileExpression(parts[0]), compileExpression(parts[2]));
+            }
+            if (type == "TernaryOp") {
+                auto parts = semanticChildren(node);
+                // parts: value if true, condition, value if false
+                EvalExpr then = compileExpression(parts[0]);
+                EvalExpr condition = compileExpression(parts[1]);
+                EvalExpr otherwise = compileExpression(parts[2]);
+                return [then, condition, otherwise](Value* locals) {
+                    return truthy(condition(locals)) ? then(locals) : otherwise(locals);
+                };
+            }
+            if (type == "AttributeAccess") {
+                auto parts = semanticChildren(node);
+                EvalExpr object = compileExpression(parts[0]);
+                string name = parts[1]->value;
+                return [object, name](Value* locals) { return getAttribute(object(locals), name); };
+            }
+            if (type == "Subscript") {
+                auto parts = semanticChildren(node);
+                EvalExpr container = compileExpression(parts[0]);
+                EvalExpr index = compileExpression(parts[1]);
+                return [container, index](Value* locals) {
+                    Value c = container(locals);
+                    Value i = index(locals);
+                    if (c.kind == V_LIST && i.kind == V_INT && i.i >= 0 && i.i < (long long)asList(c)->items.size()) {
+                        return asList(c)->items[i.i];
+                    }
+                    return getItem(c, i);
+                };
+            }
+            if (type == "FunctionCall") {
+                auto callee = semanticChildren(node)[0];
+                vector<EvalExpr> args = compileArguments(findChild(node, "Arguments"));
+                if (callee->type == "AttributeAccess") {
+                    auto parts = semanticChildren(callee);
+                    return makeMethodCall(compileExpression(parts[0]), parts[1]->value, args);
+                }
+                return makeCall(callee, args);
+            }
+            if (type == "FunctionCallStatement") {
+                auto callee = node->children[0];
+                vector<EvalExpr> args = compileArguments(findChild(node, "Arguments"));
+                if (callee->type == "DottedName") {
+                    vector<string> names;
+                    for (const auto& part : callee->children) {
+                        if (part->type == "NamePart") names.push_back(part->value);
+                    }
+                    EvalExpr object = compileLoad(names[0]);
+                    for (size_t k = 1; k + 1 < names.size(); k++) {
+                        string name = names[k];
+                        object = [object, name](Value* locals) { return getAttribute(object(locals), name); };
+                    }
+                    return makeMethodCall(object, names.back(), args);
+                }
+                return makeCall(callee, args);
+            }
+            compileError("unsupported expression " + type);
+        }
+
+    public:
+        ClosureEvaluator(const vector<Identifier>& symbolTable, size_t stackSize = 1 << 16)
+            : symbols(symbolTable), stack(stackSize) {
+            top = stack.data();
+        }
+
+        // Builds the closures for the whole program
+        EvalStmt compile(const shared_ptr<ParseTreeNode>& program) {
+            for (const auto& symbol : symbols) {
+                if (symbol.Scope == "global") globalSlot(symbol.name);
+            }
+            vector<string> bound;
+            collectBoundNames(program, bound);
+            for (const auto& name : bound) {
+                moduleBound.insert(name);
+                globalSlot(name);
+            }
+
+            Scope state;
+            state.isModule = true;
+            scope = &state;
+            EvalStmt body = compileBlock(program);
+            scope = nullptr;
+            return body;
+        }
+
+        void run(const EvalStmt& program) {
+            program(top);
+        }
+};
+
+// Builds closures for the tree and runs them; returns the process exit status
+int runClosures(const shared_ptr<ParseTreeNode>& tree, const vector<Identifier>& symbols) {
+    ClosureEvaluator evaluator(symbols);
+    EvalStmt program;
+    try {
+        program = evaluator.compile(tree);
+    } catch (const runtime_error& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    try {
+        evaluator.run(program);
+    } catch (const runtime_error& e) {
+        cout.flush();
+        cerr << "Runtime Error: " << e.what() << endl;
+        return 1;
+    }
+    cout.flush();
+    return 0;
+}
@@ -0,0 +1,446 @@
+#include <memory>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <iostream>
+#include <iomanip>
+#include <functional>
+using namespace std;
+
+// Replaces calls of small module-level functions whose body is a single 'return expression' with
+// that expression, the parameters replaced by the call's arguments. Runs before TreeOptimizer, so
+// that constant arguments fold into the inlined expression. A call is only inlined when it
+// evaluates the same way:
+//   - the function is a def at the top of the module that the symbol table lists as a function,
+//     is bound nowhere else, is not recursive, directly or through other such functions, and
+//     returns an expression of at most maxInlinedNodes nodes without f-strings, whose fields the
+//     tree does not show;
+//   - the call comes after the def in the module, so the function exists whenever it runs, and
+//     passes one argument per parameter;
+//   - every argument is a literal, True/False/None or a name. These have no side effects, so
+//     reading them where the body reads the parameter gives the same values as passing them. But
+//     the call evaluates a name first, raising NameError at once if it is unbound, so the
+//     expression must read the parameter before anything else that could raise or have an
+//     effect, unconditionally (not in the right of 'and'/'or' or an arm of 'x if c else y'), and
+//     the parameters passed names in the order the call evaluates them;
+//   - no name the expression reads from the module is a local at the call site, where it would
+//     capture that local instead.
+// Parameters are replaced in one pass over a copy of the expression, as if renamed to fresh names
+// first, so an argument naming another parameter is never replaced again. Calls inside inlinable
+// functions are inlined first, and the tree may grow by at most maxInlineGrowth of its size.
+
+const size_t maxInlinedNodes = 16;
+const double maxInlineGrowth = 0.5;
+
+class FunctionInliner {
+    private:
+        struct Candidate {
+            string name;
+            size_t index;                          // position of the def among the module's statements
+            shared_ptr<ParseTreeNode> returnStatement;
+            vector<string> parameters;
+            vector<int> firstReads;                // order of each parameter's first read, or notEarly
+            unordered_set<string> freeNames;       // other names the expression reads
+            bool recursive = false;
+            bool finished = false;
+            bool inlinable = false;
+            size_t calls = 0;                      // calls replaced by the expression
+        };
+
+        static constexpr int notEarly = -1;       // a parameter a name may not be passed for
+
+        vector<Candidate> candidates;
+        unordered_map<string, size_t> byName;
+        unordered_set<string> moduleNames;        // names the module binds
+        size_t growth = 0, budget = 0;
+
+        static shared_ptr<ParseTreeNode>& returnedExpression(const shared_ptr<ParseTreeNode>& statement) {
+            for (auto& child : statement->children) {
+                if (!isSyntaxLeaf(child)) return child;
+            }
+            return statement->children.back();
+        }
+
+        // ---- Analysis ----
+
+        // Counts the names imports in a block bind, without entering nested definitions
+        class ImportCounter : public TreeVisitor<ImportCounter> {
+            private:
+                unordered_map<string, int>& bindings;
+
+            public:
+                explicit ImportCounter(unordered_map<string, int>& bindings) : bindings(bindings) {}
+
+                bool enterImportStatement(const shared_ptr<ParseTreeNode>& node, size_t) {
+                    for (const auto& name : importedNames(node)) bindings[name]++;
+                    return false;
+                }
+                bool enterFunctionDefinition(const shared_ptr<ParseTreeNode>&, size_t) { return false; }
+                bool enterClassDefinition(const shared_ptr<ParseTreeNode>&, size_t) { return false; }
+        };
+
+        // Records in 'freeNames' the names other than parameters an expression reads. False when it
+        // holds something the inliner cannot rewrite
+        static bool collectReads(const shared_ptr<ParseTreeNode>& node, Candidate& candidate) {
+            switch (node->kind) {
+                case NodeKind::Identifier:
+                    for (const auto& parameter : candidate.parameters) {
+                        if (parameter == node->value) return true;
+                    }
+                    candidate.freeNames.insert(node->value);
+                    return true;
+                case NodeKind::Literal:
+                    return literalOf(node).kind != LIT_FSTRING;
+                default:
+                    break;
+            }
+            auto parts = semanticChildren(node);
+            if (node->kind == NodeKind::AttributeAccess) return collectReads(parts[0], candidate); // the attribute name is no read
+            if (node->kind == NodeKind::FunctionCall && parts[0]->kind == NodeKind::Identifier) {
+                // A parameter called as a function would need its argument in callee position
+                for (const auto& parameter : candidate.parameters) {
+                    if (parameter == parts[0]->value) return false;
+                }
+            }
+            for (const auto& part : parts) {
+                if (!collectReads(part, candidate)) return false;
+            }
+            return true;
+        }
+
+        // Numbers the parameters' first reads in evaluation order, or marks them notEarly when the
+        // read is conditional or comes after something that could raise or have an effect.
+        // 'applied' turns true once such an operation has been evaluated
+        void orderReads(const shared_ptr<ParseTreeNode>& node, Candidate& candidate, bool conditional, bool& applied,
+                        int& order) const {
+            auto parts = semanticChildren(node);
+            switch (node->kind) {
+                case NodeKind::Identifier:
+                    for (size_t k = 0; k < candidate.parameters.size(); k++) {
+                        if (candidate.parameters[k] != node->value) continue;
+                        if (candidate.firstReads[k] == notEarly - 1) candidate.firstReads[k] = conditional || applied ? notEarly : order++;
+                        return;
+                    }
+                    // Another name may be unbound, unless it is a builtin the module leaves alone
+                    if (!builtInFunctions.count(node->value) || moduleNames.count(node->value)) applied = true;
+                    return;
+                case NodeKind::Literal:
+                case NodeKind::Keyword:
+                case NodeKind::Delimiter:
+                    return;
+                case NodeKind::ParenExpr:
+                    for (const auto& part : parts) orderReads(part, candidate, conditional, applied, order);
+                    return;
+                case NodeKind::BinaryOp:
+                    // 'and' and 'or'; the right operand runs only for some values of the left
+                    if (parts.size() != 2) break;
+                    orderReads(parts[0], candidate, conditional, applied, order);
+                    orderReads(parts[1], candidate, true, applied, order);
+                    applied = true;
+                    return;
+                case NodeKind::TernaryOp:
+                    orderReads(parts[1], candidate, conditional, applied, order);
+                    orderReads(parts[0], candidate, true, applied, order);
+                    orderReads(parts[2], candidate, true, applied, order);
+                    applied = true;
+                    return;
+                case NodeKind::Comparison: {
+                    // 'a < b < c' compares a and b before it evaluates c, and only if a < b
+                    size_t operands = 0;
+                    for (const auto& part : parts) {
+                        if (part->kind == NodeKind::ComparisonOp) continue;
+                        if (operands++ >= 2) applied = true;
+                        orderReads(part, candidate, conditional || operands > 2, applied, order);
+                    }
+                    applied = true;
+                    return;
+                }
+                case NodeKind::ExpressionList: {
+                    // An arithmetic chain applies each operator before evaluating the next operand
+                    size_t operands = 0;
+                    for (const auto& part : parts) {
+                        if (part->kind == NodeKind::BinaryOp && part->children.empty()) continue;
+                        if (operands++ >= 2) applied = true;
+                        orderReads(part, candidate, conditional, applied, order);
+                    }
+                    applied = true;
+                    return;
+                }
+                case NodeKind::AttributeAccess:
+                    orderReads(parts[0], candidate, conditional, applied, order); // the attribute name is no read
+                    applied = true;
+                    return;
+                default:
+                    break;
+            }
+            for (const auto& part : parts) orderReads(part, candidate, conditional, applied, order);
+            applied = true;
+        }
+
+        void analyze(Candidate& candidate) {
+            candidate.freeNames.clear();
+            const auto& expression = returnedExpression(candidate.returnStatement);
+            candidate.inlinable = !candidate.recursive && collectReads(expression, candidate) &&
+                                  countNodes(expression) <= maxInlinedNodes;
+            if (!candidate.inlinable) return;
+            candidate.firstReads.assign(candidate.parameters.size(), notEarly - 1); // unread
+            bool applied = false;
+            int order = 0;
+            orderReads(expression, candidate, false, applied, order);
+            for (int& read : candidate.firstReads) read = max(read, notEarly);
+        }
+
+        // A def whose body is 'return expression', with a single result rather than a tuple
+        void addCandidate(const shared_ptr<ParseTreeNode>& definition, size_t index, const unordered_set<string>& functions,
+                          const unordered_map<string, int>& bindings) {
+            string name = findChild(definition, "Identifier")->value;
+            auto binding = bindings.find(name);
+            if (!functions.count(name) || binding == bindings.end() || binding->second != 1) return;
+            auto body = semanticChildren(findChild(definition, "Suite"));
+            if (body.size() != 1 || body[0]->kind != NodeKind::ReturnStatement || semanticChildren(body[0]).size() != 1) return;
+            const auto& expression = returnedExpression(body[0]);
+            if (expression->kind == NodeKind::ExpressionList && !isArithChain(expression)) return;
+
+            Candidate candidate;
+            candidate.name = name;
+            candidate.index = index;
+            candidate.returnStatement = body[0];
+            for (const auto& parameter : findChild(definition, "Parameters")->children) {
+                if (parameter->kind == NodeKind::Parameter) candidate.parameters.push_back(parameter->value);
+            }
+            byName[name] = candidates.size();
+            candidates.push_back(move(candidate));
+        }
+
+        // Marks the candidates that reach themselves through the names their expressions read
+        void markRecursion() {
+            vector<int> state(candidates.size(), 0); // 0 unvisited, 1 on the stack, 2 done
+            vector<size_t> stack;
+            function<void(size_t)> visit = [&](size_t k) {
+                state[k] = 1;
+                stack.push_back(k);
+                Candidate probe = candidates[k];
+                collectReads(returnedExpression(probe.returnStatement), probe);
+                for (const auto& name : probe.freeNames) {
+                    auto callee = byName.find(name);
+                    if (callee == byName.end()) continue;
+                    if (state[callee->second] == 1) {
+                        // Everything on the stack from the callee up is on the cycle
+                        for (size_t s = stack.size(); s-- > 0;) {
+                            candidates[stack[s]].recursive = true;
+                            if (stack[s] == callee->second) break;
+                        }
+                    } else if (state[callee->second] == 0) {
+                        visit(callee->second);
+                    }
+                }
+                stack.pop_back();
+                state[k] = 2;
+            };
+            for (size_t k = 0; k < candidates.size(); k++) {
+                if (state[k] == 0) visit(k);
+            }
+        }
+
+        // Inlines into a candidate's own expression, after the candidates it calls
+        void finish(Candidate& candidate) {
+            if (candidate.finished) return;
+            candidate.finished = true;
+            if (candidate.recursive) return;
+            Candidate probe = candidate;
+            collectReads(returnedExpression(probe.returnStatement), probe);
+            for (const auto& name : probe.freeNames) {
+                auto callee = byName.find(name);
+                if (callee != byName.end()) finish(candidates[callee->second]);
+            }
+            auto& expression = returnedExpression(candidate.returnStatement);
+            unordered_set<string> parameters(candidate.parameters.begin(), candidate.parameters.end());
+            expression = CallRewriter(*this, candidate.index, move(parameters)).rewrite(expression);
+            analyze(candidate);
+        }
+
+        // ---- Rewriting ----
+
+        static bool atomicArgument(const shared_ptr<ParseTreeNode>& node) {
+            switch (node->kind) {
+                case NodeKind::Identifier: return true;
+                case NodeKind::Keyword: return !isSyntaxLeaf(node);
+                case NodeKind::Literal: return literalOf(node).kind != LIT_FSTRING;
+                default: return false;
+            }
+        }
+
+        // Replaces each read of a parameter in a copy of the expression
+        class Substitution : public TreeRewriter<Substitution> {
+            private:
+                const unordered_map<string, shared_ptr<ParseTreeNode>>& arguments;
+
+            public:
+                explicit Substitution(const unordered_map<string, shared_ptr<ParseTreeNode>>& arguments) : arguments(arguments) {}
+
+                // The attribute name is no read, so only the object is substituted
+                bool enterNode(const shared_ptr<ParseTreeNode>& node) {
+                    if (node->kind != NodeKind::AttributeAccess) return true;
+                    for (auto& child : node->children) {
+                        if (isSyntaxLeaf(child)) continue;
+                        child = rewrite(child);
+                        break;
+                    }
+                    return false;
+                }
+
+                shared_ptr<ParseTreeNode> rewriteIdentifier(const shared_ptr<ParseTreeNode>& node) {
+                    auto argument = arguments.find(node->value);
+                    return argument != arguments.end() ? copyTree(argument->second) : node;
+                }
+        };
+
+        // The inlined expression for a call, or nullptr when the call has to stay
+        shared_ptr<ParseTreeNode> inlineCall(const shared_ptr<ParseTreeNode>& call, size_t site, const unordered_set<string>& locals) {
+            auto parts = semanticChildren(call);
+            if (parts.empty() || parts[0]->kind != NodeKind::Identifier) return nullptr;
+            auto found = byName.find(parts[0]->value);
+            if (found == byName.end() || locals.count(parts[0]->value)) return nullptr;
+            Candidate& candidate = candidates[found->second];
+            if (!candidate.inlinable || candidate.index >= site) return nullptr;
+
+            auto argumentsNode = findChild(call, "Arguments");
+            auto arguments = argumentsNode ? semanticChildren(argumentsNode) : vector<shared_ptr<ParseTreeNode>>();
+            if (arguments.size() != candidate.parameters.size()) return nullptr;
+            unordered_map<string, shared_ptr<ParseTreeNode>> replacements;
+            int lastRead = notEarly;
+            for (size_t k = 0; k < arguments.size(); k++) {
+                if (!atomicArgument(arguments[k])) return nullptr;
+                // A name that may be unbound has to be read where the call would evaluate it
+                if (arguments[k]->kind == NodeKind::Identifier) {
+                    if (candidate.firstReads[k] <= lastRead) return nullptr;
+                    lastRead = candidate.firstReads[k];
+                }
+                replacements[candidate.parameters[k]] = arguments[k];
+            }
+            for (const auto& name : candidate.freeNames) {
+                if (locals.count(name)) return nullptr;
+            }
+
+            auto expression = Substitution(replacements).rewrite(copyTree(returnedExpression(candidate.returnStatement)));
+            size_t added = countNodes(expression), removed = countNodes(call);
+            if (added > removed && growth + (added - removed) > budget) return nullptr;
+            if (added > removed) growth += added - removed;
+            candidate.calls++;
+            return expression;
+        }
+
+        // Inlines the calls it can, innermost first. 'site' is the module statement the code
+        // belongs to, and the innermost scope holds the names local where it runs
+        class CallRewriter : public TreeRewriter<CallRewriter> {
+            private:
+                FunctionInliner& inliner;
+                size_t site;
+                vector<unordered_set<string>> scopes;
+
+                shared_ptr<ParseTreeNode> leaveScope(const shared_ptr<ParseTreeNode>& node) {
+                    scopes.pop_back();
+                    return node;
+                }
+
+            public:
+                CallRewriter(FunctionInliner& inliner, size_t site, unordered_set<string> locals) : inliner(inliner), site(site) {
+                    scopes.push_back(move(locals));
+                }
+
+                // A def or class body adds its own locals
+                bool enterNode(const shared_ptr<ParseTreeNode>& node) {
+                    if (node->kind != NodeKind::FunctionDefinition && node->kind != NodeKind::ClassDefinition) return true;
+                    unordered_set<string> inner = scopes.back();
+                    if (node->kind == NodeKind::FunctionDefinition) {
+                        for (const auto& parameter : findChild(node, "Parameters")->children) {
+                            if (parameter->kind == NodeKind::Parameter) inner.insert(parameter->value);
+                        }
+                    }
+                    vector<string> bound;
+                    collectBoundNames(findChild(node, "Suite"), bound);
+                    inner.insert(bound.begin(), bound.end());
+                    scopes.push_back(move(inner));
+                    return true;
+                }
+
+                shared_ptr<ParseTreeNode> rewriteFunctionDefinition(const shared_ptr<ParseTreeNode>& node) { return leaveScope(node); }
+                shared_ptr<ParseTreeNode> rewriteClassDefinition(const shared_ptr<ParseTreeNode>& node) { return leaveScope(node); }
+
+                shared_ptr<ParseTreeNode> rewriteFunctionCall(const shared_ptr<ParseTreeNode>& node) {
+                    auto expression = inliner.inlineCall(node, site, scopes.back());
+                    return expression ? expression : node;
+                }
+
+                shared_ptr<ParseTreeNode> rewriteFunctionCallStatement(const shared_ptr<ParseTreeNode>& node) {
+                    auto expression = inliner.inlineCall(node, site, scopes.back());
+                    if (!expression) return node;
+                    auto statement = make_shared<ParseTreeNode>("ExpressionStatement");
+                    statement->line = node->line;
+                    statement->addChild(expression);
+                    return statement;
+                }
+        };
+
+    public:
+        // Inlines calls throughout the module; returns the number of calls replaced
+        size_t inlineCalls(const shared_ptr<ParseTreeNode>& program, const vector<Identifier>& symbols) {
+            unordered_set<string> functions;
+            for (const auto& symbol : symbols) {
+                if (symbol.type == "function") functions.insert(symbol.name);
+            }
+            vector<string> bound;
+            collectBoundNames(program, bound);
+            unordered_map<string, int> bindings;
+            for (const auto& name : bound) bindings[name]++;
+            ImportCounter(bindings).walk(program);
+            for (const auto& binding : bindings) moduleNames.insert(binding.first);
+            for (size_t k = 0; k < program->children.size(); k++) {
+                if (program->children[k]->kind == NodeKind::FunctionDefinition) addCandidate(program->children[k], k, functions, bindings);
+            }
+            if (candidates.empty()) return 0;
+            markRecursion();
+            budget = (size_t)(countNodes(program) * maxInlineGrowth);
+            for (auto& candidate : candidates) finish(candidate);
+
+            for (size_t k = 0; k < program->children.size(); k++) {
+                auto& statement = program->children[k];
+                if (statement->kind == NodeKind::FunctionDefinition && byName.count(findChild(statement, "Identifier")->value)) {
+                    continue; // their expressions are done
+                }
+                statement = CallRewriter(*this, k, {}).rewrite(statement);
+            }
+            size_t calls = 0;
+            for (const auto& candidate : candidates) calls += candidate.calls;
+            return calls;
+        }
+
+        // "name (n calls)" for each function that was inlined
+        string summary() const {
+            string text;
+            for (const auto& candidate : candidates) {
+                if (!candidate.calls) continue;
+                if (!text.empty()) text += ", ";
+                text += candidate.name + " (" + to_string(candidate.calls) + (candidate.calls == 1 ? " call)" : " calls)");
+            }
+            return text;
+        }
+};
+
+// Inlines small functions in place; with 'report' set, prints what was inlined and the growth
+void inlineFunctions(const shared_ptr<ParseTreeNode>& tree, const vector<Identifier>& symbols, bool report) {
+    size_t before = report ? countNodes(tree) : 0;
+    FunctionInliner inliner;
+    size_t calls = inliner.inlineCalls(tree, symbols);
+    if (!report) return;
+    if (!calls) {
+        cerr << "Inliner: no calls inlined" << endl;
+        return;
+    }
+    size_t after = countNodes(tree);
+    // Usually fewer, since a small expression replaces the call and its argument list
+    double change = before ? ((double)after - (double)before) * 100.0 / before : 0.0;
+    cerr << "Inliner: " << inliner.summary() << "; " << before << " -> " << after << " nodes (" << fixed << setprecision(1)
+         << (change < 0 ? -change : change) << (after > before ? "% more)" : "% fewer)") << endl;
+}
@@ -0,0 +1,67 @@
+#ifndef LEXER2_H
+#define LEXER2_H
+
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "definitions.h"
+
+using namespace std;
+
+class Lexer {
+    private:
+        vector<tuple<string, int, int>> CodeLines; 
+        vector<string> scopeStack; 
+        vector<Identifier> symbol_table;
+        vector<Token> tokens;
+        string CurrentScope = "global";
+        bool inBlockComment = false;
+        string currentBlockCommentDelimiter = "";
+        int previousIndentation = 0;
+        int expectedIndentation = 0;
+        bool expectingIndentedBlock = false;
+        ostream* diagnostics = &cerr;     // where lexing errors are reported
+        bool tablesOnError = true;        // print the tables so far before throwing on an error
+
+        int getIndentationLevel(const string& line) const;
+
+        // Symbol table growth is its own memory phase, nested in tokenizing
+        void addToSymbolTable(const string& name, const string& type, const string& scope);
+
+        void insertSymbol(const string& name, const string& type, const string& scope);
+
+        // Number and string literals are decoded here, once, for every later stage
+        void pushLiteral(const string& text, int lineNumber);
+
+    public:
+        // Reads the file's lines; false when it cannot be opened
+        bool parser(string filename);
+
+        // Reads source held in memory, line by line as parser() reads a file
+        void readSource(const char* source, size_t length);
+
+        // Forgets the last file so that the next one can be read, keeping the settings and the
+        // capacity of the line, token and symbol buffers
+        void reset();
+
+        // Reports errors to 'stream' instead of cerr, without printing the tables before them
+        void setDiagnostics(ostream& stream);
+
+        // Strip the comment from a raw source line and pair it with its line number and indentation level
+        tuple<string, int, int> makeCodeLine(string line, int lineNumber) const;
+
+        void tokenizeLine(const vector<tuple<string, int, int>>& lines);
+        void tokenizeStatement(const string& code, int lineNumber);
+        const vector<Token>& getTokens() const;
+        const vector<Identifier>& getsymbols() const;
+        void setSymbolType(size_t index, const string& type);
+
+        // For variables a pass introduces after lexing
+        void addSymbol(const string& name, const string& type, const string& scope);
+
+        const vector<tuple<string, int, int>>& getcodelines() const;
+        void printTables() const;
+};
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef LITERALS_H
+#define LITERALS_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+using namespace std;
+
+// Number and string literals decoded once, by the lexer, into the value they spell. The token
+// and the parse tree's Literal leaf share the payload, so constant folding and the backends read
+// values instead of re-parsing the literal text.
+
+enum LiteralKind {
+    LIT_INT,     // decimal or hex integer that fits in 64 bits
+    LIT_BIG_INT, // integer past 64 bits; text holds its digits
+    LIT_FLOAT,
+    LIT_STRING,  // text holds the contents with escapes resolved
+    LIT_FSTRING, // segments holds the literal and {expression} parts
+    LIT_INVALID  // f-string missing a '}'; text holds the error to raise when it is evaluated
+};
+
+// One piece of an f-string: literal text, or the source of a {expression} with its format spec
+struct FStringSegment {
+    bool isExpression;
+    string text;
+    string formatSpec;
+};
+
+struct LiteralValue {
+    LiteralKind kind = LIT_INVALID;
+    int64_t integer = 0;
+    double number = 0;
+    string text;
+    vector<FStringSegment> segments;
+};
+
+// Resolves backslash escapes in the body of a string literal
+inline string unescapeString(const string& body) {
+    string out;
+    out.reserve(body.size());
+    for (size_t k = 0; k < body.size(); k++) {
+        if (body[k] != '\\' || k + 1 == body.size()) {
+            out += body[k];
+            continue;
+        }
+        char c = body[++k];
+        switch (c) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case '0': out += '\0'; break;
+            case '\\': out += '\\'; break;
+            case '\'': out += '\''; break;
+            case '"': out += '"'; break;
+            default: out += '\\'; out += c;
+        }
+    }
+    return out;
+}
+
+inline bool isFormattedStringLiteral(const string& text) {
+    return text.size() >= 3 && (text[0] == 'f' || text[0] == 'F');
+}
+
+inline bool isStringLiteral(const string& text) {
+    return !text.empty() && (text[0] == '"' || text[0] == '\'' || isFormattedStringLiteral(text));
+}
+
+// Splits the text of an f-string literal; false when a '{' has no closing '}'
+inline bool splitFormattedString(const string& literal, vector<FStringSegment>& segments) {
+    string body = literal.substr(2, literal.size() - 3);
+    string text;
+    for (size_t k = 0; k < body.size(); k++) {
+        char c = body[k];
+        if ((c == '{' || c == '}') && k + 1 < body.size() && body[k + 1] == c) {
+            text += c;
+            k++;
+        } else if (c == '{') {
+            if (!text.empty()) segments.push_back({false, unescapeString(text), ""});
+            text.clear();
+            size_t close = body.find('}', k);
+            if (close == string::npos) return false;
+            string expr = body.substr(k + 1, close - k - 1);
+            string spec;
+            size_t colon = expr.find(':');
+            if (colon != string::npos) {
+                spec = expr.substr(colon + 1);
+                expr = expr.substr(0, colon);
+            }
+            segments.push_back({true, expr, spec});
+            k = close;
+        } else {
+            text += c;
+        }
+    }
+    if (!text.empty()) segments.push_back({false, unescapeString(text), ""});
+    return true;
+}
+
+// Decodes the text of a literal token: a quoted or f-string, or a decimal, hex or float number
+inline LiteralValue decodeLiteral(const string& text) {
+    LiteralValue literal;
+    if (isFormattedStringLiteral(text)) {
+        if (splitFormattedString(text, literal.segments)) {
+            literal.kind = LIT_FSTRING;
+        } else {
+            literal.segments.clear();
+            literal.text = "SyntaxError: f-string: expecting '}'";
+        }
+        return literal;
+    }
+    if (isStringLiteral(text)) {
+        literal.kind = LIT_STRING;
+        literal.text = unescapeString(text.substr(1, text.size() - 2));
+        return literal;
+    }
+    const char* first = text.c_str();
+    const char* last = first + text.size();
+    bool hex = text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X');
+    if (!hex && text.find_first_of(".eE") != string::npos) {
+        literal.kind = LIT_FLOAT;
+        auto parsed = from_chars(first, last, literal.number);
+        // Out of range spells infinity or zero, as strtod gives it
+        if (parsed.ec != errc()) literal.number = strtod(first, nullptr);
+        return literal;
+    }
+    auto parsed = from_chars(first + (hex ? 2 : 0), last, literal.integer, hex ? 16 : 10);
+    literal.kind = parsed.ec == errc() ? LIT_INT : LIT_BIG_INT;
+    if (literal.kind == LIT_BIG_INT) literal.text = text;
+    return literal;
+}
+
+#endif
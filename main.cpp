@@ -0,0 +1,338 @@
+// The command-line compiler: the passes after parsing and main(), linked with the lexer and
+// parser objects (lexer2.cpp, parser.cpp) that libpycompiler is built from
+#include "memory_telemetry.h"
+#include "parser.h"
+#include "pipeline.cpp"
+#include "ast_utils.cpp"
+#include "runtime.cpp"
+#include "type_inference.cpp"
+#include "optimizer.cpp"
+#include "inliner.cpp"
+#include "common_subexpressions.cpp"
+#include "control_flow.cpp"
+#include "dataflow.cpp"
+#include "symbol_index.cpp"
+#include "table_dump.cpp"
+#include "module_graph.cpp"
+#include "compile_server.cpp"
+#include "vm.cpp"
+#include "evaluator.cpp"
+#include "transpiler.cpp"
+
+// The global allocator counts allocations for --mem-stats (memory_telemetry.h). Only this
+// translation unit replaces it; the library leaves the embedding program's allocator alone
+void* operator new(size_t size) { return memory_telemetry::allocate(size); }
+void* operator new[](size_t size) { return memory_telemetry::allocate(size); }
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    try { return memory_telemetry::allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t size, const nothrow_t&) noexcept {
+    try { return memory_telemetry::allocate(size); } catch (...) { return nullptr; }
+}
+void operator delete(void* block) noexcept { memory_telemetry::release(block); }
+void operator delete[](void* block) noexcept { memory_telemetry::release(block); }
+void operator delete(void* block, size_t) noexcept { memory_telemetry::release(block); }
+void operator delete[](void* block, size_t) noexcept { memory_telemetry::release(block); }
+void operator delete(void* block, const nothrow_t&) noexcept { memory_telemetry::release(block); }
+void operator delete[](void* block, const nothrow_t&) noexcept { memory_telemetry::release(block); }
+
+// Print the parse tree and export it for Graphviz
+void reportParseTree(Parser& parser, const shared_ptr<ParseTreeNode>& parseTree) {
+    if (parseTree) {
+        cout << "Parsing successful! Parse tree:" << endl;
+        // Print the parse tree and save it to a DOT file
+        parser.printAndSaveTree("tree.dot");
+
+        // Generate PNG image from DOT file using Graphviz
+        int result = system("clear");
+        if (result == 0) {
+            cout << "Parse tree image saved as tree.png" << endl;
+        } else {
+            cerr << "Failed to generate tree.png. Make sure Graphviz is installed and 'dot' is in your PATH." << endl;
+        }
+    }
+}
+
+struct CompilerOptions {
+    string filename = "example.py";
+    bool pipelined = false;    // reader, lexer and parser on separate threads
+    bool run = false;          // execute the program on the bytecode VM instead of printing the report
+    bool showBytecode = false; // print the compiled bytecode instead of running it
+    bool evaluate = false;     // execute the program with the closure evaluator
+    bool emitCpp = false;      // print the program translated to C++
+    bool showTypes = false;    // print the inferred function signatures and variable types
+    bool optimize = true;      // fold constants and prune dead branches before running or translating
+    bool inlineCalls = true;   // replace calls of small single-return functions by their expression
+    bool reuseExpressions = true; // compute repeated and loop-invariant expressions once
+    bool optimizerStats = false; // print the node counts before and after optimizing
+    bool showCfg = false;      // print each function's control-flow graph in SSA form
+    bool check = false;        // report undefined names, unused assignments and unreachable code
+    bool leanTree = false;     // parse without Delimiter and syntax Keyword leaves
+    bool internLeaves = false; // share one node per distinct leaf
+    string indexRoot;          // index the .py files under this directory instead of compiling
+    string lookupName;         // print where this name is defined and referenced
+    string indexFile = "symbols.idx";
+    string buildRoot;          // analyse every module under this directory in import order
+    string buildCache = "modules.cache";
+    size_t jobs = 0;           // build threads; 0 uses one per hardware thread
+    string serveSocket;        // run as a server listening on this Unix socket
+    string clientSocket;       // send one request to the server on this socket
+    string clientCommand;      // lex, parse, check, stats or stop
+    bool sendBuffer = false;   // send the source read from stdin instead of having the server read the file
+    int repeat = 1;            // times to send the request, timing each round trip
+    bool profileParser = false; // print the per-rule parser profile (builds with -DPARSER_PROFILE)
+    string profileJson;        // also write the profile as JSON to this file
+    bool memoryStats = false;  // print allocations and retained bytes per front-end phase
+    string memoryJson;         // also write them as JSON to this file
+    string tableDump;          // write the token and symbol tables to this file as columnar binary
+    string readDump;           // print the tables stored in this dump instead of compiling
+    vector<string> queries;    // tree patterns to match, from --query and --query-file
+};
+
+// Lexes and parses the file, serially or pipelined, then infers types over the tree; returns
+// false when lexing failed. With 'report' set, the token and symbol tables are printed at the end.
+bool runFrontEnd(const CompilerOptions& options, Lexer& lexer, unique_ptr<Parser>& parser,
+                 shared_ptr<ParseTreeNode>& parseTree, bool report) {
+    if (!options.pipelined) {
+        MemoryPhase readPhase("read", "line");
+        if (!lexer.parser(options.filename)) return false;
+        readPhase.finish(lexer.getcodelines().size());
+        try
+        {
+            MemoryPhase lexPhase("lex", "token");
+            lexer.tokenizeLine(lexer.getcodelines());
+            lexPhase.finish(lexer.getTokens().size());
+        }
+        catch(const std::exception& e)
+        {
+            return false;
+        }
+
+        MemoryPhase parsePhase("parse", "node");
+        parser = make_unique<Parser>(lexer.getTokens());
+        parser->setLeanTree(options.leanTree);
+        parser->setInternLeaves(options.internLeaves);
+        parser->setBuildIndex(!options.queries.empty());
+#ifdef PARSER_PROFILE
+        if (options.profileParser) parser->enableProfile();
+#endif
+        parseTree = parser->parse();
+        size_t nodes = MemoryTelemetry::enabled() && parseTree ? countNodes(parseTree) : 0;
+        parsePhase.finish(nodes);
+        if (parseTree) {
+            MemoryPhase typesPhase("types", "node");
+            inferTypes(parseTree, lexer, options.showTypes);
+            typesPhase.finish(nodes);
+        }
+        if (report) lexer.printTables();
+        return true;
+    }
+
+    // Reader, lexer and parser run concurrently; the tables are printed once all stages are done
+    PipelinedFrontEnd frontEnd(lexer);
+    frontEnd.start(options.filename);
+    parser = make_unique<Parser>(frontEnd.tokenSource());
+    parser->setLeanTree(options.leanTree);
+    parser->setInternLeaves(options.internLeaves);
+    parser->setBuildIndex(!options.queries.empty());
+#ifdef PARSER_PROFILE
+    if (options.profileParser) parser->enableProfile();
+#endif
+    try
+    {
+        parseTree = parser->parse();
+        frontEnd.finish();
+    }
+    catch(const PipelineAborted&)
+    {
+        return false;
+    }
+    catch(const std::exception& e)
+    {
+        return false;
+    }
+
+    if (parseTree) inferTypes(parseTree, lexer, options.showTypes);
+    if (report) lexer.printTables();
+    return true;
+}
+
+// Prints the parser profile and writes its JSON export; false when the profiler is compiled out
+// or the export cannot be written
+bool reportParseProfile(const CompilerOptions& options, const Parser& parser) {
+#ifdef PARSER_PROFILE
+    const ParseProfile* profile = parser.getProfile();
+    if (!profile) return false;
+    profile->print(cout);
+    if (!options.profileJson.empty()) {
+        ofstream json(options.profileJson);
+        if (!json) {
+            cerr << "Error: Could not write " << options.profileJson << endl;
+            return false;
+        }
+        profile->writeJson(json, options.filename);
+    }
+    return true;
+#else
+    (void)options;
+    (void)parser;
+    cerr << "Error: Parser profiling is compiled out; rebuild with -DPARSER_PROFILE" << endl;
+    return false;
+#endif
+}
+
+// Prints the memory telemetry table and writes its JSON export; false when the export cannot be written
+bool reportMemoryStats(const CompilerOptions& options) {
+    const MemoryTelemetry& telemetry = MemoryTelemetry::instance();
+    telemetry.print(cout);
+    if (!options.memoryJson.empty()) {
+        ofstream json(options.memoryJson);
+        if (!json) {
+            cerr << "Error: Could not write " << options.memoryJson << endl;
+            return false;
+        }
+        telemetry.writeJson(json, options.filename);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    CompilerOptions options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--pipeline") {
+            options.pipelined = true;
+        } else if (arg == "--run") {
+            options.run = true;
+        } else if (arg == "--bytecode") {
+            options.showBytecode = true;
+        } else if (arg == "--eval") {
+            options.evaluate = true;
+        } else if (arg == "--emit-cpp") {
+            options.emitCpp = true;
+        } else if (arg == "--types") {
+            options.showTypes = true;
+        } else if (arg == "--lean") {
+            options.leanTree = true;
+        } else if (arg == "--intern") {
+            options.internLeaves = true;
+        } else if (arg == "--no-optimize") {
+            options.optimize = false;
+        } else if (arg == "--no-inline") {
+            options.inlineCalls = false;
+        } else if (arg == "--no-cse") {
+            options.reuseExpressions = false;
+        } else if (arg == "--opt-stats") {
+            options.optimizerStats = true;
+        } else if (arg == "--cfg") {
+            options.showCfg = true;
+        } else if (arg == "--check") {
+            options.check = true;
+        } else if (arg == "--index" && i + 1 < argc) {
+            options.indexRoot = argv[++i];
+        } else if (arg == "--lookup" && i + 1 < argc) {
+            options.lookupName = argv[++i];
+        } else if (arg == "--index-file" && i + 1 < argc) {
+            options.indexFile = argv[++i];
+        } else if (arg == "--build" && i + 1 < argc) {
+            options.buildRoot = argv[++i];
+        } else if (arg == "--build-cache" && i + 1 < argc) {
+            options.buildCache = argv[++i];
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            options.jobs = (size_t)max(0, atoi(argv[++i]));
+        } else if (arg == "--serve" && i + 1 < argc) {
+            options.serveSocket = argv[++i];
+        } else if (arg == "--client" && i + 2 < argc) {
+            options.clientSocket = argv[++i];
+            options.clientCommand = argv[++i];
+        } else if (arg == "--parse-profile") {
+            options.profileParser = true;
+        } else if (arg == "--parse-profile-json" && i + 1 < argc) {
+            options.profileParser = true;
+            options.profileJson = argv[++i];
+        } else if (arg == "--mem-stats") {
+            options.memoryStats = true;
+        } else if (arg == "--mem-stats-json" && i + 1 < argc) {
+            options.memoryStats = true;
+            options.memoryJson = argv[++i];
+        } else if (arg == "--dump-tables" && i + 1 < argc) {
+            options.tableDump = argv[++i];
+        } else if (arg == "--read-tables" && i + 1 < argc) {
+            options.readDump = argv[++i];
+        } else if (arg == "--query" && i + 1 < argc) {
+            options.queries.push_back(argv[++i]);
+        } else if (arg == "--query-file" && i + 1 < argc) {
+            ifstream patterns(argv[++i]);
+            if (!patterns) {
+                cerr << "Error: Could not open file " << argv[i] << endl;
+                return 1;
+            }
+            string line;
+            while (getline(patterns, line)) {
+                if (!line.empty() && line[0] != '#') options.queries.push_back(line);
+            }
+        } else if (arg == "--stdin") {
+            options.sendBuffer = true;
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            options.repeat = max(1, atoi(argv[++i]));
+        } else {
+            options.filename = arg;
+        }
+    }
+    if (!options.indexRoot.empty()) return buildSymbolIndex(options.indexRoot, options.indexFile);
+    if (!options.lookupName.empty()) return lookupSymbol(options.indexFile, options.lookupName);
+    if (!options.readDump.empty()) return printTableDump(options.readDump);
+    if (!options.buildRoot.empty()) {
+        size_t threads = options.jobs ? options.jobs : max(1u, thread::hardware_concurrency());
+        return buildModules(options.buildRoot, options.buildCache, threads);
+    }
+    if (!options.serveSocket.empty()) return serveRequests(options.serveSocket);
+    if (!options.clientSocket.empty()) {
+        return sendRequest(options.clientSocket, options.clientCommand, options.filename, options.sendBuffer, options.repeat);
+    }
+
+    bool backend = options.run || options.showBytecode || options.evaluate || options.emitCpp;
+    bool report = !backend && !options.showTypes && !options.optimizerStats && !options.showCfg && !options.check &&
+                  !options.profileParser && !options.memoryStats && options.tableDump.empty() &&
+                  options.queries.empty();
+    // The backends never look at syntax-only leaves, so they always get the lean tree
+    if (backend) options.leanTree = true;
+
+    if (options.memoryStats) {
+        // Phases are attributed per thread, so the stages must not overlap
+        options.pipelined = false;
+        MemoryTelemetry::enable();
+    }
+
+    Lexer lexer;
+    unique_ptr<Parser> parser;
+    shared_ptr<ParseTreeNode> parseTree;
+    if (!runFrontEnd(options, lexer, parser, parseTree, report)) {
+        return report ? 0 : 1;
+    }
+
+    if (!report) {
+        if (options.profileParser && !reportParseProfile(options, *parser)) return 1;
+        if (options.memoryStats && !reportMemoryStats(options)) return 1;
+        if (!options.tableDump.empty() && dumpTables(lexer, options.tableDump) != 0) return 1;
+        if (!parseTree) return 1;
+        // Checked before optimizing, which drops dead branches and replaces names with constants
+        int status = options.check ? checkSemantics(parseTree, cout) : 0;
+        if (!options.queries.empty()) status = max(status, runQueries(options.queries, *parser->getIndex(), cout));
+        // Only what follows reads the rewritten tree; the reports above are done with it
+        if (options.optimize && (backend || options.optimizerStats || options.showCfg)) {
+            if (options.inlineCalls) inlineFunctions(parseTree, lexer.getsymbols(), options.optimizerStats);
+            optimizeTree(parseTree, lexer.getsymbols(), options.optimizerStats);
+            if (options.reuseExpressions) eliminateCommonSubexpressions(parseTree, lexer, options.optimizerStats);
+        }
+        if (options.showCfg) printControlFlow(parseTree, cout);
+        if (!backend) return status;
+        ios::sync_with_stdio(false);
+        if (options.evaluate) return runClosures(parseTree, lexer.getsymbols());
+        if (options.emitCpp) return emitCpp(parseTree, lexer.getsymbols(), options.filename);
+        return runBytecode(parseTree, lexer.getsymbols(), options.showBytecode);
+    }
+
+    reportParseTree(*parser, parseTree);
+    return 0;
+}
@@ -0,0 +1,209 @@
+#ifndef MEMORY_TELEMETRY_H
+#define MEMORY_TELEMETRY_H
+
+#include <atomic>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <iomanip>
+#include <new>
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+using namespace std;
+
+// Allocation telemetry per compiler phase. allocate() and release() count every allocation while
+// telemetry is on, and a MemoryPhase scope attributes what happens during it to
+// a named phase: allocations, bytes allocated, bytes still live at its end, and the peak of live
+// bytes above its start. Nested phases are reported on their own and left out of the enclosing
+// phase's counts. With glibc, sizes are the allocator's usable sizes, so they include its rounding;
+// elsewhere each block carries its requested size in a header and sizes are the requested ones.
+//
+// The command-line compiler replaces the global operator new and delete with allocate() and
+// release(); with telemetry off (the default) they cost one relaxed load per call. Only the
+// thread that opened a phase is attributed to it; other threads count towards no phase.
+
+namespace memory_telemetry {
+    inline atomic<bool> enabled{false};
+    inline atomic<int64_t> liveBytes{0};
+    inline atomic<int64_t> peakBytes{0}; // highest liveBytes since the innermost phase began
+
+    struct Counters {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+    inline thread_local Counters* current = nullptr; // the innermost phase open on this thread
+
+    inline void recordAllocation(size_t size) {
+        if (!enabled.load(memory_order_relaxed)) return;
+        int64_t live = liveBytes.fetch_add((int64_t)size, memory_order_relaxed) + (int64_t)size;
+        int64_t peak = peakBytes.load(memory_order_relaxed);
+        while (live > peak && !peakBytes.compare_exchange_weak(peak, live, memory_order_relaxed)) {}
+        if (current) {
+            current->allocations++;
+            current->bytes += size;
+        }
+    }
+
+    inline void recordFree(size_t size) {
+        if (!enabled.load(memory_order_relaxed)) return;
+        liveBytes.fetch_sub((int64_t)size, memory_order_relaxed);
+    }
+
+#ifdef __GLIBC__
+    inline void* allocate(size_t size) {
+        void* block = malloc(size ? size : 1);
+        if (!block) throw bad_alloc();
+        if (enabled.load(memory_order_relaxed)) recordAllocation(malloc_usable_size(block));
+        return block;
+    }
+
+    inline void release(void* block) noexcept {
+        if (block && enabled.load(memory_order_relaxed)) recordFree(malloc_usable_size(block));
+        free(block);
+    }
+#else
+    // Keeps the block's size in front of it, padded so the block stays suitably aligned
+    const size_t headerBytes = alignof(max_align_t);
+
+    inline void* allocate(size_t size) {
+        if (size > SIZE_MAX - headerBytes) throw bad_alloc();
+        char* start = static_cast<char*>(malloc(size + headerBytes));
+        if (!start) throw bad_alloc();
+        *reinterpret_cast<size_t*>(start) = size;
+        recordAllocation(size);
+        return start + headerBytes;
+    }
+
+    inline void release(void* block) noexcept {
+        if (!block) return;
+        char* start = static_cast<char*>(block) - headerBytes;
+        recordFree(*reinterpret_cast<size_t*>(start));
+        free(start);
+    }
+#endif
+}
+
+struct MemoryPhaseReport {
+    string name;
+    string unit;           // what the per-unit figures divide by: line, token, symbol, node
+    uint64_t units = 0;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;    // allocated during the phase
+    int64_t retained = 0;  // allocated during the phase and still live at its end
+    int64_t peak = 0;      // highest live bytes during the phase, above the level it started at
+};
+
+class MemoryTelemetry {
+    private:
+        vector<MemoryPhaseReport> phases;
+
+    public:
+        static MemoryTelemetry& instance() {
+            static MemoryTelemetry telemetry;
+            return telemetry;
+        }
+
+        static bool enabled() { return memory_telemetry::enabled.load(memory_order_relaxed); }
+        static void enable() { memory_telemetry::enabled = true; }
+
+        // Adds a finished phase, merging it into an earlier one of the same name
+        void record(const MemoryPhaseReport& report) {
+            for (auto& phase : phases) {
+                if (phase.name != report.name) continue;
+                phase.units += report.units;
+                phase.allocations += report.allocations;
+                phase.bytes += report.bytes;
+                phase.retained += report.retained;
+                phase.peak = max(phase.peak, report.peak);
+                return;
+            }
+            phases.push_back(report);
+        }
+
+        bool empty() const { return phases.empty(); }
+
+        void print(ostream& out) const {
+            out << "--- Memory ---" << endl;
+            out << left << setw(14) << "Phase" << right << setw(10) << "Units" << setw(12) << "Allocs" << setw(14) << "Bytes"
+                << setw(14) << "Retained" << setw(14) << "Peak" << setw(12) << "Bytes/unit" << "  Unit" << endl;
+            for (const auto& phase : phases) {
+                out << left << setw(14) << phase.name << right << setw(10) << phase.units << setw(12) << phase.allocations
+                    << setw(14) << phase.bytes << setw(14) << phase.retained << setw(14) << phase.peak << setw(12) << fixed
+                    << setprecision(1) << (phase.units ? (double)phase.retained / phase.units : 0.0) << "  " << phase.unit << endl;
+            }
+        }
+
+        void writeJson(ostream& out, const string& file) const {
+            out << "{\"file\": \"";
+            for (char c : file) {
+                if (c == '"' || c == '\\') out << '\\';
+                out << c;
+            }
+            out << "\", \"phases\": [";
+            for (size_t k = 0; k < phases.size(); k++) {
+                const auto& phase = phases[k];
+                out << (k ? "," : "") << "\n  {\"phase\": \"" << phase.name << "\", \"unit\": \"" << phase.unit
+                    << "\", \"units\": " << phase.units << ", \"allocations\": " << phase.allocations
+                    << ", \"bytes\": " << phase.bytes << ", \"retained_bytes\": " << phase.retained
+                    << ", \"peak_bytes\": " << phase.peak << ", \"retained_per_unit\": " << fixed << setprecision(2)
+                    << (phase.units ? (double)phase.retained / phase.units : 0.0) << "}";
+            }
+            out << "\n]}" << endl;
+        }
+};
+
+// Attributes this thread's allocations to a phase until finish() or the end of the scope. Phases
+// with the same name, e.g. one per symbol table insertion, are merged into one report
+class MemoryPhase {
+    private:
+        const char* name;
+        const char* unit;
+        bool active;
+        memory_telemetry::Counters counters;
+        memory_telemetry::Counters* outer = nullptr;
+        int64_t startLive = 0, outerPeak = 0;
+        int64_t nestedRetained = 0; // bytes nested phases kept, left out of this one
+        MemoryPhase* outerPhase = nullptr;
+        static inline thread_local MemoryPhase* innermost = nullptr;
+
+    public:
+        MemoryPhase(const char* phaseName, const char* unitName)
+            : name(phaseName), unit(unitName), active(MemoryTelemetry::enabled()) {
+            if (!active) return;
+            outer = memory_telemetry::current;
+            outerPhase = innermost;
+            startLive = memory_telemetry::liveBytes.load(memory_order_relaxed);
+            outerPeak = memory_telemetry::peakBytes.exchange(startLive, memory_order_relaxed);
+            memory_telemetry::current = &counters;
+            innermost = this;
+        }
+
+        ~MemoryPhase() { finish(0); }
+
+        MemoryPhase(const MemoryPhase&) = delete;
+        MemoryPhase& operator=(const MemoryPhase&) = delete;
+
+        // Ends the phase, 'units' being the lines, tokens or nodes it produced
+        void finish(uint64_t units) {
+            if (!active) return;
+            active = false;
+            memory_telemetry::current = outer;
+            innermost = outerPhase;
+            int64_t live = memory_telemetry::liveBytes.load(memory_order_relaxed);
+            int64_t peak = memory_telemetry::peakBytes.load(memory_order_relaxed);
+            // The enclosing phase's peak covers this one too
+            memory_telemetry::peakBytes.store(max(peak, outerPeak), memory_order_relaxed);
+            int64_t retained = live - startLive;
+            if (outerPhase) outerPhase->nestedRetained += retained;
+
+            MemoryTelemetry::instance().record(
+                {name, unit, units, counters.allocations, counters.bytes, retained - nestedRetained, peak - startLive});
+        }
+};
+
+#endif
@@ -0,0 +1,487 @@
+#include <memory>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include "thread_pool.h"
+using namespace std;
+
+// Whole-program builds over a source root. Every .py file is a module named by its path
+// ('pkg/mod.py' is 'pkg.mod', 'pkg/__init__.py' is 'pkg'); import statements that name another
+// module of the root become edges of a dependency graph, and imports of anything else are
+// external and ignored. Modules are then analysed in topological waves on a thread pool: a wave
+// holds every module whose dependencies are all done, so an analysis can use what its imports
+// export, checking 'from m import x' against m and resolving names a star import brings in.
+// Modules on an import cycle, and those importing them, are reported and skipped. An import that
+// names a module under a package or module of the root that does not exist is reported as an error.
+//
+// The build cache remembers each module's imports by content hash and its results by input
+// hash, which mixes the module's own hash with the input hashes of its dependencies. A rebuild
+// parses only changed files and re-analyses only modules whose transitive inputs changed.
+
+struct ModuleUnit {
+    string name;
+    string path;
+    string source;
+    uint64_t contentHash = 0;
+    uint64_t inputHash = 0;         // contents plus the input hashes of every dependency
+    vector<string> importedModules; // dotted names the imports may load, in this root or not
+    vector<string> namedModules;    // the ones the statements spell out, which must exist
+    vector<string> unresolved;      // named modules under the root that are not there
+    vector<uint32_t> dependencies;  // modules of this root that it imports
+    shared_ptr<ParseTreeNode> tree; // held from finding the imports until the analysis
+
+    // Results, from the analysis or the cache
+    vector<string> exports;         // names bound at the top level, sorted
+    vector<string> diagnostics;
+    bool failed = false;            // did not parse, or has an error diagnostic
+    bool analysed = false;          // false when the results came from the cache
+};
+
+const char moduleCacheMagic[8] = {'M', 'O', 'D', 'C', 'A', 'C', 'H', '2'};
+
+uint64_t mixHash(uint64_t hash, uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8) {
+        hash ^= (value >> shift) & 0xff;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Import statements anywhere in the tree, with the name of the function they appear in
+void collectImports(const shared_ptr<ParseTreeNode>& node, const string& scope,
+                    vector<pair<shared_ptr<ParseTreeNode>, string>>& out) {
+    if (node->type == "ImportStatement") {
+        out.push_back({node, scope});
+        return;
+    }
+    if (node->type == "FunctionDefinition") {
+        const string& name = findChild(node, "Identifier")->value;
+        for (const auto& child : node->children) collectImports(child, name, out);
+        return;
+    }
+    for (const auto& child : node->children) collectImports(child, scope, out);
+}
+
+string dottedName(const shared_ptr<ParseTreeNode>& node) {
+    string name;
+    for (const auto& part : node->children) name += (name.empty() ? "" : ".") + part->value;
+    return name;
+}
+
+class ModuleBuilder {
+    private:
+        struct CachedModule {
+            uint64_t contentHash, inputHash;
+            bool failed;
+            vector<string> importedModules, namedModules, exports, diagnostics;
+        };
+
+        string root;
+        ThreadPool pool;
+        vector<ModuleUnit> modules;
+        unordered_map<string, uint32_t> byName;
+        unordered_map<string, CachedModule> cache; // by path
+        vector<vector<uint32_t>> waves;
+        vector<uint32_t> blocked; // on an import cycle or importing one
+        vector<string> cycles;
+        size_t externalImports = 0;
+        size_t unresolvedImports = 0;
+
+        // ---- Cache ----
+
+        static void writeString(ostream& out, const string& text) {
+            uint32_t length = (uint32_t)text.size();
+            out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            out.write(text.data(), length);
+        }
+
+        static void writeStrings(ostream& out, const vector<string>& texts) {
+            uint32_t count = (uint32_t)texts.size();
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            for (const string& text : texts) writeString(out, text);
+        }
+
+        template <typename T>
+        static bool readValue(istream& in, T& value) {
+            return (bool)in.read(reinterpret_cast<char*>(&value), sizeof(value));
+        }
+
+        static bool readString(istream& in, string& text) {
+            uint32_t length;
+            if (!readValue(in, length) || length > (1u << 28)) return false;
+            text.resize(length);
+            return (bool)in.read(&text[0], length);
+        }
+
+        static bool readStrings(istream& in, vector<string>& texts) {
+            uint32_t count;
+            if (!readValue(in, count) || count > (1u << 24)) return false;
+            texts.resize(count);
+            for (string& text : texts) {
+                if (!readString(in, text)) return false;
+            }
+            return true;
+        }
+
+        // ---- Import resolution ----
+
+        // 'import a.b' loads a and a.b; 'from a.b import c' loads a, a.b and a.b.c when that is a module.
+        // 'named' gets the names spelled out, a and a.b, without the guess a.b.c
+        static void importCandidates(const shared_ptr<ParseTreeNode>& statement, vector<string>& out, vector<string>& named) {
+            string base;
+            for (const auto& child : statement->children) {
+                if (child->type == "DottedName") {
+                    base.clear();
+                    for (const auto& part : child->children) {
+                        base += (base.empty() ? "" : ".") + part->value;
+                        out.push_back(base);
+                        named.push_back(base);
+                    }
+                } else if (child->type == "ImportName") {
+                    out.push_back(base + "." + child->value);
+                }
+            }
+        }
+
+        static void sortUnique(vector<string>& names) {
+            sort(names.begin(), names.end());
+            names.erase(unique(names.begin(), names.end()), names.end());
+        }
+
+        void findImports(ModuleUnit& unit) {
+            unit.tree = parseSource(unit.source);
+            if (!unit.tree) {
+                unit.failed = true; // analysed without parsing again
+                return;
+            }
+            vector<pair<shared_ptr<ParseTreeNode>, string>> statements;
+            collectImports(unit.tree, "<module>", statements);
+            for (const auto& statement : statements) importCandidates(statement.first, unit.importedModules, unit.namedModules);
+            sortUnique(unit.importedModules);
+            sortUnique(unit.namedModules);
+        }
+
+        // ---- Analysis ----
+
+        bool exports(uint32_t module, const string& name) const {
+            const auto& names = modules[module].exports;
+            return binary_search(names.begin(), names.end(), name);
+        }
+
+        void analyse(ModuleUnit& unit) {
+            unit.analysed = true;
+            if (!unit.tree && !unit.failed) unit.tree = parseSource(unit.source);
+            if (!unit.tree) {
+                unit.failed = true;
+                unit.diagnostics.push_back("Error: the module does not parse");
+                return;
+            }
+
+            // Check 'from m import x' against m, and gather what star imports bind
+            vector<Diagnostic> diagnostics;
+            unordered_set<string> starNames;
+            vector<pair<shared_ptr<ParseTreeNode>, string>> statements;
+            collectImports(unit.tree, "<module>", statements);
+            for (const auto& statement : statements) {
+                const auto& node = statement.first;
+                if (node->children[0]->value != "from") continue;
+                string source = dottedName(findChild(node, "DottedName"));
+                auto found = byName.find(source);
+                if (found == byName.end() || &modules[found->second] == &unit) continue;
+                for (const auto& child : node->children) {
+                    if (child->type == "ImportAll") {
+                        const auto& names = modules[found->second].exports;
+                        starNames.insert(names.begin(), names.end());
+                    } else if (child->type == "ImportName" && !exports(found->second, child->value) &&
+                               !byName.count(source + "." + child->value)) {
+                        diagnostics.push_back({node->line, true, statement.second,
+                                               "module '" + source + "' has no name '" + child->value + "'"});
+                    }
+                }
+            }
+
+            auto graphs = buildControlFlow(unit.tree);
+            for (auto& diagnostic : DataflowChecker(graphs, &starNames).check()) diagnostics.push_back(move(diagnostic));
+            stable_sort(diagnostics.begin(), diagnostics.end(),
+                        [](const Diagnostic& a, const Diagnostic& b) { return a.line < b.line; });
+            for (const auto& diagnostic : diagnostics) {
+                unit.diagnostics.push_back(formatDiagnostic(diagnostic));
+                if (diagnostic.error) unit.failed = true;
+            }
+
+            unit.exports = graphs[0].variables;
+            unit.exports.insert(unit.exports.end(), starNames.begin(), starNames.end());
+            sort(unit.exports.begin(), unit.exports.end());
+            unit.exports.erase(unique(unit.exports.begin(), unit.exports.end()), unit.exports.end());
+            unit.tree.reset();
+            unit.source.clear();
+        }
+
+    public:
+        ModuleBuilder(const string& sourceRoot, size_t threads) : root(sourceRoot), pool(threads) {}
+
+        size_t threadCount() const { return pool.size(); }
+
+        // Finds, reads and hashes every module; false when the root cannot be read
+        bool discover() {
+            vector<filesystem::path> paths;
+            error_code failure;
+            for (filesystem::recursive_directory_iterator it(root, filesystem::directory_options::skip_permission_denied, failure), end;
+                 !failure && it != end; it.increment(failure)) {
+                if (it->is_regular_file() && it->path().extension() == ".py") paths.push_back(it->path());
+            }
+            if (failure) {
+                cerr << "Error: Could not read directory " << root << ": " << failure.message() << endl;
+                return false;
+            }
+            sort(paths.begin(), paths.end());
+
+            modules.resize(paths.size());
+            for (size_t k = 0; k < paths.size(); k++) {
+                ModuleUnit& unit = modules[k];
+                unit.path = paths[k].lexically_normal().string();
+                filesystem::path relative = paths[k].lexically_relative(root).replace_extension();
+                for (const auto& part : relative) unit.name += (unit.name.empty() ? "" : ".") + part.string();
+                const string suffix = ".__init__";
+                if (unit.name == "__init__") unit.name.clear();
+                else if (unit.name.size() > suffix.size() && unit.name.compare(unit.name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                    unit.name.resize(unit.name.size() - suffix.size());
+                }
+                byName.emplace(unit.name, (uint32_t)k);
+            }
+            pool.forEach(modules.size(), [&](size_t k) {
+                ModuleUnit& unit = modules[k];
+                ifstream in(unit.path, ios::binary);
+                stringstream contents;
+                contents << in.rdbuf();
+                unit.source = contents.str();
+                unit.contentHash = hashBytes(unit.source);
+            });
+            return true;
+        }
+
+        // A missing or unreadable cache just means a full build
+        void loadCache(const string& path) {
+            ifstream in(path, ios::binary);
+            char magic[sizeof(moduleCacheMagic)];
+            uint32_t count;
+            if (!in.read(magic, sizeof(magic)) || memcmp(magic, moduleCacheMagic, sizeof(magic)) != 0 || !readValue(in, count)) return;
+            for (uint32_t k = 0; k < count; k++) {
+                string modulePath;
+                CachedModule entry;
+                uint8_t failed;
+                if (!readString(in, modulePath) || !readValue(in, entry.contentHash) || !readValue(in, entry.inputHash) ||
+                    !readValue(in, failed) || !readStrings(in, entry.importedModules) || !readStrings(in, entry.namedModules) ||
+                    !readStrings(in, entry.exports) ||
+                    !readStrings(in, entry.diagnostics)) {
+                    cache.clear();
+                    return;
+                }
+                entry.failed = failed != 0;
+                cache[modulePath] = move(entry);
+            }
+        }
+
+        bool saveCache(const string& path) const {
+            string temporary = path + ".tmp";
+            ofstream out(temporary, ios::binary | ios::trunc);
+            if (!out) return false;
+            out.write(moduleCacheMagic, sizeof(moduleCacheMagic));
+            uint32_t count = 0;
+            for (const auto& wave : waves) count += (uint32_t)wave.size();
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            for (const auto& wave : waves) {
+                for (uint32_t k : wave) {
+                    const ModuleUnit& unit = modules[k];
+                    writeString(out, unit.path);
+                    out.write(reinterpret_cast<const char*>(&unit.contentHash), sizeof(unit.contentHash));
+                    out.write(reinterpret_cast<const char*>(&unit.inputHash), sizeof(unit.inputHash));
+                    uint8_t failed = unit.failed;
+                    out.write(reinterpret_cast<const char*>(&failed), sizeof(failed));
+                    writeStrings(out, unit.importedModules);
+                    writeStrings(out, unit.namedModules);
+                    writeStrings(out, unit.exports);
+                    writeStrings(out, unit.diagnostics);
+                }
+            }
+            out.close();
+            if (!out) return false;
+            error_code failure;
+            filesystem::rename(temporary, path, failure);
+            return !failure;
+        }
+
+        // Takes each module's imports from the cache when its contents are unchanged, parsing the
+        // others in parallel, then turns them into edges between the modules of the root
+        void linkModules() {
+            vector<uint32_t> changed;
+            for (uint32_t k = 0; k < modules.size(); k++) {
+                auto cached = cache.find(modules[k].path);
+                if (cached != cache.end() && cached->second.contentHash == modules[k].contentHash) {
+                    modules[k].importedModules = cached->second.importedModules;
+                    modules[k].namedModules = cached->second.namedModules;
+                } else {
+                    changed.push_back(k);
+                }
+            }
+            pool.forEach(changed.size(), [&](size_t k) { findImports(modules[changed[k]]); });
+
+            for (uint32_t k = 0; k < modules.size(); k++) {
+                ModuleUnit& unit = modules[k];
+                for (const string& name : unit.importedModules) {
+                    auto found = byName.find(name);
+                    if (found == byName.end()) {
+                        // Only the names a statement spelled out count, not the 'from' guesses
+                        if (name.find('.') == string::npos) externalImports++;
+                        continue;
+                    }
+                    if (found->second != k) unit.dependencies.push_back(found->second);
+                }
+                sort(unit.dependencies.begin(), unit.dependencies.end());
+                unit.dependencies.erase(unique(unit.dependencies.begin(), unit.dependencies.end()), unit.dependencies.end());
+
+                // 'pkg.c' is missing when pkg is a module of the root; a missing 'pkg.c.d' is
+                // reported as pkg.c only
+                for (const string& name : unit.namedModules) {
+                    size_t dot = name.rfind('.');
+                    if (dot == string::npos || byName.count(name) || !byName.count(name.substr(0, dot))) continue;
+                    unit.unresolved.push_back(name);
+                    unresolvedImports++;
+                }
+            }
+        }
+
+        // Kahn's algorithm one level at a time; what never becomes ready is on a cycle or behind one
+        void planWaves() {
+            vector<uint32_t> pending(modules.size());
+            vector<vector<uint32_t>> importers(modules.size());
+            vector<uint32_t> ready;
+            for (uint32_t k = 0; k < modules.size(); k++) {
+                pending[k] = (uint32_t)modules[k].dependencies.size();
+                for (uint32_t dependency : modules[k].dependencies) importers[dependency].push_back(k);
+                if (pending[k] == 0) ready.push_back(k);
+            }
+            size_t placed = 0;
+            while (!ready.empty()) {
+                vector<uint32_t> next;
+                for (uint32_t k : ready) {
+                    for (uint32_t importer : importers[k]) {
+                        if (--pending[importer] == 0) next.push_back(importer);
+                    }
+                }
+                placed += ready.size();
+                sort(next.begin(), next.end());
+                waves.push_back(move(ready));
+                ready = move(next);
+            }
+            if (placed == modules.size()) return;
+
+            // Every blocked module imports another blocked one, so following those edges from any
+            // of them ends on a cycle, or on a module an earlier walk already passed
+            vector<uint8_t> state(modules.size(), 0); // 1 on the current walk, 2 done
+            for (uint32_t k = 0; k < modules.size(); k++) {
+                if (pending[k] == 0) continue;
+                blocked.push_back(k);
+                if (state[k]) continue;
+                vector<uint32_t> walk;
+                uint32_t current = k;
+                while (state[current] == 0) {
+                    state[current] = 1;
+                    walk.push_back(current);
+                    for (uint32_t dependency : modules[current].dependencies) {
+                        if (pending[dependency] != 0) {
+                            current = dependency;
+                            break;
+                        }
+                    }
+                }
+                if (state[current] == 1) {
+                    string cycle;
+                    auto start = find(walk.begin(), walk.end(), current);
+                    for (auto it = start; it != walk.end(); ++it) cycle += modules[*it].name + " -> ";
+                    cycles.push_back(cycle + modules[current].name);
+                }
+                for (uint32_t visited : walk) state[visited] = 2;
+            }
+        }
+
+        // Analyses the waves in order; within one, every module whose inputs changed runs in parallel
+        void runWaves() {
+            for (const auto& wave : waves) {
+                vector<uint32_t> work;
+                for (uint32_t k : wave) {
+                    ModuleUnit& unit = modules[k];
+                    unit.inputHash = unit.contentHash;
+                    for (uint32_t dependency : unit.dependencies) unit.inputHash = mixHash(unit.inputHash, modules[dependency].inputHash);
+                    auto cached = cache.find(unit.path);
+                    if (cached != cache.end() && cached->second.contentHash == unit.contentHash &&
+                        cached->second.inputHash == unit.inputHash) {
+                        unit.exports = cached->second.exports;
+                        unit.diagnostics = cached->second.diagnostics;
+                        unit.failed = cached->second.failed;
+                        unit.tree.reset();
+                        unit.source.clear();
+                    } else {
+                        work.push_back(k);
+                    }
+                }
+                pool.forEach(work.size(), [&](size_t k) { analyse(modules[work[k]]); });
+            }
+        }
+
+        // Prints the diagnostics in build order and a summary; returns the process exit status
+        int report(ostream& out, double elapsed) const {
+            size_t analysed = 0, reused = 0;
+            bool failed = !blocked.empty();
+            for (const auto& wave : waves) {
+                for (uint32_t k : wave) {
+                    const ModuleUnit& unit = modules[k];
+                    for (const string& name : unit.unresolved) {
+                        out << unit.path << ": Error: no module named '" << name << "' under the root" << endl;
+                    }
+                    for (const string& line : unit.diagnostics) out << unit.path << ": " << line << endl;
+                    if (unit.analysed) analysed++;
+                    else reused++;
+                    failed = failed || unit.failed || !unit.unresolved.empty();
+                }
+            }
+            for (const string& cycle : cycles) out << "Error: import cycle " << cycle << endl;
+            for (uint32_t k : blocked) {
+                for (const string& name : modules[k].unresolved) {
+                    out << modules[k].path << ": Error: no module named '" << name << "' under the root" << endl;
+                }
+                out << modules[k].path << ": skipped, it is on or behind an import cycle" << endl;
+            }
+            out << "Built " << modules.size() << " modules in " << waves.size() << " waves on " << pool.size()
+                << (pool.size() == 1 ? " thread (" : " threads (") << analysed << " analysed, " << reused << " unchanged, " << blocked.size()
+                << " blocked by cycles, " << externalImports << " external imports, " << unresolvedImports
+                << " unresolved) in " << fixed << setprecision(1)
+                << elapsed << " ms" << endl;
+            return failed ? 1 : 0;
+        }
+};
+
+// Builds every module under 'root', reusing the results in 'cachePath' whose inputs are
+// unchanged; returns the process exit status
+int buildModules(const string& root, const string& cachePath, size_t threads) {
+    auto started = chrono::steady_clock::now();
+    ModuleBuilder builder(root, threads);
+    if (!builder.discover()) return 1;
+    builder.loadCache(cachePath);
+    builder.linkModules();
+    builder.planWaves();
+    builder.runWaves();
+    if (!builder.saveCache(cachePath)) cerr << "Error: Could not write build cache " << cachePath << endl;
+    double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    return builder.report(cout, elapsed);
+}
@@ -0,0 +1,52 @@
+#ifndef NODE_KINDS_H
+#define NODE_KINDS_H
+
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+using namespace std;
+
+// Every parse tree node type, as one list so the enum, the name table and the visitor hooks
+// in ast_visitor.h are generated from the same place
+#define PARSE_NODE_KINDS(X) \
+    X(Program) X(Suite) \
+    X(Assignment) X(IdentifierList) X(AssignOp) \
+    X(IfStatement) X(ElifClause) X(ElseClause) X(WhileStatement) X(ForStatement) \
+    X(FunctionDefinition) X(Parameters) X(Parameter) X(ReturnStatement) \
+    X(ClassDefinition) X(Parent) \
+    X(PassStatement) X(BreakStatement) X(ContinueStatement) \
+    X(ImportStatement) X(DottedName) X(NamePart) X(Alias) X(ImportName) X(ImportAll) \
+    X(ExpressionStatement) X(FunctionCallStatement) \
+    X(TernaryOp) X(BinaryOp) X(UnaryOp) X(Comparison) X(ComparisonOp) X(ExpressionList) \
+    X(FunctionCall) X(Arguments) X(AttributeAccess) X(Subscript) \
+    X(ParenExpr) X(Tuple) X(List) X(Dict) X(KeyValuePair) \
+    X(Identifier) X(Literal) X(Keyword) X(Delimiter)
+
+enum class NodeKind : uint8_t {
+#define PARSE_NODE_KIND_ENUM(name) name,
+    PARSE_NODE_KINDS(PARSE_NODE_KIND_ENUM)
+#undef PARSE_NODE_KIND_ENUM
+    Other // a type string outside the list
+};
+
+inline NodeKind nodeKindOf(const string& type) {
+    static const unordered_map<string, NodeKind> kinds = {
+#define PARSE_NODE_KIND_ENTRY(name) {#name, NodeKind::name},
+        PARSE_NODE_KINDS(PARSE_NODE_KIND_ENTRY)
+#undef PARSE_NODE_KIND_ENTRY
+    };
+    auto found = kinds.find(type);
+    return found == kinds.end() ? NodeKind::Other : found->second;
+}
+
+inline const char* nodeKindName(NodeKind kind) {
+    switch (kind) {
+#define PARSE_NODE_KIND_NAME(name) case NodeKind::name: return #name;
+        PARSE_NODE_KINDS(PARSE_NODE_KIND_NAME)
+#undef PARSE_NODE_KIND_NAME
+        case NodeKind::Other: break;
+    }
+    return "Other";
+}
+
+#endif
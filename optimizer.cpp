@@ -0,0 +1,441 @@
+#include <memory>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdexcept>
+#include <iomanip>
+#include <cmath>
+using namespace std;
+
+// Folds constant expressions, propagates module-level constants and drops branches whose
+// conditions are known. Runs on the parse tree before a backend executes or translates it, and
+// only rewrites what evaluates the same way at run time: anything that would raise, does not fit
+// back into a literal, or could change which names a function binds is left alone.
+
+const size_t maxFoldedStringLength = 4096;
+const size_t maxPropagatedStringLength = 64;
+
+class TreeOptimizer {
+    private:
+        const vector<Identifier>& symbols;
+        unordered_map<string, shared_ptr<ParseTreeNode>> constants; // module constants in effect
+        unordered_set<string> candidates;  // module names bound exactly once, by a top-level '='
+        const unordered_set<string>* shadowed = nullptr; // locals of the function being optimized
+        bool inFunction = false;
+
+        // ---- Constants ----
+
+        static bool constantValue(const shared_ptr<ParseTreeNode>& node, Value& out) {
+            if (node->type == "Keyword") {
+                if (node->value == "True" || node->value == "False") out = Value::boolean(node->value == "True");
+                else if (node->value == "None") out = Value::none();
+                else return false;
+                return true;
+            }
+            if (node->type != "Literal") return false;
+            const LiteralValue& literal = literalOf(node);
+            // f-strings are not constant, and a too-large integer fails when it runs
+            if (literal.kind != LIT_INT && literal.kind != LIT_FLOAT && literal.kind != LIT_STRING) return false;
+            out = literalConstant(literal);
+            return true;
+        }
+
+        static string quoteString(const string& s) {
+            string out = "\"";
+            for (char c : s) {
+                switch (c) {
+                    case '\n': out += "\\n"; break;
+                    case '\t': out += "\\t"; break;
+                    case '\r': out += "\\r"; break;
+                    case '\0': out += "\\0"; break;
+                    case '\\': out += "\\\\"; break;
+                    case '"': out += "\\\""; break;
+                    default: out += c;
+                }
+            }
+            return out + "\"";
+        }
+
+        // The literal node for a folded value; nullptr when no literal spells it
+        static shared_ptr<ParseTreeNode> constantNode(const Value& value) {
+            shared_ptr<ParseTreeNode> node;
+            switch (value.kind) {
+                case V_NONE:
+                    node = make_shared<ParseTreeNode>("Keyword", "None");
+                    node->inferredType = "None";
+                    return node;
+                case V_BOOL:
+                    node = make_shared<ParseTreeNode>("Keyword", value.b ? "True" : "False");
+                    node->inferredType = "bool";
+                    return node;
+                case V_INT:
+                    node = make_shared<ParseTreeNode>("Literal", to_string(value.i));
+                    node->inferredType = "int";
+                    return node;
+                case V_FLOAT:
+                    if (!std::isfinite(value.f)) return nullptr;
+                    node = make_shared<ParseTreeNode>("Literal", formatFloat(value.f));
+                    node->inferredType = "float";
+                    return node;
+                case V_STR: {
+                    const string& text = asStr(value)->s;
+                    if (text.size() > maxFoldedStringLength) return nullptr;
+                    string literal = quoteString(text);
+                    if (unescapeString(literal.substr(1, literal.size() - 2)) != text) return nullptr;
+                    node = make_shared<ParseTreeNode>("Literal", literal);
+                    node->inferredType = "string";
+                    return node;
+                }
+                default:
+                    return nullptr;
+            }
+        }
+
+        static bool compareConstants(const string& op, const Value& a, const Value& b) {
+            if (op == "==") return valuesEqual(a, b);
+            if (op == "!=") return !valuesEqual(a, b);
+            if (op == "in") return containsValue(b, a);
+            if (op == "not in") return !containsValue(b, a);
+            int order = compareValues(a, b, op.c_str());
+            if (op == "<") return order < 0;
+            if (op == ">") return order > 0;
+            if (op == "<=") return order <= 0;
+            if (op == ">=") return order >= 0;
+            throw runtime_error("unsupported comparison " + op);
+        }
+
+        // ---- Expressions ----
+
+        shared_ptr<ParseTreeNode> foldArithChain(const shared_ptr<ParseTreeNode>& node) {
+            // Python evaluates the chain left to right, so only a constant prefix can be combined
+            auto items = semanticChildren(node);
+            Value result;
+            if (!constantValue(items[0], result)) return node;
+            size_t folded = 0;
+            for (size_t k = 1; k + 1 < items.size(); k += 2) {
+                Value right;
+                BinaryOperator op;
+                if (!constantValue(items[k + 1], right) || !binaryOperatorFromString(items[k]->value, op)) break;
+                try {
+                    Value next = binaryOp(op, result, right);
+                    if (!constantNode(next)) break;
+                    result = next;
+                } catch (const runtime_error&) {
+                    break;
+                }
+                folded = k + 1;
+            }
+            if (folded == 0) return node;
+            auto literal = constantNode(result);
+            if (folded + 1 == items.size()) return literal;
+            auto chain = make_shared<ParseTreeNode>(node->type, node->value);
+            chain->inferredType = node->inferredType;
+            chain->addChild(literal);
+            for (size_t k = folded + 1; k < items.size(); k++) chain->addChild(items[k]);
+            return chain;
+        }
+
+        shared_ptr<ParseTreeNode> foldExpression(const shared_ptr<ParseTreeNode>& node) {
+            const string& type = node->type;
+            auto parts = semanticChildren(node);
+            Value a, b;
+            if (type == "ParenExpr") {
+                Value inner;
+                return constantValue(parts[0], inner) ? parts[0] : node;
+            }
+            if (type == "ExpressionList" && isArithChain(node)) return foldArithChain(node);
+            if (type == "BinaryOp" && parts.size() == 2 && constantValue(parts[0], a)) {
+                // 'and'/'or' yield one of their operands, so a constant left side decides which
+                if (node->value == "and") return truthy(a) ? parts[1] : parts[0];
+                if (node->value == "or") return truthy(a) ? parts[0] : parts[1];
+                BinaryOperator op;
+                if (!constantValue(parts[1], b) || !binaryOperatorFromString(node->value, op)) return node;
+                try {
+                    auto folded = constantNode(binaryOp(op, a, b));
+                    return folded ? folded : node;
+                } catch (const runtime_error&) {
+                    return node;
+                }
+            }
+            if (type == "UnaryOp" && constantValue(parts[0], a)) {
+                try {
+                    auto folded = constantNode(unaryOp(node->value, a));
+                    return folded ? folded : node;
+                } catch (const runtime_error&) {
+                    return node;
+                }
+            }
+            if (type == "Comparison" && constantValue(parts[0], a) && constantValue(parts[2], b)) {
+                try {
+                    return constantNode(Value::boolean(compareConstants(parts[1]->value, a, b)));
+                } catch (const runtime_error&) {
+                    return node;
+                }
+            }
+            if (type == "TernaryOp" && constantValue(parts[1], a)) {
+                // parts: value if true, condition, value if false
+                return truthy(a) ? parts[0] : parts[2];
+            }
+            return node;
+        }
+
+        shared_ptr<ParseTreeNode> optimizeExpression(const shared_ptr<ParseTreeNode>& node) {
+            const string& type = node->type;
+            if (type == "Identifier") {
+                auto constant = constants.find(node->value);
+                if (constant == constants.end() || (shadowed && shadowed->count(node->value))) return node;
+                auto copy = make_shared<ParseTreeNode>(constant->second->type, constant->second->value);
+                copy->inferredType = constant->second->inferredType;
+                return copy;
+            }
+            if (type == "AttributeAccess") {
+                // The attribute name is an Identifier too, but not a load
+                for (auto& child : node->children) {
+                    if (!isSyntaxLeaf(child)) {
+                        child = optimizeExpression(child);
+                        break;
+                    }
+                }
+                return node;
+            }
+            if (type == "FunctionCall" || type == "FunctionCallStatement") {
+                for (auto& child : node->children) {
+                    if (child->type == "Arguments") {
+                        for (auto& arg : child->children) arg = optimizeExpression(arg);
+                    } else if (child->type != "Identifier" && child->type != "DottedName" && !isSyntaxLeaf(child)) {
+                        child = optimizeExpression(child);
+                    }
+                }
+                return node;
+            }
+            if (type == "Literal" || type == "Keyword" || isSyntaxLeaf(node)) return node;
+            for (auto& child : node->children) child = optimizeExpression(child);
+            return foldExpression(node);
+        }
+
+        // ---- Statements ----
+
+        // A branch can go when it binds nothing the function would otherwise treat as local
+        bool removable(const shared_ptr<ParseTreeNode>& node) {
+            if (!inFunction) return true;
+            vector<string> bound;
+            collectBoundNames(node, bound);
+            return bound.empty();
+        }
+
+        static shared_ptr<ParseTreeNode> passStatement() {
+            return make_shared<ParseTreeNode>("PassStatement");
+        }
+
+        void optimizeBlock(const shared_ptr<ParseTreeNode>& block) {
+            vector<shared_ptr<ParseTreeNode>> statements;
+            for (const auto& statement : block->children) optimizeStatement(statement, statements);
+            if (statements.empty() && block->type == "Suite") statements.push_back(passStatement());
+            block->children = move(statements);
+        }
+
+        void appendBlock(const shared_ptr<ParseTreeNode>& suite, vector<shared_ptr<ParseTreeNode>>& out) {
+            for (const auto& statement : suite->children) {
+                if (statement->type != "PassStatement") out.push_back(statement);
+            }
+        }
+
+        void optimizeIf(const shared_ptr<ParseTreeNode>& node, vector<shared_ptr<ParseTreeNode>>& out) {
+            // Flatten into (condition, suite) pairs with an optional else suite, fold each condition,
+            // then drop the branches that can never run
+            vector<pair<shared_ptr<ParseTreeNode>, shared_ptr<ParseTreeNode>>> branches;
+            shared_ptr<ParseTreeNode> otherwise;
+            auto parts = semanticChildren(node);
+            branches.emplace_back(optimizeExpression(parts[0]), parts[1]);
+            for (size_t k = 2; k < parts.size(); k++) {
+                auto clause = semanticChildren(parts[k]);
+                if (parts[k]->type == "ElifClause") branches.emplace_back(optimizeExpression(clause[0]), clause[1]);
+                else otherwise = clause[0];
+            }
+            for (auto& branch : branches) optimizeBlock(branch.second);
+            if (otherwise) optimizeBlock(otherwise);
+
+            // Rebuilt nodes get no syntax leaves, like a lean tree
+            vector<pair<shared_ptr<ParseTreeNode>, shared_ptr<ParseTreeNode>>> kept;
+            shared_ptr<ParseTreeNode> keptElse = otherwise;
+            for (size_t k = 0; k < branches.size(); k++) {
+                Value condition;
+                if (!constantValue(branches[k].first, condition)) {
+                    kept.push_back(branches[k]);
+                    continue;
+                }
+                if (!truthy(condition)) {
+                    if (removable(branches[k].second)) continue;
+                    kept.push_back(branches[k]);
+                    continue;
+                }
+                // Always taken: it becomes the else and everything after it is dead
+                bool restRemovable = !otherwise || removable(otherwise);
+                for (size_t r = k + 1; r < branches.size(); r++) restRemovable = restRemovable && removable(branches[r].second);
+                if (!restRemovable) {
+                    kept.insert(kept.end(), branches.begin() + k, branches.end());
+                    break;
+                }
+                keptElse = branches[k].second;
+                break;
+            }
+
+            if (kept.empty()) {
+                if (keptElse) appendBlock(keptElse, out);
+                return;
+            }
+            auto result = make_shared<ParseTreeNode>("IfStatement");
+            result->line = node->line;
+            result->addChild(kept[0].first);
+            result->addChild(kept[0].second);
+            for (size_t k = 1; k < kept.size(); k++) {
+                auto clause = make_shared<ParseTreeNode>("ElifClause");
+                clause->addChild(kept[k].first);
+                clause->addChild(kept[k].second);
+                result->addChild(clause);
+            }
+            if (keptElse) {
+                auto clause = make_shared<ParseTreeNode>("ElseClause");
+                clause->addChild(keptElse);
+                result->addChild(clause);
+            }
+            out.push_back(result);
+        }
+
+        void optimizeFunction(const shared_ptr<ParseTreeNode>& node) {
+            unordered_set<string> locals;
+            for (const auto& param : findChild(node, "Parameters")->children) {
+                if (param->type == "Parameter") locals.insert(param->value);
+            }
+            auto body = findChild(node, "Suite");
+            vector<string> bound;
+            collectBoundNames(body, bound);
+            locals.insert(bound.begin(), bound.end());
+
+            const unordered_set<string>* savedShadowed = shadowed;
+            bool savedInFunction = inFunction;
+            shadowed = &locals;
+            inFunction = true;
+            optimizeBlock(body);
+            shadowed = savedShadowed;
+            inFunction = savedInFunction;
+        }
+
+        void optimizeClass(const shared_ptr<ParseTreeNode>& node) {
+            // Names the class body assigns are class attributes within it
+            unordered_set<string> attributes;
+            auto body = findChild(node, "Suite");
+            vector<string> bound;
+            collectBoundNames(body, bound);
+            attributes.insert(bound.begin(), bound.end());
+            if (shadowed) attributes.insert(shadowed->begin(), shadowed->end());
+
+            const unordered_set<string>* savedShadowed = shadowed;
+            shadowed = &attributes;
+            for (const auto& statement : body->children) {
+                if (statement->type == "FunctionDefinition") optimizeFunction(statement);
+                else if (statement->type == "Assignment") optimizeAssignment(statement);
+            }
+            shadowed = savedShadowed;
+        }
+
+        void optimizeAssignment(const shared_ptr<ParseTreeNode>& node) {
+            for (auto& child : node->children) {
+                if (child->type == "IdentifierList") {
+                    for (auto& target : child->children) {
+                        if (target->type != "Identifier" && !isSyntaxLeaf(target)) target = optimizeExpression(target);
+                    }
+                } else if (child->type != "AssignOp" && !isSyntaxLeaf(child)) {
+                    child = optimizeExpression(child);
+                }
+            }
+        }
+
+        // Records 'name = constant' at module level once the assignment has run
+        void recordConstant(const shared_ptr<ParseTreeNode>& node) {
+            auto targets = semanticChildren(findChild(node, "IdentifierList"));
+            if (targets.size() != 1 || targets[0]->type != "Identifier" || findChild(node, "AssignOp")->value != "=") return;
+            const string& name = targets[0]->value;
+            if (!candidates.count(name)) return;
+            auto value = semanticChildren(node).back();
+            Value constant;
+            if (!constantValue(value, constant)) return;
+            if (constant.kind == V_STR && asStr(constant)->s.size() > maxPropagatedStringLength) return;
+            string type = constant.kind == V_INT ? "int" : constant.kind == V_FLOAT ? "float" :
+                          constant.kind == V_STR ? "string" : constant.kind == V_BOOL ? "bool" : "None";
+            for (const auto& symbol : symbols) {
+                if (symbol.name == name && symbol.type == type) {
+                    constants[name] = value;
+                    return;
+                }
+            }
+        }
+
+        void optimizeStatement(const shared_ptr<ParseTreeNode>& node, vector<shared_ptr<ParseTreeNode>>& out) {
+            const string& type = node->type;
+            if (type == "IfStatement") {
+                optimizeIf(node, out);
+                return;
+            }
+            if (type == "WhileStatement") {
+                for (auto& child : node->children) {
+                    if (child->type != "Suite" && !isSyntaxLeaf(child)) child = optimizeExpression(child);
+                }
+                auto condition = semanticChildren(node)[0];
+                optimizeBlock(findChild(node, "Suite"));
+                Value value;
+                if (constantValue(condition, value) && !truthy(value) && removable(node)) return;
+            } else if (type == "ForStatement") {
+                for (auto& child : node->children) {
+                    if (child->type == "Suite") optimizeBlock(child);
+                    else if (child->type != "Identifier" && !isSyntaxLeaf(child)) child = optimizeExpression(child);
+                }
+            } else if (type == "Assignment") {
+                optimizeAssignment(node);
+                if (!inFunction && !shadowed) recordConstant(node);
+            } else if (type == "FunctionDefinition") {
+                optimizeFunction(node);
+            } else if (type == "ClassDefinition") {
+                optimizeClass(node);
+            } else if (type == "Suite") {
+                optimizeBlock(node);
+            } else if (type == "ExpressionStatement" || type == "ReturnStatement" || type == "FunctionCallStatement") {
+                if (type == "FunctionCallStatement") {
+                    optimizeExpression(node);
+                } else {
+                    for (auto& child : node->children) child = optimizeExpression(child);
+                }
+            }
+            out.push_back(node);
+        }
+
+    public:
+        TreeOptimizer(const vector<Identifier>& symbolTable) : symbols(symbolTable) {}
+
+        void optimize(const shared_ptr<ParseTreeNode>& program) {
+            // Module constants are names bound once, by an assignment directly in the module body
+            vector<string> bound;
+            collectBoundNames(program, bound);
+            unordered_map<string, int> bindings;
+            for (const auto& name : bound) bindings[name]++;
+            for (const auto& statement : program->children) {
+                if (statement->type != "Assignment") continue;
+                for (const auto& target : semanticChildren(findChild(statement, "IdentifierList"))) {
+                    if (target->type == "Identifier" && bindings[target->value] == 1) candidates.insert(target->value);
+                }
+            }
+            optimizeBlock(program);
+        }
+};
+
+// Optimizes the tree in place; with 'report' set, prints how many nodes it removed
+void optimizeTree(const shared_ptr<ParseTreeNode>& tree, const vector<Identifier>& symbols, bool report) {
+    size_t before = countNodes(tree);
+    TreeOptimizer(symbols).optimize(tree);
+    if (report) {
+        size_t after = countNodes(tree);
+        cerr << "Optimizer: " << before << " -> " << after << " nodes (" << fixed << setprecision(1)
+             << (before ? (before - after) * 100.0 / before : 0.0) << "% fewer)" << endl;
+    }
+}
@@ -0,0 +1,177 @@
+#ifndef PARSE_PROFILE_H
+#define PARSE_PROFILE_H
+
+// Per-rule profile of the recursive-descent parser: calls, tokens consumed, inclusive and
+// exclusive time, and the lookahead scans that stand in for backtracking. Instrumentation is
+// compiled in only with -DPARSER_PROFILE; without it PROFILE_RULE expands to nothing and the
+// parser is unchanged.
+
+#ifdef PARSER_PROFILE
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <ostream>
+#include <iomanip>
+#include <cstdint>
+using namespace std;
+
+// One entry per parse* method
+#define PARSE_RULES(X) \
+    X(Program) X(Statement) X(StatementBody) X(BlockOrSimpleSuite) X(Suite) \
+    X(IfStatement) X(WhileStatement) X(ForStatement) X(FunctionDef) X(ClassDef) \
+    X(ReturnStatement) X(PassStatement) X(BreakStatement) X(ContinueStatement) \
+    X(ImportStatement) X(DottedName) X(Assignment) X(FunctionCallStatement) X(ExpressionStatement) \
+    X(TernaryOp) X(Test) X(OrTest) X(AndTest) X(NotTest) X(Comparison) \
+    X(ArithExpr) X(Term) X(Factor) X(AtomExpr) X(Atom) X(KeyValuePair)
+
+enum ParseRule {
+#define PARSE_RULE_ENUM(name) RULE_##name,
+    PARSE_RULES(PARSE_RULE_ENUM)
+#undef PARSE_RULE_ENUM
+    RULE_COUNT
+};
+
+struct RuleStats {
+    uint64_t calls = 0;
+    uint64_t tokens = 0;          // consumed inside the rule, counting a recursive call once
+    uint64_t ownTokens = 0;       // consumed by the rule itself rather than the rules it calls
+    uint64_t inclusiveNs = 0;     // counting a recursive call once
+    uint64_t exclusiveNs = 0;
+    uint64_t lookaheadScans = 0;  // scans past the current token to pick an alternative
+    uint64_t lookaheadTokens = 0; // tokens those scans examined
+};
+
+class ParseProfile {
+    private:
+        using Clock = chrono::steady_clock;
+
+        struct Frame {
+            ParseRule rule;
+            Clock::time_point start;
+            size_t startPos;
+            uint64_t childNs = 0;
+            uint64_t childTokens = 0;
+        };
+
+        RuleStats stats[RULE_COUNT];
+        uint32_t active[RULE_COUNT] = {}; // activations of each rule on the stack
+        vector<Frame> stack;
+
+        static const char* ruleName(ParseRule rule) {
+            static const char* names[] = {
+#define PARSE_RULE_NAME(name) #name,
+                PARSE_RULES(PARSE_RULE_NAME)
+#undef PARSE_RULE_NAME
+            };
+            return names[rule];
+        }
+
+        // Rules with any time spent, most exclusive time first
+        vector<ParseRule> rulesByCost() const {
+            vector<ParseRule> rules;
+            for (int rule = 0; rule < RULE_COUNT; rule++) {
+                if (stats[rule].calls) rules.push_back((ParseRule)rule);
+            }
+            stable_sort(rules.begin(), rules.end(), [&](ParseRule a, ParseRule b) {
+                return stats[a].exclusiveNs > stats[b].exclusiveNs;
+            });
+            return rules;
+        }
+
+        uint64_t totalNs() const { return stats[RULE_Program].inclusiveNs; }
+
+    public:
+        void enter(ParseRule rule, size_t pos) {
+            stack.push_back({rule, Clock::now(), pos});
+            active[rule]++;
+            stats[rule].calls++;
+        }
+
+        void leave(size_t pos) {
+            Frame frame = stack.back();
+            stack.pop_back();
+            uint64_t elapsed = chrono::duration_cast<chrono::nanoseconds>(Clock::now() - frame.start).count();
+            uint64_t consumed = pos - frame.startPos;
+            RuleStats& rule = stats[frame.rule];
+            rule.exclusiveNs += elapsed - frame.childNs;
+            rule.ownTokens += consumed - frame.childTokens;
+            if (--active[frame.rule] == 0) {
+                rule.inclusiveNs += elapsed;
+                rule.tokens += consumed;
+            }
+            if (!stack.empty()) {
+                stack.back().childNs += elapsed;
+                stack.back().childTokens += consumed;
+            }
+        }
+
+        void lookahead(size_t tokens) {
+            if (stack.empty()) return;
+            RuleStats& rule = stats[stack.back().rule];
+            rule.lookaheadScans++;
+            rule.lookaheadTokens += tokens;
+        }
+
+        void print(ostream& out) const {
+            out << "--- Parser Profile (" << fixed << setprecision(3) << totalNs() / 1e6 << " ms) ---" << endl;
+            out << left << setw(24) << "Rule" << right << setw(10) << "Calls" << setw(10) << "Tokens" << setw(10) << "Own"
+                << setw(12) << "Incl ms" << setw(12) << "Excl ms" << setw(8) << "Excl%" << setw(10) << "Scans"
+                << setw(12) << "Scanned" << endl;
+            for (ParseRule rule : rulesByCost()) {
+                const RuleStats& s = stats[rule];
+                out << left << setw(24) << ruleName(rule) << right << setw(10) << s.calls << setw(10) << s.tokens
+                    << setw(10) << s.ownTokens << setw(12) << s.inclusiveNs / 1e6 << setw(12) << s.exclusiveNs / 1e6
+                    << setw(8) << setprecision(1) << (totalNs() ? 100.0 * s.exclusiveNs / totalNs() : 0.0) << setprecision(3)
+                    << setw(10) << s.lookaheadScans << setw(12) << s.lookaheadTokens << endl;
+            }
+        }
+
+        void writeJson(ostream& out, const string& file) const {
+            out << "{\"file\": \"";
+            for (char c : file) {
+                if (c == '"' || c == '\\') out << '\\';
+                out << c;
+            }
+            out << "\", \"total_ns\": " << totalNs() << ", \"rules\": [";
+            bool first = true;
+            for (ParseRule rule : rulesByCost()) {
+                const RuleStats& s = stats[rule];
+                out << (first ? "" : ",") << "\n  {\"rule\": \"" << ruleName(rule) << "\", \"calls\": " << s.calls
+                    << ", \"tokens\": " << s.tokens << ", \"own_tokens\": " << s.ownTokens
+                    << ", \"inclusive_ns\": " << s.inclusiveNs << ", \"exclusive_ns\": " << s.exclusiveNs
+                    << ", \"lookahead_scans\": " << s.lookaheadScans << ", \"lookahead_tokens\": " << s.lookaheadTokens << "}";
+                first = false;
+            }
+            out << "\n]}" << endl;
+        }
+};
+
+// Enters a rule for the lifetime of the scope, also when a syntax error unwinds it
+class ParseRuleScope {
+    private:
+        ParseProfile* profile;
+        const size_t& position;
+
+    public:
+        ParseRuleScope(ParseProfile* p, ParseRule rule, const size_t& pos) : profile(p), position(pos) {
+            if (profile) profile->enter(rule, position);
+        }
+
+        ~ParseRuleScope() {
+            if (profile) profile->leave(position);
+        }
+};
+
+#define PROFILE_RULE(rule) ParseRuleScope profileRule_(profile.get(), RULE_##rule, currentPos)
+#define PROFILE_LOOKAHEAD(tokens) do { if (profile) profile->lookahead(tokens); } while (0)
+
+#else
+
+#define PROFILE_RULE(rule)
+#define PROFILE_LOOKAHEAD(tokens)
+
+#endif
+
+#endif
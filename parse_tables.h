@@ -0,0 +1,271 @@
+// Generated by tools/gen_parse_tables.py from grammar.txt; do not edit.
+// Regenerate after changing the grammar:
+//     python3 tools/gen_parse_tables.py grammar.txt > parse_tables.h
+//
+// Decisions the tables cannot make with one token of lookahead; the parser resolves them:
+//   D_STATEMENT on NAME: STATEMENT_ASSIGNMENT | STATEMENT_FUNCTION_CALL_STMT | STATEMENT_EXPRESSION_STMT
+//   D_STATEMENT on NUMBER, STRING, KW_FALSE, KW_NONE, KW_TRUE, LBRACE, LBRACKET, LPAREN: STATEMENT_ASSIGNMENT | STATEMENT_EXPRESSION_STMT
+//   D_RETURN_STMT_EXPRESSION_LIST enters on KW_FALSE, KW_NONE, KW_NOT, KW_TRUE, LBRACE, LBRACKET, LPAREN, MINUS, NAME, NUMBER, PLUS, STRING, TILDE, which may also follow it
+//   D_ASSIGNMENT_ALT on NAME, NUMBER, STRING, KW_FALSE, KW_NONE, KW_NOT, KW_TRUE, LBRACE, LBRACKET, LPAREN, MINUS, PLUS, TILDE: ASSIGNMENT_ALT_EXPRESSION_LIST | ASSIGNMENT_ALT_TEST
+//   D_IDENTIFIER_LIST_ALT on NAME: IDENTIFIER_LIST_ALT_NAME | IDENTIFIER_LIST_ALT_ATTRIBUTE_ACCESS | IDENTIFIER_LIST_ALT_SUBSCRIPT
+//   D_IDENTIFIER_LIST_ALT on NUMBER, STRING, KW_FALSE, KW_NONE, KW_TRUE, LBRACE, LBRACKET, LPAREN: IDENTIFIER_LIST_ALT_ATTRIBUTE_ACCESS | IDENTIFIER_LIST_ALT_SUBSCRIPT
+//   D_FUNCTION_CALL_STMT_ALT on NAME: FUNCTION_CALL_STMT_ALT_NAME | FUNCTION_CALL_STMT_ALT_DOTTED_NAME
+//   D_ARGUMENTS_COMMA enters on COMMA, which may also follow it
+//   D_IF_STMT_KW_ELIF enters on KW_ELIF, which may also follow it
+//   D_IF_STMT_KW_ELSE enters on KW_ELSE, which may also follow it
+//   D_TERNARY_OP_KW_IF enters on KW_IF, which may also follow it
+//   D_COMPARISON_COMP_OP enters on KW_NOT, which may also follow it
+//   D_ARITH_EXPR_PLUS enters on MINUS, PLUS, which may also follow it
+//   D_ATOM_EXPR_TRAILER enters on DOT, LBRACKET, LPAREN, which may also follow it
+
+#ifndef PARSE_TABLES_H
+#define PARSE_TABLES_H
+
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "definitions.h"
+
+// Token sub-kinds: one per keyword, operator and delimiter the grammar mentions
+enum TokenKind : uint8_t {
+    TK_OTHER, TK_END, TK_NAME, TK_NUMBER, TK_STRING, TK_NEWLINE, TK_INDENT, TK_DEDENT, TK_ASSIGN,
+    TK_COLON, TK_COMMA, TK_DOT, TK_DOUBLE_SLASH, TK_DOUBLE_SLASH_ASSIGN, TK_EQUAL, TK_GREATER,
+    TK_GREATER_EQUAL, TK_KW_AND, TK_KW_AS, TK_KW_BREAK, TK_KW_CLASS, TK_KW_CONTINUE, TK_KW_DEF,
+    TK_KW_ELIF, TK_KW_ELSE, TK_KW_FALSE, TK_KW_FOR, TK_KW_FROM, TK_KW_IF, TK_KW_IMPORT, TK_KW_IN,
+    TK_KW_NONE, TK_KW_NOT, TK_KW_OR, TK_KW_PASS, TK_KW_RETURN, TK_KW_TRUE, TK_KW_WHILE, TK_LBRACE,
+    TK_LBRACKET, TK_LESS, TK_LESS_EQUAL, TK_LPAREN, TK_MINUS, TK_MINUS_ASSIGN, TK_NOT_EQUAL,
+    TK_PERCENT, TK_PERCENT_ASSIGN, TK_PLUS, TK_PLUS_ASSIGN, TK_RBRACE, TK_RBRACKET, TK_RPAREN,
+    TK_SLASH, TK_SLASH_ASSIGN, TK_STAR, TK_STAR_ASSIGN, TK_TILDE, TOKEN_KIND_COUNT
+};
+
+inline const unordered_map<string, TokenKind>& tokenSpellings() {
+    static const unordered_map<string, TokenKind> spellings = {
+        {"=", TK_ASSIGN}, {":", TK_COLON}, {",", TK_COMMA}, {".", TK_DOT}, {"//", TK_DOUBLE_SLASH},
+        {"//=", TK_DOUBLE_SLASH_ASSIGN}, {"==", TK_EQUAL}, {">", TK_GREATER},
+        {">=", TK_GREATER_EQUAL}, {"and", TK_KW_AND}, {"as", TK_KW_AS}, {"break", TK_KW_BREAK},
+        {"class", TK_KW_CLASS}, {"continue", TK_KW_CONTINUE}, {"def", TK_KW_DEF},
+        {"elif", TK_KW_ELIF}, {"else", TK_KW_ELSE}, {"False", TK_KW_FALSE}, {"for", TK_KW_FOR},
+        {"from", TK_KW_FROM}, {"if", TK_KW_IF}, {"import", TK_KW_IMPORT}, {"in", TK_KW_IN},
+        {"None", TK_KW_NONE}, {"not", TK_KW_NOT}, {"or", TK_KW_OR}, {"pass", TK_KW_PASS},
+        {"return", TK_KW_RETURN}, {"True", TK_KW_TRUE}, {"while", TK_KW_WHILE}, {"{", TK_LBRACE},
+        {"[", TK_LBRACKET}, {"<", TK_LESS}, {"<=", TK_LESS_EQUAL}, {"(", TK_LPAREN},
+        {"-", TK_MINUS}, {"-=", TK_MINUS_ASSIGN}, {"!=", TK_NOT_EQUAL}, {"%", TK_PERCENT},
+        {"%=", TK_PERCENT_ASSIGN}, {"+", TK_PLUS}, {"+=", TK_PLUS_ASSIGN}, {"}", TK_RBRACE},
+        {"]", TK_RBRACKET}, {")", TK_RPAREN}, {"/", TK_SLASH}, {"/=", TK_SLASH_ASSIGN},
+        {"*", TK_STAR}, {"*=", TK_STAR_ASSIGN}, {"~", TK_TILDE},
+    };
+    return spellings;
+}
+
+inline TokenKind tokenKindOf(const Token& token) {
+    switch (token.type) {
+        case IDENTIFIER: return TK_NAME;
+        case LITERAL: return isdigit((unsigned char)token.value[0]) ? TK_NUMBER : TK_STRING;
+        case NEWLINE: return TK_NEWLINE;
+        case INDENT: return TK_INDENT;
+        case DEDENT: return TK_DEDENT;
+        case KEYWORD:
+        case OPERATOR:
+        case DELIMITER: {
+            auto found = tokenSpellings().find(token.value);
+            return found != tokenSpellings().end() ? found->second : TK_OTHER;
+        }
+        default: return TK_OTHER;
+    }
+}
+
+enum ParseDecision : uint8_t {
+    D_PROGRAM_STATEMENT, D_STATEMENT, D_RETURN_STMT_EXPRESSION_LIST, D_IMPORT_STMT,
+    D_IMPORT_STMT_KW_AS, D_IMPORT_STMT_COMMA, D_IMPORT_STMT_KW_AS_2, D_IMPORT_STMT_ALT,
+    D_IMPORT_STMT_KW_AS_3, D_DOTTED_NAME_DOT, D_ASSIGNMENT_ALT, D_IDENTIFIER_LIST_ALT,
+    D_IDENTIFIER_LIST_COMMA, D_EXPRESSION_LIST_COMMA, D_ASSIGN_OP, D_FUNCTION_CALL_STMT_ALT,
+    D_FUNCTION_CALL_STMT_ARGUMENTS, D_ARGUMENTS_COMMA, D_ARGUMENTS_COMMA_2, D_IF_STMT_KW_ELIF,
+    D_IF_STMT_KW_ELSE, D_FUNCDEF_PARAMETERS, D_PARAMETERS_COMMA, D_CLASS_DEF_LPAREN, D_SUITE,
+    D_SUITE_STATEMENT, D_TERNARY_OP_KW_IF, D_OR_TEST_KW_OR, D_AND_TEST_KW_AND, D_NOT_TEST,
+    D_COMPARISON_COMP_OP, D_COMP_OP, D_ARITH_EXPR_PLUS, D_ARITH_EXPR_ALT, D_TERM_STAR, D_TERM_ALT,
+    D_FACTOR, D_FACTOR_ALT, D_ATOM_EXPR_TRAILER, D_TRAILER, D_TRAILER_ARGUMENTS, D_ATOM,
+    D_ATOM_TEST, D_ATOM_COMMA, D_ATOM_TEST_2, D_ATOM_COMMA_2, D_ATOM_KEY_VALUE_PAIR,
+    D_ATOM_COMMA_3, PARSE_DECISION_COUNT
+};
+
+// Alternatives of each multi-way decision, numbered from 1 in grammar order
+enum ParseAlternative : uint8_t {
+    STATEMENT_IF_STMT = 1, STATEMENT_WHILE_STMT = 2, STATEMENT_FOR_STMT = 3, STATEMENT_FUNCDEF = 4,
+    STATEMENT_CLASS_DEF = 5, STATEMENT_RETURN_STMT = 6, STATEMENT_PASS_STMT = 7,
+    STATEMENT_BREAK_STMT = 8, STATEMENT_CONTINUE_STMT = 9, STATEMENT_IMPORT_STMT = 10,
+    STATEMENT_ASSIGNMENT = 11, STATEMENT_FUNCTION_CALL_STMT = 12, STATEMENT_EXPRESSION_STMT = 13,
+    IMPORT_STMT_KW_IMPORT = 1, IMPORT_STMT_KW_FROM = 2, IMPORT_STMT_ALT_NAME = 1,
+    IMPORT_STMT_ALT_STAR = 2, ASSIGNMENT_ALT_EXPRESSION_LIST = 1, ASSIGNMENT_ALT_TEST = 2,
+    IDENTIFIER_LIST_ALT_NAME = 1, IDENTIFIER_LIST_ALT_ATTRIBUTE_ACCESS = 2,
+    IDENTIFIER_LIST_ALT_SUBSCRIPT = 3, ASSIGN_OP_ASSIGN = 1, ASSIGN_OP_PLUS_ASSIGN = 2,
+    ASSIGN_OP_MINUS_ASSIGN = 3, ASSIGN_OP_STAR_ASSIGN = 4, ASSIGN_OP_SLASH_ASSIGN = 5,
+    ASSIGN_OP_PERCENT_ASSIGN = 6, ASSIGN_OP_DOUBLE_SLASH_ASSIGN = 7,
+    FUNCTION_CALL_STMT_ALT_NAME = 1, FUNCTION_CALL_STMT_ALT_DOTTED_NAME = 2, SUITE_STATEMENT = 1,
+    SUITE_NEWLINE = 2, NOT_TEST_KW_NOT = 1, NOT_TEST_COMPARISON = 2, COMP_OP_LESS = 1,
+    COMP_OP_GREATER = 2, COMP_OP_EQUAL = 3, COMP_OP_GREATER_EQUAL = 4, COMP_OP_LESS_EQUAL = 5,
+    COMP_OP_NOT_EQUAL = 6, COMP_OP_KW_IN = 7, COMP_OP_KW_NOT = 8, ARITH_EXPR_ALT_PLUS = 1,
+    ARITH_EXPR_ALT_MINUS = 2, TERM_ALT_STAR = 1, TERM_ALT_SLASH = 2, TERM_ALT_DOUBLE_SLASH = 3,
+    TERM_ALT_PERCENT = 4, FACTOR_PLUS = 1, FACTOR_ATOM_EXPR = 2, FACTOR_ALT_PLUS = 1,
+    FACTOR_ALT_MINUS = 2, FACTOR_ALT_TILDE = 3, TRAILER_LPAREN = 1, TRAILER_DOT = 2,
+    TRAILER_LBRACKET = 3, ATOM_LPAREN = 1, ATOM_LBRACKET = 2, ATOM_LBRACE = 3, ATOM_NAME = 4,
+    ATOM_NUMBER = 5, ATOM_STRING = 6, ATOM_KW_NONE = 7, ATOM_KW_TRUE = 8, ATOM_KW_FALSE = 9,
+};
+
+const uint8_t PARSE_CONFLICT = 0xFF;
+
+// parseTable[decision][token kind]: the alternative to take, or 1 to enter an optional or
+// repeated group; 0 when the token cannot start it
+const uint8_t parseTable[PARSE_DECISION_COUNT][TOKEN_KIND_COUNT] = {
+    // D_PROGRAM_STATEMENT
+    {0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 1, 1, 1, 0, 1, 1,
+     0, 1, 1, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1},
+    // D_STATEMENT
+    {0, 0, PARSE_CONFLICT, PARSE_CONFLICT, PARSE_CONFLICT, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8,
+     5, 9, 4, 0, 0, PARSE_CONFLICT, 3, 10, 1, 10, 0, PARSE_CONFLICT, 13, 0, 7, 6, PARSE_CONFLICT, 2,
+     PARSE_CONFLICT, PARSE_CONFLICT, 0, 0, PARSE_CONFLICT, 13, 0, 0, 0, 0, 13, 0, 0, 0, 0, 0, 0, 0, 0,
+     13},
+    // D_RETURN_STMT_EXPRESSION_LIST
+    {0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 1,
+     0, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1},
+    // D_IMPORT_STMT
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 1, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_IMPORT_STMT_KW_AS
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_IMPORT_STMT_COMMA
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_IMPORT_STMT_KW_AS_2
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_IMPORT_STMT_ALT
+    {0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0},
+    // D_IMPORT_STMT_KW_AS_3
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_DOTTED_NAME_DOT
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_ASSIGNMENT_ALT
+    {0, 0, PARSE_CONFLICT, PARSE_CONFLICT, PARSE_CONFLICT, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, PARSE_CONFLICT, 0, 0, 0, 0, 0, PARSE_CONFLICT, PARSE_CONFLICT, 0, 0, 0,
+     PARSE_CONFLICT, 0, PARSE_CONFLICT, PARSE_CONFLICT, 0, 0, PARSE_CONFLICT, PARSE_CONFLICT, 0, 0, 0,
+     0, PARSE_CONFLICT, 0, 0, 0, 0, 0, 0, 0, 0, PARSE_CONFLICT},
+    // D_IDENTIFIER_LIST_ALT
+    {0, 0, PARSE_CONFLICT, PARSE_CONFLICT, PARSE_CONFLICT, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, PARSE_CONFLICT, 0, 0, 0, 0, 0, PARSE_CONFLICT, 0, 0, 0, 0, PARSE_CONFLICT, 0,
+     PARSE_CONFLICT, PARSE_CONFLICT, 0, 0, PARSE_CONFLICT, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_IDENTIFIER_LIST_COMMA
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_EXPRESSION_LIST_COMMA
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_ASSIGN_OP
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 7, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 6, 0, 2, 0, 0, 0, 0, 5, 0, 4, 0},
+    // D_FUNCTION_CALL_STMT_ALT
+    {0, 0, PARSE_CONFLICT, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_FUNCTION_CALL_STMT_ARGUMENTS
+    {0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 1,
+     0, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1},
+    // D_ARGUMENTS_COMMA
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_ARGUMENTS_COMMA_2
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_IF_STMT_KW_ELIF
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_IF_STMT_KW_ELSE
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_FUNCDEF_PARAMETERS
+    {0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_PARAMETERS_COMMA
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_CLASS_DEF_LPAREN
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_SUITE
+    {0, 0, 1, 1, 1, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 1, 1, 1, 0, 1, 1,
+     0, 1, 1, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1},
+    // D_SUITE_STATEMENT
+    {0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 1, 1, 1, 0, 1, 1,
+     0, 1, 1, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1},
+    // D_TERNARY_OP_KW_IF
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_OR_TEST_KW_OR
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_AND_TEST_KW_AND
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_NOT_TEST
+    {0, 0, 2, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 2, 1,
+     0, 0, 0, 2, 0, 2, 2, 0, 0, 2, 2, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 2},
+    // D_COMPARISON_COMP_OP
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1,
+     0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_COMP_OP
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 2, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 7, 0, 8,
+     0, 0, 0, 0, 0, 0, 0, 1, 5, 0, 0, 0, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_ARITH_EXPR_PLUS
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_ARITH_EXPR_ALT
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_TERM_STAR
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0},
+    // D_TERM_ALT
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4, 0, 0, 0, 0, 0, 0, 2, 0, 1, 0, 0},
+    // D_FACTOR
+    {0, 0, 2, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 2, 0,
+     0, 0, 0, 2, 0, 2, 2, 0, 0, 2, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1},
+    // D_FACTOR_ALT
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 3},
+    // D_ATOM_EXPR_TRAILER
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_TRAILER
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 3, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_TRAILER_ARGUMENTS
+    {0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 1,
+     0, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1},
+    // D_ATOM
+    {0, 0, 4, 5, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 9, 0, 0, 0, 0, 0, 7, 0,
+     0, 0, 0, 8, 0, 3, 2, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_ATOM_TEST
+    {0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 1,
+     0, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1},
+    // D_ATOM_COMMA
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_ATOM_TEST_2
+    {0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 1,
+     0, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1},
+    // D_ATOM_COMMA_2
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    // D_ATOM_KEY_VALUE_PAIR
+    {0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 1,
+     0, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1},
+    // D_ATOM_COMMA_3
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+};
+
+#endif
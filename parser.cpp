@@ -1,230 +1,314 @@
-#include <iostream>
-#include <vector>
-#include <memory>
-#include <string>
-#include <stdexcept>
+#include <algorithm>
 #include <fstream>
-#include <sstream>
-#include "definitions.h"
-#include "lexer2.cpp"
+#include "parser.h"
 using namespace std;
 
-// Forward declaration of ParseTreeNode
-class ParseTreeNode;
-
-// Parse Tree Node class
-class ParseTreeNode {
-public:
-    string type;
-    string value;
-    vector<shared_ptr<ParseTreeNode>> children;
-    static int nodeCounter;
-
-    ParseTreeNode(const string& t, const string& v = "") : type(t), value(v) {}
-
-    void addChild(shared_ptr<ParseTreeNode> child) {
-        children.push_back(child);
+bool Parser::hasToken(size_t pos) {
+    while (pos >= tokens.size()) {
+        if (!tokenSource || !tokenSource(tokens)) return false;
+        classifyTokens();
     }
+    return true;
+}
 
-    void print(int indent = 0) const {
-        string indentation(indent * 2, ' ');
-        cout << indentation << type;
-        if (!value.empty()) {
-            cout << ": " << value;
-        }
-        cout << endl;
-
-        for (const auto& child : children) {
-            child->print(indent + 1);
-        }
+void Parser::classifyTokens() {
+    kinds.reserve(tokens.size());
+    for (size_t k = kinds.size(); k < tokens.size(); k++) {
+        kinds.push_back(tokenKindOf(tokens[k]));
     }
-    
-    // Generate DOT representation of the node and its children
-    void toDot(ostream& out, int& nodeId) const {
-        int myId = nodeId++;
-        
-        // Node label
-        string label = type;
-        if (!value.empty()) {
-            label += ": " + value;
-        }
-        
-        // Escape quotes in the label
-        size_t pos = 0;
-        while ((pos = label.find("\"", pos)) != string::npos) {
-            label.replace(pos, 1, "\\\"");
-            pos += 2;
-        }
-        
-        out << "  node" << myId << " [label=\"" << label << "\"];" << endl;
-        
-        // Connect to children
-        for (const auto& child : children) {
-            int childId = nodeId;
-            child->toDot(out, nodeId);
-            out << "  node" << myId << " -> node" << childId << ";" << endl;
+}
+
+TokenKind Parser::kindAt(size_t pos) {
+    return hasToken(pos) ? kinds[pos] : TK_END;
+}
+
+bool Parser::at(TokenKind kind) {
+    return kindAt(currentPos) == kind;
+}
+
+uint8_t Parser::decide(ParseDecision decision) {
+    return parseTable[decision][kindAt(currentPos)];
+}
+
+bool Parser::atEnd() {
+    return !hasToken(currentPos);
+}
+
+shared_ptr<ParseTreeNode> Parser::makeLeaf(const string& type, const string& value) {
+    if (!internLeaves) return make_shared<ParseTreeNode>(type, value);
+    auto& table = leafTables[type == "Identifier" ? 0 : type == "Literal" ? 1 : type == "Keyword" ? 2 : 3];
+    auto found = table.find(value);
+    if (found != table.end()) return found->second;
+    return table.emplace(value, make_shared<ParseTreeNode>(type, value)).first->second;
+}
+
+void Parser::addSyntaxLeaf(const shared_ptr<ParseTreeNode>& node, const string& type, const string& value) {
+    if (!leanTree) node->addChild(makeLeaf(type, value));
+}
+
+bool Parser::assignmentAhead() {
+    size_t pos = currentPos;
+    bool found = scanForAssignment(pos);
+    PROFILE_LOOKAHEAD(pos - currentPos + (pos < tokens.size() ? 1 : 0)); // including the deciding token
+    return found;
+}
+
+bool Parser::scanForAssignment(size_t& pos) {
+    int depth = 0;
+    for (; hasToken(pos); pos++) {
+        const Token& token = tokens[pos];
+        if (token.type == NEWLINE || token.type == INDENT || token.type == DEDENT) return false;
+        if (token.type == DELIMITER) {
+            if (token.value == "(" || token.value == "[" || token.value == "{") depth++;
+            else if (token.value == ")" || token.value == "]" || token.value == "}") depth--;
+            else if (depth == 0 && (token.value == ":" || token.value == ";")) return false;
+            if (depth < 0) return false;
+        } else if (depth == 0 && parseTable[D_ASSIGN_OP][kinds[pos]]) {
+            return true;
         }
     }
-};
-
-// Initialize static counter
-int ParseTreeNode::nodeCounter = 0;
-
-// Parser class for syntax analysis
-class Parser {
-private:
-    vector<Token> tokens;
-    size_t currentPos;
-    shared_ptr<ParseTreeNode> parseTree;
-
-    // Error handling
-    void syntaxError(const string& message) {
-        int line = currentPos < tokens.size() ? tokens[currentPos].line : -1;
-        string tokenValue = currentPos < tokens.size() ? tokens[currentPos].value : "EOF";
-        
-        cerr << "Syntax Error at line " << line << " near '" << tokenValue << "': " << message << endl;
-        throw runtime_error("Syntax Error: " + message);
-    }
-
-    // Helper methods
-    Token& currentToken() {
-        if (currentPos >= tokens.size()) {
-            static Token eofToken = {ERROR, "EOF", -1};
-            return eofToken;
-        }
-        return tokens[currentPos];
+    return false;
+}
+
+void Parser::syntaxError(const string& message) {
+    int line = !atEnd() ? tokens[currentPos].line : -1;
+    string tokenValue = !atEnd() ? tokens[currentPos].value : "EOF";
+
+    if (!quiet) *diagnostics << "Syntax Error at line " << line << " near '" << tokenValue << "': " << message << endl;
+    throw runtime_error("Syntax Error: " + message);
+}
+
+Token& Parser::currentToken() {
+    if (atEnd()) return eofToken;
+    return tokens[currentPos];
+}
+
+bool Parser::match(TokenType type) {
+    if (atEnd()) return false;
+    return currentToken().type == type;
+}
+
+bool Parser::match(TokenType type, const string& value) {
+    if (atEnd()) return false;
+    return currentToken().type == type && currentToken().value == value;
+}
+
+Token Parser::consume() {
+    if (atEnd()) {
+        syntaxError("Unexpected end of input");
     }
+    return tokens[currentPos++];
+}
 
-    bool match(TokenType type) {
-        if (currentPos >= tokens.size()) return false;
-        return currentToken().type == type;
+Token Parser::expect(TokenKind kind, const string& message) {
+    if (!at(kind)) {
+        syntaxError(message);
     }
-
-    bool match(TokenType type, const string& value) {
-        if (currentPos >= tokens.size()) return false;
-        return currentToken().type == type && currentToken().value == value;
+    return consume();
+}
+
+shared_ptr<ParseTreeNode> Parser::parseProgram() {
+    PROFILE_RULE(Program);
+    auto node = make_shared<ParseTreeNode>("Program");
+    container = node.get();
+    while (!atEnd()) {
+        // Skip NEWLINE tokens between statements
+        while (at(TK_NEWLINE)) consume();
+        if (atEnd()) break;
+        node->addChild(parseStatement());
     }
-
-    Token consume() {
-        if (currentPos >= tokens.size()) {
-            syntaxError("Unexpected end of input");
+    return node;
+}
+
+void Parser::recoverFromError() {
+    // Simple error recovery: skip tokens until we find a statement delimiter
+    while (!atEnd()) {
+        if (match(DELIMITER, ";") || match(KEYWORD, "if") ||
+            match(KEYWORD, "while") || match(KEYWORD, "for") ||
+            match(KEYWORD, "def") || match(KEYWORD, "class")) {
+            break;
         }
-        return tokens[currentPos++];
+        currentPos++;
     }
-
-    Token expect(TokenType type, const string& message) {
-        if (!match(type)) {
-            syntaxError(message);
-        }
-        return consume();
+}
+
+shared_ptr<ParseTreeNode> Parser::parseStatement() {
+    PROFILE_RULE(Statement);
+    while (at(TK_NEWLINE)) consume();
+    if (incremental) return parseTrackedStatement();
+    int line = atEnd() ? 0 : tokens[currentPos].line;
+    auto node = parseStatementBody();
+    node->line = line;
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseTrackedStatement() {
+    if (auto reused = reuseStatement()) return reused;
+    size_t local = spans.size();
+    spans.push_back({currentPos, currentPos, nullptr, parentSpan, container, false});
+    int outer = parentSpan;
+    parentSpan = (int)(spanBase + local);
+    int line = atEnd() ? 0 : tokens[currentPos].line;
+    auto node = parseStatementBody();
+    node->line = line;
+    parentSpan = outer;
+    spans[local].end = currentPos;
+    spans[local].node = node;
+    return node;
+}
+
+size_t Parser::subtreeEnd(const vector<StatementSpan>& list, size_t index) {
+    size_t last = index + 1;
+    while (last < list.size() && list[last].start < list[index].end) last++;
+    return last;
+}
+
+size_t Parser::toNewPosition(size_t oldPos) const {
+    return oldPos < edit.oldEnd ? oldPos : oldPos - edit.oldEnd + edit.newEnd;
+}
+
+shared_ptr<ParseTreeNode> Parser::reuseStatement() {
+    if (!reusing) return nullptr;
+    size_t oldPos;
+    bool after = currentPos >= edit.newEnd;
+    if (currentPos < edit.start) oldPos = currentPos;
+    else if (after) oldPos = currentPos - edit.newEnd + edit.oldEnd;
+    else return nullptr;
+    auto found = lower_bound(previousSpans.begin(), previousSpans.end(), oldPos,
+                             [](const StatementSpan& span, size_t pos) { return span.start < pos; });
+    if (found == previousSpans.end() || found->start != oldPos) return nullptr;
+    // Before the edit, the token after the statement must be untouched too: an 'elif' or
+    // 'else' there would extend an if statement
+    if (!after && found->end >= edit.start) return nullptr;
+
+    size_t first = found - previousSpans.begin();
+    size_t last = subtreeEnd(previousSpans, first);
+    size_t local = spans.size();
+    int base = (int)(spanBase + local);
+    for (size_t k = first; k < last; k++) {
+        StatementSpan span = previousSpans[k];
+        span.start = toNewPosition(span.start);
+        span.end = toNewPosition(span.end);
+        span.parent = k == first ? parentSpan : base + (span.parent - (int)first);
+        if (k == first) span.container = container;
+        span.movedLines = after;
+        spans.push_back(move(span));
     }
-
-    Token expect(TokenType type, const string& value, const string& message) {
-        if (!match(type, value)) {
-            syntaxError(message);
+    currentPos = spans[local].end;
+    return spans[local].node;
+}
+
+bool Parser::reparseStatement(size_t index) {
+    const StatementSpan& old = previousSpans[index];
+    // The statement before it in the same block must not end where the edit begins
+    for (int k = (int)index - 1; k >= 0 && k != old.parent; k = previousSpans[k].parent) {
+        if (previousSpans[k].parent == old.parent) {
+            if (previousSpans[k].end >= edit.start) return false;
+            break;
         }
-        return consume();
     }
-
-    // Grammar rules implementation
-    shared_ptr<ParseTreeNode> parseProgram() {
-        auto node = make_shared<ParseTreeNode>("Program");
-        while (currentPos < tokens.size()) {
-            // Skip NEWLINE tokens between statements
-            while (match(NEWLINE)) consume();
-            if (currentPos >= tokens.size()) break;
-            node->addChild(parseStatement());
-        }
-        return node;
+    spans.clear();
+    spanBase = index;
+    parentSpan = old.parent;
+    container = old.container;
+    currentPos = old.start;
+    shared_ptr<ParseTreeNode> node;
+    quiet = true;
+    try {
+        node = parseStatement();
+    } catch (const runtime_error&) {
+        quiet = false;
+        return false;
     }
-
-    void recoverFromError() {
-        // Simple error recovery: skip tokens until we find a statement delimiter
-        while (currentPos < tokens.size()) {
-            if (match(DELIMITER, ";") || match(KEYWORD, "if") || 
-                match(KEYWORD, "while") || match(KEYWORD, "for") || 
-                match(KEYWORD, "def") || match(KEYWORD, "class")) {
-                break;
-            }
-            currentPos++;
+    quiet = false;
+    if (currentPos != toNewPosition(old.end)) return false;
+    auto& siblings = old.container->children;
+    auto slot = find(siblings.begin(), siblings.end(), old.node);
+    if (slot == siblings.end()) return false;
+    *slot = node;
+
+    // Splice the statement's new spans in place of its old ones. The statements enclosing it
+    // end where they did, give or take the edit, and those after it are all past the edit
+    size_t last = subtreeEnd(previousSpans, index);
+    int added = (int)spans.size() - (int)(last - index);
+    for (int k = old.parent; k >= 0; k = previousSpans[k].parent) {
+        previousSpans[k].end = toNewPosition(previousSpans[k].end);
+    }
+    for (size_t k = last; k < previousSpans.size(); k++) {
+        StatementSpan& span = previousSpans[k];
+        span.start = toNewPosition(span.start);
+        span.end = toNewPosition(span.end);
+        if (span.parent >= (int)last) span.parent += added;
+        span.movedLines = true;
+    }
+    previousSpans.erase(previousSpans.begin() + index, previousSpans.begin() + last);
+    previousSpans.insert(previousSpans.begin() + index, make_move_iterator(spans.begin()), make_move_iterator(spans.end()));
+    spans = move(previousSpans);
+    spanBase = 0;
+    return true;
+}
+
+void Parser::shiftReusedLines(int lineShift) {
+    for (auto& span : spans) {
+        if (!span.movedLines) continue;
+        span.movedLines = false;
+        if (lineShift == 0) continue;
+        span.node->line += lineShift;
+        for (auto& child : span.node->children) {
+            if (child->kind == NodeKind::ElifClause) child->line += lineShift;
         }
     }
-
-    shared_ptr<ParseTreeNode> parseStatement() {
-        while (match(NEWLINE)) consume();
-        if (match(KEYWORD, "if")) {
-            return parseIfStatement();
-        } else if (match(KEYWORD, "while")) {
-            return parseWhileStatement();
-        } else if (match(KEYWORD, "for")) {
-            return parseForStatement();
-        } else if (match(KEYWORD, "def")) {
-            return parseFunctionDef();
-        } else if (match(KEYWORD, "class")) {
-            return parseClassDef();
-        } else if (match(KEYWORD, "return")) {
-            return parseReturnStatement();
-        } else if (match(KEYWORD, "pass")) {
-            return parsePassStatement();
-        } else if (match(KEYWORD, "break")) {
-            return parseBreakStatement();
-        } else if (match(KEYWORD, "continue")) {
-            return parseContinueStatement();
-        } else if (match(KEYWORD, "import") || match(KEYWORD, "from")) {
-            return parseImportStatement();
-        } else if (match(IDENTIFIER)) {
-            // Look ahead to see if this is an assignment or attribute assignment
-            size_t savedPos = currentPos;
-            consume(); // consume identifier
-            
-            // Check for attribute access followed by assignment
-            if (match(DELIMITER, ".")) {
-                consume(); // consume '.'
-                if (match(IDENTIFIER)) {
-                    consume(); // consume attribute name
-                    if (match(OPERATOR, "=") || match(OPERATOR, "+=") || match(OPERATOR, "-=") || 
-                        match(OPERATOR, "*=") || match(OPERATOR, "/=") || match(OPERATOR, "%=") || 
-                        match(OPERATOR, "//=")) {
-                        currentPos = savedPos; // rewind
-                        return parseAssignment();
-                    }
+}
+
+shared_ptr<ParseTreeNode> Parser::parseStatementBody() {
+    PROFILE_RULE(StatementBody);
+    switch (decide(D_STATEMENT)) {
+        case STATEMENT_IF_STMT: return parseIfStatement();
+        case STATEMENT_WHILE_STMT: return parseWhileStatement();
+        case STATEMENT_FOR_STMT: return parseForStatement();
+        case STATEMENT_FUNCDEF: return parseFunctionDef();
+        case STATEMENT_CLASS_DEF: return parseClassDef();
+        case STATEMENT_RETURN_STMT: return parseReturnStatement();
+        case STATEMENT_PASS_STMT: return parsePassStatement();
+        case STATEMENT_BREAK_STMT: return parseBreakStatement();
+        case STATEMENT_CONTINUE_STMT: return parseContinueStatement();
+        case STATEMENT_IMPORT_STMT: return parseImportStatement();
+        case PARSE_CONFLICT:
+            // An identifier starts an assignment (to a name, attribute, subscript or name list),
+            // a call statement or an expression; the tokens after it decide
+            if (at(TK_NAME)) {
+                if (assignmentAhead()) {
+                    return parseAssignment();
+                }
+                if (kindAt(currentPos + 1) == TK_LPAREN) {
+                    return parseFunctionCallStatement();
                 }
-                currentPos = savedPos; // rewind if not an attribute assignment
-            }
-            
-            // Check for direct assignment
-            if (match(OPERATOR, "=") || match(OPERATOR, "+=") || match(OPERATOR, "-=") || 
-                match(OPERATOR, "*=") || match(OPERATOR, "/=") || match(OPERATOR, "%=") || 
-                match(OPERATOR, "//=")) {
-                currentPos = savedPos; // rewind
-                return parseAssignment();
-            } else if (match(DELIMITER, "(")) {
-                currentPos = savedPos; // rewind
-                return parseFunctionCallStatement();
-            } else {
-                currentPos = savedPos; // rewind
-                return parseExpressionStatement();
             }
-        } else {
             return parseExpressionStatement();
-        }
+        default:
+            return parseExpressionStatement();
     }
-
-    shared_ptr<ParseTreeNode> parseBlockOrSimpleSuite() {
-        auto node = make_shared<ParseTreeNode>("Suite");
-        if (match(NEWLINE)) {
+}
+
+shared_ptr<ParseTreeNode> Parser::parseBlockOrSimpleSuite() {
+    PROFILE_RULE(BlockOrSimpleSuite);
+    auto node = make_shared<ParseTreeNode>("Suite");
+    ParseTreeNode* outerContainer = container;
+    container = node.get();
+    switch (decide(D_SUITE)) {
+        case SUITE_NEWLINE:
             consume(); // consume NEWLINE
-            if (match(INDENT)) {
+            if (at(TK_INDENT)) {
                 consume(); // consume INDENT
-                while (!match(DEDENT) && currentPos < tokens.size()) {
+                while (!at(TK_DEDENT) && !atEnd()) {
                     // Skip extra NEWLINEs inside block
-                    while (match(NEWLINE)) consume();
-                    if (match(DEDENT) || currentPos >= tokens.size()) break;
+                    while (at(TK_NEWLINE)) consume();
+                    if (at(TK_DEDENT) || atEnd()) break;
                     node->addChild(parseStatement());
                 }
-                if (match(DEDENT)) {
+                if (at(TK_DEDENT)) {
                     consume(); // consume DEDENT
-                } else if (currentPos >= tokens.size()) {
+                } else if (atEnd()) {
                     // Allow EOF as valid end of block
                 } else {
                     syntaxError("Expected DEDENT at end of block");
@@ -232,759 +316,901 @@ private:
             } else {
                 syntaxError("Expected INDENT after NEWLINE for block suite");
             }
-        } else if (
-            // Accept a simple statement (start of a statement)
-            match(IDENTIFIER) || match(KEYWORD, "return") || match(KEYWORD, "pass") ||
-            match(KEYWORD, "break") || match(KEYWORD, "continue") || match(KEYWORD, "import") ||
-            match(KEYWORD, "from") || match(KEYWORD, "if") || match(KEYWORD, "while") ||
-            match(KEYWORD, "for") || match(KEYWORD, "def") || match(KEYWORD, "class")
-        ) {
+            break;
+        case SUITE_STATEMENT:
+            // A simple statement on the same line as the ':'
             node->addChild(parseStatement());
-        } else {
+            break;
+        default:
             syntaxError("Expected NEWLINE+INDENT for block or a simple statement after ':'");
-        }
-        return node;
     }
+    container = outerContainer;
+    return node;
+}
 
-    shared_ptr<ParseTreeNode> parseIfStatement() {
-        auto node = make_shared<ParseTreeNode>("IfStatement");
-        node->addChild(make_shared<ParseTreeNode>("Keyword", consume().value)); // 'if'
-        
-        // Parse the condition - no need to flatten it anymore
-        node->addChild(parseTest());
-        
-        expect(DELIMITER, ":", "Expected ':' after if condition");
-        node->addChild(parseBlockOrSimpleSuite());
-
-        // Parse optional elif blocks
-        while (match(KEYWORD, "elif")) {
-            auto elifNode = make_shared<ParseTreeNode>("ElifClause");
-            elifNode->addChild(make_shared<ParseTreeNode>("Keyword", consume().value));
-            
-            // Parse the elif condition - no need to flatten it anymore
-            elifNode->addChild(parseTest());
-            
-            expect(DELIMITER, ":", "Expected ':' after elif condition");
-            elifNode->addChild(parseBlockOrSimpleSuite());
-            node->addChild(elifNode);
-        }
+shared_ptr<ParseTreeNode> Parser::parseIfStatement() {
+    PROFILE_RULE(IfStatement);
+    auto node = make_shared<ParseTreeNode>("IfStatement");
+    addSyntaxLeaf(node, "Keyword", consume().value); // 'if'
 
-        // Parse optional else-block
-        if (match(KEYWORD, "else")) {
-            auto elseNode = make_shared<ParseTreeNode>("ElseClause");
-            elseNode->addChild(make_shared<ParseTreeNode>("Keyword", consume().value));
-            expect(DELIMITER, ":", "Expected ':' after 'else'");
-            elseNode->addChild(parseBlockOrSimpleSuite());
-            node->addChild(elseNode);
-        }
+    // Parse the condition - no need to flatten it anymore
+    node->addChild(parseTest());
 
-        return node;
+    expect(TK_COLON, "Expected ':' after if condition");
+    node->addChild(parseBlockOrSimpleSuite());
+
+    // Parse optional elif blocks
+    while (decide(D_IF_STMT_KW_ELIF)) {
+        auto elifNode = make_shared<ParseTreeNode>("ElifClause");
+        elifNode->line = currentToken().line;
+        addSyntaxLeaf(elifNode, "Keyword", consume().value);
+
+        // Parse the elif condition - no need to flatten it anymore
+        elifNode->addChild(parseTest());
+
+        expect(TK_COLON, "Expected ':' after elif condition");
+        elifNode->addChild(parseBlockOrSimpleSuite());
+        node->addChild(elifNode);
     }
 
-    shared_ptr<ParseTreeNode> parseWhileStatement() {
-        auto node = make_shared<ParseTreeNode>("WhileStatement");
-        node->addChild(make_shared<ParseTreeNode>("Keyword", consume().value));
-        node->addChild(parseTest());
-        expect(DELIMITER, ":", "Expected ':' after while condition");
-        node->addChild(parseBlockOrSimpleSuite());
-        return node;
+    // Parse optional else-block
+    if (decide(D_IF_STMT_KW_ELSE)) {
+        auto elseNode = make_shared<ParseTreeNode>("ElseClause");
+        addSyntaxLeaf(elseNode, "Keyword", consume().value);
+        expect(TK_COLON, "Expected ':' after 'else'");
+        elseNode->addChild(parseBlockOrSimpleSuite());
+        node->addChild(elseNode);
     }
 
-    shared_ptr<ParseTreeNode> parseForStatement() {
-        auto node = make_shared<ParseTreeNode>("ForStatement");
-        node->addChild(make_shared<ParseTreeNode>("Keyword", consume().value));
-        node->addChild(make_shared<ParseTreeNode>("Identifier", expect(IDENTIFIER, "Expected identifier after 'for'").value));
-        expect(KEYWORD, "in", "Expected 'in' after for variable");
-        node->addChild(make_shared<ParseTreeNode>("Keyword", "in"));
-        node->addChild(parseTest());
-        expect(DELIMITER, ":", "Expected ':' after for statement");
-        node->addChild(parseBlockOrSimpleSuite());
-        return node;
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseWhileStatement() {
+    PROFILE_RULE(WhileStatement);
+    auto node = make_shared<ParseTreeNode>("WhileStatement");
+    addSyntaxLeaf(node, "Keyword", consume().value);
+    node->addChild(parseTest());
+    expect(TK_COLON, "Expected ':' after while condition");
+    node->addChild(parseBlockOrSimpleSuite());
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseForStatement() {
+    PROFILE_RULE(ForStatement);
+    auto node = make_shared<ParseTreeNode>("ForStatement");
+    addSyntaxLeaf(node, "Keyword", consume().value);
+    node->addChild(makeLeaf("Identifier", expect(TK_NAME, "Expected identifier after 'for'").value));
+    expect(TK_KW_IN, "Expected 'in' after for variable");
+    addSyntaxLeaf(node, "Keyword", "in");
+    node->addChild(parseTest());
+    expect(TK_COLON, "Expected ':' after for statement");
+    node->addChild(parseBlockOrSimpleSuite());
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseFunctionDef() {
+    PROFILE_RULE(FunctionDef);
+    auto node = make_shared<ParseTreeNode>("FunctionDefinition");
+    addSyntaxLeaf(node, "Keyword", consume().value);
+    node->addChild(makeLeaf("Identifier", expect(TK_NAME, "Expected function name after 'def'").value));
+
+    // Add opening parenthesis node
+    Token openParen = expect(TK_LPAREN, "Expected '(' after function name");
+    addSyntaxLeaf(node, "Delimiter", openParen.value);
+
+    auto paramsNode = make_shared<ParseTreeNode>("Parameters");
+    // Anything but ')' is taken as a parameter list, so a bad name gets the precise message
+    if (!at(TK_RPAREN)) {
+        do {
+            paramsNode->addChild(make_shared<ParseTreeNode>("Parameter", expect(TK_NAME, "Expected parameter name").value));
+            if (decide(D_PARAMETERS_COMMA)) {
+                Token comma = consume();
+                addSyntaxLeaf(paramsNode, "Delimiter", comma.value);
+                if (at(TK_RPAREN)) break;
+            } else {
+                break;
+            }
+        } while (true);
     }
+    node->addChild(paramsNode);
 
-    shared_ptr<ParseTreeNode> parseFunctionDef() {
-        auto node = make_shared<ParseTreeNode>("FunctionDefinition");
-        node->addChild(make_shared<ParseTreeNode>("Keyword", consume().value));
-        node->addChild(make_shared<ParseTreeNode>("Identifier", expect(IDENTIFIER, "Expected function name after 'def'").value));
+    // Add closing parenthesis node
+    Token closeParen = expect(TK_RPAREN, "Expected ')' after parameters");
+    addSyntaxLeaf(node, "Delimiter", closeParen.value);
 
-        // Add opening parenthesis node
-        Token openParen = expect(DELIMITER, "(", "Expected '(' after function name");
-        node->addChild(make_shared<ParseTreeNode>("Delimiter", openParen.value));
+    // Add colon node
+    Token colon = expect(TK_COLON, "Expected ':' after function declaration");
+    addSyntaxLeaf(node, "Delimiter", colon.value);
 
-        auto paramsNode = make_shared<ParseTreeNode>("Parameters");
-        if (!match(DELIMITER, ")")) {
-            do {
-                paramsNode->addChild(make_shared<ParseTreeNode>("Parameter", expect(IDENTIFIER, "Expected parameter name").value));
-                if (match(DELIMITER, ",")) {
-                    Token comma = consume();
-                    paramsNode->addChild(make_shared<ParseTreeNode>("Delimiter", comma.value));
-                    if (match(DELIMITER, ")")) break;
-                } else {
-                    break;
-                }
-            } while (true);
-        }
-        node->addChild(paramsNode);
+    node->addChild(parseBlockOrSimpleSuite());
+    return node;
+}
 
-        // Add closing parenthesis node
-        Token closeParen = expect(DELIMITER, ")", "Expected ')' after parameters");
-        node->addChild(make_shared<ParseTreeNode>("Delimiter", closeParen.value));
+shared_ptr<ParseTreeNode> Parser::parseClassDef() {
+    PROFILE_RULE(ClassDef);
+    auto node = make_shared<ParseTreeNode>("ClassDefinition");
+    addSyntaxLeaf(node, "Keyword", consume().value);
+    node->addChild(makeLeaf("Identifier", expect(TK_NAME, "Expected class name after 'class'").value));
 
-        // Add colon node
-        Token colon = expect(DELIMITER, ":", "Expected ':' after function declaration");
-        node->addChild(make_shared<ParseTreeNode>("Delimiter", colon.value));
+    if (decide(D_CLASS_DEF_LPAREN)) {
+        // Add opening parenthesis to parse tree
+        Token openParen = consume();
+        addSyntaxLeaf(node, "Delimiter", openParen.value);
 
-        node->addChild(parseBlockOrSimpleSuite());
-        return node;
-    }
+        node->addChild(make_shared<ParseTreeNode>("Parent", expect(TK_NAME, "Expected parent class name").value));
 
-    shared_ptr<ParseTreeNode> parseClassDef() {
-        auto node = make_shared<ParseTreeNode>("ClassDefinition");
-        node->addChild(make_shared<ParseTreeNode>("Keyword", consume().value));
-        node->addChild(make_shared<ParseTreeNode>("Identifier", expect(IDENTIFIER, "Expected class name after 'class'").value));
-        
-        if (match(DELIMITER, "(")) {
-            // Add opening parenthesis to parse tree
-            Token openParen = consume();
-            node->addChild(make_shared<ParseTreeNode>("Delimiter", openParen.value));
-            
-            node->addChild(make_shared<ParseTreeNode>("Parent", expect(IDENTIFIER, "Expected parent class name").value));
-            
-            // Add closing parenthesis to parse tree
-            Token closeParen = expect(DELIMITER, ")", "Expected ')' after parent class name");
-            node->addChild(make_shared<ParseTreeNode>("Delimiter", closeParen.value));
-        }
-        
-        // Add colon to parse tree
-        Token colon = expect(DELIMITER, ":", "Expected ':' after class declaration");
-        node->addChild(make_shared<ParseTreeNode>("Delimiter", colon.value));
-        
-        node->addChild(parseBlockOrSimpleSuite());
-        return node;
+        // Add closing parenthesis to parse tree
+        Token closeParen = expect(TK_RPAREN, "Expected ')' after parent class name");
+        addSyntaxLeaf(node, "Delimiter", closeParen.value);
     }
 
-    shared_ptr<ParseTreeNode> parseReturnStatement() {
-        auto node = make_shared<ParseTreeNode>("ReturnStatement");
-        
-        // Parse 'return' keyword
-        node->addChild(make_shared<ParseTreeNode>("Keyword", consume().value));
-        
-        // Parse optional return value
-        if (!match(DELIMITER, ";") && currentPos < tokens.size()) {
-            node->addChild(parseTest());
-        }
-        
-        return node;
-    }
+    // Add colon to parse tree
+    Token colon = expect(TK_COLON, "Expected ':' after class declaration");
+    addSyntaxLeaf(node, "Delimiter", colon.value);
 
-    shared_ptr<ParseTreeNode> parsePassStatement() {
-        auto node = make_shared<ParseTreeNode>("PassStatement");
-        node->addChild(make_shared<ParseTreeNode>("Keyword", consume().value)); // 'pass'
-        return node;
-    }
+    node->addChild(parseBlockOrSimpleSuite());
+    return node;
+}
 
-    shared_ptr<ParseTreeNode> parseBreakStatement() {
-        auto node = make_shared<ParseTreeNode>("BreakStatement");
-        node->addChild(make_shared<ParseTreeNode>("Keyword", consume().value)); // 'break'
-        return node;
-    }
+shared_ptr<ParseTreeNode> Parser::parseReturnStatement() {
+    PROFILE_RULE(ReturnStatement);
+    auto node = make_shared<ParseTreeNode>("ReturnStatement");
 
-    shared_ptr<ParseTreeNode> parseContinueStatement() {
-        auto node = make_shared<ParseTreeNode>("ContinueStatement");
-        node->addChild(make_shared<ParseTreeNode>("Keyword", consume().value)); // 'continue'
-        return node;
+    // Parse 'return' keyword
+    addSyntaxLeaf(node, "Keyword", consume().value);
+
+    // Parse optional return value
+    if (decide(D_RETURN_STMT_EXPRESSION_LIST)) {
+        auto firstExpr = parseTest();
+        if (decide(D_EXPRESSION_LIST_COMMA)) {
+            // 'return a, b' returns a tuple
+            auto valueNode = make_shared<ParseTreeNode>("ExpressionList");
+            valueNode->addChild(firstExpr);
+            while (decide(D_EXPRESSION_LIST_COMMA)) {
+                consume(); // consume ','
+                valueNode->addChild(parseTest());
+            }
+            node->addChild(valueNode);
+        } else {
+            node->addChild(firstExpr);
+        }
     }
 
-    shared_ptr<ParseTreeNode> parseImportStatement() {
-        auto node = make_shared<ParseTreeNode>("ImportStatement");
-        
-        // Parse 'import' or 'from' keyword
-        node->addChild(make_shared<ParseTreeNode>("Keyword", consume().value));
-        
-        if (node->children[0]->value == "import") {
-            // Parse module name
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parsePassStatement() {
+    PROFILE_RULE(PassStatement);
+    auto node = make_shared<ParseTreeNode>("PassStatement");
+    addSyntaxLeaf(node, "Keyword", consume().value); // 'pass'
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseBreakStatement() {
+    PROFILE_RULE(BreakStatement);
+    auto node = make_shared<ParseTreeNode>("BreakStatement");
+    addSyntaxLeaf(node, "Keyword", consume().value); // 'break'
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseContinueStatement() {
+    PROFILE_RULE(ContinueStatement);
+    auto node = make_shared<ParseTreeNode>("ContinueStatement");
+    addSyntaxLeaf(node, "Keyword", consume().value); // 'continue'
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseImportStatement() {
+    PROFILE_RULE(ImportStatement);
+    auto node = make_shared<ParseTreeNode>("ImportStatement");
+    uint8_t form = decide(D_IMPORT_STMT);
+
+    // Parse 'import' or 'from' keyword
+    node->addChild(make_shared<ParseTreeNode>("Keyword", consume().value));
+
+    if (form == IMPORT_STMT_KW_IMPORT) {
+        // Parse module name
+        node->addChild(parseDottedName());
+
+        // Parse optional 'as' clause
+        if (decide(D_IMPORT_STMT_KW_AS)) {
+            consume(); // consume 'as'
+            node->addChild(make_shared<ParseTreeNode>("Alias", expect(TK_NAME, "Expected identifier after 'as'").value));
+        }
+
+        // Parse additional imports
+        while (decide(D_IMPORT_STMT_COMMA)) {
+            consume(); // consume ','
             node->addChild(parseDottedName());
-            
+
             // Parse optional 'as' clause
-            if (match(KEYWORD, "as")) {
+            if (decide(D_IMPORT_STMT_KW_AS_2)) {
                 consume(); // consume 'as'
-                node->addChild(make_shared<ParseTreeNode>("Alias", expect(IDENTIFIER, "Expected identifier after 'as'").value));
+                node->addChild(make_shared<ParseTreeNode>("Alias", expect(TK_NAME, "Expected identifier after 'as'").value));
             }
-            
-            // Parse additional imports
-            while (match(DELIMITER, ",")) {
-                consume(); // consume ','
-                node->addChild(parseDottedName());
-                
-                // Parse optional 'as' clause
-                if (match(KEYWORD, "as")) {
-                    consume(); // consume 'as'
-                    node->addChild(make_shared<ParseTreeNode>("Alias", expect(IDENTIFIER, "Expected identifier after 'as'").value));
-                }
-            }
-        } else if (node->children[0]->value == "from") {
-            // Parse module name
-            node->addChild(parseDottedName());
-            
-            // Parse 'import' keyword
-            expect(KEYWORD, "import", "Expected 'import' after module name");
-            
-            // Parse '*' or specific imports
-            if (match(OPERATOR, "*")) {
-                node->addChild(make_shared<ParseTreeNode>("ImportAll", consume().value));
-            } else {
-                // Parse name to import
-                node->addChild(make_shared<ParseTreeNode>("ImportName", expect(IDENTIFIER, "Expected name to import").value));
-                
-                // Parse optional 'as' clause
-                if (match(KEYWORD, "as")) {
-                    consume(); // consume 'as'
-                    node->addChild(make_shared<ParseTreeNode>("Alias", expect(IDENTIFIER, "Expected identifier after 'as'").value));
-                }
+        }
+    } else if (form == IMPORT_STMT_KW_FROM) {
+        // Parse module name
+        node->addChild(parseDottedName());
+
+        // Parse 'import' keyword
+        expect(TK_KW_IMPORT, "Expected 'import' after module name");
+
+        // Parse '*' or specific imports
+        if (decide(D_IMPORT_STMT_ALT) == IMPORT_STMT_ALT_STAR) {
+            node->addChild(make_shared<ParseTreeNode>("ImportAll", consume().value));
+        } else {
+            // Parse name to import
+            node->addChild(make_shared<ParseTreeNode>("ImportName", expect(TK_NAME, "Expected name to import").value));
+
+            // Parse optional 'as' clause
+            if (decide(D_IMPORT_STMT_KW_AS_3)) {
+                consume(); // consume 'as'
+                node->addChild(make_shared<ParseTreeNode>("Alias", expect(TK_NAME, "Expected identifier after 'as'").value));
             }
         }
-        
-        return node;
     }
 
-    shared_ptr<ParseTreeNode> parseDottedName() {
-        auto node = make_shared<ParseTreeNode>("DottedName");
-        
-        // Parse first part of the name
-        node->addChild(make_shared<ParseTreeNode>("NamePart", expect(IDENTIFIER, "Expected identifier").value));
-        
-        // Parse additional parts
-        while (match(DELIMITER, ".")) {
-            // Add dot to parse tree
-            Token dot = consume();
-            node->addChild(make_shared<ParseTreeNode>("Delimiter", dot.value));
-            
-            node->addChild(make_shared<ParseTreeNode>("NamePart", expect(IDENTIFIER, "Expected identifier after '.'").value));
-        }
-        
-        return node;
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseDottedName() {
+    PROFILE_RULE(DottedName);
+    auto node = make_shared<ParseTreeNode>("DottedName");
+
+    // Parse first part of the name
+    node->addChild(make_shared<ParseTreeNode>("NamePart", expect(TK_NAME, "Expected identifier").value));
+
+    // Parse additional parts
+    while (decide(D_DOTTED_NAME_DOT)) {
+        // Add dot to parse tree
+        Token dot = consume();
+        addSyntaxLeaf(node, "Delimiter", dot.value);
+
+        node->addChild(make_shared<ParseTreeNode>("NamePart", expect(TK_NAME, "Expected identifier after '.'").value));
     }
 
-    shared_ptr<ParseTreeNode> parseAssignment() {
-        auto node = make_shared<ParseTreeNode>("Assignment");
-        
-        // Parse identifier list (target)
-        auto targetNode = make_shared<ParseTreeNode>("IdentifierList");
-        
-        // Check if the target is a simple identifier or an attribute access
-        if (match(IDENTIFIER)) {
-            size_t savedPos = currentPos;
-            string name = consume().value;
-            
-            if (match(DELIMITER, ".")) {
-                // It's an attribute access
-                currentPos = savedPos;
-                targetNode->addChild(parseAtomExpr());
-            } else {
-                // It's a simple identifier
-                currentPos = savedPos;
-                targetNode->addChild(make_shared<ParseTreeNode>("Identifier", consume().value));
-            }
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseAssignment() {
+    PROFILE_RULE(Assignment);
+    auto node = make_shared<ParseTreeNode>("Assignment");
+
+    // Parse identifier list (target)
+    auto targetNode = make_shared<ParseTreeNode>("IdentifierList");
+
+    // The target's alternatives all start with an identifier; the token after it tells a
+    // simple name from an attribute access or a subscript
+    if (decide(D_IDENTIFIER_LIST_ALT) == PARSE_CONFLICT && at(TK_NAME)) {
+        TokenKind next = kindAt(currentPos + 1);
+        if (next == TK_DOT || next == TK_LBRACKET) {
+            targetNode->addChild(parseAtomExpr());
         } else {
-            syntaxError("Expected identifier or attribute access");
+            targetNode->addChild(makeLeaf("Identifier", consume().value));
         }
-        
-        while (match(DELIMITER, ",")) {
+    } else {
+        syntaxError("Expected identifier or attribute access");
+    }
+
+    while (decide(D_IDENTIFIER_LIST_COMMA)) {
+        consume(); // consume ','
+        targetNode->addChild(makeLeaf("Identifier", expect(TK_NAME, "Expected identifier after ','").value));
+    }
+
+    node->addChild(targetNode);
+
+    // Parse assignment operator
+    if (!decide(D_ASSIGN_OP)) {
+        syntaxError("Expected assignment operator");
+    }
+    string op = consume().value; // =, +=, -=, etc.
+    node->addChild(make_shared<ParseTreeNode>("AssignOp", op));
+
+    // Parse expression list (value)
+    auto firstExpr = parseTest();
+    if (decide(D_EXPRESSION_LIST_COMMA)) {
+        auto valueNode = make_shared<ParseTreeNode>("ExpressionList");
+        valueNode->addChild(firstExpr);
+        while (decide(D_EXPRESSION_LIST_COMMA)) {
             consume(); // consume ','
-            targetNode->addChild(make_shared<ParseTreeNode>("Identifier", expect(IDENTIFIER, "Expected identifier after ','").value));
+            valueNode->addChild(parseTest());
         }
-        
-        node->addChild(targetNode);
-        
-        // Parse assignment operator
-        string op = consume().value; // =, +=, -=, etc.
-        node->addChild(make_shared<ParseTreeNode>("AssignOp", op));
-        
-        // Parse expression list (value)
-        auto firstExpr = parseTest();
-        if (match(DELIMITER, ",")) {
-            auto valueNode = make_shared<ParseTreeNode>("ExpressionList");
-            valueNode->addChild(firstExpr);
-            while (match(DELIMITER, ",")) {
-                consume(); // consume ','
-                valueNode->addChild(parseTest());
-            }
-            node->addChild(valueNode);
-        } else {
-            node->addChild(firstExpr);
-        }
-        
-        return node;
+        node->addChild(valueNode);
+    } else {
+        node->addChild(firstExpr);
     }
 
-    shared_ptr<ParseTreeNode> parseFunctionCallStatement() {
-        auto node = make_shared<ParseTreeNode>("FunctionCallStatement");
-        
-        // Parse function name (could be dotted)
-        if (match(IDENTIFIER)) {
-            size_t savedPos = currentPos;
-            string name = consume().value;
-            
-            if (match(DELIMITER, ".")) {
-                // It's a dotted name
-                currentPos = savedPos;
-                node->addChild(parseDottedName());
-            } else {
-                // It's a simple name
-                currentPos = savedPos;
-                node->addChild(make_shared<ParseTreeNode>("Identifier", consume().value));
-            }
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseFunctionCallStatement() {
+    PROFILE_RULE(FunctionCallStatement);
+    auto node = make_shared<ParseTreeNode>("FunctionCallStatement");
+
+    // Parse function name (could be dotted)
+    if (decide(D_FUNCTION_CALL_STMT_ALT) == PARSE_CONFLICT && at(TK_NAME)) {
+        if (kindAt(currentPos + 1) == TK_DOT) {
+            node->addChild(parseDottedName());
         } else {
-            syntaxError("Expected function name");
+            node->addChild(makeLeaf("Identifier", consume().value));
         }
-        
-        // Add opening parenthesis to parse tree
-        Token openParen = expect(DELIMITER, "(", "Expected '(' after function name");
-        node->addChild(make_shared<ParseTreeNode>("Delimiter", openParen.value));
-        
-        auto argsNode = make_shared<ParseTreeNode>("Arguments");
-        if (!match(DELIMITER, ")")) {
+    } else {
+        syntaxError("Expected function name");
+    }
+
+    // Add opening parenthesis to parse tree
+    Token openParen = expect(TK_LPAREN, "Expected '(' after function name");
+    addSyntaxLeaf(node, "Delimiter", openParen.value);
+
+    auto argsNode = make_shared<ParseTreeNode>("Arguments");
+    if (decide(D_FUNCTION_CALL_STMT_ARGUMENTS)) {
+        argsNode->addChild(parseTest());
+
+        while (decide(D_ARGUMENTS_COMMA)) {
+            // Add comma to parse tree
+            Token comma = consume();
+            addSyntaxLeaf(argsNode, "Delimiter", comma.value);
+
+            if (at(TK_RPAREN)) break; // Handle trailing comma
             argsNode->addChild(parseTest());
-            
-            while (match(DELIMITER, ",")) {
-                // Add comma to parse tree
-                Token comma = consume();
-                argsNode->addChild(make_shared<ParseTreeNode>("Delimiter", comma.value));
-                
-                if (match(DELIMITER, ")")) break; // Handle trailing comma
-                argsNode->addChild(parseTest());
-            }
         }
-        
-        node->addChild(argsNode);
-        
-        // Add closing parenthesis to parse tree
-        Token closeParen = expect(DELIMITER, ")", "Expected ')' after function arguments");
-        node->addChild(make_shared<ParseTreeNode>("Delimiter", closeParen.value));
-        
-        return node;
     }
 
-    shared_ptr<ParseTreeNode> parseExpressionStatement() {
-        auto node = make_shared<ParseTreeNode>("ExpressionStatement");
-        node->addChild(parseTest());
-        return node;
-    }
+    node->addChild(argsNode);
 
-    shared_ptr<ParseTreeNode> parseSuite() {
-        auto node = make_shared<ParseTreeNode>("Suite");
-        
-        // Handle INDENT for block
-        if ( match(NEWLINE)) {
-            consume(); // consume INDENT
-            if (match(INDENT)) {
-                consume(); // consume NEWLINE
-            } else {
-                syntaxError("Expected INDENT after newline");
-            }
-            // Parse multiple statements until DEDENT
-            while (!match(DEDENT) && currentPos < tokens.size()) {
-                node->addChild(parseStatement());
-            }
-            // Accept DEDENT or EOF as valid end of block
-            if (match(DEDENT)) {
-                consume(); // consume DEDENT
-            } else if (currentPos >= tokens.size()) {
-                // Allow EOF as a valid end of block
-            } else {
-                syntaxError("Expected DEDENT at end of block");
-            }        
+    // Add closing parenthesis to parse tree
+    Token closeParen = expect(TK_RPAREN, "Expected ')' after function arguments");
+    addSyntaxLeaf(node, "Delimiter", closeParen.value);
+
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseExpressionStatement() {
+    PROFILE_RULE(ExpressionStatement);
+    auto node = make_shared<ParseTreeNode>("ExpressionStatement");
+    node->addChild(parseTest());
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseSuite() {
+    PROFILE_RULE(Suite);
+    auto node = make_shared<ParseTreeNode>("Suite");
+
+    // Handle INDENT for block
+    if ( match(NEWLINE)) {
+        consume(); // consume INDENT
+        if (match(INDENT)) {
+            consume(); // consume NEWLINE
         } else {
-            // Simple statement after ':'
+            syntaxError("Expected INDENT after newline");
+        }
+        // Parse multiple statements until DEDENT
+        while (!match(DEDENT) && !atEnd()) {
             node->addChild(parseStatement());
         }
-        
+        // Accept DEDENT or EOF as valid end of block
+        if (match(DEDENT)) {
+            consume(); // consume DEDENT
+        } else if (atEnd()) {
+            // Allow EOF as a valid end of block
+        } else {
+            syntaxError("Expected DEDENT at end of block");
+        }
+    } else {
+        // Simple statement after ':'
+        node->addChild(parseStatement());
+    }
+
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseTernaryOp() {
+    PROFILE_RULE(TernaryOp);
+    auto thenExpr = parseOrTest();
+
+    if (decide(D_TERNARY_OP_KW_IF)) {
+        auto node = make_shared<ParseTreeNode>("TernaryOp");
+        node->addChild(thenExpr);  // Value if true
+        addSyntaxLeaf(node, "Keyword", consume().value);  // 'if'
+        node->addChild(parseOrTest());  // Condition
+
+        expect(TK_KW_ELSE, "Expected 'else' in conditional expression");
+        addSyntaxLeaf(node, "Keyword", "else");
+        node->addChild(parseTest());  // Value if false
+
         return node;
     }
 
-    shared_ptr<ParseTreeNode> parseTernaryOp() {
-        auto thenExpr = parseOrTest();
-        
-        if (match(KEYWORD, "if")) {
-            auto node = make_shared<ParseTreeNode>("TernaryOp");
-            node->addChild(thenExpr);  // Value if true
-            node->addChild(make_shared<ParseTreeNode>("Keyword", consume().value));  // 'if'
-            node->addChild(parseOrTest());  // Condition
-            
-            expect(KEYWORD, "else", "Expected 'else' in conditional expression");
-            node->addChild(make_shared<ParseTreeNode>("Keyword", "else"));
-            node->addChild(parseTest());  // Value if false
-            
-            return node;
-        }
-        
-        return thenExpr;
+    return thenExpr;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseTest() {
+    PROFILE_RULE(Test);
+    return parseTernaryOp();
+}
+
+shared_ptr<ParseTreeNode> Parser::parseOrTest() {
+    PROFILE_RULE(OrTest);
+    auto node = parseAndTest();
+
+    while (decide(D_OR_TEST_KW_OR)) {
+        auto opNode = make_shared<ParseTreeNode>("BinaryOp", consume().value);
+        opNode->addChild(node);
+        opNode->addChild(parseAndTest());
+        node = opNode;
     }
 
-    shared_ptr<ParseTreeNode> parseTest() {
-        return parseTernaryOp();
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseAndTest() {
+    PROFILE_RULE(AndTest);
+    auto node = parseNotTest();
+
+    while (decide(D_AND_TEST_KW_AND)) {
+        auto opNode = make_shared<ParseTreeNode>("BinaryOp", consume().value);
+        opNode->addChild(node);
+        opNode->addChild(parseNotTest());
+        node = opNode;
     }
 
-    shared_ptr<ParseTreeNode> parseOrTest() {
-        auto node = parseAndTest();
-        
-        while (match(KEYWORD, "or")) {
-            auto opNode = make_shared<ParseTreeNode>("BinaryOp", consume().value);
-            opNode->addChild(node);
-            opNode->addChild(parseAndTest());
-            node = opNode;
-        }
-        
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseNotTest() {
+    PROFILE_RULE(NotTest);
+    if (decide(D_NOT_TEST) == NOT_TEST_KW_NOT) {
+        auto node = make_shared<ParseTreeNode>("UnaryOp", consume().value);
+        node->addChild(parseNotTest());
         return node;
     }
 
-    shared_ptr<ParseTreeNode> parseAndTest() {
-        auto node = parseNotTest();
-        
-        while (match(KEYWORD, "and")) {
-            auto opNode = make_shared<ParseTreeNode>("BinaryOp", consume().value);
-            opNode->addChild(node);
-            opNode->addChild(parseNotTest());
-            node = opNode;
+    return parseComparison();
+}
+
+shared_ptr<ParseTreeNode> Parser::parseComparison() {
+    PROFILE_RULE(Comparison);
+    auto leftExpr = parseArithExpr();
+
+    // 'not' only starts an operator as part of 'not in', which takes a second token to see
+    bool notIn = decide(D_COMP_OP) == COMP_OP_KW_NOT;
+    if (decide(D_COMPARISON_COMP_OP) && (!notIn || kindAt(currentPos + 1) == TK_KW_IN)) {
+
+        // Create a flattened comparison node
+        auto node = make_shared<ParseTreeNode>("Comparison");
+
+        // Add left operand
+        node->addChild(leftExpr);
+
+        // Add operator; 'not in' is two tokens but one operator
+        Token op = consume();
+        if (notIn) {
+            consume();
+            op.value = "not in";
         }
-        
+        node->addChild(make_shared<ParseTreeNode>("ComparisonOp", op.value));
+
+        // Add right operand
+        auto rightExpr = parseArithExpr();
+        node->addChild(rightExpr);
+
         return node;
     }
 
-    shared_ptr<ParseTreeNode> parseNotTest() {
-        if (match(KEYWORD, "not")) {
-            auto node = make_shared<ParseTreeNode>("UnaryOp", consume().value);
-            node->addChild(parseNotTest());
-            return node;
-        }
-        
-        return parseComparison();
-    }
-
-    shared_ptr<ParseTreeNode> parseComparison() {
-        auto leftExpr = parseArithExpr();
-        
-        if (match(OPERATOR, "<") || match(OPERATOR, ">") || match(OPERATOR, "==") || 
-            match(OPERATOR, ">=") || match(OPERATOR, "<=") || match(OPERATOR, "!=")) {
-            
-            // Create a flattened comparison node
-            auto node = make_shared<ParseTreeNode>("Comparison");
-            
-            // Add left operand
-            node->addChild(leftExpr);
-            
-            // Add operator
-            Token op = consume();
-            node->addChild(make_shared<ParseTreeNode>("ComparisonOp", op.value));
-            
-            // Add right operand
-            auto rightExpr = parseArithExpr();
-            node->addChild(rightExpr);
-            
-            return node;
-        }
-        
-        return leftExpr;
-    }
+    return leftExpr;
+}
 
-    shared_ptr<ParseTreeNode> parseArithExpr() {
-        auto exprList = make_shared<ParseTreeNode>("ExpressionList");
+shared_ptr<ParseTreeNode> Parser::parseArithExpr() {
+    PROFILE_RULE(ArithExpr);
+    auto exprList = make_shared<ParseTreeNode>("ExpressionList");
+    exprList->addChild(parseTerm());
+    while (decide(D_ARITH_EXPR_PLUS)) {
+        exprList->addChild(make_shared<ParseTreeNode>("BinaryOp", consume().value));
         exprList->addChild(parseTerm());
-        while (match(OPERATOR, "+") || match(OPERATOR, "-")) {
-            exprList->addChild(make_shared<ParseTreeNode>("BinaryOp", consume().value));
-            exprList->addChild(parseTerm());
-        }
-        return exprList->children.size() == 1 ? exprList->children[0] : exprList;
+    }
+    return exprList->children.size() == 1 ? exprList->children[0] : exprList;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseTerm() {
+    PROFILE_RULE(Term);
+    auto node = parseFactor();
+
+    while (decide(D_TERM_STAR)) {
+        auto opNode = make_shared<ParseTreeNode>("BinaryOp", consume().value);
+        opNode->addChild(node);
+        opNode->addChild(parseFactor());
+        node = opNode;
     }
 
-    shared_ptr<ParseTreeNode> parseTerm() {
-        auto node = parseFactor();
-        
-        while (match(OPERATOR, "*") || match(OPERATOR, "/") || match(OPERATOR, "//")) {
-            auto opNode = make_shared<ParseTreeNode>("BinaryOp", consume().value);
-            opNode->addChild(node);
-            opNode->addChild(parseFactor());
-            node = opNode;
-        }
-        
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseFactor() {
+    PROFILE_RULE(Factor);
+    if (decide(D_FACTOR) == FACTOR_PLUS) {
+        auto node = make_shared<ParseTreeNode>("UnaryOp", consume().value);
+        node->addChild(parseFactor());
         return node;
     }
 
-    shared_ptr<ParseTreeNode> parseFactor() {
-        if (match(OPERATOR, "+") || match(OPERATOR, "-") || match(OPERATOR, "~")) {
-            auto node = make_shared<ParseTreeNode>("UnaryOp", consume().value);
-            node->addChild(parseFactor());
-            return node;
-        }
-        
-        return parseAtomExpr();
-    }
+    return parseAtomExpr();
+}
 
-    // Modified parseAtomExpr method to include parentheses and dots
-    shared_ptr<ParseTreeNode> parseAtomExpr() {
-        auto node = parseAtom();
-        
-        // Parse trailers (function calls, attribute access, etc.)
-        while (match(DELIMITER, "(") || match(DELIMITER, ".")) {
-            if (match(DELIMITER, "(")) {
+shared_ptr<ParseTreeNode> Parser::parseAtomExpr() {
+    PROFILE_RULE(AtomExpr);
+    auto node = parseAtom();
+
+    // Parse trailers (function calls, attribute access, subscripts)
+    while (decide(D_ATOM_EXPR_TRAILER)) {
+        switch (decide(D_TRAILER)) {
+            case TRAILER_LPAREN: {
                 auto callNode = make_shared<ParseTreeNode>("FunctionCall");
                 callNode->addChild(node);
-                
+
                 // Add opening parenthesis to parse tree
                 Token openParen = consume();
-                callNode->addChild(make_shared<ParseTreeNode>("Delimiter", openParen.value));
-                
+                addSyntaxLeaf(callNode, "Delimiter", openParen.value);
+
                 auto argsNode = make_shared<ParseTreeNode>("Arguments");
-                
-                if (!match(DELIMITER, ")")) {
+
+                if (decide(D_TRAILER_ARGUMENTS)) {
                     argsNode->addChild(parseTest());
-                    
-                    while (match(DELIMITER, ",")) {
+
+                    while (decide(D_ARGUMENTS_COMMA)) {
                         // Add comma to parse tree
                         Token comma = consume();
-                        argsNode->addChild(make_shared<ParseTreeNode>("Delimiter", comma.value));
-                        
-                        if (match(DELIMITER, ")")) break; // Handle trailing comma
+                        addSyntaxLeaf(argsNode, "Delimiter", comma.value);
+
+                        if (at(TK_RPAREN)) break; // Handle trailing comma
                         argsNode->addChild(parseTest());
                     }
                 }
-                
+
                 callNode->addChild(argsNode);
-                
+
                 // Add closing parenthesis to parse tree
-                Token closeParen = expect(DELIMITER, ")", "Expected ')' after function arguments");
-                callNode->addChild(make_shared<ParseTreeNode>("Delimiter", closeParen.value));
-                
+                Token closeParen = expect(TK_RPAREN, "Expected ')' after function arguments");
+                addSyntaxLeaf(callNode, "Delimiter", closeParen.value);
+
                 node = callNode;
-            } else if (match(DELIMITER, ".")) {
+                break;
+            }
+            case TRAILER_DOT: {
                 // Handle attribute access (method calls)
                 // Add dot to parse tree
                 Token dot = consume();
-                
+
                 // Parse attribute name
                 auto attrNode = make_shared<ParseTreeNode>("AttributeAccess");
                 attrNode->addChild(node); // The object
-                attrNode->addChild(make_shared<ParseTreeNode>("Delimiter", dot.value)); // The dot
-                
+                addSyntaxLeaf(attrNode, "Delimiter", dot.value); // The dot
+
                 // Get the attribute name
-                if (match(IDENTIFIER)) {
-                    attrNode->addChild(make_shared<ParseTreeNode>("Identifier", consume().value));
-                } else {
-                    syntaxError("Expected attribute name after '.'");
-                }
-                
+                attrNode->addChild(makeLeaf("Identifier", expect(TK_NAME, "Expected attribute name after '.'").value));
+
                 node = attrNode;
+                break;
+            }
+            case TRAILER_LBRACKET: {
+                auto subscriptNode = make_shared<ParseTreeNode>("Subscript");
+                subscriptNode->addChild(node); // The container
+
+                Token openBracket = consume();
+                addSyntaxLeaf(subscriptNode, "Delimiter", openBracket.value);
+                subscriptNode->addChild(parseTest()); // The index or key
+                Token closeBracket = expect(TK_RBRACKET, "Expected ']' after subscript");
+                addSyntaxLeaf(subscriptNode, "Delimiter", closeBracket.value);
+
+                node = subscriptNode;
+                break;
             }
         }
-        
-        return node;
     }
 
-    shared_ptr<ParseTreeNode> parseAtom() {
-        if (match(DELIMITER, "(")) {
+    return node;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseAtom() {
+    PROFILE_RULE(Atom);
+    switch (decide(D_ATOM)) {
+        case ATOM_LPAREN: {
             Token openParen = consume();
             // Empty tuple
-            if (match(DELIMITER, ")")) {
-                Token closeParen = consume();
+            if (!decide(D_ATOM_TEST)) {
+                Token closeParen = expect(TK_RPAREN, "Expected expression");
                 auto tupleNode = make_shared<ParseTreeNode>("Tuple");
-                tupleNode->addChild(make_shared<ParseTreeNode>("Delimiter", openParen.value));
-                tupleNode->addChild(make_shared<ParseTreeNode>("Delimiter", closeParen.value));
+                addSyntaxLeaf(tupleNode, "Delimiter", openParen.value);
+                addSyntaxLeaf(tupleNode, "Delimiter", closeParen.value);
                 return tupleNode;
             }
             auto expr = parseTest();
-            if (match(DELIMITER, ",")) {
+            if (decide(D_ATOM_COMMA)) {
                 auto tupleNode = make_shared<ParseTreeNode>("Tuple");
-                tupleNode->addChild(make_shared<ParseTreeNode>("Delimiter", openParen.value));
+                addSyntaxLeaf(tupleNode, "Delimiter", openParen.value);
                 tupleNode->addChild(expr);
-                while (match(DELIMITER, ",")) {
+                while (decide(D_ATOM_COMMA)) {
                     Token comma = consume();
-                    tupleNode->addChild(make_shared<ParseTreeNode>("Delimiter", comma.value));
-                    if (match(DELIMITER, ")")) break;
+                    addSyntaxLeaf(tupleNode, "Delimiter", comma.value);
+                    if (at(TK_RPAREN)) break;
                     tupleNode->addChild(parseTest());
                 }
-                Token closeParen = expect(DELIMITER, ")", "Expected ')' after tuple elements");
-                tupleNode->addChild(make_shared<ParseTreeNode>("Delimiter", closeParen.value));
+                Token closeParen = expect(TK_RPAREN, "Expected ')' after tuple elements");
+                addSyntaxLeaf(tupleNode, "Delimiter", closeParen.value);
                 return tupleNode;
-            } else {
-                Token closeParen = expect(DELIMITER, ")", "Expected ')' after expression");
-                auto exprNode = make_shared<ParseTreeNode>("ParenExpr");
-                exprNode->addChild(make_shared<ParseTreeNode>("Delimiter", openParen.value));
-                exprNode->addChild(expr);
-                exprNode->addChild(make_shared<ParseTreeNode>("Delimiter", closeParen.value));
-                return exprNode;
             }
-        } else if (match(DELIMITER, "[")) {
+            Token closeParen = expect(TK_RPAREN, "Expected ')' after expression");
+            auto exprNode = make_shared<ParseTreeNode>("ParenExpr");
+            addSyntaxLeaf(exprNode, "Delimiter", openParen.value);
+            exprNode->addChild(expr);
+            addSyntaxLeaf(exprNode, "Delimiter", closeParen.value);
+            return exprNode;
+        }
+        case ATOM_LBRACKET: {
             auto listNode = make_shared<ParseTreeNode>("List");
 
             // Add opening bracket node
             Token openBracket = consume();
-            listNode->addChild(make_shared<ParseTreeNode>("Delimiter", openBracket.value));
+            addSyntaxLeaf(listNode, "Delimiter", openBracket.value);
 
-            if (!match(DELIMITER, "]")) {
+            if (decide(D_ATOM_TEST_2)) {
                 listNode->addChild(parseTest());
-                while (match(DELIMITER, ",")) {
+                while (decide(D_ATOM_COMMA_2)) {
                     Token comma = consume();
-                    listNode->addChild(make_shared<ParseTreeNode>("Delimiter", comma.value));
-                    if (match(DELIMITER, "]")) break;
+                    addSyntaxLeaf(listNode, "Delimiter", comma.value);
+                    if (at(TK_RBRACKET)) break;
                     listNode->addChild(parseTest());
                 }
             }
 
             // Add closing bracket node
-            Token closeBracket = expect(DELIMITER, "]", "Expected ']' after list elements");
-            listNode->addChild(make_shared<ParseTreeNode>("Delimiter", closeBracket.value));
+            Token closeBracket = expect(TK_RBRACKET, "Expected ']' after list elements");
+            addSyntaxLeaf(listNode, "Delimiter", closeBracket.value);
 
             return listNode;
-        } else if (match(DELIMITER, "{")) {
+        }
+        case ATOM_LBRACE: {
             // Dictionary
             auto dictNode = make_shared<ParseTreeNode>("Dict");
-            
+
             // Add opening brace to parse tree
             Token openBrace = consume();
-            dictNode->addChild(make_shared<ParseTreeNode>("Delimiter", openBrace.value));
-            
-            if (!match(DELIMITER, "}")) {
-                // Parse key-value pair
-                auto key = parseTest();
-                
-                // Add colon to parse tree
-                Token colon = expect(DELIMITER, ":", "Expected ':' after dictionary key");
-                
-                auto value = parseTest();
-                
-                auto pairNode = make_shared<ParseTreeNode>("KeyValuePair");
-                pairNode->addChild(key);
-                pairNode->addChild(make_shared<ParseTreeNode>("Delimiter", colon.value));
-                pairNode->addChild(value);
-                dictNode->addChild(pairNode);
-                
-                while (match(DELIMITER, ",")) {
+            addSyntaxLeaf(dictNode, "Delimiter", openBrace.value);
+
+            if (decide(D_ATOM_KEY_VALUE_PAIR)) {
+                dictNode->addChild(parseKeyValuePair());
+
+                while (decide(D_ATOM_COMMA_3)) {
                     // Add comma to parse tree
                     Token comma = consume();
-                    dictNode->addChild(make_shared<ParseTreeNode>("Delimiter", comma.value));
-                    
-                    if (match(DELIMITER, "}")) break; // Handle trailing comma
-                    
-                    // Parse key-value pair
-                    key = parseTest();
-                    
-                    // Add colon to parse tree
-                    colon = expect(DELIMITER, ":", "Expected ':' after dictionary key");
-                    
-                    value = parseTest();
-                    
-                    pairNode = make_shared<ParseTreeNode>("KeyValuePair");
-                    pairNode->addChild(key);
-                    pairNode->addChild(make_shared<ParseTreeNode>("Delimiter", colon.value));
-                    pairNode->addChild(value);
-                    dictNode->addChild(pairNode);
+                    addSyntaxLeaf(dictNode, "Delimiter", comma.value);
+
+                    if (at(TK_RBRACE)) break; // Handle trailing comma
+                    dictNode->addChild(parseKeyValuePair());
                 }
             }
-            
+
             // Add closing brace to parse tree
-            Token closeBrace = expect(DELIMITER, "}", "Expected '}' after dictionary elements");
-            dictNode->addChild(make_shared<ParseTreeNode>("Delimiter", closeBrace.value));
-            
+            Token closeBrace = expect(TK_RBRACE, "Expected '}' after dictionary elements");
+            addSyntaxLeaf(dictNode, "Delimiter", closeBrace.value);
+
             return dictNode;
-        } else if (match(IDENTIFIER)) {
-            return make_shared<ParseTreeNode>("Identifier", consume().value);
-        } else if (match(LITERAL)) {
-            return make_shared<ParseTreeNode>("Literal", consume().value);
-        } else if (match(KEYWORD, "None") || match(KEYWORD, "True") || match(KEYWORD, "False")) {
-            return make_shared<ParseTreeNode>("Keyword", consume().value);
-        } else if (currentPos >= tokens.size()) {
-            syntaxError("Unexpected end of input (EOF) while parsing expression");
-        } else {
-            syntaxError("Expected expression");
         }
-        return nullptr;
+        case ATOM_NAME:
+            return makeLeaf("Identifier", consume().value);
+        case ATOM_NUMBER:
+        case ATOM_STRING: {
+            Token token = consume();
+            auto leaf = makeLeaf("Literal", token.value);
+            if (!leaf->literal) leaf->literal = token.literal;
+            return leaf;
+        }
+        case ATOM_KW_NONE:
+        case ATOM_KW_TRUE:
+        case ATOM_KW_FALSE:
+            return makeLeaf("Keyword", consume().value);
+        default:
+            if (atEnd()) {
+                syntaxError("Unexpected end of input (EOF) while parsing expression");
+            }
+            syntaxError("Expected expression");
+    }
+    return nullptr;
+}
+
+shared_ptr<ParseTreeNode> Parser::parseKeyValuePair() {
+    PROFILE_RULE(KeyValuePair);
+    auto key = parseTest();
+
+    // Add colon to parse tree
+    Token colon = expect(TK_COLON, "Expected ':' after dictionary key");
+
+    auto value = parseTest();
+
+    auto pairNode = make_shared<ParseTreeNode>("KeyValuePair");
+    pairNode->addChild(key);
+    addSyntaxLeaf(pairNode, "Delimiter", colon.value);
+    pairNode->addChild(value);
+    return pairNode;
+}
+
+Parser::Parser(const vector<Token>& t) : tokens(t), currentPos(0) {
+    classifyTokens();
+}
+
+Parser::Parser(function<bool(vector<Token>&)> source) : currentPos(0), tokenSource(move(source)) {}
+
+void Parser::reset(const vector<Token>& newTokens) {
+    tokenSource = nullptr;
+    tokens.assign(newTokens.begin(), newTokens.end());
+    kinds.clear();
+    classifyTokens();
+    currentPos = 0;
+    parseTree = nullptr;
+    spans.clear();
+    previousSpans.clear();
+    treeIndex.reset();
+}
+
+void Parser::setDiagnostics(ostream& stream) {
+    diagnostics = &stream;
+}
+
+void Parser::setLeanTree(bool lean) {
+    leanTree = lean;
+}
+
+void Parser::setInternLeaves(bool intern) {
+    internLeaves = intern;
+}
+
+#ifdef PARSER_PROFILE
+void Parser::enableProfile() {
+    profile = make_unique<ParseProfile>();
+}
+
+const ParseProfile* Parser::getProfile() const {
+    return profile.get();
+}
+#endif
+
+void Parser::setIncremental(bool enabled) {
+    incremental = enabled;
+}
+
+const vector<Token>& Parser::getTokens() const {
+    return tokens;
+}
+
+void Parser::setBuildIndex(bool enabled) {
+    buildIndex = enabled;
+}
+
+const TreeIndex* Parser::getIndex() const {
+    return treeIndex.get();
+}
+
+shared_ptr<ParseTreeNode> Parser::parse() {
+    for (auto& table : leafTables) table.clear();
+    spans.clear();
+    spanBase = 0;
+    parentSpan = -1;
+    currentPos = 0;
+    try {
+        parseTree = parseProgram();
+    } catch (const runtime_error& e) {
+        *diagnostics << "Parsing failed: " << e.what() << endl;
+        parseTree = nullptr;
+    }
+    indexTree();
+    return parseTree;
+}
+
+shared_ptr<ParseTreeNode> Parser::reparse(vector<Token> newTokens, const TokenEdit& change) {
+    if (!incremental || !parseTree || tokenSource) {
+        tokens = move(newTokens);
+        kinds.clear();
+        classifyTokens();
+        return parse();
+    }
+    int lineShift = change.oldEnd < tokens.size() && change.newEnd < newTokens.size()
+                        ? newTokens[change.newEnd].line - tokens[change.oldEnd].line : 0;
+    kinds.erase(kinds.begin() + change.start, kinds.begin() + change.oldEnd);
+    vector<TokenKind> edited;
+    for (size_t k = change.start; k < change.newEnd; k++) edited.push_back(tokenKindOf(newTokens[k]));
+    kinds.insert(kinds.begin() + change.start, edited.begin(), edited.end());
+    tokens = move(newTokens);
+    previousSpans = move(spans);
+    spans.clear();
+    edit = change;
+    reusing = true;
+
+    // The innermost statement holding the whole edit: from the last one starting at or
+    // before it, out through the enclosing statements
+    auto after = upper_bound(previousSpans.begin(), previousSpans.end(), edit.start,
+                             [](size_t pos, const StatementSpan& span) { return pos < span.start; });
+    int target = (int)(after - previousSpans.begin()) - 1;
+    while (target >= 0 && (edit.start >= previousSpans[target].end || edit.oldEnd > previousSpans[target].end)) {
+        target = previousSpans[target].parent;
+    }
+    bool done = false;
+    while (target >= 0 && !done) {
+        done = reparseStatement(target);
+        if (!done) target = previousSpans[target].parent;
     }
 
-public:
-    Parser(const vector<Token>& t) : tokens(t), currentPos(0) {}
-
-    shared_ptr<ParseTreeNode> parse() {
+    if (!done) {
+        spans.clear();
+        spanBase = 0;
+        parentSpan = -1;
+        currentPos = 0;
         try {
             parseTree = parseProgram();
-            return parseTree;
         } catch (const runtime_error& e) {
-            cerr << "Parsing failed: " << e.what() << endl;
-            return nullptr;
+            *diagnostics << "Parsing failed: " << e.what() << endl;
+            parseTree = nullptr;
+            spans.clear();
         }
     }
+    reusing = false;
+    previousSpans.clear();
+    shiftReusedLines(lineShift);
+    indexTree();
+    return parseTree;
+}
+
+void Parser::printParseTree() const {
+    if (parseTree) {
+        TreePrinter(cout).walk(parseTree);
+    } else {
+        cout << "No parse tree available." << endl;
+    }
+}
+
+bool Parser::saveTreeToDot(const string& filename) const {
+    return writeTree(filename, false);
+}
+
+bool Parser::printAndSaveTree(const string& filename) const {
+    return writeTree(filename, true);
+}
+
+void Parser::indexTree() {
+    treeIndex.reset();
+    if (buildIndex && parseTree) treeIndex = make_unique<TreeIndex>(parseTree);
+}
+
+bool Parser::writeTree(const string& filename, bool print) const {
+    if (!parseTree) {
+        if (print) printParseTree();
+        cerr << "No parse tree available to save." << endl;
+        return false;
+    }
 
-    void printParseTree() const {
-        if (parseTree) {
-            parseTree->print();
-        } else {
-            cout << "No parse tree available." << endl;
-        }
+    ofstream dotFile(filename);
+    if (!dotFile) {
+        if (print) printParseTree();
+        cerr << "Failed to open file: " << filename << endl;
+        return false;
     }
-    
-    // Save parse tree to DOT file for visualization
-    bool saveTreeToDot(const string& filename) const {
-        if (!parseTree) {
-            cerr << "No parse tree available to save." << endl;
-            return false;
-        }
-        
-        ofstream dotFile(filename);
-        if (!dotFile) {
-            cerr << "Failed to open file: " << filename << endl;
-            return false;
-        }
-        
-        // Write DOT file header
-        dotFile << "digraph ParseTree {" << endl;
-        dotFile << "  node [shape=box, fontname=\"Arial\", fontsize=10];" << endl;
-        
-        // Generate DOT representation of the tree
-        int nodeId = 0;
-        parseTree->toDot(dotFile, nodeId);
-        
-        // Write DOT file footer
-        dotFile << "}" << endl;
-        
-        dotFile.close();
-        cout << "Parse tree saved to " << filename << endl;
-        return true;
-    }
-};
-
-int main() {
-    Lexer lexer;
-    lexer.parser("example.py");
-    try
-    {
-        lexer.tokenizeLine(lexer.getcodelines());
-    }
-    catch(const std::exception& e)
-    {
-        return 0;
-    }
-    
-
-    lexer.printTables();
-    vector<Token> tokens = lexer.getTokens();
-
-    Parser parser(tokens);
-    auto parseTree = parser.parse();
-    
-    if (parseTree) {
-        cout << "Parsing successful! Parse tree:" << endl;
-        parser.printParseTree();
-        
-        // Save the parse tree to a DOT file
-        parser.saveTreeToDot("tree.dot");
-
-        // Generate PNG image from DOT file using Graphviz
-        int result = system("clear");
-        if (result == 0) {
-            cout << "Parse tree image saved as tree.png" << endl;
-        } else {
-            cerr << "Failed to generate tree.png. Make sure Graphviz is installed and 'dot' is in your PATH." << endl;
-        }
+
+    // Write DOT file header
+    dotFile << "digraph ParseTree {" << endl;
+    dotFile << "  node [shape=box, fontname=\"Arial\", fontsize=10];" << endl;
+
+    // Generate DOT representation of the tree
+    DotWriter dot(dotFile);
+    if (print) {
+        TreePrinter printer(cout);
+        walkFused(parseTree, printer, dot);
+    } else {
+        dot.walk(parseTree);
     }
 
-    return 0;
-}
\ No newline at end of file
+    // Write DOT file footer
+    dotFile << "}" << endl;
+
+    dotFile.close();
+    cout << "Parse tree saved to " << filename << endl;
+    return true;
+}
@@ -0,0 +1,328 @@
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <functional>
+#include <unordered_map>
+#include "definitions.h"
+#include "lexer2.h"
+#include "parse_tables.h"
+#include "node_kinds.h"
+#include "parse_profile.h"
+using namespace std;
+
+// Forward declaration of ParseTreeNode
+class ParseTreeNode;
+
+// Parse Tree Node class
+class ParseTreeNode {
+public:
+    string type;
+    NodeKind kind; // type as an enum, for switching on in passes
+    string value;
+    vector<shared_ptr<ParseTreeNode>> children;
+    string inferredType; // set by TypeInference on expressions; empty when no value reaches the node
+    int line = 0;        // source line of a statement or elif clause; 0 on other nodes
+    shared_ptr<const LiteralValue> literal; // decoded value of a Literal leaf, shared with its token
+
+    ParseTreeNode(const string& t, const string& v = "") : type(t), kind(nodeKindOf(t)), value(v) {}
+
+    void addChild(shared_ptr<ParseTreeNode> child) {
+        children.push_back(child);
+    }
+};
+
+#include "ast_visitor.h"
+#include "ast_query.h"
+
+// Indented listing of the tree, one node per line
+class TreePrinter : public TreeVisitor<TreePrinter> {
+    private:
+        ostream& out;
+
+    public:
+        explicit TreePrinter(ostream& stream) : out(stream) {}
+
+        bool enterNode(const shared_ptr<ParseTreeNode>& node, size_t depth) {
+            out << string(depth * 2, ' ') << node->type;
+            if (!node->value.empty()) {
+                out << ": " << node->value;
+            }
+            out << endl;
+            return true;
+        }
+};
+
+// DOT nodes and edges of the tree, numbering nodes in preorder
+class DotWriter : public TreeVisitor<DotWriter> {
+    private:
+        ostream& out;
+        int nextId = 0;
+        vector<int> ids; // ids of the nodes on the current path from the root
+
+    public:
+        explicit DotWriter(ostream& stream) : out(stream) {}
+
+        bool enterNode(const shared_ptr<ParseTreeNode>& node, size_t) {
+            int myId = nextId++;
+            ids.push_back(myId);
+
+            // Node label
+            string label = node->type;
+            if (!node->value.empty()) {
+                label += ": " + node->value;
+            }
+
+            // Escape quotes in the label
+            size_t pos = 0;
+            while ((pos = label.find("\"", pos)) != string::npos) {
+                label.replace(pos, 1, "\\\"");
+                pos += 2;
+            }
+
+            out << "  node" << myId << " [label=\"" << label << "\"];" << endl;
+            return true;
+        }
+
+        // Connect to the parent once the subtree is written
+        void leaveNode(const shared_ptr<ParseTreeNode>&, size_t) {
+            int myId = ids.back();
+            ids.pop_back();
+            if (!ids.empty()) out << "  node" << ids.back() << " -> node" << myId << ";" << endl;
+        }
+};
+
+// An edit to a token stream: tokens [start, oldEnd) of the old stream became tokens
+// [start, newEnd) of the new one, and every token past them is unchanged but for its line
+struct TokenEdit {
+    size_t start, oldEnd, newEnd;
+};
+
+// The edit between two lexings of a file: the tokens past their common prefix and suffix. The
+// suffix only counts tokens whose lines all moved by the same amount
+inline TokenEdit editedTokens(const vector<Token>& before, const vector<Token>& after) {
+    auto same = [](const Token& a, const Token& b) { return a.type == b.type && a.value == b.value; };
+    size_t start = 0;
+    while (start < before.size() && start < after.size() && same(before[start], after[start]) &&
+           before[start].line == after[start].line) {
+        start++;
+    }
+    size_t oldEnd = before.size(), newEnd = after.size();
+    int lineShift = before.empty() || after.empty() ? 0 : after.back().line - before.back().line;
+    while (oldEnd > start && newEnd > start && same(before[oldEnd - 1], after[newEnd - 1]) &&
+           after[newEnd - 1].line - before[oldEnd - 1].line == lineShift) {
+        oldEnd--;
+        newEnd--;
+    }
+    return {start, oldEnd, newEnd};
+}
+
+// Where a statement of the last parse came from, kept by an incremental parser for reparse()
+struct StatementSpan {
+    size_t start, end;              // its tokens, [start, end)
+    shared_ptr<ParseTreeNode> node;
+    int parent;                     // index of the enclosing statement's span; -1 at the top level
+    ParseTreeNode* container;       // the Program or Suite node listing it
+    bool movedLines;                // reused from past the edit; its lines still need shifting
+};
+
+// Parser class for syntax analysis
+class Parser {
+private:
+    vector<Token> tokens;
+    vector<TokenKind> kinds; // grammar sub-kind of each token, the column index into parseTable
+    size_t currentPos;
+    shared_ptr<ParseTreeNode> parseTree;
+    bool leanTree = false; // leave out Delimiter and Keyword leaves that the node type implies
+    bool internLeaves = false; // share one node per distinct leaf within a parse
+    unordered_map<string, shared_ptr<ParseTreeNode>> leafTables[4]; // Identifier, Literal, Keyword, Delimiter
+
+    // Optional streaming input: appends the next batch of tokens, returns false when exhausted
+    function<bool(vector<Token>&)> tokenSource;
+
+#ifdef PARSER_PROFILE
+    unique_ptr<ParseProfile> profile; // set by enableProfile()
+#endif
+
+    // Incremental parsing: statement spans of the tree in preorder, and while reparse() runs,
+    // those of the previous tree with the edit between them
+    bool incremental = false;
+    vector<StatementSpan> spans;
+    vector<StatementSpan> previousSpans;
+    TokenEdit edit = {0, 0, 0};
+    bool reusing = false;
+    size_t spanBase = 0;                 // index in the final list of spans[0], while a statement is reparsed
+    int parentSpan = -1;                 // span of the statement being parsed
+    ParseTreeNode* container = nullptr;  // the Program or Suite being filled
+    bool quiet = false;                  // syntax errors are expected and not reported
+    ostream* diagnostics = &cerr;        // where syntax errors are reported
+    Token eofToken = {ERROR, "EOF", -1}; // stands in for the token past the end
+
+    bool buildIndex = false;             // index the tree for queries after each parse
+    unique_ptr<TreeIndex> treeIndex;
+
+    // True when a token exists at pos, pulling more batches from the source if needed
+    bool hasToken(size_t pos);
+
+    void classifyTokens();
+    TokenKind kindAt(size_t pos);
+    bool at(TokenKind kind);
+
+    // Every choice the grammar makes is one lookup: the alternative of a multi-way decision, or
+    // nonzero when the current token starts an optional or repeated group. PARSE_CONFLICT marks
+    // the few decisions that need more than one token, which the caller settles by looking ahead
+    uint8_t decide(ParseDecision decision);
+
+    bool atEnd();
+
+    // Leaves never change after parsing, so with interning on every occurrence of the same
+    // identifier, literal or keyword is one shared node and the tree becomes a DAG; two interned
+    // leaves are equal exactly when they are the same pointer
+    shared_ptr<ParseTreeNode> makeLeaf(const string& type, const string& value);
+
+    // Adds a punctuation or structural keyword leaf. The lean tree skips it since the node type
+    // already carries that meaning; the concrete tree keeps it for printing and the DOT export
+    void addSyntaxLeaf(const shared_ptr<ParseTreeNode>& node, const string& type, const string& value);
+
+    // Scans the rest of the simple statement for an assignment operator outside any brackets,
+    // so targets like 'a[i]', 'obj.x' and 'a, b' are recognised before parsing them
+    bool assignmentAhead();
+
+    // Advances pos to the token that settles assignmentAhead
+    bool scanForAssignment(size_t& pos);
+
+    // Error handling
+    void syntaxError(const string& message);
+
+    // Helper methods
+    Token& currentToken();
+
+    bool match(TokenType type);
+    bool match(TokenType type, const string& value);
+    Token consume();
+    Token expect(TokenKind kind, const string& message);
+
+    // Grammar rules implementation
+    shared_ptr<ParseTreeNode> parseProgram();
+
+    void recoverFromError();
+    shared_ptr<ParseTreeNode> parseStatement();
+
+    // Records the statement's span, or takes the previous tree's statement starting at the same
+    // token when the edit left it alone
+    shared_ptr<ParseTreeNode> parseTrackedStatement();
+
+    // One past the last span nested in spans[index]; a statement's descendants follow it in
+    // preorder and start before it ends
+    static size_t subtreeEnd(const vector<StatementSpan>& list, size_t index);
+
+    size_t toNewPosition(size_t oldPos) const;
+    shared_ptr<ParseTreeNode> reuseStatement();
+
+    // Parses the statement of previousSpans[index] again in place; false when the edit reaches
+    // past it, which leaves the tree unchanged
+    bool reparseStatement(size_t index);
+
+    // Moves the lines of statements and elif clauses reused from past the edit
+    void shiftReusedLines(int lineShift);
+
+    shared_ptr<ParseTreeNode> parseStatementBody();
+    shared_ptr<ParseTreeNode> parseBlockOrSimpleSuite();
+    shared_ptr<ParseTreeNode> parseIfStatement();
+    shared_ptr<ParseTreeNode> parseWhileStatement();
+    shared_ptr<ParseTreeNode> parseForStatement();
+    shared_ptr<ParseTreeNode> parseFunctionDef();
+    shared_ptr<ParseTreeNode> parseClassDef();
+    shared_ptr<ParseTreeNode> parseReturnStatement();
+    shared_ptr<ParseTreeNode> parsePassStatement();
+    shared_ptr<ParseTreeNode> parseBreakStatement();
+    shared_ptr<ParseTreeNode> parseContinueStatement();
+    shared_ptr<ParseTreeNode> parseImportStatement();
+    shared_ptr<ParseTreeNode> parseDottedName();
+    shared_ptr<ParseTreeNode> parseAssignment();
+    shared_ptr<ParseTreeNode> parseFunctionCallStatement();
+    shared_ptr<ParseTreeNode> parseExpressionStatement();
+    shared_ptr<ParseTreeNode> parseSuite();
+    shared_ptr<ParseTreeNode> parseTernaryOp();
+    shared_ptr<ParseTreeNode> parseTest();
+    shared_ptr<ParseTreeNode> parseOrTest();
+    shared_ptr<ParseTreeNode> parseAndTest();
+    shared_ptr<ParseTreeNode> parseNotTest();
+    shared_ptr<ParseTreeNode> parseComparison();
+    shared_ptr<ParseTreeNode> parseArithExpr();
+    shared_ptr<ParseTreeNode> parseTerm();
+    shared_ptr<ParseTreeNode> parseFactor();
+
+    // Modified parseAtomExpr method to include parentheses and dots
+    shared_ptr<ParseTreeNode> parseAtomExpr();
+
+    shared_ptr<ParseTreeNode> parseAtom();
+    shared_ptr<ParseTreeNode> parseKeyValuePair();
+
+public:
+    Parser(const vector<Token>& t);
+
+    // Streaming constructor: tokens are pulled from the source as the parser needs them
+    Parser(function<bool(vector<Token>&)> source);
+
+    // Takes the next file's tokens, keeping the settings and the capacity of the token buffers,
+    // so that one parser can go through many files; parse() then parses them
+    void reset(const vector<Token>& newTokens);
+
+    // Reports syntax errors to 'stream' instead of cerr
+    void setDiagnostics(ostream& stream);
+
+    // Builds the abstract tree without syntax-only leaves; call before parse()
+    void setLeanTree(bool lean);
+
+    // Shares identical Identifier, Literal, Keyword and Delimiter leaves; call before parse()
+    void setInternLeaves(bool intern);
+
+#ifdef PARSER_PROFILE
+    // Records per-rule statistics from the next parse() on
+    void enableProfile();
+
+    const ParseProfile* getProfile() const;
+#endif
+
+    // Records statement spans so that reparse() can reuse the statements an edit leaves alone;
+    // call before parse()
+    void setIncremental(bool enabled);
+
+    const vector<Token>& getTokens() const;
+
+    // Builds a TreeIndex of each tree parse() or reparse() returns; call before parse()
+    void setBuildIndex(bool enabled);
+
+    // The index of the last tree, or nullptr when indexing is off or parsing failed
+    const TreeIndex* getIndex() const;
+
+    shared_ptr<ParseTreeNode> parse();
+
+    // Parses 'newTokens', the last parse's tokens after 'change', by updating the last tree in
+    // place. Statements the edit did not touch are reused with their subtrees; only the innermost
+    // statement enclosing the edit is parsed again, or the statements around it when the edit
+    // moved where it ends, and at worst the top level, still reusing the untouched statements.
+    // Needs setIncremental(true) before the first parse(); otherwise it parses from scratch.
+    shared_ptr<ParseTreeNode> reparse(vector<Token> newTokens, const TokenEdit& change);
+
+    void printParseTree() const;
+
+    // Save parse tree to DOT file for visualization
+    bool saveTreeToDot(const string& filename) const;
+
+    // Print the parse tree and save it to a DOT file in a single traversal
+    bool printAndSaveTree(const string& filename) const;
+
+private:
+    void indexTree();
+    bool writeTree(const string& filename, bool print) const;
+};
+
+#endif
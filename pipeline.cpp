@@ -0,0 +1,112 @@
+#include <thread>
+#include <exception>
+#include "spsc_queue.h"
+
+using namespace std;
+
+// Thrown into the parser when the lexer thread failed, so parsing stops without a bogus syntax error
+struct PipelineAborted {};
+
+// Runs file reading and tokenisation on their own threads, feeding the parser through
+// bounded SPSC queues:  reader --(line batches)--> lexer --(token batches)--> parser
+class PipelinedFrontEnd {
+    private:
+        typedef vector<tuple<string, int, int>> LineBatch;
+        typedef vector<Token> TokenBatch;
+
+        Lexer& lexer;
+        size_t linesPerBatch;
+        SpscQueue<LineBatch> lineQueue;
+        SpscQueue<TokenBatch> tokenQueue;
+        thread readerThread;
+        thread lexerThread;
+        exception_ptr lexerError;
+        atomic<bool> stageFailed{false};
+
+        void readFile(const string& filename) {
+            ifstream file(filename);
+            if (!file.is_open()) {
+                cerr << "Error: Could not open file " << filename << endl;
+                stageFailed.store(true, memory_order_release);
+                lineQueue.close();
+                return;
+            }
+
+            LineBatch batch;
+            batch.reserve(linesPerBatch);
+            string line;
+            int lineNumber = 1;
+            while (getline(file, line)) {
+                batch.push_back(lexer.makeCodeLine(line, lineNumber++));
+                if (batch.size() == linesPerBatch) {
+                    lineQueue.push(move(batch));
+                    batch = LineBatch();
+                    batch.reserve(linesPerBatch);
+                }
+            }
+            if (!batch.empty()) lineQueue.push(move(batch));
+            lineQueue.close();
+        }
+
+        void tokenizeBatches() {
+            LineBatch lines;
+            size_t emitted = 0;
+            try {
+                while (lineQueue.pop(lines)) {
+                    lexer.tokenizeLine(lines);
+                    const vector<Token>& all = lexer.getTokens();
+                    if (all.size() > emitted) {
+                        tokenQueue.push(TokenBatch(all.begin() + emitted, all.end()));
+                        emitted = all.size();
+                    }
+                }
+            } catch (...) {
+                lexerError = current_exception();
+                stageFailed.store(true, memory_order_release);
+                // Keep draining so the reader never blocks on a full queue
+                while (lineQueue.pop(lines)) {}
+            }
+            tokenQueue.close();
+        }
+
+    public:
+        PipelinedFrontEnd(Lexer& l, size_t batchLines = 256, size_t queueDepth = 16)
+            : lexer(l), linesPerBatch(batchLines), lineQueue(queueDepth), tokenQueue(queueDepth) {}
+
+        ~PipelinedFrontEnd() {
+            if (readerThread.joinable() || lexerThread.joinable()) {
+                try { finish(); } catch (...) {}
+            }
+        }
+
+        void start(const string& filename) {
+            readerThread = thread(&PipelinedFrontEnd::readFile, this, filename);
+            lexerThread = thread(&PipelinedFrontEnd::tokenizeBatches, this);
+        }
+
+        // Token source for the streaming Parser constructor
+        function<bool(vector<Token>&)> tokenSource() {
+            return [this](vector<Token>& tokens) {
+                TokenBatch batch;
+                if (!tokenQueue.pop(batch)) {
+                    if (stageFailed.load(memory_order_acquire)) throw PipelineAborted();
+                    return false;
+                }
+                tokens.insert(tokens.end(), make_move_iterator(batch.begin()), make_move_iterator(batch.end()));
+                return true;
+            };
+        }
+
+        // Drains whatever the parser left unread, joins both threads and rethrows a lexer error
+        void finish() {
+            TokenBatch rest;
+            while (tokenQueue.pop(rest)) {}
+            if (readerThread.joinable()) readerThread.join();
+            if (lexerThread.joinable()) lexerThread.join();
+            if (lexerError) {
+                exception_ptr error = lexerError;
+                lexerError = nullptr;
+                rethrow_exception(error);
+            }
+        }
+};
@@ -0,0 +1,136 @@
+// The library: the lexer and parser of parser.h behind the C interface of pycompiler.h. It
+// links the same lexer and parser objects as the command-line compiler, without main(), the
+// later passes or the counting operator new.
+#include "parser.h"
+#include "pycompiler.h"
+
+static_assert(PYC_TOKEN_NEWLINE == (int)NEWLINE && PYC_TOKEN_ERROR == (int)ERROR, "pyc_token_kind must follow TokenType");
+
+struct pyc_session {
+    Lexer lexer;
+    Parser parser{vector<Token>()};
+    ostringstream diagnostics; // the lexer's and parser's messages for the current source
+    string error;
+
+    pyc_session() {
+        lexer.setDiagnostics(diagnostics);
+        parser.setDiagnostics(diagnostics);
+    }
+
+    void clearErrors() {
+        diagnostics.str("");
+        diagnostics.clear();
+        error.clear();
+    }
+
+    pyc_status fail(pyc_status status, const string& fallback) {
+        error = diagnostics.str();
+        while (!error.empty() && error.back() == '\n') error.pop_back();
+        if (error.empty()) error = fallback;
+        return status;
+    }
+
+    pyc_status lex(const char* source, size_t length) {
+        clearErrors();
+        lexer.reset();
+        lexer.readSource(source, length);
+        try {
+            lexer.tokenizeLine(lexer.getcodelines());
+        } catch (const runtime_error& e) {
+            return fail(PYC_LEX_ERROR, e.what());
+        }
+        return PYC_OK;
+    }
+};
+
+struct pyc_tree {
+    shared_ptr<ParseTreeNode> root;
+};
+
+static const ParseTreeNode* treeNode(const pyc_node* node) {
+    return reinterpret_cast<const ParseTreeNode*>(node);
+}
+
+extern "C" {
+
+pyc_session* pyc_session_new(void) {
+    try {
+        return new pyc_session();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void pyc_session_free(pyc_session* session) {
+    delete session;
+}
+
+void pyc_session_set_lean(pyc_session* session, int lean) {
+    session->parser.setLeanTree(lean != 0);
+}
+
+pyc_status pyc_lex(pyc_session* session, const char* source, size_t length) {
+    try {
+        return session->lex(source, length);
+    } catch (const exception& e) {
+        return session->fail(PYC_FAILURE, e.what());
+    }
+}
+
+size_t pyc_token_count(const pyc_session* session) {
+    return session->lexer.getTokens().size();
+}
+
+pyc_token pyc_token_at(const pyc_session* session, size_t index) {
+    const Token& token = session->lexer.getTokens()[index];
+    return {(pyc_token_kind)token.type, token.line, token.value.c_str(), token.value.size()};
+}
+
+pyc_status pyc_parse(pyc_session* session, const char* source, size_t length, pyc_tree** tree) {
+    *tree = nullptr;
+    try {
+        pyc_status status = session->lex(source, length);
+        if (status != PYC_OK) return status;
+        session->parser.reset(session->lexer.getTokens());
+        shared_ptr<ParseTreeNode> root = session->parser.parse();
+        if (!root) return session->fail(PYC_SYNTAX_ERROR, "Syntax Error");
+        *tree = new pyc_tree{move(root)};
+        return PYC_OK;
+    } catch (const exception& e) {
+        return session->fail(PYC_FAILURE, e.what());
+    }
+}
+
+void pyc_tree_free(pyc_tree* tree) {
+    delete tree;
+}
+
+const char* pyc_error(const pyc_session* session) {
+    return session->error.c_str();
+}
+
+const pyc_node* pyc_tree_root(const pyc_tree* tree) {
+    return reinterpret_cast<const pyc_node*>(tree->root.get());
+}
+
+const char* pyc_node_type(const pyc_node* node) {
+    return treeNode(node)->type.c_str();
+}
+
+const char* pyc_node_value(const pyc_node* node) {
+    return treeNode(node)->value.c_str();
+}
+
+int pyc_node_line(const pyc_node* node) {
+    return treeNode(node)->line;
+}
+
+size_t pyc_node_child_count(const pyc_node* node) {
+    return treeNode(node)->children.size();
+}
+
+const pyc_node* pyc_node_child(const pyc_node* node, size_t index) {
+    return reinterpret_cast<const pyc_node*>(treeNode(node)->children[index].get());
+}
+
+}
@@ -0,0 +1,82 @@
+#ifndef PYCOMPILER_H
+#define PYCOMPILER_H
+
+// C interface of the lexer and parser, built as libpycompiler by CMakeLists.txt.
+//
+// A session owns one lexer and one parser and is reset between files rather than rebuilt, so
+// going through many files reuses its buffers. Sessions are independent of each other: a session
+// may only be used by one thread at a time, but different sessions can run on different threads.
+// No function lets a C++ exception escape or writes to stdout or stderr; errors are returned as a
+// status, with their message in pyc_error().
+
+#include <stddef.h>
+
+#if defined(__GNUC__)
+#define PYC_API __attribute__((visibility("default")))
+#else
+#define PYC_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct pyc_session pyc_session;
+typedef struct pyc_tree pyc_tree;
+typedef struct pyc_node pyc_node;
+
+typedef enum {
+    PYC_OK = 0,
+    PYC_LEX_ERROR = 1,     // the source could not be tokenized
+    PYC_SYNTAX_ERROR = 2,  // the tokens do not form a program
+    PYC_FAILURE = 3        // out of memory or another internal error
+} pyc_status;
+
+// Same order as TokenType in definitions.h
+typedef enum {
+    PYC_TOKEN_IDENTIFIER, PYC_TOKEN_KEYWORD, PYC_TOKEN_OPERATOR, PYC_TOKEN_LITERAL, PYC_TOKEN_DELIMITER,
+    PYC_TOKEN_ERROR, PYC_TOKEN_INDENT, PYC_TOKEN_DEDENT, PYC_TOKEN_NEWLINE
+} pyc_token_kind;
+
+typedef struct {
+    pyc_token_kind kind;
+    int line;
+    const char* text;  // NUL-terminated; valid until the session lexes or parses again
+    size_t length;
+} pyc_token;
+
+// NULL when out of memory
+PYC_API pyc_session* pyc_session_new(void);
+PYC_API void pyc_session_free(pyc_session* session);
+
+// Builds lean trees, without the keyword and delimiter leaves the node type implies, as
+// `parser --lean` prints them. Off by default
+PYC_API void pyc_session_set_lean(pyc_session* session, int lean);
+
+// Tokenizes 'length' bytes of Python source. The tokens stay in the session until the next
+// pyc_lex() or pyc_parse()
+PYC_API pyc_status pyc_lex(pyc_session* session, const char* source, size_t length);
+PYC_API size_t pyc_token_count(const pyc_session* session);
+PYC_API pyc_token pyc_token_at(const pyc_session* session, size_t index);
+
+// Tokenizes and parses the source; on PYC_OK '*tree' is a tree the caller frees with
+// pyc_tree_free(), which may outlive the session. The session's tokens are those of this source
+PYC_API pyc_status pyc_parse(pyc_session* session, const char* source, size_t length, pyc_tree** tree);
+PYC_API void pyc_tree_free(pyc_tree* tree);
+
+// The message of the last failed call, "" after a successful one
+PYC_API const char* pyc_error(const pyc_session* session);
+
+// Nodes belong to their tree
+PYC_API const pyc_node* pyc_tree_root(const pyc_tree* tree);
+PYC_API const char* pyc_node_type(const pyc_node* node);   // e.g. "Assignment", "Identifier"
+PYC_API const char* pyc_node_value(const pyc_node* node);  // "" when the node has none
+PYC_API int pyc_node_line(const pyc_node* node);           // statements only; 0 on other nodes
+PYC_API size_t pyc_node_child_count(const pyc_node* node);
+PYC_API const pyc_node* pyc_node_child(const pyc_node* node, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
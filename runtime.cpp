@@ -0,0 +1,1220 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <charconv>
+#include <unordered_map>
+#include "literals.h"
+using namespace std;
+
+// Value model shared by the execution backends
+
+enum ValueKind : uint8_t {
+    V_UNDEF, V_NONE, V_BOOL, V_INT, V_FLOAT, V_BUILTIN,
+    // Kinds from here on own a heap Object
+    V_STR, V_LIST, V_TUPLE, V_SET, V_DICT, V_RANGE, V_ITER, V_FUNC, V_CLASS, V_INSTANCE, V_BOUND
+};
+
+// Heap objects are reference counted by Value; an interpreter runs on one thread so the count is plain
+struct Object {
+    int refs = 0;
+    virtual ~Object() {}
+};
+
+struct Value {
+    ValueKind kind;
+    union {
+        bool b;
+        long long i;
+        double f;
+        int builtin;
+        Object* obj;
+    };
+
+    Value() : kind(V_UNDEF), i(0) {}
+    Value(const Value& other) : kind(other.kind), i(other.i) { retain(); }
+    Value(Value&& other) noexcept : kind(other.kind), i(other.i) { other.kind = V_UNDEF; }
+    ~Value() { release(); }
+
+    Value& operator=(const Value& other) {
+        if (this != &other) {
+            if (other.kind >= V_STR) other.obj->refs++;
+            release();
+            kind = other.kind;
+            i = other.i;
+        }
+        return *this;
+    }
+
+    Value& operator=(Value&& other) noexcept {
+        if (this != &other) {
+            release();
+            kind = other.kind;
+            i = other.i;
+            other.kind = V_UNDEF;
+        }
+        return *this;
+    }
+
+    static Value none() { Value v; v.kind = V_NONE; return v; }
+    static Value boolean(bool value) { Value v; v.kind = V_BOOL; v.i = 0; v.b = value; return v; }
+    static Value integer(long long value) { Value v; v.kind = V_INT; v.i = value; return v; }
+    static Value number(double value) { Value v; v.kind = V_FLOAT; v.f = value; return v; }
+    static Value builtinFunction(int id) { Value v; v.kind = V_BUILTIN; v.i = 0; v.builtin = id; return v; }
+    static Value object(ValueKind k, Object* o) { Value v; v.kind = k; v.obj = o; o->refs++; return v; }
+
+    bool isObject() const { return kind >= V_STR; }
+    bool isNumber() const { return kind == V_INT || kind == V_FLOAT || kind == V_BOOL; }
+    void reset() { release(); }
+
+    private:
+        void retain() { if (kind >= V_STR) obj->refs++; }
+        void release() {
+            if (kind >= V_STR && --obj->refs == 0) delete obj;
+            kind = V_UNDEF;
+        }
+};
+
+size_t hashValue(const Value& v);
+bool valuesEqual(const Value& a, const Value& b);
+
+struct ValueHash {
+    size_t operator()(const Value& v) const { return hashValue(v); }
+};
+
+struct ValueKeyEqual {
+    bool operator()(const Value& a, const Value& b) const { return valuesEqual(a, b); }
+};
+
+struct StrObject : Object {
+    string s;
+    StrObject(string text) : s(move(text)) {}
+};
+
+// Backs list, tuple and the argument packs of builtins
+struct ListObject : Object {
+    vector<Value> items;
+};
+
+// Insertion-ordered like a Python dict; sets reuse it with None values
+struct DictObject : Object {
+    vector<pair<Value, Value>> entries;
+    unordered_map<Value, size_t, ValueHash, ValueKeyEqual> index;
+
+    Value* find(const Value& key) {
+        auto it = index.find(key);
+        return it == index.end() ? nullptr : &entries[it->second].second;
+    }
+
+    void set(const Value& key, const Value& value) {
+        auto it = index.find(key);
+        if (it != index.end()) {
+            entries[it->second].second = value;
+            return;
+        }
+        index.emplace(key, entries.size());
+        entries.emplace_back(key, value);
+    }
+};
+
+struct RangeObject : Object {
+    long long start, stop, step;
+    RangeObject(long long a, long long b, long long s) : start(a), stop(b), step(s) {}
+};
+
+struct IterObject : Object {
+    Value sequence;
+    size_t position = 0;
+    long long current = 0; // next value when iterating a range
+};
+
+// A user function; index selects its body in whichever backend created it
+struct FunctionObject : Object {
+    string name;
+    int arity;
+    int index;
+    FunctionObject(string n, int a, int idx) : name(move(n)), arity(a), index(idx) {}
+};
+
+struct ClassObject : Object {
+    string name;
+    Value parent;
+    unordered_map<string, Value> attributes;
+};
+
+struct InstanceObject : Object {
+    Value cls;
+    unordered_map<string, Value> attributes;
+};
+
+// A method looked up on an instance, remembered together with its 'self'
+struct BoundObject : Object {
+    Value self;
+    Value function;
+};
+
+[[noreturn]] void runtimeError(const string& message) {
+    throw runtime_error(message);
+}
+
+Value makeString(string text) {
+    return Value::object(V_STR, new StrObject(move(text)));
+}
+
+Value makeList(vector<Value> items, ValueKind kind = V_LIST) {
+    auto list = new ListObject();
+    list->items = move(items);
+    return Value::object(kind, list);
+}
+
+Value makeDict(ValueKind kind = V_DICT) {
+    return Value::object(kind, new DictObject());
+}
+
+Value makeFunction(const string& name, int arity, int index) {
+    return Value::object(V_FUNC, new FunctionObject(name, arity, index));
+}
+
+inline StrObject* asStr(const Value& v) { return static_cast<StrObject*>(v.obj); }
+inline ListObject* asList(const Value& v) { return static_cast<ListObject*>(v.obj); }
+inline DictObject* asDict(const Value& v) { return static_cast<DictObject*>(v.obj); }
+inline RangeObject* asRange(const Value& v) { return static_cast<RangeObject*>(v.obj); }
+inline IterObject* asIter(const Value& v) { return static_cast<IterObject*>(v.obj); }
+inline FunctionObject* asFunction(const Value& v) { return static_cast<FunctionObject*>(v.obj); }
+inline ClassObject* asClass(const Value& v) { return static_cast<ClassObject*>(v.obj); }
+inline InstanceObject* asInstance(const Value& v) { return static_cast<InstanceObject*>(v.obj); }
+inline BoundObject* asBound(const Value& v) { return static_cast<BoundObject*>(v.obj); }
+
+string typeName(const Value& v) {
+    switch (v.kind) {
+        case V_UNDEF: return "undefined";
+        case V_NONE: return "NoneType";
+        case V_BOOL: return "bool";
+        case V_INT: return "int";
+        case V_FLOAT: return "float";
+        case V_BUILTIN: return "builtin_function_or_method";
+        case V_STR: return "str";
+        case V_LIST: return "list";
+        case V_TUPLE: return "tuple";
+        case V_SET: return "set";
+        case V_DICT: return "dict";
+        case V_RANGE: return "range";
+        case V_ITER: return "iterator";
+        case V_FUNC: return "function";
+        case V_CLASS: return "type";
+        case V_INSTANCE: return asClass(asInstance(v)->cls)->name;
+        case V_BOUND: return "method";
+    }
+    return "object";
+}
+
+// ---- Conversions to text ----
+
+// Same digits as Python's float repr: shortest round-trip form, positional for exponents in [-4, 16)
+string formatFloat(double d) {
+    if (std::isnan(d)) return "nan";
+    if (std::isinf(d)) return d > 0 ? "inf" : "-inf";
+
+    char buffer[64];
+    auto result = to_chars(buffer, buffer + sizeof(buffer), d, chars_format::scientific);
+    string sci(buffer, result.ptr);
+
+    bool negative = sci[0] == '-';
+    if (negative) sci.erase(0, 1);
+    size_t ePos = sci.find('e');
+    int exponent = stoi(sci.substr(ePos + 1));
+    string digits;
+    for (size_t i = 0; i < ePos; i++) {
+        if (sci[i] != '.') digits += sci[i];
+    }
+
+    string text;
+    if (exponent >= -4 && exponent < 16) {
+        if (exponent < 0) {
+            text = "0." + string(-exponent - 1, '0') + digits;
+        } else if ((int)digits.size() <= exponent + 1) {
+            text = digits + string(exponent + 1 - digits.size(), '0') + ".0";
+        } else {
+            text = digits.substr(0, exponent + 1) + "." + digits.substr(exponent + 1);
+        }
+    } else {
+        text = digits.substr(0, 1);
+        if (digits.size() > 1) text += "." + digits.substr(1);
+        char expText[16];
+        snprintf(expText, sizeof(expText), "e%c%02d", exponent < 0 ? '-' : '+', abs(exponent));
+        text += expText;
+    }
+    return negative ? "-" + text : text;
+}
+
+string toRepr(const Value& v);
+
+string quoteString(const string& s) {
+    char quote = (s.find('\'') != string::npos && s.find('"') == string::npos) ? '"' : '\'';
+    string out(1, quote);
+    for (char c : s) {
+        switch (c) {
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            case '\r': out += "\\r"; break;
+            case '\\': out += "\\\\"; break;
+            default:
+                if (c == quote) out += '\\';
+                out += c;
+        }
+    }
+    return out + quote;
+}
+
+string toStr(const Value& v) {
+    switch (v.kind) {
+        case V_NONE: return "None";
+        case V_BOOL: return v.b ? "True" : "False";
+        case V_INT: return to_string(v.i);
+        case V_FLOAT: return formatFloat(v.f);
+        case V_STR: return asStr(v)->s;
+        default: return toRepr(v);
+    }
+}
+
+string toRepr(const Value& v) {
+    switch (v.kind) {
+        case V_STR: return quoteString(asStr(v)->s);
+        case V_LIST:
+        case V_TUPLE: {
+            const auto& items = asList(v)->items;
+            string out = v.kind == V_LIST ? "[" : "(";
+            for (size_t i = 0; i < items.size(); i++) {
+                if (i) out += ", ";
+                out += toRepr(items[i]);
+            }
+            if (v.kind == V_TUPLE && items.size() == 1) out += ",";
+            return out + (v.kind == V_LIST ? "]" : ")");
+        }
+        case V_SET: {
+            const auto& entries = asDict(v)->entries;
+            if (entries.empty()) return "set()";
+            string out = "{";
+            for (size_t i = 0; i < entries.size(); i++) {
+                if (i) out += ", ";
+                out += toRepr(entries[i].first);
+            }
+            return out + "}";
+        }
+        case V_DICT: {
+            const auto& entries = asDict(v)->entries;
+            string out = "{";
+            for (size_t i = 0; i < entries.size(); i++) {
+                if (i) out += ", ";
+                out += toRepr(entries[i].first) + ": " + toRepr(entries[i].second);
+            }
+            return out + "}";
+        }
+        case V_RANGE: {
+            auto r = asRange(v);
+            string out = "range(" + to_string(r->start) + ", " + to_string(r->stop);
+            if (r->step != 1) out += ", " + to_string(r->step);
+            return out + ")";
+        }
+        case V_FUNC: return "<function " + asFunction(v)->name + ">";
+        case V_BUILTIN: return "<built-in function>";
+        case V_CLASS: return "<class '__main__." + asClass(v)->name + "'>";
+        case V_INSTANCE: {
+            char address[32];
+            snprintf(address, sizeof(address), "%p", (void*)v.obj);
+            return "<__main__." + typeName(v) + " object at " + address + ">";
+        }
+        case V_BOUND: return "<bound method>";
+        case V_ITER: return "<iterator>";
+        case V_UNDEF: return "<undefined>";
+        default: return toStr(v);
+    }
+}
+
+// ---- Truth, equality, ordering ----
+
+bool truthy(const Value& v) {
+    switch (v.kind) {
+        case V_NONE: return false;
+        case V_BOOL: return v.b;
+        case V_INT: return v.i != 0;
+        case V_FLOAT: return v.f != 0.0;
+        case V_STR: return !asStr(v)->s.empty();
+        case V_LIST:
+        case V_TUPLE: return !asList(v)->items.empty();
+        case V_SET:
+        case V_DICT: return !asDict(v)->entries.empty();
+        case V_RANGE: {
+            auto r = asRange(v);
+            return r->step > 0 ? r->start < r->stop : r->start > r->stop;
+        }
+        default: return true;
+    }
+}
+
+double numberValue(const Value& v) {
+    if (v.kind == V_FLOAT) return v.f;
+    if (v.kind == V_BOOL) return v.b ? 1.0 : 0.0;
+    return (double)v.i;
+}
+
+long long intValue(const Value& v) {
+    return v.kind == V_BOOL ? (v.b ? 1 : 0) : v.i;
+}
+
+bool valuesEqual(const Value& a, const Value& b) {
+    if (a.isNumber() && b.isNumber()) {
+        if (a.kind == V_FLOAT || b.kind == V_FLOAT) return numberValue(a) == numberValue(b);
+        return intValue(a) == intValue(b);
+    }
+    if (a.kind != b.kind) return false;
+    switch (a.kind) {
+        case V_NONE: return true;
+        case V_STR: return asStr(a)->s == asStr(b)->s;
+        case V_LIST:
+        case V_TUPLE: {
+            const auto& x = asList(a)->items;
+            const auto& y = asList(b)->items;
+            if (x.size() != y.size()) return false;
+            for (size_t i = 0; i < x.size(); i++) {
+                if (!valuesEqual(x[i], y[i])) return false;
+            }
+            return true;
+        }
+        case V_SET:
+        case V_DICT: {
+            auto x = asDict(a);
+            auto y = asDict(b);
+            if (x->entries.size() != y->entries.size()) return false;
+            for (const auto& entry : x->entries) {
+                Value* other = y->find(entry.first);
+                if (!other || (a.kind == V_DICT && !valuesEqual(entry.second, *other))) return false;
+            }
+            return true;
+        }
+        case V_BUILTIN: return a.builtin == b.builtin;
+        default: return a.obj == b.obj;
+    }
+}
+
+size_t hashValue(const Value& v) {
+    switch (v.kind) {
+        case V_NONE: return 0x9e3779b9;
+        case V_BOOL:
+        case V_INT: return hash<long long>()(intValue(v));
+        case V_FLOAT: {
+            // Equal numbers must hash alike: 1.0 and 1 share a bucket
+            double whole;
+            if (modf(v.f, &whole) == 0.0 && fabs(v.f) < 9.2e18) return hash<long long>()((long long)v.f);
+            return hash<double>()(v.f);
+        }
+        case V_STR: return hash<string>()(asStr(v)->s);
+        case V_TUPLE: {
+            size_t h = 0x345678;
+            for (const auto& item : asList(v)->items) h = h * 1000003 ^ hashValue(item);
+            return h;
+        }
+        case V_LIST:
+        case V_DICT:
+        case V_SET: runtimeError("TypeError: unhashable type: '" + typeName(v) + "'");
+        default: return hash<void*>()(v.obj);
+    }
+}
+
+// Three-way comparison for the ordering operators; raises TypeError like Python for mixed kinds
+int compareValues(const Value& a, const Value& b, const char* op) {
+    if (a.isNumber() && b.isNumber()) {
+        if (a.kind == V_FLOAT || b.kind == V_FLOAT) {
+            double x = numberValue(a), y = numberValue(b);
+            return x < y ? -1 : (x > y ? 1 : 0);
+        }
+        long long x = intValue(a), y = intValue(b);
+        return x < y ? -1 : (x > y ? 1 : 0);
+    }
+    if (a.kind == V_STR && b.kind == V_STR) {
+        int c = asStr(a)->s.compare(asStr(b)->s);
+        return c < 0 ? -1 : (c > 0 ? 1 : 0);
+    }
+    if ((a.kind == V_LIST || a.kind == V_TUPLE) && a.kind == b.kind) {
+        const auto& x = asList(a)->items;
+        const auto& y = asList(b)->items;
+        for (size_t i = 0; i < x.size() && i < y.size(); i++) {
+            if (!valuesEqual(x[i], y[i])) return compareValues(x[i], y[i], op);
+        }
+        return x.size() < y.size() ? -1 : (x.size() > y.size() ? 1 : 0);
+    }
+    runtimeError(string("TypeError: '") + op + "' not supported between instances of '" +
+                 typeName(a) + "' and '" + typeName(b) + "'");
+}
+
+// ---- Arithmetic ----
+
+enum BinaryOperator { BIN_ADD, BIN_SUB, BIN_MUL, BIN_DIV, BIN_FLOORDIV, BIN_MOD };
+
+const char* binaryOperatorSymbol(BinaryOperator op) {
+    static const char* symbols[] = {"+", "-", "*", "/", "//", "%"};
+    return symbols[op];
+}
+
+bool binaryOperatorFromString(const string& text, BinaryOperator& op) {
+    if (text == "+") op = BIN_ADD;
+    else if (text == "-") op = BIN_SUB;
+    else if (text == "*") op = BIN_MUL;
+    else if (text == "/") op = BIN_DIV;
+    else if (text == "//") op = BIN_FLOORDIV;
+    else if (text == "%") op = BIN_MOD;
+    else return false;
+    return true;
+}
+
+[[noreturn]] void unsupportedOperands(BinaryOperator op, const Value& a, const Value& b) {
+    runtimeError(string("TypeError: unsupported operand type(s) for ") + binaryOperatorSymbol(op) +
+                 ": '" + typeName(a) + "' and '" + typeName(b) + "'");
+}
+
+Value repeatSequence(const Value& sequence, long long count) {
+    if (sequence.kind == V_STR) {
+        string out;
+        for (long long k = 0; k < count; k++) out += asStr(sequence)->s;
+        return makeString(out);
+    }
+    vector<Value> items;
+    for (long long k = 0; k < count; k++) {
+        for (const auto& item : asList(sequence)->items) items.push_back(item);
+    }
+    return makeList(move(items), sequence.kind);
+}
+
+Value intArithmetic(BinaryOperator op, long long x, long long y) {
+    long long r;
+    switch (op) {
+        case BIN_ADD:
+            if (__builtin_add_overflow(x, y, &r)) break;
+            return Value::integer(r);
+        case BIN_SUB:
+            if (__builtin_sub_overflow(x, y, &r)) break;
+            return Value::integer(r);
+        case BIN_MUL:
+            if (__builtin_mul_overflow(x, y, &r)) break;
+            return Value::integer(r);
+        case BIN_DIV:
+            if (y == 0) runtimeError("ZeroDivisionError: division by zero");
+            return Value::number((double)x / (double)y);
+        case BIN_FLOORDIV: {
+            if (y == 0) runtimeError("ZeroDivisionError: integer division or modulo by zero");
+            long long q = x / y;
+            if ((x % y != 0) && ((x < 0) != (y < 0))) q--;
+            return Value::integer(q);
+        }
+        case BIN_MOD: {
+            if (y == 0) runtimeError("ZeroDivisionError: integer division or modulo by zero");
+            long long m = x % y;
+            if (m != 0 && ((m < 0) != (y < 0))) m += y;
+            return Value::integer(m);
+        }
+    }
+    runtimeError("OverflowError: integer result does not fit in 64 bits");
+}
+
+Value floatArithmetic(BinaryOperator op, double x, double y) {
+    switch (op) {
+        case BIN_ADD: return Value::number(x + y);
+        case BIN_SUB: return Value::number(x - y);
+        case BIN_MUL: return Value::number(x * y);
+        case BIN_DIV:
+            if (y == 0.0) runtimeError("ZeroDivisionError: float division by zero");
+            return Value::number(x / y);
+        case BIN_FLOORDIV:
+            if (y == 0.0) runtimeError("ZeroDivisionError: float floor division by zero");
+            return Value::number(floor(x / y));
+        case BIN_MOD: {
+            if (y == 0.0) runtimeError("ZeroDivisionError: float modulo");
+            double m = fmod(x, y);
+            if (m != 0.0 && ((m < 0) != (y < 0))) m += y;
+            return Value::number(m);
+        }
+    }
+    return Value::none();
+}
+
+Value binaryOp(BinaryOperator op, const Value& a, const Value& b) {
+    if (a.isNumber() && b.isNumber()) {
+        if (a.kind == V_FLOAT || b.kind == V_FLOAT) return floatArithmetic(op, numberValue(a), numberValue(b));
+        return intArithmetic(op, intValue(a), intValue(b));
+    }
+    if (op == BIN_ADD && a.kind == b.kind) {
+        if (a.kind == V_STR) return makeString(asStr(a)->s + asStr(b)->s);
+        if (a.kind == V_LIST || a.kind == V_TUPLE) {
+            vector<Value> items = asList(a)->items;
+            items.insert(items.end(), asList(b)->items.begin(), asList(b)->items.end());
+            return makeList(move(items), a.kind);
+        }
+    }
+    if (op == BIN_MUL) {
+        bool aSeq = a.kind == V_STR || a.kind == V_LIST || a.kind == V_TUPLE;
+        bool bSeq = b.kind == V_STR || b.kind == V_LIST || b.kind == V_TUPLE;
+        if (aSeq && (b.kind == V_INT || b.kind == V_BOOL)) return repeatSequence(a, intValue(b));
+        if (bSeq && (a.kind == V_INT || a.kind == V_BOOL)) return repeatSequence(b, intValue(a));
+    }
+    unsupportedOperands(op, a, b);
+}
+
+Value unaryOp(const string& op, const Value& v) {
+    if (op == "not") return Value::boolean(!truthy(v));
+    if (v.kind == V_INT || v.kind == V_BOOL) {
+        long long x = intValue(v);
+        if (op == "-") {
+            if (x == LLONG_MIN) runtimeError("OverflowError: integer result does not fit in 64 bits");
+            return Value::integer(-x);
+        }
+        if (op == "+") return Value::integer(x);
+        if (op == "~") return Value::integer(~x);
+    }
+    if (v.kind == V_FLOAT) {
+        if (op == "-") return Value::number(-v.f);
+        if (op == "+") return v;
+    }
+    runtimeError("TypeError: bad operand type for unary " + op + ": '" + typeName(v) + "'");
+}
+
+// ---- Containers ----
+
+long long normalizeIndex(long long index, size_t size) {
+    long long i = index < 0 ? index + (long long)size : index;
+    if (i < 0 || i >= (long long)size) runtimeError("IndexError: index out of range");
+    return i;
+}
+
+Value getItem(const Value& container, const Value& key) {
+    switch (container.kind) {
+        case V_LIST:
+        case V_TUPLE:
+            if (key.kind != V_INT && key.kind != V_BOOL) {
+                runtimeError("TypeError: " + typeName(container) + " indices must be integers, not " + typeName(key));
+            }
+            return asList(container)->items[normalizeIndex(intValue(key), asList(container)->items.size())];
+        case V_STR: {
+            if (key.kind != V_INT && key.kind != V_BOOL) runtimeError("TypeError: string indices must be integers");
+            const string& s = asStr(container)->s;
+            return makeString(string(1, s[normalizeIndex(intValue(key), s.size())]));
+        }
+        case V_DICT: {
+            Value* found = asDict(container)->find(key);
+            if (!found) runtimeError("KeyError: " + toRepr(key));
+            return *found;
+        }
+        case V_RANGE: {
+            auto r = asRange(container);
+            long long length = r->step > 0 ? max(0LL, (r->stop - r->start + r->step - 1) / r->step)
+                                           : max(0LL, (r->start - r->stop - r->step - 1) / -r->step);
+            return Value::integer(r->start + normalizeIndex(intValue(key), length) * r->step);
+        }
+        default:
+            runtimeError("TypeError: '" + typeName(container) + "' object is not subscriptable");
+    }
+}
+
+void setItem(const Value& container, const Value& key, const Value& value) {
+    if (container.kind == V_LIST) {
+        if (key.kind != V_INT && key.kind != V_BOOL) runtimeError("TypeError: list indices must be integers");
+        auto& items = asList(container)->items;
+        items[normalizeIndex(intValue(key), items.size())] = value;
+    } else if (container.kind == V_DICT) {
+        hashValue(key);
+        asDict(container)->set(key, value);
+    } else {
+        runtimeError("TypeError: '" + typeName(container) + "' object does not support item assignment");
+    }
+}
+
+Value makeIterator(const Value& iterable) {
+    switch (iterable.kind) {
+        case V_LIST: case V_TUPLE: case V_STR: case V_DICT: case V_SET: case V_RANGE: break;
+        case V_ITER: return iterable;
+        default: runtimeError("TypeError: '" + typeName(iterable) + "' object is not iterable");
+    }
+    auto it = new IterObject();
+    it->sequence = iterable;
+    if (iterable.kind == V_RANGE) it->current = asRange(iterable)->start;
+    return Value::object(V_ITER, it);
+}
+
+// Stores the next element in 'out'; false when exhausted
+bool iteratorNext(IterObject* it, Value& out) {
+    const Value& seq = it->sequence;
+    switch (seq.kind) {
+        case V_RANGE: {
+            auto r = asRange(seq);
+            if (r->step > 0 ? it->current >= r->stop : it->current <= r->stop) return false;
+            out = Value::integer(it->current);
+            it->current += r->step;
+            return true;
+        }
+        case V_LIST:
+        case V_TUPLE: {
+            const auto& items = asList(seq)->items;
+            if (it->position >= items.size()) return false;
+            out = items[it->position++];
+            return true;
+        }
+        case V_STR: {
+            const string& s = asStr(seq)->s;
+            if (it->position >= s.size()) return false;
+            out = makeString(string(1, s[it->position++]));
+            return true;
+        }
+        case V_DICT:
+        case V_SET: {
+            const auto& entries = asDict(seq)->entries;
+            if (it->position >= entries.size()) return false;
+            out = entries[it->position++].first;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+vector<Value> collectItems(const Value& iterable) {
+    if (iterable.kind == V_LIST || iterable.kind == V_TUPLE) return asList(iterable)->items;
+    vector<Value> items;
+    Value it = makeIterator(iterable);
+    Value item;
+    while (iteratorNext(asIter(it), item)) items.push_back(item);
+    return items;
+}
+
+// Python's 'needle in haystack'
+bool containsValue(const Value& haystack, const Value& needle) {
+    switch (haystack.kind) {
+        case V_STR: {
+            if (needle.kind != V_STR) runtimeError("TypeError: 'in <string>' requires string as left operand, not " + typeName(needle));
+            return asStr(haystack)->s.find(asStr(needle)->s) != string::npos;
+        }
+        case V_DICT:
+        case V_SET:
+            hashValue(needle);
+            return asDict(haystack)->find(needle) != nullptr;
+        case V_LIST:
+        case V_TUPLE:
+            for (const Value& item : asList(haystack)->items) {
+                if (valuesEqual(item, needle)) return true;
+            }
+            return false;
+        default: {
+            Value it = makeIterator(haystack);
+            Value item;
+            while (iteratorNext(asIter(it), item)) {
+                if (valuesEqual(item, needle)) return true;
+            }
+            return false;
+        }
+    }
+}
+
+// ---- Classes and attributes ----
+
+// Looks a name up on a class and its parents; nullptr when absent
+Value* findClassAttribute(const Value& cls, const string& name) {
+    Value current = cls;
+    while (current.kind == V_CLASS) {
+        auto c = asClass(current);
+        auto it = c->attributes.find(name);
+        if (it != c->attributes.end()) return &it->second;
+        current = c->parent;
+    }
+    return nullptr;
+}
+
+Value bindMethod(const Value& self, const Value& function) {
+    auto bound = new BoundObject();
+    bound->self = self;
+    bound->function = function;
+    return Value::object(V_BOUND, bound);
+}
+
+Value getAttribute(const Value& object, const string& name) {
+    if (object.kind == V_INSTANCE) {
+        auto inst = asInstance(object);
+        auto it = inst->attributes.find(name);
+        if (it != inst->attributes.end()) return it->second;
+        Value* attr = findClassAttribute(inst->cls, name);
+        if (attr) return attr->kind == V_FUNC ? bindMethod(object, *attr) : *attr;
+    } else if (object.kind == V_CLASS) {
+        Value* attr = findClassAttribute(object, name);
+        if (attr) return *attr;
+    }
+    runtimeError("AttributeError: '" + typeName(object) + "' object has no attribute '" + name + "'");
+}
+
+void setAttribute(const Value& object, const string& name, const Value& value) {
+    if (object.kind == V_INSTANCE) {
+        asInstance(object)->attributes[name] = value;
+    } else if (object.kind == V_CLASS) {
+        asClass(object)->attributes[name] = value;
+    } else {
+        runtimeError("AttributeError: '" + typeName(object) + "' object has no attribute '" + name + "'");
+    }
+}
+
+Value makeClass(const string& name, const Value& parent) {
+    auto cls = new ClassObject();
+    cls->name = name;
+    if (parent.kind == V_CLASS) cls->parent = parent;
+    else if (parent.kind != V_NONE && parent.kind != V_UNDEF) runtimeError("TypeError: base class must be a class");
+    return Value::object(V_CLASS, cls);
+}
+
+Value makeInstance(const Value& cls) {
+    auto inst = new InstanceObject();
+    inst->cls = cls;
+    return Value::object(V_INSTANCE, inst);
+}
+
+// ---- Builtins ----
+
+typedef Value (*BuiltinFunction)(Value* args, int argc);
+
+void expectArgs(const char* name, int argc, int minArgs, int maxArgs) {
+    if (argc < minArgs || argc > maxArgs) {
+        runtimeError(string("TypeError: ") + name + "() takes " +
+                     (minArgs == maxArgs ? to_string(minArgs) : to_string(minArgs) + " to " + to_string(maxArgs)) +
+                     " arguments (" + to_string(argc) + " given)");
+    }
+}
+
+Value builtinPrint(Value* args, int argc) {
+    string line;
+    for (int k = 0; k < argc; k++) {
+        if (k) line += ' ';
+        line += toStr(args[k]);
+    }
+    line += '\n';
+    cout << line;
+    return Value::none();
+}
+
+Value builtinInput(Value* args, int argc) {
+    expectArgs("input", argc, 0, 1);
+    if (argc == 1) cout << toStr(args[0]) << flush;
+    string line;
+    getline(cin, line);
+    return makeString(line);
+}
+
+Value builtinLen(Value* args, int argc) {
+    expectArgs("len", argc, 1, 1);
+    const Value& v = args[0];
+    switch (v.kind) {
+        case V_STR: return Value::integer(asStr(v)->s.size());
+        case V_LIST: case V_TUPLE: return Value::integer(asList(v)->items.size());
+        case V_DICT: case V_SET: return Value::integer(asDict(v)->entries.size());
+        case V_RANGE: {
+            auto r = asRange(v);
+            long long n = r->step > 0 ? (r->stop - r->start + r->step - 1) / r->step
+                                      : (r->start - r->stop - r->step - 1) / -r->step;
+            return Value::integer(max(0LL, n));
+        }
+        default: runtimeError("TypeError: object of type '" + typeName(v) + "' has no len()");
+    }
+}
+
+Value builtinRange(Value* args, int argc) {
+    expectArgs("range", argc, 1, 3);
+    for (int k = 0; k < argc; k++) {
+        if (args[k].kind != V_INT && args[k].kind != V_BOOL) {
+            runtimeError("TypeError: '" + typeName(args[k]) + "' object cannot be interpreted as an integer");
+        }
+    }
+    long long start = 0, stop, step = 1;
+    if (argc == 1) {
+        stop = intValue(args[0]);
+    } else {
+        start = intValue(args[0]);
+        stop = intValue(args[1]);
+        if (argc == 3) step = intValue(args[2]);
+    }
+    if (step == 0) runtimeError("ValueError: range() arg 3 must not be zero");
+    return Value::object(V_RANGE, new RangeObject(start, stop, step));
+}
+
+Value builtinStr(Value* args, int argc) {
+    expectArgs("str", argc, 0, 1);
+    return makeString(argc ? toStr(args[0]) : "");
+}
+
+string trimmed(const string& s) {
+    size_t begin = s.find_first_not_of(" \t\n\r");
+    if (begin == string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\n\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+Value builtinInt(Value* args, int argc) {
+    expectArgs("int", argc, 0, 1);
+    if (argc == 0) return Value::integer(0);
+    const Value& v = args[0];
+    if (v.kind == V_INT || v.kind == V_BOOL) return Value::integer(intValue(v));
+    if (v.kind == V_FLOAT) {
+        if (std::isnan(v.f) || std::isinf(v.f)) runtimeError("ValueError: cannot convert float to integer");
+        return Value::integer((long long)v.f);
+    }
+    if (v.kind == V_STR) {
+        string text = trimmed(asStr(v)->s);
+        long long result = 0;
+        const char* first = text.c_str();
+        if (!text.empty() && text[0] == '+') first++;
+        auto parsed = from_chars(first, text.c_str() + text.size(), result);
+        if (text.empty() || parsed.ec != errc() || parsed.ptr != text.c_str() + text.size()) {
+            runtimeError("ValueError: invalid literal for int() with base 10: " + quoteString(asStr(v)->s));
+        }
+        return Value::integer(result);
+    }
+    runtimeError("TypeError: int() argument must be a string or a number, not '" + typeName(v) + "'");
+}
+
+Value builtinFloat(Value* args, int argc) {
+    expectArgs("float", argc, 0, 1);
+    if (argc == 0) return Value::number(0.0);
+    const Value& v = args[0];
+    if (v.isNumber()) return Value::number(numberValue(v));
+    if (v.kind == V_STR) {
+        string text = trimmed(asStr(v)->s);
+        try {
+            size_t used = 0;
+            double d = stod(text, &used);
+            if (used == text.size()) return Value::number(d);
+        } catch (const exception&) {}
+        runtimeError("ValueError: could not convert string to float: " + quoteString(asStr(v)->s));
+    }
+    runtimeError("TypeError: float() argument must be a string or a number, not '" + typeName(v) + "'");
+}
+
+Value builtinBool(Value* args, int argc) {
+    expectArgs("bool", argc, 0, 1);
+    return Value::boolean(argc ? truthy(args[0]) : false);
+}
+
+Value builtinList(Value* args, int argc) {
+    expectArgs("list", argc, 0, 1);
+    return makeList(argc ? collectItems(args[0]) : vector<Value>());
+}
+
+Value builtinTuple(Value* args, int argc) {
+    expectArgs("tuple", argc, 0, 1);
+    return makeList(argc ? collectItems(args[0]) : vector<Value>(), V_TUPLE);
+}
+
+Value builtinSet(Value* args, int argc) {
+    expectArgs("set", argc, 0, 1);
+    Value result = makeDict(V_SET);
+    if (argc) {
+        for (const auto& item : collectItems(args[0])) {
+            hashValue(item);
+            asDict(result)->set(item, Value::none());
+        }
+    }
+    return result;
+}
+
+Value builtinDict(Value* args, int argc) {
+    expectArgs("dict", argc, 0, 1);
+    Value result = makeDict();
+    if (argc) {
+        if (args[0].kind == V_DICT) {
+            for (const auto& entry : asDict(args[0])->entries) asDict(result)->set(entry.first, entry.second);
+        } else {
+            for (const auto& pair : collectItems(args[0])) {
+                vector<Value> kv = collectItems(pair);
+                if (kv.size() != 2) runtimeError("ValueError: dictionary update sequence element has wrong length");
+                hashValue(kv[0]);
+                asDict(result)->set(kv[0], kv[1]);
+            }
+        }
+    }
+    return result;
+}
+
+Value builtinLower(Value* args, int argc) {
+    expectArgs("lower", argc, 1, 1);
+    if (args[0].kind != V_STR) runtimeError("TypeError: lower() argument must be str");
+    string s = asStr(args[0])->s;
+    transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return tolower(c); });
+    return makeString(s);
+}
+
+Value builtinUpper(Value* args, int argc) {
+    expectArgs("upper", argc, 1, 1);
+    if (args[0].kind != V_STR) runtimeError("TypeError: upper() argument must be str");
+    string s = asStr(args[0])->s;
+    transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return toupper(c); });
+    return makeString(s);
+}
+
+struct BuiltinEntry {
+    const char* name;
+    BuiltinFunction function;
+};
+
+// One entry per name in builtInFunctions; the index is the builtin id stored in a Value
+const vector<BuiltinEntry>& builtinTable() {
+    static const vector<BuiltinEntry> table = {
+        {"print", builtinPrint}, {"input", builtinInput}, {"lower", builtinLower}, {"upper", builtinUpper},
+        {"len", builtinLen}, {"range", builtinRange}, {"str", builtinStr}, {"int", builtinInt},
+        {"float", builtinFloat}, {"bool", builtinBool}, {"list", builtinList}, {"dict", builtinDict},
+        {"set", builtinSet}, {"tuple", builtinTuple}
+    };
+    return table;
+}
+
+// Builtin id for a name from builtInFunctions, or -1
+int findBuiltin(const string& name) {
+    const auto& table = builtinTable();
+    for (size_t k = 0; k < table.size(); k++) {
+        if (name == table[k].name) return (int)k;
+    }
+    return -1;
+}
+
+// ---- Methods of the built-in types ----
+
+Value stringMethod(const string& s, const string& name, Value* args, int argc) {
+    if (name == "upper" || name == "lower") {
+        expectArgs(name.c_str(), argc, 0, 0);
+        Value self = makeString(s);
+        return name == "upper" ? builtinUpper(&self, 1) : builtinLower(&self, 1);
+    }
+    if (name == "strip") {
+        expectArgs("strip", argc, 0, 0);
+        return makeString(trimmed(s));
+    }
+    if (name == "startswith" || name == "endswith") {
+        expectArgs(name.c_str(), argc, 1, 1);
+        if (args[0].kind != V_STR) runtimeError("TypeError: " + name + " arg must be str");
+        const string& part = asStr(args[0])->s;
+        if (part.size() > s.size()) return Value::boolean(false);
+        return Value::boolean(name == "startswith" ? s.compare(0, part.size(), part) == 0
+                                                   : s.compare(s.size() - part.size(), part.size(), part) == 0);
+    }
+    if (name == "find") {
+        expectArgs("find", argc, 1, 1);
+        if (args[0].kind != V_STR) runtimeError("TypeError: find() arg must be str");
+        size_t pos = s.find(asStr(args[0])->s);
+        return Value::integer(pos == string::npos ? -1 : (long long)pos);
+    }
+    if (name == "replace") {
+        expectArgs("replace", argc, 2, 2);
+        if (args[0].kind != V_STR || args[1].kind != V_STR) runtimeError("TypeError: replace() args must be str");
+        const string& from = asStr(args[0])->s;
+        const string& to = asStr(args[1])->s;
+        if (from.empty()) return makeString(s);
+        string out;
+        size_t pos = 0, hit;
+        while ((hit = s.find(from, pos)) != string::npos) {
+            out += s.substr(pos, hit - pos) + to;
+            pos = hit + from.size();
+        }
+        return makeString(out + s.substr(pos));
+    }
+    if (name == "split") {
+        expectArgs("split", argc, 0, 1);
+        vector<Value> parts;
+        if (argc == 0) {
+            stringstream ss(s);
+            string word;
+            while (ss >> word) parts.push_back(makeString(word));
+        } else {
+            if (args[0].kind != V_STR || asStr(args[0])->s.empty()) runtimeError("ValueError: empty separator");
+            const string& sep = asStr(args[0])->s;
+            size_t pos = 0, hit;
+            while ((hit = s.find(sep, pos)) != string::npos) {
+                parts.push_back(makeString(s.substr(pos, hit - pos)));
+                pos = hit + sep.size();
+            }
+            parts.push_back(makeString(s.substr(pos)));
+        }
+        return makeList(move(parts));
+    }
+    if (name == "join") {
+        expectArgs("join", argc, 1, 1);
+        string out;
+        bool first = true;
+        for (const auto& item : collectItems(args[0])) {
+            if (item.kind != V_STR) runtimeError("TypeError: sequence item: expected str instance, " + typeName(item) + " found");
+            if (!first) out += s;
+            out += asStr(item)->s;
+            first = false;
+        }
+        return makeString(out);
+    }
+    runtimeError("AttributeError: 'str' object has no attribute '" + name + "'");
+}
+
+Value listMethod(const Value& self, const string& name, Value* args, int argc) {
+    auto& items = asList(self)->items;
+    if (name == "append") {
+        expectArgs("append", argc, 1, 1);
+        items.push_back(args[0]);
+        return Value::none();
+    }
+    if (name == "pop") {
+        expectArgs("pop", argc, 0, 1);
+        if (items.empty()) runtimeError("IndexError: pop from empty list");
+        long long index = argc ? normalizeIndex(intValue(args[0]), items.size()) : (long long)items.size() - 1;
+        Value result = items[index];
+        items.erase(items.begin() + index);
+        return result;
+    }
+    if (name == "insert") {
+        expectArgs("insert", argc, 2, 2);
+        long long index = intValue(args[0]);
+        if (index < 0) index = max(0LL, index + (long long)items.size());
+        index = min(index, (long long)items.size());
+        items.insert(items.begin() + index, args[1]);
+        return Value::none();
+    }
+    if (name == "extend") {
+        expectArgs("extend", argc, 1, 1);
+        for (const auto& item : collectItems(args[0])) items.push_back(item);
+        return Value::none();
+    }
+    if (name == "index" || name == "count") {
+        expectArgs(name.c_str(), argc, 1, 1);
+        long long count = 0;
+        for (size_t k = 0; k < items.size(); k++) {
+            if (valuesEqual(items[k], args[0])) {
+                if (name == "index") return Value::integer(k);
+                count++;
+            }
+        }
+        if (name == "index") runtimeError("ValueError: " + toRepr(args[0]) + " is not in list");
+        return Value::integer(count);
+    }
+    if (name == "reverse") {
+        expectArgs("reverse", argc, 0, 0);
+        reverse(items.begin(), items.end());
+        return Value::none();
+    }
+    if (name == "sort") {
+        expectArgs("sort", argc, 0, 0);
+        stable_sort(items.begin(), items.end(), [](const Value& a, const Value& b) {
+            return compareValues(a, b, "<") < 0;
+        });
+        return Value::none();
+    }
+    runtimeError("AttributeError: 'list' object has no attribute '" + name + "'");
+}
+
+Value dictMethod(const Value& self, const string& name, Value* args, int argc) {
+    auto dict = asDict(self);
+    if (self.kind == V_SET) {
+        if (name == "add") {
+            expectArgs("add", argc, 1, 1);
+            hashValue(args[0]);
+            dict->set(args[0], Value::none());
+            return Value::none();
+        }
+        runtimeError("AttributeError: 'set' object has no attribute '" + name + "'");
+    }
+    if (name == "get") {
+        expectArgs("get", argc, 1, 2);
+        Value* found = dict->find(args[0]);
+        return found ? *found : (argc == 2 ? args[1] : Value::none());
+    }
+    if (name == "keys" || name == "values" || name == "items") {
+        expectArgs(name.c_str(), argc, 0, 0);
+        vector<Value> result;
+        for (const auto& entry : dict->entries) {
+            if (name == "keys") result.push_back(entry.first);
+            else if (name == "values") result.push_back(entry.second);
+            else result.push_back(makeList({entry.first, entry.second}, V_TUPLE));
+        }
+        return makeList(move(result));
+    }
+    if (name == "update") {
+        expectArgs("update", argc, 1, 1);
+        if (args[0].kind != V_DICT) runtimeError("TypeError: update() argument must be a dict");
+        for (const auto& entry : asDict(args[0])->entries) dict->set(entry.first, entry.second);
+        return Value::none();
+    }
+    runtimeError("AttributeError: 'dict' object has no attribute '" + name + "'");
+}
+
+// Calls a method of str/list/dict/set; instances go through their class instead
+Value callNativeMethod(const Value& self, const string& name, Value* args, int argc) {
+    switch (self.kind) {
+        case V_STR: return stringMethod(asStr(self)->s, name, args, argc);
+        case V_LIST: return listMethod(self, name, args, argc);
+        case V_DICT:
+        case V_SET: return dictMethod(self, name, args, argc);
+        default:
+            runtimeError("AttributeError: '" + typeName(self) + "' object has no attribute '" + name + "'");
+    }
+}
+
+// ---- Literals ----
+
+// The value of a decoded number or string literal
+Value literalConstant(const LiteralValue& literal) {
+    switch (literal.kind) {
+        case LIT_INT: return Value::integer(literal.integer);
+        case LIT_FLOAT: return Value::number(literal.number);
+        case LIT_STRING: return makeString(literal.text);
+        case LIT_BIG_INT: runtimeError("OverflowError: integer literal too large: " + literal.text);
+        default: runtimeError(literal.text);
+    }
+}
+
+// The parts of a decoded f-string literal
+const vector<FStringSegment>& formattedSegments(const LiteralValue& literal) {
+    if (literal.kind != LIT_FSTRING) runtimeError(literal.text);
+    return literal.segments;
+}
+
+// Applies a format spec of the form [<|>|^][width][.precision][f|d]
+string formatWithSpec(const Value& v, const string& spec) {
+    if (spec.empty()) return toStr(v);
+    size_t k = 0;
+    char align = 0;
+    if (k < spec.size() && (spec[k] == '<' || spec[k] == '>' || spec[k] == '^')) align = spec[k++];
+    int width = 0;
+    while (k < spec.size() && isdigit((unsigned char)spec[k])) width = width * 10 + (spec[k++] - '0');
+    int precision = -1;
+    if (k < spec.size() && spec[k] == '.') {
+        precision = 0;
+        k++;
+        while (k < spec.size() && isdigit((unsigned char)spec[k])) precision = precision * 10 + (spec[k++] - '0');
+    }
+    char type = k < spec.size() ? spec[k++] : 0;
+    if (k != spec.size()) runtimeError("ValueError: Invalid format specifier '" + spec + "'");
+
+    string text;
+    if (type == 'f' || (precision >= 0 && type == 0 && v.kind == V_FLOAT)) {
+        if (!v.isNumber()) runtimeError("ValueError: Unknown format code 'f' for object of type '" + typeName(v) + "'");
+        char buffer[512];
+        snprintf(buffer, sizeof(buffer), "%.*f", precision < 0 ? 6 : precision, numberValue(v));
+        text = buffer;
+    } else if (type == 'd') {
+        if (v.kind != V_INT && v.kind != V_BOOL) runtimeError("ValueError: Unknown format code 'd' for object of type '" + typeName(v) + "'");
+        text = to_string(intValue(v));
+    } else if (type == 0) {
+        text = toStr(v);
+    } else {
+        runtimeError(string("ValueError: Unknown format code '") + type + "'");
+    }
+
+    if ((int)text.size() < width) {
+        size_t pad = width - text.size();
+        if (!align) align = v.isNumber() ? '>' : '<';
+        if (align == '<') text += string(pad, ' ');
+        else if (align == '>') text = string(pad, ' ') + text;
+        else text = string(pad / 2, ' ') + text + string(pad - pad / 2, ' ');
+    }
+    return text;
+}
@@ -0,0 +1,77 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+using namespace std;
+
+// Bounded lock-free single-producer/single-consumer ring buffer.
+// push() blocks while the queue is full (backpressure), pop() blocks while it is empty
+// until the producer calls close().
+template <typename T>
+class SpscQueue {
+    private:
+        vector<T> slots;
+        size_t mask;
+        alignas(64) atomic<size_t> head{0}; // next slot to read, owned by the consumer
+        alignas(64) atomic<size_t> tail{0}; // next slot to write, owned by the producer
+        alignas(64) atomic<bool> closed{false};
+
+        static size_t roundUpToPowerOfTwo(size_t n) {
+            size_t size = 1;
+            while (size < n) size <<= 1;
+            return size;
+        }
+
+        // Spin briefly, then yield, then sleep so a long-stalled peer does not burn a core
+        static void backoff(int& spins) {
+            ++spins;
+            if (spins < 64) return;
+            if (spins < 1024) {
+                this_thread::yield();
+                return;
+            }
+            this_thread::sleep_for(chrono::microseconds(50));
+        }
+
+    public:
+        explicit SpscQueue(size_t capacity) : slots(roundUpToPowerOfTwo(capacity < 2 ? 2 : capacity)) {
+            mask = slots.size() - 1;
+        }
+
+        void push(T item) {
+            size_t t = tail.load(memory_order_relaxed);
+            int spins = 0;
+            while (t - head.load(memory_order_acquire) == slots.size()) {
+                backoff(spins);
+            }
+            slots[t & mask] = move(item);
+            tail.store(t + 1, memory_order_release);
+        }
+
+        // Returns false once the queue is closed and drained
+        bool pop(T& item) {
+            size_t h = head.load(memory_order_relaxed);
+            int spins = 0;
+            while (h == tail.load(memory_order_acquire)) {
+                if (closed.load(memory_order_acquire)) {
+                    // Re-check: the producer may have pushed right before closing
+                    if (h == tail.load(memory_order_acquire)) return false;
+                    break;
+                }
+                backoff(spins);
+            }
+            item = move(slots[h & mask]);
+            head.store(h + 1, memory_order_release);
+            return true;
+        }
+
+        void close() {
+            closed.store(true, memory_order_release);
+        }
+};
+
+#endif
@@ -0,0 +1,524 @@
+#include <memory>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+using namespace std;
+
+// Workspace symbol index: every definition and reference of a name across a tree of source
+// files, with the file, line, enclosing scope and kind of each. It is written as one flat file
+// of fixed-size records that lookups map into memory and binary search by name without
+// deserializing anything, so a query costs a few page touches however large the workspace is.
+//
+// Layout, every section 8-byte aligned:
+//   SymbolIndexHeader
+//   IndexedFile[fileCount]    one per source file, with the hash of its contents
+//   IndexedName[nameCount]    sorted by name; each owns a range of entries
+//   IndexedEntry[entryCount]  grouped by name, definitions first, then by file and line
+//   char[stringBytes]         NUL-terminated names, scopes and paths
+//
+// Rebuilding reuses the entries of every file whose hash is unchanged and only lexes and
+// parses the rest.
+
+enum SymbolKind : uint8_t { SYMBOL_FUNCTION, SYMBOL_CLASS, SYMBOL_VARIABLE, SYMBOL_IMPORT };
+enum SymbolRole : uint8_t { SYMBOL_DEFINITION, SYMBOL_REFERENCE };
+
+const char symbolIndexMagic[8] = {'S', 'Y', 'M', 'I', 'D', 'X', '0', '2'};
+
+struct SymbolIndexHeader {
+    char magic[8];
+    uint32_t fileCount, nameCount, entryCount, stringBytes;
+};
+
+struct IndexedFile {
+    uint64_t hash;    // FNV-1a of the file's bytes
+    uint32_t path;    // string offset
+    uint32_t symbols; // entries that come from this file
+};
+
+struct IndexedName {
+    uint32_t text, length; // string offset and length
+    uint32_t firstEntry, entryCount;
+};
+
+struct IndexedEntry {
+    uint32_t file, line;
+    uint32_t scope; // string offset of the qualified scope name, like 'Car.display' or '<module>'
+    SymbolKind kind;
+    SymbolRole role;
+    uint16_t reserved;
+};
+
+const char* symbolKindName(SymbolKind kind) {
+    switch (kind) {
+        case SYMBOL_FUNCTION: return "function";
+        case SYMBOL_CLASS: return "class";
+        case SYMBOL_VARIABLE: return "variable";
+        case SYMBOL_IMPORT: return "import";
+    }
+    return "?";
+}
+
+uint64_t hashBytes(const string& bytes) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : bytes) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// ---- Reading ----
+
+// A read-only mapping of an index file. Opening checks the header and section sizes; the
+// records themselves are trusted, as the writer is this file
+class MappedSymbolIndex {
+    private:
+        void* data = MAP_FAILED;
+        size_t size = 0;
+        const SymbolIndexHeader* header = nullptr;
+        const IndexedFile* files = nullptr;
+        const IndexedName* names = nullptr;
+        const IndexedEntry* entries = nullptr;
+        const char* strings = nullptr;
+
+    public:
+        MappedSymbolIndex() = default;
+        MappedSymbolIndex(const MappedSymbolIndex&) = delete;
+        MappedSymbolIndex& operator=(const MappedSymbolIndex&) = delete;
+        ~MappedSymbolIndex() {
+            if (data != MAP_FAILED) munmap(data, size);
+        }
+
+        // False when the file is missing or is not an index
+        bool open(const string& path) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) return false;
+            struct stat info;
+            if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SymbolIndexHeader)) {
+                close(fd);
+                return false;
+            }
+            size = (size_t)info.st_size;
+            data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (data == MAP_FAILED) return false;
+
+            const char* bytes = static_cast<const char*>(data);
+            header = reinterpret_cast<const SymbolIndexHeader*>(bytes);
+            size_t expected = sizeof(SymbolIndexHeader) + header->fileCount * sizeof(IndexedFile) +
+                              (size_t)header->nameCount * sizeof(IndexedName) +
+                              (size_t)header->entryCount * sizeof(IndexedEntry) + header->stringBytes;
+            if (memcmp(header->magic, symbolIndexMagic, sizeof(symbolIndexMagic)) != 0 || expected != size ||
+                header->stringBytes == 0 || bytes[size - 1] != '\0') {
+                munmap(data, size);
+                data = MAP_FAILED;
+                return false;
+            }
+            files = reinterpret_cast<const IndexedFile*>(bytes + sizeof(SymbolIndexHeader));
+            names = reinterpret_cast<const IndexedName*>(files + header->fileCount);
+            entries = reinterpret_cast<const IndexedEntry*>(names + header->nameCount);
+            strings = reinterpret_cast<const char*>(entries + header->entryCount);
+            return true;
+        }
+
+        uint32_t fileCount() const { return header->fileCount; }
+        uint32_t nameCount() const { return header->nameCount; }
+        uint32_t entryCount() const { return header->entryCount; }
+        const IndexedFile& file(uint32_t k) const { return files[k]; }
+        const IndexedName& name(uint32_t k) const { return names[k]; }
+        const IndexedEntry& entry(uint32_t k) const { return entries[k]; }
+        const char* text(uint32_t offset) const { return strings + offset; }
+
+        // The name's record, or nullptr when nothing by that name is indexed
+        const IndexedName* find(const string& wanted) const {
+            const IndexedName* first = names;
+            const IndexedName* last = names + header->nameCount;
+            auto found = lower_bound(first, last, wanted, [&](const IndexedName& name, const string& value) {
+                return value.compare(0, string::npos, strings + name.text, name.length) > 0;
+            });
+            if (found == last || wanted.compare(0, string::npos, strings + found->text, found->length) != 0) return nullptr;
+            return found;
+        }
+};
+
+// ---- Collecting ----
+
+class StringPool {
+    private:
+        unordered_map<string, uint32_t> ids;
+
+    public:
+        vector<string> strings;
+
+        uint32_t intern(const string& text) {
+            auto found = ids.find(text);
+            if (found != ids.end()) return found->second;
+            uint32_t id = (uint32_t)strings.size();
+            ids.emplace(text, id);
+            strings.push_back(text);
+            return id;
+        }
+};
+
+struct SymbolRecord {
+    uint32_t name, line, scope; // name and scope are StringPool ids
+    SymbolKind kind;
+    SymbolRole role;
+};
+
+// Walks one file's parse tree. References are recorded at the line of the statement they
+// appear in, and their kind is settled later from the name's definitions
+class SymbolCollector {
+    private:
+        StringPool& pool;
+        vector<SymbolRecord>& records;
+
+        void define(const string& name, SymbolKind kind, int line, uint32_t scope) {
+            records.push_back({pool.intern(name), (uint32_t)line, scope, kind, SYMBOL_DEFINITION});
+        }
+
+        void reference(const string& name, int line, uint32_t scope) {
+            records.push_back({pool.intern(name), (uint32_t)line, scope, SYMBOL_VARIABLE, SYMBOL_REFERENCE});
+        }
+
+        uint32_t nestedScope(uint32_t scope, const string& name) {
+            const string& outer = pool.strings[scope];
+            return pool.intern(outer == "<module>" ? name : outer + "." + name);
+        }
+
+        void visitExpression(const shared_ptr<ParseTreeNode>& node, int line, uint32_t scope) {
+            const string& type = node->type;
+            if (type == "Identifier") {
+                reference(node->value, line, scope);
+            } else if (type == "AttributeAccess") {
+                visitExpression(node->children[0], line, scope);
+                reference(node->children.back()->value, line, scope);
+            } else if (type == "DottedName") {
+                for (const auto& part : node->children) reference(part->value, line, scope);
+            } else if (type == "Literal") {
+                // Only f-strings have segments; a malformed one references nothing
+                for (const auto& segment : literalOf(node).segments) {
+                    if (!segment.isExpression) continue;
+                    auto expression = parseEmbeddedExpression(segment.text);
+                    if (expression) visitExpression(expression, line, scope);
+                }
+            } else {
+                for (const auto& child : node->children) visitExpression(child, line, scope);
+            }
+        }
+
+        void visitBlock(const shared_ptr<ParseTreeNode>& block, uint32_t scope) {
+            for (const auto& statement : block->children) {
+                if (!isSyntaxLeaf(statement)) visitStatement(statement, scope);
+            }
+        }
+
+        void visitStatement(const shared_ptr<ParseTreeNode>& node, uint32_t scope) {
+            const string& type = node->type;
+            int line = node->line;
+            if (type == "FunctionDefinition") {
+                const string& name = findChild(node, "Identifier")->value;
+                define(name, SYMBOL_FUNCTION, line, scope);
+                uint32_t inner = nestedScope(scope, name);
+                auto params = findChild(node, "Parameters");
+                if (params) {
+                    for (const auto& param : params->children) {
+                        if (param->type == "Parameter") define(param->value, SYMBOL_VARIABLE, line, inner);
+                    }
+                }
+                visitBlock(findChild(node, "Suite"), inner);
+            } else if (type == "ClassDefinition") {
+                const string& name = findChild(node, "Identifier")->value;
+                define(name, SYMBOL_CLASS, line, scope);
+                auto parent = findChild(node, "Parent");
+                if (parent) reference(parent->value, line, scope);
+                visitBlock(findChild(node, "Suite"), nestedScope(scope, name));
+            } else if (type == "Assignment") {
+                auto children = semanticChildren(node);
+                bool augmented = children[1]->value != "=";
+                visitExpression(children[2], line, scope);
+                for (const auto& target : children[0]->children) {
+                    if (target->type != "Identifier") {
+                        visitExpression(target, line, scope);
+                        continue;
+                    }
+                    if (augmented) reference(target->value, line, scope);
+                    define(target->value, SYMBOL_VARIABLE, line, scope);
+                }
+            } else if (type == "ForStatement") {
+                auto children = semanticChildren(node); // target, iterable, body
+                define(children[0]->value, SYMBOL_VARIABLE, line, scope);
+                visitExpression(children[1], line, scope);
+                visitBlock(children[2], scope);
+            } else if (type == "ImportStatement") {
+                for (const string& name : importedNames(node)) define(name, SYMBOL_IMPORT, line, scope);
+            } else if (type == "IfStatement" || type == "WhileStatement" || type == "ElifClause" || type == "ElseClause") {
+                for (const auto& child : semanticChildren(node)) {
+                    if (child->type == "Suite") visitBlock(child, scope);
+                    else if (child->type == "ElifClause" || child->type == "ElseClause") visitStatement(child, scope);
+                    else visitExpression(child, line, scope);
+                }
+            } else {
+                visitExpression(node, line, scope);
+            }
+        }
+
+    public:
+        SymbolCollector(StringPool& strings, vector<SymbolRecord>& out) : pool(strings), records(out) {}
+
+        void collect(const shared_ptr<ParseTreeNode>& program) {
+            visitBlock(program, pool.intern("<module>"));
+        }
+};
+
+// Lexes and parses source text without the symbol table's type guesses; nullptr on errors,
+// which the lexer and parser have already printed
+shared_ptr<ParseTreeNode> parseSource(const string& source) {
+    Lexer lexer;
+    vector<tuple<string, int, int>> lines;
+    istringstream input(source);
+    string line;
+    int lineNumber = 1;
+    while (getline(input, line)) lines.push_back(lexer.makeCodeLine(line, lineNumber++));
+    try {
+        lexer.tokenizeLine(lines);
+    } catch (const exception&) {
+        return nullptr;
+    }
+    Parser parser(lexer.getTokens());
+    parser.setLeanTree(true);
+    return parser.parse();
+}
+
+// ---- Writing ----
+
+class SymbolIndexBuilder {
+    private:
+        struct FileSymbols {
+            uint32_t path; // StringPool id
+            uint64_t hash;
+            vector<SymbolRecord> records;
+        };
+
+        StringPool pool;
+        vector<FileSymbols> files;
+
+    public:
+        size_t reused = 0, parsed = 0, failed = 0;
+
+        // Copies the entries an earlier index holds for 'oldFile', given as (name index, entry
+        // index) pairs
+        void reuseFile(const MappedSymbolIndex& previous, uint32_t oldFile, const vector<uint32_t>& entryIds) {
+            const IndexedFile& file = previous.file(oldFile);
+            files.push_back({pool.intern(previous.text(file.path)), file.hash, {}});
+            auto& records = files.back().records;
+            records.reserve(entryIds.size());
+            // Entries are grouped by name, so consecutive ones usually share it
+            uint32_t lastName = UINT32_MAX, nameId = 0;
+            for (size_t k = 0; k < entryIds.size(); k += 2) {
+                uint32_t nameIndex = entryIds[k], entryIndex = entryIds[k + 1];
+                if (nameIndex != lastName) {
+                    const IndexedName& name = previous.name(nameIndex);
+                    nameId = pool.intern(string(previous.text(name.text), name.length));
+                    lastName = nameIndex;
+                }
+                const IndexedEntry& entry = previous.entry(entryIndex);
+                records.push_back({nameId, entry.line, pool.intern(previous.text(entry.scope)), entry.kind, entry.role});
+            }
+            reused++;
+        }
+
+        void parseFile(const string& path, const string& source, uint64_t hash) {
+            files.push_back({pool.intern(path), hash, {}});
+            auto tree = parseSource(source);
+            if (!tree) {
+                // Kept without symbols so an unchanged broken file is not parsed again
+                cerr << "Skipping " << path << ": it does not parse" << endl;
+                failed++;
+                return;
+            }
+            SymbolCollector(pool, files.back().records).collect(tree);
+            parsed++;
+        }
+
+        size_t fileCount() const { return files.size(); }
+
+        // Writes the index next to 'path' and renames it into place; returns false on I/O errors
+        bool write(const string& path, uint32_t& nameCount, uint32_t& entryCount) {
+            // Group every record by name: (name, role, file, line) order
+            struct Slot { uint32_t name, file; const SymbolRecord* record; };
+            vector<Slot> slots;
+            for (uint32_t f = 0; f < files.size(); f++) {
+                for (const auto& record : files[f].records) slots.push_back({record.name, f, &record});
+            }
+            const auto& strings = pool.strings;
+            sort(slots.begin(), slots.end(), [&](const Slot& a, const Slot& b) {
+                if (a.name != b.name) return strings[a.name] < strings[b.name];
+                if (a.record->role != b.record->role) return a.record->role < b.record->role;
+                if (a.file != b.file) return a.file < b.file;
+                return a.record->line < b.record->line;
+            });
+
+            // String offsets in pool order
+            vector<uint32_t> offsets(strings.size());
+            uint32_t stringBytes = 0;
+            for (size_t k = 0; k < strings.size(); k++) {
+                offsets[k] = stringBytes;
+                stringBytes += (uint32_t)strings[k].size() + 1;
+            }
+            stringBytes = (stringBytes + 7) & ~7u;
+
+            vector<IndexedFile> fileRecords;
+            for (const auto& file : files) fileRecords.push_back({file.hash, offsets[file.path], (uint32_t)file.records.size()});
+
+            vector<IndexedName> nameRecords;
+            vector<IndexedEntry> entryRecords;
+            entryRecords.reserve(slots.size());
+            for (size_t k = 0; k < slots.size();) {
+                size_t end = k;
+                while (end < slots.size() && slots[end].name == slots[k].name) end++;
+                // References take the kind of the name's first definition other than an import, which
+                // only binds what another module defines
+                SymbolKind referenceKind = SYMBOL_VARIABLE;
+                for (size_t d = k; d < end && slots[d].record->role == SYMBOL_DEFINITION; d++) {
+                    referenceKind = slots[d].record->kind;
+                    if (referenceKind != SYMBOL_IMPORT) break;
+                }
+                nameRecords.push_back({offsets[slots[k].name], (uint32_t)strings[slots[k].name].size(),
+                                       (uint32_t)entryRecords.size(), (uint32_t)(end - k)});
+                for (; k < end; k++) {
+                    const SymbolRecord& record = *slots[k].record;
+                    SymbolKind kind = record.role == SYMBOL_DEFINITION ? record.kind : referenceKind;
+                    entryRecords.push_back({slots[k].file, record.line, offsets[record.scope], kind, record.role, 0});
+                }
+            }
+
+            SymbolIndexHeader header;
+            memcpy(header.magic, symbolIndexMagic, sizeof(symbolIndexMagic));
+            header.fileCount = (uint32_t)fileRecords.size();
+            header.nameCount = (uint32_t)nameRecords.size();
+            header.entryCount = (uint32_t)entryRecords.size();
+            header.stringBytes = stringBytes;
+            nameCount = header.nameCount;
+            entryCount = header.entryCount;
+
+            string temporary = path + ".tmp";
+            ofstream out(temporary, ios::binary | ios::trunc);
+            if (!out) return false;
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(fileRecords.data()), fileRecords.size() * sizeof(IndexedFile));
+            out.write(reinterpret_cast<const char*>(nameRecords.data()), nameRecords.size() * sizeof(IndexedName));
+            out.write(reinterpret_cast<const char*>(entryRecords.data()), entryRecords.size() * sizeof(IndexedEntry));
+            uint32_t written = 0;
+            for (const string& text : strings) {
+                out.write(text.c_str(), text.size() + 1);
+                written += (uint32_t)text.size() + 1;
+            }
+            for (; written < stringBytes; written++) out.put('\0');
+            out.close();
+            if (!out) return false;
+            error_code failure;
+            filesystem::rename(temporary, path, failure);
+            return !failure;
+        }
+};
+
+// ---- Entry points ----
+
+// Indexes every .py file under 'root' into 'indexPath', reusing the previous index's entries for
+// files whose contents have not changed; returns the process exit status
+int buildSymbolIndex(const string& root, const string& indexPath) {
+    auto started = chrono::steady_clock::now();
+    vector<string> paths;
+    error_code failure;
+    for (filesystem::recursive_directory_iterator it(root, filesystem::directory_options::skip_permission_denied, failure), end;
+         !failure && it != end; it.increment(failure)) {
+        if (it->is_regular_file() && it->path().extension() == ".py") paths.push_back(it->path().lexically_normal().string());
+    }
+    if (failure) {
+        cerr << "Error: Could not read directory " << root << ": " << failure.message() << endl;
+        return 1;
+    }
+    sort(paths.begin(), paths.end());
+
+    // Each earlier file's entries as (name index, entry index) pairs
+    MappedSymbolIndex previous;
+    unordered_map<string, uint32_t> previousFiles;
+    vector<vector<uint32_t>> previousEntries;
+    if (previous.open(indexPath)) {
+        for (uint32_t f = 0; f < previous.fileCount(); f++) previousFiles.emplace(previous.text(previous.file(f).path), f);
+        previousEntries.resize(previous.fileCount());
+        for (uint32_t n = 0; n < previous.nameCount(); n++) {
+            const IndexedName& name = previous.name(n);
+            for (uint32_t e = name.firstEntry; e < name.firstEntry + name.entryCount; e++) {
+                auto& list = previousEntries[previous.entry(e).file];
+                list.push_back(n);
+                list.push_back(e);
+            }
+        }
+    }
+
+    SymbolIndexBuilder builder;
+    for (const string& path : paths) {
+        ifstream in(path, ios::binary);
+        if (!in) {
+            cerr << "Error: Could not open file " << path << endl;
+            continue;
+        }
+        stringstream contents;
+        contents << in.rdbuf();
+        string source = contents.str();
+        uint64_t hash = hashBytes(source);
+        auto found = previousFiles.find(path);
+        if (found != previousFiles.end() && previous.file(found->second).hash == hash) {
+            builder.reuseFile(previous, found->second, previousEntries[found->second]);
+        } else {
+            builder.parseFile(path, source, hash);
+        }
+    }
+
+    uint32_t nameCount = 0, entryCount = 0;
+    if (!builder.write(indexPath, nameCount, entryCount)) {
+        cerr << "Error: Could not write symbol index " << indexPath << endl;
+        return 1;
+    }
+    double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    cout << "Indexed " << builder.fileCount() << " files (" << builder.parsed << " parsed, " << builder.reused
+         << " unchanged, " << builder.failed << " failed): " << nameCount << " names, " << entryCount
+         << " symbols in " << fixed << setprecision(1) << elapsed << " ms" << endl;
+    return 0;
+}
+
+// Prints every definition and reference of 'name' as 'path:line: kind role in scope'; returns
+// 1 when the index is missing or has no such name
+int lookupSymbol(const string& indexPath, const string& name) {
+    MappedSymbolIndex index;
+    if (!index.open(indexPath)) {
+        cerr << "Error: No symbol index at " << indexPath << endl;
+        return 1;
+    }
+    const IndexedName* found = index.find(name);
+    if (!found) {
+        cout << "No symbol named '" << name << "'" << endl;
+        return 1;
+    }
+    for (uint32_t e = found->firstEntry; e < found->firstEntry + found->entryCount; e++) {
+        const IndexedEntry& entry = index.entry(e);
+        cout << index.text(index.file(entry.file).path) << ":" << entry.line << ": " << symbolKindName(entry.kind)
+             << (entry.role == SYMBOL_DEFINITION ? " definition" : " reference") << " in " << index.text(entry.scope) << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,259 @@
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+using namespace std;
+
+// The token and symbol tables as columnar binary arrays, for tools that load them in bulk
+// instead of parsing the text report. Every column is a plain array that can be used in place
+// from a mapping of the file; strings live once in a shared string table.
+//
+// Layout, every section 8-byte aligned:
+//   TableDumpHeader
+//   uint8_t  tokenKind[tokenCount]       TokenType
+//   uint8_t  tokenSubKind[tokenCount]    LiteralKind of a LITERAL token, otherwise TOKEN_SUBKIND_NONE
+//   uint32_t tokenLine[tokenCount]
+//   uint32_t tokenOffset[tokenCount]     byte offset of the token's text in the string bytes
+//   uint32_t tokenLength[tokenCount]
+//   uint32_t symbolId[symbolCount]
+//   uint32_t symbolName[symbolCount]     string ids
+//   uint32_t symbolType[symbolCount]
+//   uint32_t symbolScope[symbolCount]
+//   uint32_t stringOffset[stringCount + 1] string id -> byte offset; the last entry is the end
+//   char     stringBytes[stringBytes]    NUL-terminated strings
+//
+// As in the text report, ERROR tokens are left out.
+
+const char tableDumpMagic[8] = {'T', 'O', 'K', 'D', 'M', 'P', '0', '1'};
+const uint8_t TOKEN_SUBKIND_NONE = 0xFF;
+
+struct TableDumpHeader {
+    char magic[8];
+    uint32_t tokenCount, symbolCount, stringCount, stringBytes;
+};
+
+inline size_t alignedSection(size_t bytes) {
+    return (bytes + 7) & ~(size_t)7;
+}
+
+// ---- Writing ----
+
+class TableDumpWriter {
+    private:
+        ofstream out;
+
+        template <typename T>
+        void writeColumn(const vector<T>& column) {
+            size_t bytes = column.size() * sizeof(T);
+            out.write(reinterpret_cast<const char*>(column.data()), bytes);
+            static const char padding[8] = {};
+            out.write(padding, alignedSection(bytes) - bytes);
+        }
+
+    public:
+        // Writes the lexer's tables next to 'path' and renames the file into place; false on I/O errors
+        bool write(const Lexer& lexer, const string& path) {
+            const vector<Token>& tokens = lexer.getTokens();
+            const vector<Identifier>& symbols = lexer.getsymbols();
+            StringPool pool;
+
+            vector<uint8_t> kinds, subKinds;
+            vector<uint32_t> lines, textIds;
+            kinds.reserve(tokens.size());
+            subKinds.reserve(tokens.size());
+            lines.reserve(tokens.size());
+            textIds.reserve(tokens.size());
+            for (const auto& token : tokens) {
+                if (token.type == TokenType::ERROR) continue;
+                kinds.push_back((uint8_t)token.type);
+                subKinds.push_back(token.literal ? (uint8_t)token.literal->kind : TOKEN_SUBKIND_NONE);
+                lines.push_back((uint32_t)token.line);
+                textIds.push_back(pool.intern(token.value));
+            }
+
+            vector<uint32_t> ids, names, types, scopes;
+            for (const auto& symbol : symbols) {
+                ids.push_back((uint32_t)symbol.ID);
+                names.push_back(pool.intern(symbol.name));
+                types.push_back(pool.intern(symbol.type));
+                scopes.push_back(pool.intern(symbol.Scope));
+            }
+
+            vector<uint32_t> stringOffsets;
+            stringOffsets.reserve(pool.strings.size() + 1);
+            uint32_t stringBytes = 0;
+            for (const string& text : pool.strings) {
+                stringOffsets.push_back(stringBytes);
+                stringBytes += (uint32_t)text.size() + 1;
+            }
+            stringOffsets.push_back(stringBytes);
+
+            vector<uint32_t> offsets, lengths;
+            offsets.reserve(textIds.size());
+            lengths.reserve(textIds.size());
+            for (uint32_t id : textIds) {
+                offsets.push_back(stringOffsets[id]);
+                lengths.push_back(stringOffsets[id + 1] - stringOffsets[id] - 1);
+            }
+
+            TableDumpHeader header;
+            memcpy(header.magic, tableDumpMagic, sizeof(tableDumpMagic));
+            header.tokenCount = (uint32_t)kinds.size();
+            header.symbolCount = (uint32_t)ids.size();
+            header.stringCount = (uint32_t)pool.strings.size();
+            header.stringBytes = stringBytes;
+
+            string temporary = path + ".tmp";
+            out.open(temporary, ios::binary | ios::trunc);
+            if (!out) return false;
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            writeColumn(kinds);
+            writeColumn(subKinds);
+            writeColumn(lines);
+            writeColumn(offsets);
+            writeColumn(lengths);
+            writeColumn(ids);
+            writeColumn(names);
+            writeColumn(types);
+            writeColumn(scopes);
+            writeColumn(stringOffsets);
+            string bytes;
+            bytes.reserve(alignedSection(stringBytes));
+            for (const string& text : pool.strings) bytes.append(text.c_str(), text.size() + 1);
+            bytes.resize(alignedSection(stringBytes), '\0');
+            out.write(bytes.data(), bytes.size());
+            out.close();
+            if (!out) return false;
+            error_code failure;
+            filesystem::rename(temporary, path, failure);
+            return !failure;
+        }
+};
+
+// ---- Reading ----
+
+// A read-only mapping of a dump. Opening checks the header and the file size; the columns
+// themselves are trusted, as the writer is this file
+class MappedTableDump {
+    private:
+        void* data = MAP_FAILED;
+        size_t size = 0;
+        const TableDumpHeader* header = nullptr;
+
+    public:
+        const uint8_t* tokenKind = nullptr;
+        const uint8_t* tokenSubKind = nullptr;
+        const uint32_t* tokenLine = nullptr;
+        const uint32_t* tokenOffset = nullptr;
+        const uint32_t* tokenLength = nullptr;
+        const uint32_t* symbolId = nullptr;
+        const uint32_t* symbolName = nullptr;
+        const uint32_t* symbolType = nullptr;
+        const uint32_t* symbolScope = nullptr;
+        const uint32_t* stringOffset = nullptr;
+        const char* stringBytes = nullptr;
+
+        MappedTableDump() = default;
+        MappedTableDump(const MappedTableDump&) = delete;
+        MappedTableDump& operator=(const MappedTableDump&) = delete;
+        ~MappedTableDump() {
+            if (data != MAP_FAILED) munmap(data, size);
+        }
+
+        // False when the file is missing or is not a table dump
+        bool open(const string& path) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) return false;
+            struct stat info;
+            if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(TableDumpHeader)) {
+                close(fd);
+                return false;
+            }
+            size = (size_t)info.st_size;
+            data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (data == MAP_FAILED) return false;
+
+            const char* bytes = static_cast<const char*>(data);
+            header = reinterpret_cast<const TableDumpHeader*>(bytes);
+            size_t tokens = header->tokenCount, symbols = header->symbolCount;
+            size_t expected = sizeof(TableDumpHeader) + 2 * alignedSection(tokens) + 3 * alignedSection(tokens * 4) +
+                              4 * alignedSection(symbols * 4) + alignedSection(((size_t)header->stringCount + 1) * 4) +
+                              alignedSection(header->stringBytes);
+            if (memcmp(header->magic, tableDumpMagic, sizeof(tableDumpMagic)) != 0 || expected != size) {
+                munmap(data, size);
+                data = MAP_FAILED;
+                return false;
+            }
+            const char* section = bytes + sizeof(TableDumpHeader);
+            auto take = [&](size_t sectionBytes) {
+                const char* start = section;
+                section += alignedSection(sectionBytes);
+                return start;
+            };
+            tokenKind = reinterpret_cast<const uint8_t*>(take(tokens));
+            tokenSubKind = reinterpret_cast<const uint8_t*>(take(tokens));
+            tokenLine = reinterpret_cast<const uint32_t*>(take(tokens * 4));
+            tokenOffset = reinterpret_cast<const uint32_t*>(take(tokens * 4));
+            tokenLength = reinterpret_cast<const uint32_t*>(take(tokens * 4));
+            symbolId = reinterpret_cast<const uint32_t*>(take(symbols * 4));
+            symbolName = reinterpret_cast<const uint32_t*>(take(symbols * 4));
+            symbolType = reinterpret_cast<const uint32_t*>(take(symbols * 4));
+            symbolScope = reinterpret_cast<const uint32_t*>(take(symbols * 4));
+            stringOffset = reinterpret_cast<const uint32_t*>(take(((size_t)header->stringCount + 1) * 4));
+            stringBytes = take(header->stringBytes);
+            return true;
+        }
+
+        uint32_t tokenCount() const { return header->tokenCount; }
+        uint32_t symbolCount() const { return header->symbolCount; }
+        const char* text(uint32_t stringId) const { return stringBytes + stringOffset[stringId]; }
+};
+
+int dumpTables(const Lexer& lexer, const string& path) {
+    if (!TableDumpWriter().write(lexer, path)) {
+        cerr << "Error: Could not write " << path << endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Prints a dump as the text tables the report would have shown
+int printTableDump(const string& path) {
+    MappedTableDump dump;
+    if (!dump.open(path)) {
+        cerr << "Error: No table dump at " << path << endl;
+        return 1;
+    }
+    cout << left << setw(8) << "Line"
+         << setw(15) << "Type"
+         << setw(20) << "Value" << endl;
+    cout << string(45, '-') << endl;
+    for (uint32_t k = 0; k < dump.tokenCount(); k++) {
+        cout << left << setw(8) << dump.tokenLine[k]
+             << setw(15) << tokenTypeToString((TokenType)dump.tokenKind[k])
+             << setw(20) << string(dump.stringBytes + dump.tokenOffset[k], dump.tokenLength[k]) << endl;
+    }
+
+    cout << "\n--- Symbol Table ---\n";
+    cout << left << setw(6) << "ID"
+         << setw(20) << "Name"
+         << setw(15) << "Type"
+         << setw(15) << "Scope" << endl;
+    cout << string(56, '-') << endl;
+    for (uint32_t k = 0; k < dump.symbolCount(); k++) {
+        cout << left << setw(6) << dump.symbolId[k]
+             << setw(20) << dump.text(dump.symbolName[k])
+             << setw(15) << dump.text(dump.symbolType[k])
+             << setw(15) << dump.text(dump.symbolScope[k]) << endl;
+    }
+    return 0;
+}
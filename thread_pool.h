@@ -0,0 +1,93 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+using namespace std;
+
+// Fixed set of worker threads taking tasks from one shared queue. wait() blocks until every
+// task submitted so far has finished and rethrows the first exception a task threw.
+class ThreadPool {
+    private:
+        vector<thread> workers;
+        deque<function<void()>> tasks;
+        mutex lock;
+        condition_variable available; // a task was queued or the pool is stopping
+        condition_variable drained;   // the queue is empty and no task is running
+        size_t running = 0;
+        bool stopping = false;
+        exception_ptr failure;
+
+        void work() {
+            unique_lock<mutex> guard(lock);
+            while (true) {
+                available.wait(guard, [&] { return stopping || !tasks.empty(); });
+                if (tasks.empty()) return;
+                function<void()> task = move(tasks.front());
+                tasks.pop_front();
+                running++;
+                guard.unlock();
+                try {
+                    task();
+                } catch (...) {
+                    guard.lock();
+                    if (!failure) failure = current_exception();
+                    guard.unlock();
+                }
+                guard.lock();
+                running--;
+                if (tasks.empty() && running == 0) drained.notify_all();
+            }
+        }
+
+    public:
+        explicit ThreadPool(size_t threads) {
+            if (threads == 0) threads = 1;
+            for (size_t k = 0; k < threads; k++) workers.emplace_back([this] { work(); });
+        }
+
+        ~ThreadPool() {
+            {
+                lock_guard<mutex> guard(lock);
+                stopping = true;
+            }
+            available.notify_all();
+            for (auto& worker : workers) worker.join();
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        size_t size() const { return workers.size(); }
+
+        void submit(function<void()> task) {
+            {
+                lock_guard<mutex> guard(lock);
+                tasks.push_back(move(task));
+            }
+            available.notify_one();
+        }
+
+        void wait() {
+            unique_lock<mutex> guard(lock);
+            drained.wait(guard, [&] { return tasks.empty() && running == 0; });
+            if (failure) {
+                exception_ptr error = failure;
+                failure = nullptr;
+                rethrow_exception(error);
+            }
+        }
+
+        // Runs body(0) .. body(count - 1) across the pool and waits for all of them
+        void forEach(size_t count, const function<void(size_t)>& body) {
+            for (size_t k = 0; k < count; k++) submit([&body, k] { body(k); });
+            wait();
+        }
+};
+
+#endif
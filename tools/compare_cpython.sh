@@ -0,0 +1,50 @@
+#!/bin/sh
+# Transpiles each script with --emit-cpp, builds it with the system C++ compiler and checks that
+# the native program prints the same output and exits the same way as CPython.
+# Usage: tools/compare_cpython.sh [path/to/parser] [script.py ...]   (default: bench/*.py)
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+PARSER=${1:-$ROOT/parser}
+[ $# -gt 0 ] && shift
+[ $# -eq 0 ] && set -- "$ROOT"/bench/*.py
+CXX=${CXX:-g++}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+failures=0
+for script in "$@"; do
+    name=$(basename "$script" .py)
+    if ! "$PARSER" --emit-cpp "$script" > "$WORK/$name.cpp"; then
+        echo "$name: transpile failed"
+        failures=$((failures + 1))
+        continue
+    fi
+    if ! "$CXX" -std=c++17 -O2 -I"$ROOT" -o "$WORK/$name" "$WORK/$name.cpp" 2> "$WORK/$name.log"; then
+        echo "$name: C++ build failed (see below)"
+        head -20 "$WORK/$name.log"
+        failures=$((failures + 1))
+        continue
+    fi
+
+    t0=$(date +%s.%N)
+    "$WORK/$name" < /dev/null > "$WORK/$name.native" 2> /dev/null
+    native_status=$?
+    t1=$(date +%s.%N)
+    python3 "$script" < /dev/null > "$WORK/$name.python" 2> /dev/null
+    python_status=$?
+    t2=$(date +%s.%N)
+
+    status=ok
+    if ! cmp -s "$WORK/$name.native" "$WORK/$name.python"; then
+        status="OUTPUT DIFFERS"
+    elif [ $((native_status != 0)) -ne $((python_status != 0)) ]; then
+        status="EXIT STATUS DIFFERS ($native_status vs $python_status)"
+    fi
+    [ "$status" = ok ] || failures=$((failures + 1))
+    awk -v n="$name" -v a="$t0" -v b="$t1" -v c="$t2" -v s="$status" \
+        'BEGIN { printf "%-12s native %7.3fs   python3 %7.3fs   %s\n", n, b - a, c - b, s }'
+    if [ "$status" = "OUTPUT DIFFERS" ]; then
+        diff "$WORK/$name.python" "$WORK/$name.native" | head -10
+    fi
+done
+
+[ $failures -eq 0 ]
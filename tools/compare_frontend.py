@@ -0,0 +1,387 @@
+#!/usr/bin/env python3
+"""Compares the lexer and parser with CPython's tokenize and ast modules, in speed and in output.
+
+Runs both front ends over the same files: ours through libpycompiler (pycompiler.h), loaded with
+ctypes, and CPython's through `tokenize.tokenize` and `ast.parse` in this interpreter. For every
+file it prints the throughput of each in MB/s (best of --repeat runs) and whether the two agree:
+
+  - tokens: the sequence of token kinds, with CPython's mapped onto ours (NAME is KEYWORD or
+    IDENTIFIER, NUMBER and STRING are LITERAL, OP is DELIMITER for ( ) [ ] { } , . : ; and
+    OPERATOR otherwise). COMMENT, NL, ENCODING and ENDMARKER have no counterpart and are skipped;
+  - statements: the statement kinds in preorder with their nesting depth. An elif chain counts
+    as clauses of one if statement, as our tree has it, and an expression statement is one
+    whatever the expression.
+
+A file that both reject counts as agreeing; one rejected by a single side is a disagreement. Every
+disagreement is listed at the end with the first place the two differ, and the exit status is 1
+when there is any.
+
+--generate N adds N generated files of about --lines lines each, written in the subset of Python
+the parser accepts, so that the agreement check covers more than the hand-written files.
+
+Usage: tools/compare_frontend.py [--lib build/libpycompiler.so] [--repeat 3] [--generate N]
+                                 [--lines 400] [--seed 1] [file.py | dir ...]
+       (default: example.py errors.py bench/*.py)
+"""
+import argparse
+import ast
+import ctypes
+import io
+import keyword
+import os
+import random
+import sys
+import time
+import tokenize
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# pyc_token_kind
+TOKEN_KINDS = ["IDENTIFIER", "KEYWORD", "OPERATOR", "LITERAL", "DELIMITER", "ERROR", "INDENT", "DEDENT", "NEWLINE"]
+DELIMITERS = set("()[]{},.:;")
+SKIPPED_TOKENS = {tokenize.COMMENT, tokenize.NL, tokenize.ENCODING, tokenize.ENDMARKER}
+
+# CPython statement classes under the names of our statement nodes
+STATEMENT_NAMES = {
+    "Import": "ImportStatement", "ImportFrom": "ImportStatement",
+    "Assign": "Assignment", "AugAssign": "Assignment", "AnnAssign": "Assignment",
+    "Expr": "ExpressionStatement", "If": "IfStatement", "While": "WhileStatement", "For": "ForStatement",
+    "FunctionDef": "FunctionDefinition", "ClassDef": "ClassDefinition", "Return": "ReturnStatement",
+    "Pass": "PassStatement", "Break": "BreakStatement", "Continue": "ContinueStatement",
+}
+
+
+def fail(message):
+    sys.stderr.write("Error: " + message + "\n")
+    sys.exit(1)
+
+
+# ---- Our front end, through libpycompiler ----
+
+class PycToken(ctypes.Structure):
+    _fields_ = [("kind", ctypes.c_int), ("line", ctypes.c_int), ("text", ctypes.c_char_p), ("length", ctypes.c_size_t)]
+
+
+class Library:
+    def __init__(self, path):
+        try:
+            lib = ctypes.CDLL(path)
+        except OSError as error:
+            fail("Could not load %s (%s); build it with cmake -S . -B build && cmake --build build" % (path, error))
+        voidp, size, charp = ctypes.c_void_p, ctypes.c_size_t, ctypes.c_char_p
+        signatures = {
+            "pyc_session_new": ([], voidp), "pyc_session_free": ([voidp], None),
+            "pyc_session_set_lean": ([voidp, ctypes.c_int], None),
+            "pyc_lex": ([voidp, charp, size], ctypes.c_int), "pyc_token_count": ([voidp], size),
+            "pyc_token_at": ([voidp, size], PycToken),
+            "pyc_parse": ([voidp, charp, size, ctypes.POINTER(voidp)], ctypes.c_int),
+            "pyc_tree_free": ([voidp], None), "pyc_error": ([voidp], charp), "pyc_tree_root": ([voidp], voidp),
+            "pyc_node_type": ([voidp], charp), "pyc_node_child_count": ([voidp], size),
+            "pyc_node_child": ([voidp, size], voidp),
+        }
+        for name, (arguments, result) in signatures.items():
+            function = getattr(lib, name)
+            function.argtypes = arguments
+            function.restype = result
+        self.lib = lib
+        self.session = lib.pyc_session_new()
+        lib.pyc_session_set_lean(self.session, 1)
+        # Compiles the lexer's regular expressions before anything is timed
+        lib.pyc_lex(self.session, b"x = 1\n", 6)
+
+    def error(self):
+        return self.lib.pyc_error(self.session).decode(errors="replace")
+
+    def lex(self, data):
+        """[(kind, text, line)], or the error message"""
+        if self.lib.pyc_lex(self.session, data, len(data)) != 0:
+            return self.error()
+        tokens = []
+        for k in range(self.lib.pyc_token_count(self.session)):
+            token = self.lib.pyc_token_at(self.session, k)
+            tokens.append((TOKEN_KINDS[token.kind], token.text.decode(errors="replace"), token.line))
+        return tokens
+
+    def parse(self, data):
+        """[(depth, statement kind)] in preorder, or the error message"""
+        tree = ctypes.c_void_p()
+        if self.lib.pyc_parse(self.session, data, len(data), ctypes.byref(tree)) != 0:
+            return self.error()
+        statements = []
+
+        def walk(node, depth):
+            kind = self.lib.pyc_node_type(node).decode()
+            inner = depth
+            if kind.endswith("Statement") or kind.endswith("Definition") or kind == "Assignment":
+                if kind == "FunctionCallStatement":
+                    kind = "ExpressionStatement"
+                statements.append((depth, kind))
+                inner = depth + 1
+            for k in range(self.lib.pyc_node_child_count(node)):
+                walk(self.lib.pyc_node_child(node, k), inner)
+
+        walk(self.lib.pyc_tree_root(tree), 0)
+        self.lib.pyc_tree_free(tree)
+        return statements
+
+    def time_lex(self, data):
+        start = time.perf_counter()
+        self.lib.pyc_lex(self.session, data, len(data))
+        return time.perf_counter() - start
+
+    def time_parse(self, data):
+        tree = ctypes.c_void_p()
+        start = time.perf_counter()
+        status = self.lib.pyc_parse(self.session, data, len(data), ctypes.byref(tree))
+        elapsed = time.perf_counter() - start
+        if status == 0:
+            self.lib.pyc_tree_free(tree)
+        return elapsed
+
+
+# ---- CPython's front end ----
+
+def cpython_tokens(data):
+    """Tokens mapped onto our kinds, or the error message"""
+    tokens = []
+    try:
+        for token in tokenize.tokenize(io.BytesIO(data).readline):
+            if token.type in SKIPPED_TOKENS:
+                continue
+            if token.type == tokenize.ERRORTOKEN:
+                return "%s on line %d" % (tokenize.tok_name[token.type], token.start[0])
+            if token.type == tokenize.NAME:
+                kind = "KEYWORD" if keyword.iskeyword(token.string) else "IDENTIFIER"
+            elif token.type in (tokenize.NUMBER, tokenize.STRING):
+                kind = "LITERAL"
+            elif token.type == tokenize.OP:
+                kind = "DELIMITER" if token.string in DELIMITERS else "OPERATOR"
+            else:
+                kind = tokenize.tok_name[token.type]
+            tokens.append((kind, token.string, token.start[0]))
+    except (tokenize.TokenError, SyntaxError) as error:
+        return str(error)
+    return tokens
+
+
+def cpython_statements(data):
+    """[(depth, statement kind)] in preorder, or the error message"""
+    try:
+        module = ast.parse(data)
+    except (SyntaxError, ValueError) as error:
+        return str(error)
+    lines = data.decode(errors="replace").splitlines()
+    statements = []
+
+    def is_elif(statement):
+        return isinstance(statement, ast.If) and lines[statement.lineno - 1].lstrip().startswith("elif")
+
+    def walk(body, depth):
+        for statement in body:
+            statements.append((depth, STATEMENT_NAMES.get(type(statement).__name__, type(statement).__name__)))
+            walk_inside(statement, depth + 1)
+
+    def walk_inside(statement, depth):
+        walk(getattr(statement, "body", []), depth)
+        orelse = getattr(statement, "orelse", [])
+        # An elif is a clause of the if it follows rather than a statement nested in its else
+        while len(orelse) == 1 and is_elif(orelse[0]):
+            walk(orelse[0].body, depth)
+            orelse = orelse[0].orelse
+        walk(orelse, depth)
+
+    walk(module.body, 0)
+    return statements
+
+
+def timed(function, data):
+    start = time.perf_counter()
+    try:
+        function(data)
+    except Exception:
+        pass
+    return time.perf_counter() - start
+
+
+def drain_tokens(data):
+    for _ in tokenize.tokenize(io.BytesIO(data).readline):
+        pass
+
+
+# ---- Comparison ----
+
+def compare(what, ours, theirs, describe):
+    """None when the results agree, otherwise the first difference"""
+    our_error, their_error = isinstance(ours, str), isinstance(theirs, str)
+    if our_error and their_error:
+        return None
+    if our_error:
+        return "%s: ours rejects (%s), CPython accepts" % (what, ours)
+    if their_error:
+        return "%s: CPython rejects (%s), ours accepts" % (what, theirs)
+    for k, (mine, reference) in enumerate(zip(ours, theirs)):
+        if describe(mine) != describe(reference):
+            return "%s: #%d is %s, CPython has %s" % (what, k, format_item(mine), format_item(reference))
+    if len(ours) != len(theirs):
+        longer, name = (ours, "ours") if len(ours) > len(theirs) else (theirs, "CPython")
+        return "%s: %s has %d more, from %s" % (what, name, abs(len(ours) - len(theirs)), format_item(longer[min(len(ours), len(theirs))]))
+    return None
+
+
+def format_item(item):
+    if isinstance(item[0], int):
+        return "%s at depth %d" % (item[1], item[0])
+    return "%s %r on line %d" % item
+
+
+def status(ours, theirs, difference):
+    if difference:
+        return "DIFFERS"
+    return "both reject" if isinstance(ours, str) and isinstance(theirs, str) else "ok"
+
+
+# ---- Generated input ----
+
+def generate(random_state, lines):
+    """A program of about 'lines' lines in the subset both front ends accept"""
+    out = []
+    names = ["a", "b", "count", "total", "value", "items", "k"]
+
+    def expression(depth=0):
+        choice = random_state.randrange(6 if depth < 2 else 3)
+        if choice == 0:
+            return str(random_state.randrange(1000))
+        if choice == 1:
+            return random_state.choice(names)
+        if choice == 2:
+            return '"s%d"' % random_state.randrange(100)
+        if choice == 3:
+            return "%s %s %s" % (expression(depth + 1), random_state.choice("+-*/%"), expression(depth + 1))
+        if choice == 4:
+            return "(%s)" % expression(depth + 1)
+        return "[%s, %s]" % (expression(depth + 1), expression(depth + 1))
+
+    def condition():
+        return "%s %s %s" % (random_state.choice(names), random_state.choice(["<", ">", "==", "!=", "<=", ">="]), expression(1))
+
+    def block(indent, depth, in_loop):
+        for _ in range(random_state.randrange(1, 4)):
+            statement(indent, depth, in_loop)
+
+    def statement(indent, depth, in_loop):
+        pad = "    " * indent
+        choice = random_state.randrange(9 if depth < 3 else 4)
+        if choice == 0:
+            out.append("%s%s = %s" % (pad, random_state.choice(names), expression()))
+        elif choice == 1:
+            out.append("%s%s += %s" % (pad, random_state.choice(names), expression()))
+        elif choice == 2:
+            out.append("%sprint(%s)" % (pad, expression()))
+        elif choice == 3:
+            out.append(pad + (random_state.choice(["break", "continue"]) if in_loop else "pass"))
+        elif choice in (4, 5):
+            out.append("%sif %s:" % (pad, condition()))
+            block(indent + 1, depth + 1, in_loop)
+            for _ in range(random_state.randrange(3)):
+                out.append("%selif %s:" % (pad, condition()))
+                block(indent + 1, depth + 1, in_loop)
+            if random_state.randrange(2):
+                out.append(pad + "else:")
+                block(indent + 1, depth + 1, in_loop)
+        elif choice == 6:
+            out.append("%sfor %s in range(%d):" % (pad, random_state.choice(names), random_state.randrange(1, 50)))
+            block(indent + 1, depth + 1, True)
+        elif choice == 7:
+            out.append("%swhile %s:" % (pad, condition()))
+            block(indent + 1, depth + 1, True)
+        else:
+            out.append("%sif %s:" % (pad, condition()))
+            out.append("%s    return %s" % (pad, expression()) if indent else "%s    pass" % pad)
+
+    definition = 0
+    while len(out) < lines:
+        if random_state.randrange(4) == 0:
+            out.append("class Shape%d:" % definition)
+            out.append("    def area(self, k):")
+            out.append("        self.k = k")
+            block(2, 1, False)
+            out.append("        return self.k")
+            out.append("shape%d = Shape%d()" % (definition, definition))
+        else:
+            out.append("def step%d(a, b):" % definition)
+            block(1, 0, False)
+            out.append("    return a + b")
+            out.append("print(step%d(%d, %d))" % (definition, definition, definition + 1))
+        definition += 1
+    return ("\n".join(out) + "\n").encode()
+
+
+# ---- Driver ----
+
+def collect(paths):
+    files = []
+    for path in paths:
+        if os.path.isdir(path):
+            for directory, _, names in sorted(os.walk(path)):
+                files.extend(os.path.join(directory, name) for name in sorted(names) if name.endswith(".py"))
+        else:
+            files.append(path)
+    return files
+
+
+def rate(size, seconds):
+    return "%9.2f" % (size / seconds / 1e6) if seconds > 0 else "%9s" % "-"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("paths", nargs="*")
+    parser.add_argument("--lib", default=os.path.join(ROOT, "build", "libpycompiler.so"))
+    parser.add_argument("--repeat", type=int, default=3)
+    parser.add_argument("--generate", type=int, default=0)
+    parser.add_argument("--lines", type=int, default=400)
+    parser.add_argument("--seed", type=int, default=1)
+    options = parser.parse_args()
+
+    paths = options.paths or [os.path.join(ROOT, "example.py"), os.path.join(ROOT, "errors.py"), os.path.join(ROOT, "bench")]
+    files = [(os.path.relpath(path), open(path, "rb").read()) for path in collect(paths)]
+    random_state = random.Random(options.seed)
+    for k in range(options.generate):
+        files.append(("generated_%d.py" % k, generate(random_state, options.lines)))
+    if not files:
+        fail("No .py files to compare")
+
+    ours = Library(options.lib)
+    repeat = max(1, options.repeat)
+    print("%-28s %9s %9s %9s %9s %9s  %-11s %s" % ("File", "KB", "tokenize", "ast", "our lex", "our parse", "Tokens", "Statements"))
+    print("%-28s %9s %9s %9s %9s %9s" % ("", "", "MB/s", "MB/s", "MB/s", "MB/s"))
+    totals = [0.0, 0.0, 0.0, 0.0]
+    total_bytes = 0
+    differences = []
+    for name, data in files:
+        times = [min(measure(data) for _ in range(repeat))
+                 for measure in (lambda d: timed(drain_tokens, d), lambda d: timed(ast.parse, d), ours.time_lex, ours.time_parse)]
+        total_bytes += len(data)
+        for k, seconds in enumerate(times):
+            totals[k] += seconds
+
+        our_tokens, their_tokens = ours.lex(data), cpython_tokens(data)
+        token_difference = compare("tokens", our_tokens, their_tokens, lambda token: token[0])
+        our_statements, their_statements = ours.parse(data), cpython_statements(data)
+        statement_difference = compare("statements", our_statements, their_statements, lambda statement: statement)
+        differences.extend("%s: %s" % (name, difference) for difference in (token_difference, statement_difference) if difference)
+
+        print("%-28s %9.1f %s %s %s %s  %-11s %s" % (name[-28:], len(data) / 1e3, *(rate(len(data), seconds) for seconds in times),
+                                                   status(our_tokens, their_tokens, token_difference),
+                                                   status(our_statements, their_statements, statement_difference)))
+    print("%-28s %9.1f %s %s %s %s" % ("total", total_bytes / 1e3, *(rate(total_bytes, seconds) for seconds in totals)))
+
+    if differences:
+        print("\nDisagreements:")
+        for difference in differences:
+            print("  " + difference)
+    return 1 if differences else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,439 @@
+#!/usr/bin/env python3
+"""Generates parse_tables.h from grammar.txt.
+
+Reads the EBNF rules, computes nullable, FIRST and FOLLOW sets and emits one dense row per
+decision point of the grammar, indexed by token kind:
+
+  - a rule or parenthesised group with several alternatives gets a row holding the number of the
+    alternative to take (from 1), 0 when none starts with the token, or PARSE_CONFLICT when more
+    than one does and the parser has to look further ahead;
+  - an optional or repeated group ([x], x?, x*, x+) gets a row holding 1 when the token starts
+    the group. Where such a token may also follow the group, entering wins, like a shifting
+    LR parser; these overlaps are listed in the header next to the true conflicts.
+
+Usage: tools/gen_parse_tables.py [grammar.txt] > parse_tables.h
+"""
+import re
+import sys
+
+TOKEN_CLASSES = ["NAME", "NUMBER", "STRING", "NEWLINE", "INDENT", "DEDENT"]
+
+SYMBOL_NAMES = {
+    "(": "LPAREN", ")": "RPAREN", "[": "LBRACKET", "]": "RBRACKET", "{": "LBRACE", "}": "RBRACE",
+    ",": "COMMA", ":": "COLON", ".": "DOT", ";": "SEMICOLON",
+    "=": "ASSIGN", "+=": "PLUS_ASSIGN", "-=": "MINUS_ASSIGN", "*=": "STAR_ASSIGN",
+    "/=": "SLASH_ASSIGN", "%=": "PERCENT_ASSIGN", "//=": "DOUBLE_SLASH_ASSIGN",
+    "+": "PLUS", "-": "MINUS", "*": "STAR", "/": "SLASH", "//": "DOUBLE_SLASH", "%": "PERCENT",
+    "~": "TILDE", "<": "LESS", ">": "GREATER", "==": "EQUAL", "!=": "NOT_EQUAL",
+    "<=": "LESS_EQUAL", ">=": "GREATER_EQUAL",
+}
+
+
+def fail(message):
+    sys.stderr.write("gen_parse_tables: " + message + "\n")
+    sys.exit(1)
+
+
+# ---- Reading the grammar ----
+
+def read_rules(text):
+    """Returns [(name, rhs text)] for the syntactic rules, in file order."""
+    rules = []
+    for raw in text.splitlines():
+        line = strip_comment(raw).rstrip()
+        if not line.strip():
+            continue
+        if not raw[0].isspace():
+            name, sep, rhs = line.partition(":")
+            if not sep:
+                fail("expected 'name: ...' in line: " + raw)
+            rules.append([name.strip(), rhs])
+        elif rules:
+            rules[-1][1] += " " + line.strip()
+    # Upper-case rules describe the lexer's tokens
+    return [(name, rhs) for name, rhs in rules if not name.isupper()]
+
+
+def strip_comment(line):
+    quoted = False
+    for k, c in enumerate(line):
+        if c == "'":
+            quoted = not quoted
+        elif c == "#" and not quoted:
+            return line[:k]
+    return line
+
+
+def tokenize(rhs):
+    tokens = re.findall(r"'[^']*'|[A-Za-z_][A-Za-z0-9_]*|[|()\[\]*+?]", rhs)
+    if re.sub(r"'[^']*'|[A-Za-z_][A-Za-z0-9_]*|[|()\[\]*+?]|\s", "", rhs):
+        fail("unexpected characters in rule: " + rhs)
+    return tokens
+
+
+class Node:
+    """kind is 'alt', 'seq', 'opt', 'star', 'plus', 'term' or 'rule'"""
+    def __init__(self, kind, items=None, name=None):
+        self.kind = kind
+        self.items = items or []
+        self.name = name
+
+
+class RuleParser:
+    def __init__(self, tokens):
+        self.tokens = tokens
+        self.pos = 0
+
+    def peek(self):
+        return self.tokens[self.pos] if self.pos < len(self.tokens) else None
+
+    def parse_alt(self):
+        seqs = [self.parse_seq()]
+        while self.peek() == "|":
+            self.pos += 1
+            seqs.append(self.parse_seq())
+        return seqs[0] if len(seqs) == 1 else Node("alt", seqs)
+
+    def parse_seq(self):
+        items = []
+        while self.peek() not in (None, "|", ")", "]"):
+            items.append(self.parse_postfix())
+        if not items:
+            fail("empty alternative")
+        return items[0] if len(items) == 1 else Node("seq", items)
+
+    def parse_postfix(self):
+        node = self.parse_primary()
+        while self.peek() in ("*", "+", "?"):
+            kind = {"*": "star", "+": "plus", "?": "opt"}[self.tokens[self.pos]]
+            self.pos += 1
+            node = Node(kind, [node])
+        return node
+
+    def parse_primary(self):
+        token = self.peek()
+        self.pos += 1
+        if token == "(":
+            node = self.parse_alt()
+            self.expect(")")
+            return node
+        if token == "[":
+            node = Node("opt", [self.parse_alt()])
+            self.expect("]")
+            return node
+        if token is None or token in "|)]*+?":
+            fail("unexpected '%s'" % token)
+        if token.startswith("'"):
+            return Node("term", name=terminal_name(token[1:-1]))
+        if token in TOKEN_CLASSES:
+            return Node("term", name=token)
+        return Node("rule", name=token)
+
+    def expect(self, token):
+        if self.peek() != token:
+            fail("expected '%s'" % token)
+        self.pos += 1
+
+
+def terminal_name(spelling):
+    if spelling.isidentifier():
+        return "KW_" + spelling.upper()
+    if spelling not in SYMBOL_NAMES:
+        fail("no name for symbol '%s'; add it to SYMBOL_NAMES" % spelling)
+    return SYMBOL_NAMES[spelling]
+
+
+# ---- FIRST and FOLLOW ----
+
+class Grammar:
+    def __init__(self, rules):
+        self.order = [name for name, _ in rules]
+        self.rules = {}
+        for name, rhs in rules:
+            parser = RuleParser(tokenize(rhs))
+            self.rules[name] = parser.parse_alt()
+            if parser.peek() is not None:
+                fail("trailing '%s' in rule %s" % (parser.peek(), name))
+        for node in self.walk_all():
+            if node.kind == "rule" and node.name not in self.rules:
+                fail("undefined rule " + node.name)
+        self.nullable_rules = set()
+        self.first_rules = {name: set() for name in self.rules}
+        self.follow_rules = {name: set() for name in self.rules}
+        self.follow_nodes = {}
+        self.compute_first()
+        self.compute_follow()
+
+    def walk_all(self):
+        for name in self.order:
+            yield from walk(self.rules[name])
+
+    def nullable(self, node):
+        if node.kind == "term":
+            return False
+        if node.kind == "rule":
+            return node.name in self.nullable_rules
+        if node.kind in ("opt", "star"):
+            return True
+        if node.kind == "alt":
+            return any(self.nullable(item) for item in node.items)
+        return all(self.nullable(item) for item in node.items)  # seq, plus
+
+    def first(self, node):
+        if node.kind == "term":
+            return {node.name}
+        if node.kind == "rule":
+            return self.first_rules[node.name]
+        if node.kind == "seq":
+            result = set()
+            for item in node.items:
+                result |= self.first(item)
+                if not self.nullable(item):
+                    break
+            return result
+        return set().union(*(self.first(item) for item in node.items))
+
+    def first_of_sequence(self, items):
+        return self.first(Node("seq", items)) if items else set()
+
+    def compute_first(self):
+        changed = True
+        while changed:
+            changed = False
+            for name in self.order:
+                body = self.rules[name]
+                if self.nullable(body) and name not in self.nullable_rules:
+                    self.nullable_rules.add(name)
+                    changed = True
+                first = self.first(body)
+                if not first <= self.first_rules[name]:
+                    self.first_rules[name] |= first
+                    changed = True
+
+    def compute_follow(self):
+        # The program rule may be followed by the end of input
+        self.follow_rules[self.order[0]].add("END")
+        changed = True
+        while changed:
+            changed = False
+            for name in self.order:
+                changed |= self.spread_follow(self.rules[name], set(self.follow_rules[name]))
+
+    def spread_follow(self, node, follow):
+        changed = False
+        if id(node) not in self.follow_nodes:
+            self.follow_nodes[id(node)] = set()
+        if not follow <= self.follow_nodes[id(node)]:
+            self.follow_nodes[id(node)] |= follow
+            changed = True
+        follow = self.follow_nodes[id(node)]
+        if node.kind == "rule":
+            if not follow <= self.follow_rules[node.name]:
+                self.follow_rules[node.name] |= follow
+                changed = True
+        elif node.kind == "alt":
+            for item in node.items:
+                changed |= self.spread_follow(item, follow)
+        elif node.kind == "seq":
+            for k, item in enumerate(node.items):
+                rest = node.items[k + 1:]
+                after = set(self.first_of_sequence(rest))
+                if all(self.nullable(r) for r in rest):
+                    after |= follow
+                changed |= self.spread_follow(item, after)
+        elif node.kind in ("star", "plus"):
+            changed |= self.spread_follow(node.items[0], follow | self.first(node.items[0]))
+        elif node.kind == "opt":
+            changed |= self.spread_follow(node.items[0], follow)
+        return changed
+
+
+def walk(node):
+    yield node
+    for item in node.items:
+        yield from walk(item)
+
+
+def leading_symbol(node):
+    while node.kind not in ("term", "rule"):
+        node = node.items[0]
+    return node.name
+
+
+def alternative_tag(node):
+    if node.kind in ("term", "rule"):
+        return node.name
+    return leading_symbol(node)
+
+
+# ---- Decision points ----
+
+class Decision:
+    def __init__(self, name, rule, node, row, kind):
+        self.name = name
+        self.rule = rule
+        self.node = node
+        self.row = row
+        self.kind = kind  # 'alt' or 'group'
+
+
+def unique(name, used):
+    candidate, n = name, 2
+    while candidate in used:
+        candidate = "%s_%d" % (name, n)
+        n += 1
+    used.add(candidate)
+    return candidate
+
+
+def build_decisions(grammar, kinds):
+    decisions, notes, used = [], [], set()
+    alternatives = []
+    for rule in grammar.order:
+        for node in walk(grammar.rules[rule]):
+            if node.kind == "alt":
+                top = node is grammar.rules[rule]
+                base = rule.upper() if top else rule.upper() + "_ALT"
+                name = unique("D_" + base, used)
+                row = [0] * len(kinds)
+                tags = []
+                for number, item in enumerate(node.items, 1):
+                    tag = unique(name[2:] + "_" + alternative_tag(item).upper(), used)
+                    tags.append(tag)
+                    alternatives.append((tag, number))
+                    predict = set(grammar.first(item))
+                    if grammar.nullable(item):
+                        predict |= grammar.follow_nodes[id(node)]
+                    for kind in predict:
+                        index = kinds.index(kind)
+                        row[index] = number if row[index] == 0 else "PARSE_CONFLICT"
+                conflicts = {}
+                for index, cell in enumerate(row):
+                    if cell == "PARSE_CONFLICT":
+                        choices = " | ".join(tags[k] for k, item in enumerate(node.items)
+                                             if kinds[index] in grammar.first(item))
+                        conflicts.setdefault(choices, []).append(kinds[index])
+                for choices, on in conflicts.items():
+                    notes.append("%s on %s: %s" % (name, ", ".join(on), choices))
+                decisions.append(Decision(name, rule, node, row, "alt"))
+            elif node.kind in ("opt", "star", "plus"):
+                name = unique("D_%s_%s" % (rule.upper(), leading_symbol(node).upper()), used)
+                inner = node.items[0]
+                starts = grammar.first(inner)
+                row = [1 if kind in starts else 0 for kind in kinds]
+                overlap = starts & grammar.follow_nodes.get(id(node), set())
+                if overlap:
+                    notes.append("%s enters on %s, which may also follow it" %
+                                 (name, ", ".join(sorted(overlap))))
+                decisions.append(Decision(name, rule, node, row, "group"))
+    return decisions, alternatives, notes
+
+
+# ---- Output ----
+
+def emit(grammar, source):
+    terminals = set()
+    for node in grammar.walk_all():
+        if node.kind == "term":
+            terminals.add(node.name)
+    spellings = {}
+    for spelling, name in SYMBOL_NAMES.items():
+        if name in terminals:
+            spellings[spelling] = name
+    for name in terminals:
+        if name.startswith("KW_"):
+            spellings[name[3:].capitalize() if name[3:] in ("NONE", "TRUE", "FALSE") else name[3:].lower()] = name
+    kinds = ["OTHER", "END"] + TOKEN_CLASSES + sorted(terminals - set(TOKEN_CLASSES))
+    decisions, alternatives, notes = build_decisions(grammar, kinds)
+
+    out = []
+    out.append("// Generated by tools/gen_parse_tables.py from %s; do not edit." % source)
+    out.append("// Regenerate after changing the grammar:")
+    out.append("//     python3 tools/gen_parse_tables.py %s > parse_tables.h" % source)
+    out.append("//")
+    out.append("// Decisions the tables cannot make with one token of lookahead; the parser resolves them:")
+    for note in notes:
+        out.append("//   " + note)
+    out.append("")
+    out.append("#ifndef PARSE_TABLES_H")
+    out.append("#define PARSE_TABLES_H")
+    out.append("")
+    out.append("#include <cctype>")
+    out.append("#include <cstdint>")
+    out.append("#include <string>")
+    out.append("#include <unordered_map>")
+    out.append('#include "definitions.h"')
+    out.append("")
+    out.append("// Token sub-kinds: one per keyword, operator and delimiter the grammar mentions")
+    out.append("enum TokenKind : uint8_t {")
+    out.append(wrap(["TK_" + kind + "," for kind in kinds] + ["TOKEN_KIND_COUNT"]))
+    out.append("};")
+    out.append("")
+    out.append("inline const unordered_map<string, TokenKind>& tokenSpellings() {")
+    out.append("    static const unordered_map<string, TokenKind> spellings = {")
+    out.append(wrap(['{"%s", TK_%s},' % (s, n) for s, n in sorted(spellings.items(), key=lambda p: p[1])],
+                    indent=8))
+    out.append("    };")
+    out.append("    return spellings;")
+    out.append("}")
+    out.append("")
+    out.append("inline TokenKind tokenKindOf(const Token& token) {")
+    out.append("    switch (token.type) {")
+    out.append("        case IDENTIFIER: return TK_NAME;")
+    out.append("        case LITERAL: return isdigit((unsigned char)token.value[0]) ? TK_NUMBER : TK_STRING;")
+    out.append("        case NEWLINE: return TK_NEWLINE;")
+    out.append("        case INDENT: return TK_INDENT;")
+    out.append("        case DEDENT: return TK_DEDENT;")
+    out.append("        case KEYWORD:")
+    out.append("        case OPERATOR:")
+    out.append("        case DELIMITER: {")
+    out.append("            auto found = tokenSpellings().find(token.value);")
+    out.append("            return found != tokenSpellings().end() ? found->second : TK_OTHER;")
+    out.append("        }")
+    out.append("        default: return TK_OTHER;")
+    out.append("    }")
+    out.append("}")
+    out.append("")
+    out.append("enum ParseDecision : uint8_t {")
+    out.append(wrap([d.name + "," for d in decisions] + ["PARSE_DECISION_COUNT"]))
+    out.append("};")
+    out.append("")
+    out.append("// Alternatives of each multi-way decision, numbered from 1 in grammar order")
+    out.append("enum ParseAlternative : uint8_t {")
+    out.append(wrap(["%s = %d," % (tag, number) for tag, number in alternatives]))
+    out.append("};")
+    out.append("")
+    out.append("const uint8_t PARSE_CONFLICT = 0xFF;")
+    out.append("")
+    out.append("// parseTable[decision][token kind]: the alternative to take, or 1 to enter an optional or")
+    out.append("// repeated group; 0 when the token cannot start it")
+    out.append("const uint8_t parseTable[PARSE_DECISION_COUNT][TOKEN_KIND_COUNT] = {")
+    for decision in decisions:
+        out.append("    // " + decision.name)
+        out.append("    {" + wrap([str(cell) + "," for cell in decision.row], indent=0)[:-1].replace("\n", "\n     ") + "},")
+    out.append("};")
+    out.append("")
+    out.append("#endif")
+    return "\n".join(out) + "\n"
+
+
+def wrap(words, indent=4, width=100):
+    lines, line = [], " " * indent
+    for word in words:
+        if len(line) + len(word) + 1 > width and line.strip():
+            lines.append(line.rstrip())
+            line = " " * indent
+        line += word + " "
+    lines.append(line.rstrip())
+    return "\n".join(lines)
+
+
+def main():
+    path = sys.argv[1] if len(sys.argv) > 1 else "grammar.txt"
+    with open(path) as f:
+        grammar = Grammar(read_rules(f.read()))
+    sys.stdout.write(emit(grammar, path.rsplit("/", 1)[-1]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,14 @@
+#!/bin/sh
+# Prints the optimizer's node counts for each script and the total over all of them.
+# Usage: tools/opt_stats.sh [path/to/parser] [script.py ...]   (default: bench/*.py example.py)
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+PARSER=${1:-$ROOT/parser}
+[ $# -gt 0 ] && shift
+[ $# -eq 0 ] && set -- "$ROOT"/bench/*.py "$ROOT"/example.py
+
+for script in "$@"; do
+    line=$("$PARSER" --opt-stats "$script" 2>&1 >/dev/null | grep '^Optimizer:')
+    [ -n "$line" ] || { echo "$(basename "$script"): no parse tree" >&2; continue; }
+    echo "$(basename "$script" .py) $line"
+done | awk '{ printf "%-12s %6d -> %6d nodes\n", $1, $3, $5; before += $3; after += $5 }
+    END { if (before) printf "%-12s %6d -> %6d nodes (%.1f%% fewer)\n", "total", before, after, (before - after) * 100 / before }'
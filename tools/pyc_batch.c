@@ -0,0 +1,64 @@
+// Lexes and parses every file named on the command line with one libpycompiler session and
+// prints the totals, e.g. to time the library on many files in one process.
+// Usage: pyc_batch [--lean] file.py ...
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pycompiler.h"
+
+static size_t countNodes(const pyc_node* node) {
+    size_t count = 1;
+    for (size_t k = 0; k < pyc_node_child_count(node); k++) count += countNodes(pyc_node_child(node, k));
+    return count;
+}
+
+static char* readFile(const char* path, size_t* length) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* data = malloc(size > 0 ? (size_t)size : 1);
+    *length = data ? fread(data, 1, (size_t)size, file) : 0;
+    fclose(file);
+    return data;
+}
+
+int main(int argc, char** argv) {
+    pyc_session* session = pyc_session_new();
+    if (!session) return 1;
+    size_t files = 0, failures = 0, tokens = 0, nodes = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--lean") == 0) {
+            pyc_session_set_lean(session, 1);
+            continue;
+        }
+        size_t length;
+        char* source = readFile(argv[i], &length);
+        if (!source) {
+            fprintf(stderr, "Error: Could not open file %s\n", argv[i]);
+            failures++;
+            continue;
+        }
+        pyc_tree* tree;
+        pyc_status status = pyc_parse(session, source, length, &tree);
+        free(source);
+        files++;
+        tokens += pyc_token_count(session);
+        if (status != PYC_OK) {
+            fprintf(stderr, "%s: %s\n", argv[i], pyc_error(session));
+            failures++;
+            continue;
+        }
+        nodes += countNodes(pyc_tree_root(tree));
+        pyc_tree_free(tree);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    printf("%zu files, %zu failed, %zu tokens, %zu nodes in %.1f ms\n", files, failures, tokens, nodes, ms);
+    pyc_session_free(session);
+    return failures ? 1 : 0;
+}
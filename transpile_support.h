@@ -0,0 +1,217 @@
+#ifndef TRANSPILE_SUPPORT_H
+#define TRANSPILE_SUPPORT_H
+
+#include "runtime.cpp"
+
+// Support code for the C++ emitted by CppTranspiler. Dynamic values use the same runtime as the
+// bytecode VM; variables proven to be int, float, str or bool are plain C++ types and use the
+// helpers below. The generated file defines invokeFunction.
+
+Value invokeFunction(int index, Value* args);
+
+const int maxCallDepth = 1000;
+int callDepth = 0;
+
+struct CallDepthGuard {
+    CallDepthGuard() {
+        if (++callDepth >= maxCallDepth) {
+            callDepth--;
+            runtimeError("RecursionError: maximum recursion depth exceeded");
+        }
+    }
+    ~CallDepthGuard() { callDepth--; }
+};
+
+// ---- Native arithmetic with the runtime's semantics ----
+
+[[noreturn]] void integerOverflow() {
+    runtimeError("OverflowError: integer result does not fit in 64 bits");
+}
+
+inline long long addInt(long long a, long long b) {
+    long long r;
+    if (__builtin_add_overflow(a, b, &r)) integerOverflow();
+    return r;
+}
+
+inline long long subInt(long long a, long long b) {
+    long long r;
+    if (__builtin_sub_overflow(a, b, &r)) integerOverflow();
+    return r;
+}
+
+inline long long mulInt(long long a, long long b) {
+    long long r;
+    if (__builtin_mul_overflow(a, b, &r)) integerOverflow();
+    return r;
+}
+
+inline long long negInt(long long a) {
+    if (a == LLONG_MIN) integerOverflow();
+    return -a;
+}
+
+inline double divInt(long long a, long long b) { return intArithmetic(BIN_DIV, a, b).f; }
+inline long long floorDivInt(long long a, long long b) { return intArithmetic(BIN_FLOORDIV, a, b).i; }
+inline long long modInt(long long a, long long b) { return intArithmetic(BIN_MOD, a, b).i; }
+inline double divFloat(double a, double b) { return floatArithmetic(BIN_DIV, a, b).f; }
+inline double floorDivFloat(double a, double b) { return floatArithmetic(BIN_FLOORDIV, a, b).f; }
+inline double modFloat(double a, double b) { return floatArithmetic(BIN_MOD, a, b).f; }
+
+inline string unboxStr(const Value& v) { return asStr(v)->s; }
+
+// Dynamic operands that turn out to be ints skip the generic runtime path; 'op' is a constant at
+// every call site, so the switch folds away
+inline Value binaryFast(BinaryOperator op, const Value& a, const Value& b) {
+    if (a.kind == V_INT && b.kind == V_INT) {
+        switch (op) {
+            case BIN_ADD: return Value::integer(addInt(a.i, b.i));
+            case BIN_SUB: return Value::integer(subInt(a.i, b.i));
+            case BIN_MUL: return Value::integer(mulInt(a.i, b.i));
+            default: return intArithmetic(op, a.i, b.i);
+        }
+    }
+    return binaryOp(op, a, b);
+}
+
+inline int compareFast(const Value& a, const Value& b, const char* op) {
+    if (a.kind == V_INT && b.kind == V_INT) return (a.i > b.i) - (a.i < b.i);
+    return compareValues(a, b, op);
+}
+
+// ---- Names ----
+
+inline const Value& checkGlobal(const Value& v, const char* name) {
+    if (v.kind == V_UNDEF) runtimeError(string("NameError: name '") + name + "' is not defined");
+    return v;
+}
+
+inline const Value& checkLocal(const Value& v, const char* name) {
+    if (v.kind == V_UNDEF) runtimeError(string("UnboundLocalError: local variable '") + name + "' referenced before assignment");
+    return v;
+}
+
+[[noreturn]] Value undefinedName(const char* name) {
+    runtimeError(string("NameError: name '") + name + "' is not defined");
+}
+
+// ---- Containers ----
+
+template <size_t N>
+Value makeDictFrom(Value (&&keysAndValues)[N]) {
+    Value dict = makeDict();
+    for (size_t k = 0; k < N; k += 2) {
+        hashValue(keysAndValues[k]);
+        asDict(dict)->set(keysAndValues[k], keysAndValues[k + 1]);
+    }
+    return dict;
+}
+
+inline Value subscriptInt(const Value& container, long long index) {
+    if (container.kind == V_LIST && index >= 0 && index < (long long)asList(container)->items.size()) {
+        return asList(container)->items[index];
+    }
+    return getItem(container, Value::integer(index));
+}
+
+void unpackInto(const Value& sequence, vector<Value>& items, size_t count) {
+    items = collectItems(sequence);
+    if (items.size() != count) {
+        runtimeError("ValueError: expected " + to_string(count) + " values to unpack, got " + to_string(items.size()));
+    }
+}
+
+// ---- Calls ----
+
+[[noreturn]] void arityError(const string& name, int expected, int given) {
+    runtimeError("TypeError: " + name + "() takes " + to_string(expected) +
+                 " positional arguments but " + to_string(given) + " were given");
+}
+
+// Calls a user function with 'self' placed in front of the arguments
+Value invokeWithSelf(FunctionObject* function, const Value& self, Value* args, int argc) {
+    if (function->arity != argc + 1) arityError(function->name, function->arity - 1, argc);
+    vector<Value> withSelf;
+    withSelf.reserve(argc + 1);
+    withSelf.push_back(self);
+    for (int k = 0; k < argc; k++) withSelf.push_back(args[k]);
+    return invokeFunction(function->index, withSelf.data());
+}
+
+Value callValue(const Value& callee, Value* args, int argc) {
+    switch (callee.kind) {
+        case V_FUNC: {
+            FunctionObject* function = asFunction(callee);
+            if (function->arity != argc) arityError(function->name, function->arity, argc);
+            return invokeFunction(function->index, args);
+        }
+        case V_BUILTIN:
+            return builtinTable()[callee.builtin].function(args, argc);
+        case V_BOUND:
+            return invokeWithSelf(asFunction(asBound(callee)->function), asBound(callee)->self, args, argc);
+        case V_CLASS: {
+            Value instance = makeInstance(callee);
+            Value* init = findClassAttribute(callee, "__init__");
+            if (init && init->kind == V_FUNC) {
+                invokeWithSelf(asFunction(*init), instance, args, argc);
+            } else if (argc != 0) {
+                runtimeError("TypeError: " + asClass(callee)->name + "() takes no arguments");
+            }
+            return instance;
+        }
+        default:
+            runtimeError("TypeError: '" + typeName(callee) + "' object is not callable");
+    }
+}
+
+Value callMethod(const Value& self, const string& name, Value* args, int argc) {
+    if (self.kind == V_INSTANCE && !asInstance(self)->attributes.count(name)) {
+        Value* attr = findClassAttribute(asInstance(self)->cls, name);
+        if (attr && attr->kind == V_FUNC) return invokeWithSelf(asFunction(*attr), self, args, argc);
+    }
+    if (self.kind == V_INSTANCE || self.kind == V_CLASS) return callValue(getAttribute(self, name), args, argc);
+    return callNativeMethod(self, name, args, argc);
+}
+
+// The braced argument list at a call site is evaluated left to right, unlike function arguments
+template <size_t N>
+Value callWith(BuiltinFunction function, Value (&&args)[N]) {
+    return function(args, N);
+}
+
+inline Value callWith(BuiltinFunction function) {
+    return function(nullptr, 0);
+}
+
+template <size_t N>
+Value callValueWith(const Value& callee, Value (&&args)[N]) {
+    return callValue(callee, args, N);
+}
+
+inline Value callValueWith(const Value& callee) {
+    return callValue(callee, nullptr, 0);
+}
+
+template <size_t N>
+Value callMethodWith(const Value& self, const string& name, Value (&&args)[N]) {
+    return callMethod(self, name, args, N);
+}
+
+inline Value callMethodWith(const Value& self, const string& name) {
+    return callMethod(self, name, nullptr, 0);
+}
+
+int runTranspiled(void (*moduleBody)()) {
+    ios::sync_with_stdio(false);
+    try {
+        moduleBody();
+    } catch (const runtime_error& e) {
+        cout.flush();
+        cerr << "Runtime Error: " << e.what() << endl;
+        return 1;
+    }
+    cout.flush();
+    return 0;
+}
+
+#endif
@@ -0,0 +1,1047 @@
+#include <sstream>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+using namespace std;
+
+// Python-to-C++ transpiler: CppTranspiler walks the parse tree and emits a standalone C++ program
+// built on transpile_support.h. A variable becomes a native long long, double, string or bool when
+// the symbol table names that type, every binding of the variable in the tree produces it and it is
+// assigned on every path to each of its reads; 'for' variables over range() of ints are native ints
+// as well. Everything else is a dynamic Value, which reports a read before assignment.
+
+enum CType { CT_DYN, CT_INT, CT_FLOAT, CT_STR, CT_BOOL };
+
+// An emitted C++ expression
+struct Typed {
+    string code;
+    CType type;
+    bool hasCall;  // may run user code or otherwise have side effects
+    bool stable;   // a literal or a plain name, which no call can change
+};
+
+class CppTranspiler {
+    private:
+        struct FunctionInfo {
+            string name;
+            string cppName;
+            vector<string> params;
+            shared_ptr<ParseTreeNode> node;
+        };
+
+        // A place where a name gets its value; 'value' is null when the value is not known statically
+        struct Binding {
+            string name;
+            string op; // "=", an augmented operator, or "for"
+            shared_ptr<ParseTreeNode> value;
+        };
+
+        struct Scope {
+            bool isModule;
+            unordered_set<string> locals;
+            unordered_set<string> params;
+            unordered_map<string, CType> natives;
+        };
+
+        const vector<Identifier>& symbols;
+        string sourceName;
+        vector<FunctionInfo> functions;
+        unordered_map<const ParseTreeNode*, int> functionIndex;
+        vector<string> moduleNames;
+        unordered_set<string> moduleBound;
+        unordered_map<string, int> directCalls; // module functions bound only by their 'def'
+        unordered_set<string> functionGlobalReads; // module variables read inside functions
+        Scope moduleScope;
+        Scope* scope = nullptr;
+        int tempCounter = 0;
+        ostringstream body;
+        int indent = 0;
+
+        [[noreturn]] void compileError(const string& message) {
+            throw runtime_error("Compile Error: " + message);
+        }
+
+        void line(const string& text) {
+            body << string(indent * 4, ' ') << text << "\n";
+        }
+
+        string temp(const string& stem) {
+            return stem + to_string(tempCounter++) + "_";
+        }
+
+        static const char* cppTypeName(CType type) {
+            switch (type) {
+                case CT_INT: return "long long";
+                case CT_FLOAT: return "double";
+                case CT_STR: return "string";
+                case CT_BOOL: return "bool";
+                default: return "Value";
+            }
+        }
+
+        static string cppString(const string& text) {
+            // Octal escapes are always three digits, so a following digit is never absorbed
+            string out = "\"";
+            for (unsigned char c : text) {
+                if (c == '"' || c == '\\') {
+                    out += '\\';
+                    out += c;
+                } else if (c >= 32 && c < 127 && c != '?') {
+                    out += c;
+                } else {
+                    char buffer[8];
+                    snprintf(buffer, sizeof(buffer), "\\%03o", c);
+                    out += buffer;
+                }
+            }
+            return out + "\"";
+        }
+
+        static string stringValue(const string& text) {
+            return "string(" + cppString(text) + ", " + to_string(text.size()) + ")";
+        }
+
+        static Typed constant(const string& code, CType type) {
+            return {code, type, false, true};
+        }
+
+        static string box(const Typed& value) {
+            switch (value.type) {
+                case CT_INT: return "Value::integer(" + value.code + ")";
+                case CT_FLOAT: return "Value::number(" + value.code + ")";
+                case CT_STR: return "makeString(" + value.code + ")";
+                case CT_BOOL: return "Value::boolean(" + value.code + ")";
+                default: return value.code;
+            }
+        }
+
+        static string truth(const Typed& value) {
+            switch (value.type) {
+                case CT_INT: return "(" + value.code + " != 0)";
+                case CT_FLOAT: return "(" + value.code + " != 0.0)";
+                case CT_STR: return "!(" + value.code + ").empty()";
+                case CT_BOOL: return value.code;
+                default: return "truthy(" + value.code + ")";
+            }
+        }
+
+        // C++ leaves the order of operand evaluation open; when it can matter the operands are
+        // evaluated into temporaries first
+        Typed combine(const vector<Typed>& operands, CType type, const function<string(const vector<Typed>&)>& build) {
+            int calls = 0, unstable = 0;
+            for (const auto& operand : operands) {
+                if (operand.hasCall) calls++;
+                if (!operand.stable) unstable++;
+            }
+            bool anyCall = calls > 0;
+            if (!anyCall || operands.size() < 2 || (calls == 1 && unstable == 1)) {
+                return {build(operands), type, anyCall, false};
+            }
+            string code = string("[&]() -> ") + cppTypeName(type) + " { ";
+            vector<Typed> temps;
+            for (size_t k = 0; k < operands.size(); k++) {
+                string name = "t" + to_string(k) + "_";
+                code += "auto " + name + " = " + operands[k].code + "; ";
+                temps.push_back({name, operands[k].type, false, true});
+            }
+            code += "return " + build(temps) + "; }()";
+            return {code, type, true, false};
+        }
+
+        // ---- Analysis ----
+
+        int builtinId(const string& name) {
+            if (!scope->isModule && scope->locals.count(name)) return -1;
+            if (moduleBound.count(name)) return -1;
+            return findBuiltin(name);
+        }
+
+        bool isRangeCall(const shared_ptr<ParseTreeNode>& node) {
+            if (node->type != "FunctionCall" && node->type != "FunctionCallStatement") return false;
+            auto callee = node->type == "FunctionCall" ? semanticChildren(node)[0] : node->children[0];
+            if (callee->type != "Identifier" || callee->value != "range" || builtinId("range") < 0) return false;
+            auto args = findChild(node, "Arguments");
+            size_t argc = args ? semanticChildren(args).size() : 0;
+            if (argc < 1 || argc > 3) return false;
+            for (const auto& arg : semanticChildren(args)) {
+                if (emitExpression(arg).type != CT_INT) return false;
+            }
+            return true;
+        }
+
+        CType symbolHint(const string& name) {
+            CType hint = CT_DYN;
+            for (const auto& symbol : symbols) {
+                if (symbol.name != name) continue;
+                CType type = symbol.type == "int" ? CT_INT : symbol.type == "float" ? CT_FLOAT :
+                             symbol.type == "string" ? CT_STR : symbol.type == "bool" ? CT_BOOL : CT_DYN;
+                if (hint != CT_DYN && type != hint) return CT_DYN;
+                hint = type;
+            }
+            return hint;
+        }
+
+        void collectBindings(const shared_ptr<ParseTreeNode>& node, vector<Binding>& bindings) {
+            if (node->type == "Assignment") {
+                auto targets = semanticChildren(findChild(node, "IdentifierList"));
+                string op = findChild(node, "AssignOp")->value;
+                auto value = semanticChildren(node).back();
+                for (const auto& target : targets) {
+                    if (target->type == "Identifier") {
+                        bindings.push_back({target->value, op, targets.size() == 1 ? value : nullptr});
+                    }
+                }
+                return;
+            }
+            if (node->type == "ForStatement") {
+                auto parts = semanticChildren(node);
+                bindings.push_back({parts[0]->value, "for", parts[1]});
+            }
+            if (node->type == "FunctionDefinition" || node->type == "ClassDefinition") {
+                bindings.push_back({findChild(node, "Identifier")->value, "=", nullptr});
+                return;
+            }
+            for (const auto& child : node->children) collectBindings(child, bindings);
+        }
+
+        bool bindingProduces(const Binding& binding, CType type) {
+            if (!binding.value) return false;
+            if (binding.op == "for") return type == CT_INT && isRangeCall(binding.value);
+            Typed value = emitExpression(binding.value);
+            if (binding.op == "=") return value.type == type;
+            BinaryOperator op;
+            if (!binaryOperatorFromString(binding.op.substr(0, binding.op.size() - 1), op)) return false;
+            return binaryType(op, type, value.type) == type;
+        }
+
+        // Calls 'read' with each name 'node' reads outside nested definitions and 'call' at each call
+        void visitReads(const shared_ptr<ParseTreeNode>& node, const function<void(const string&)>& read,
+                        const function<void()>& call) {
+            if (node->type == "Identifier") {
+                read(node->value);
+                return;
+            }
+            if (node->type == "DottedName") {
+                // The callee of a method call statement: only the first name is a read
+                for (const auto& part : node->children) {
+                    if (part->type != "NamePart") continue;
+                    read(part->value);
+                    break;
+                }
+                return;
+            }
+            if (node->type == "FunctionDefinition" || node->type == "ClassDefinition") return;
+            if (node->type == "FunctionCall" || node->type == "FunctionCallStatement") call();
+            auto parts = semanticChildren(node);
+            if (node->type == "AttributeAccess") {
+                visitReads(parts[0], read, call); // the attribute name is no read
+                return;
+            }
+            for (const auto& part : parts) visitReads(part, read, call);
+        }
+
+        // Drops the natives 'node' reads where they may not be assigned yet. At module level a call
+        // may run a function that reads module variables, so those must be assigned by then too
+        void checkReads(const shared_ptr<ParseTreeNode>& node, const unordered_set<string>& assigned, Scope& target) {
+            auto drop = [&](const string& name) {
+                if (!assigned.count(name)) target.natives.erase(name);
+            };
+            visitReads(node, drop, [&]() {
+                if (!target.isModule) return;
+                for (const auto& name : functionGlobalReads) drop(name);
+            });
+        }
+
+        // Drops the natives a block may read before assigning them: a native variable has no unbound
+        // state, so it must hold a value wherever it is read. 'assigned' holds the names bound on
+        // every path to the current statement
+        void checkAssigned(const shared_ptr<ParseTreeNode>& block, unordered_set<string>& assigned, Scope& target) {
+            for (const auto& statement : block->children) {
+                const string& type = statement->type;
+                if (type == "Assignment") {
+                    auto targets = semanticChildren(findChild(statement, "IdentifierList"));
+                    bool augmented = findChild(statement, "AssignOp")->value != "=";
+                    checkReads(semanticChildren(statement).back(), assigned, target);
+                    for (const auto& assignee : targets) {
+                        if (augmented || assignee->type != "Identifier") checkReads(assignee, assigned, target);
+                    }
+                    for (const auto& assignee : targets) {
+                        if (assignee->type == "Identifier") assigned.insert(assignee->value);
+                    }
+                } else if (type == "IfStatement") {
+                    auto parts = semanticChildren(statement);
+                    checkReads(parts[0], assigned, target);
+                    unordered_set<string> common = assigned;
+                    checkAssigned(parts[1], common, target);
+                    bool hasElse = false;
+                    for (size_t k = 2; k < parts.size(); k++) {
+                        unordered_set<string> branch = assigned;
+                        if (parts[k]->type == "ElifClause") {
+                            auto clause = semanticChildren(parts[k]);
+                            checkReads(clause[0], assigned, target);
+                            checkAssigned(clause[1], branch, target);
+                        } else {
+                            hasElse = true;
+                            checkAssigned(findChild(parts[k], "Suite"), branch, target);
+                        }
+                        for (auto it = common.begin(); it != common.end();) {
+                            it = branch.count(*it) ? next(it) : common.erase(it);
+                        }
+                    }
+                    if (hasElse) assigned = common;
+                } else if (type == "WhileStatement") {
+                    // The body may not run, so nothing it assigns is certain afterwards
+                    auto parts = semanticChildren(statement);
+                    checkReads(parts[0], assigned, target);
+                    unordered_set<string> body = assigned;
+                    checkAssigned(parts[1], body, target);
+                } else if (type == "ForStatement") {
+                    auto parts = semanticChildren(statement);
+                    checkReads(parts[1], assigned, target);
+                    unordered_set<string> body = assigned;
+                    body.insert(parts[0]->value);
+                    checkAssigned(parts[2], body, target);
+                } else if (type == "FunctionDefinition") {
+                    assigned.insert(findChild(statement, "Identifier")->value);
+                } else if (type == "ClassDefinition") {
+                    // Only the values of class attributes are evaluated here
+                    for (const auto& member : findChild(statement, "Suite")->children) {
+                        if (member->type == "Assignment") checkReads(semanticChildren(member).back(), assigned, target);
+                    }
+                    assigned.insert(findChild(statement, "Identifier")->value);
+                } else if (type == "Suite") {
+                    checkAssigned(statement, assigned, target);
+                } else {
+                    checkReads(statement, assigned, target);
+                }
+            }
+        }
+
+        // Starts from the symbol table's types, drops every variable that may be read unassigned,
+        // and then every variable with a binding that cannot be shown to produce its type, until
+        // nothing changes
+        void inferNatives(Scope& target, const shared_ptr<ParseTreeNode>& block, const vector<Binding>& bindings) {
+            unordered_map<string, vector<const Binding*>> byName;
+            for (const auto& binding : bindings) byName[binding.name].push_back(&binding);
+            for (const auto& entry : byName) {
+                if (target.params.count(entry.first)) continue;
+                CType hint = symbolHint(entry.first);
+                if (hint == CT_DYN) {
+                    bool onlyLoops = true;
+                    for (const Binding* binding : entry.second) onlyLoops = onlyLoops && binding->op == "for";
+                    if (onlyLoops) hint = CT_INT;
+                }
+                if (hint != CT_DYN) target.natives[entry.first] = hint;
+            }
+            unordered_set<string> assigned(target.params.begin(), target.params.end());
+            checkAssigned(block, assigned, target);
+
+            Scope* saved = scope;
+            scope = &target;
+            for (bool changed = true; changed;) {
+                changed = false;
+                for (const auto& entry : byName) {
+                    auto native = target.natives.find(entry.first);
+                    if (native == target.natives.end()) continue;
+                    for (const Binding* binding : entry.second) {
+                        if (!bindingProduces(*binding, native->second)) {
+                            target.natives.erase(native);
+                            changed = true;
+                            break;
+                        }
+                    }
+                }
+            }
+            scope = saved;
+        }
+
+        void collectFunctions(const shared_ptr<ParseTreeNode>& node) {
+            if (node->type == "FunctionDefinition") {
+                FunctionInfo info;
+                info.name = findChild(node, "Identifier")->value;
+                info.cppName = "f" + to_string(functions.size()) + "_" + info.name;
+                for (const auto& param : findChild(node, "Parameters")->children) {
+                    if (param->type == "Parameter") info.params.push_back(param->value);
+                }
+                info.node = node;
+                functionIndex[node.get()] = functions.size();
+                functions.push_back(info);
+            }
+            for (const auto& child : node->children) collectFunctions(child);
+        }
+
+        // ---- Names ----
+
+        Typed emitLoad(const string& name) {
+            if (!scope->isModule && scope->locals.count(name)) {
+                auto native = scope->natives.find(name);
+                if (native != scope->natives.end()) return {"l_" + name, native->second, false, true};
+                if (scope->params.count(name)) return {"l_" + name, CT_DYN, false, true};
+                return {"checkLocal(l_" + name + ", " + cppString(name) + ")", CT_DYN, false, true};
+            }
+            int builtin = builtinId(name);
+            if (builtin >= 0) return constant("Value::builtinFunction(" + to_string(builtin) + ")", CT_DYN);
+            if (!moduleBound.count(name)) {
+                if (name == "__name__") return constant("makeString(\"__main__\")", CT_DYN);
+                return {"undefinedName(" + cppString(name) + ")", CT_DYN, true, false};
+            }
+            auto native = moduleScope.natives.find(name);
+            if (native != moduleScope.natives.end()) return {"g_" + name, native->second, false, true};
+            return {"checkGlobal(g_" + name + ", " + cppString(name) + ")", CT_DYN, false, true};
+        }
+
+        string variable(const string& name) {
+            return (scope->isModule ? "g_" : "l_") + name;
+        }
+
+        CType variableType(const string& name) {
+            auto native = scope->natives.find(name);
+            return native == scope->natives.end() ? CT_DYN : native->second;
+        }
+
+        // Stores a dynamic Value held in 'value' (a C++ lvalue) into an assignment target
+        void emitStore(const shared_ptr<ParseTreeNode>& target, const string& value) {
+            if (target->type == "Identifier") {
+                if (variableType(target->value) != CT_DYN) compileError("internal error: dynamic store into native variable");
+                line(variable(target->value) + " = " + value + ";");
+            } else if (target->type == "AttributeAccess") {
+                auto parts = semanticChildren(target);
+                line("setAttribute(" + box(emitExpression(parts[0])) + ", " + cppString(parts[1]->value) + ", " + value + ");");
+            } else if (target->type == "Subscript") {
+                auto parts = semanticChildren(target);
+                string container = temp("c"), index = temp("i");
+                line("{");
+                line("    Value " + container + " = " + box(emitExpression(parts[0])) + ";");
+                line("    Value " + index + " = " + box(emitExpression(parts[1])) + ";");
+                line("    setItem(" + container + ", " + index + ", " + value + ");");
+                line("}");
+            } else {
+                compileError("cannot assign to " + target->type);
+            }
+        }
+
+        // ---- Statements ----
+
+        void emitBlock(const shared_ptr<ParseTreeNode>& block) {
+            for (const auto& statement : block->children) emitStatement(statement);
+        }
+
+        void emitStatement(const shared_ptr<ParseTreeNode>& node) {
+            const string& type = node->type;
+            if (type == "ExpressionStatement") {
+                line(emitExpression(semanticChildren(node)[0]).code + ";");
+            } else if (type == "FunctionCallStatement") {
+                line(emitExpression(node).code + ";");
+            } else if (type == "Assignment") {
+                emitAssignment(node);
+            } else if (type == "IfStatement") {
+                emitIf(node);
+            } else if (type == "WhileStatement") {
+                auto parts = semanticChildren(node);
+                line("while (" + truth(emitExpression(parts[0])) + ") {");
+                indent++;
+                emitBlock(parts[1]);
+                indent--;
+                line("}");
+            } else if (type == "ForStatement") {
+                emitFor(node);
+            } else if (type == "FunctionDefinition") {
+                const FunctionInfo& info = functions[functionIndex.at(node.get())];
+                line(variable(info.name) + " = makeFunction(" + cppString(info.name) + ", " + to_string(info.params.size()) +
+                     ", " + to_string(functionIndex.at(node.get())) + ");");
+            } else if (type == "ClassDefinition") {
+                emitClassDefinition(node);
+            } else if (type == "ReturnStatement") {
+                if (scope->isModule) compileError("'return' outside function");
+                auto parts = semanticChildren(node);
+                line(parts.empty() ? "return Value::none();" : "return " + box(emitExpression(parts[0])) + ";");
+            } else if (type == "BreakStatement") {
+                line("break;");
+            } else if (type == "ContinueStatement") {
+                line("continue;");
+            } else if (type == "PassStatement") {
+                // nothing to emit
+            } else if (type == "Suite") {
+                emitBlock(node);
+            } else if (type == "ImportStatement") {
+                compileError("import is not supported by the transpiler");
+            } else {
+                compileError("unsupported statement " + type);
+            }
+        }
+
+        void emitAssignment(const shared_ptr<ParseTreeNode>& node) {
+            auto targets = semanticChildren(findChild(node, "IdentifierList"));
+            string op = findChild(node, "AssignOp")->value;
+            Typed value = emitExpression(semanticChildren(node).back());
+
+            if (op == "=") {
+                if (targets.size() == 1 && targets[0]->type == "Identifier") {
+                    CType type = variableType(targets[0]->value);
+                    line(variable(targets[0]->value) + " = " + (type == CT_DYN ? box(value) : value.code) + ";");
+                    return;
+                }
+                string held = temp("v");
+                line("{");
+                indent++;
+                line("Value " + held + " = " + box(value) + ";");
+                if (targets.size() == 1) {
+                    emitStore(targets[0], held);
+                } else {
+                    string items = temp("items");
+                    line("vector<Value> " + items + ";");
+                    line("unpackInto(" + held + ", " + items + ", " + to_string(targets.size()) + ");");
+                    for (size_t k = 0; k < targets.size(); k++) emitStore(targets[k], items + "[" + to_string(k) + "]");
+                }
+                indent--;
+                line("}");
+                return;
+            }
+
+            BinaryOperator binary;
+            if (targets.size() != 1 || !binaryOperatorFromString(op.substr(0, op.size() - 1), binary)) {
+                compileError("illegal expression for augmented assignment");
+            }
+            auto target = targets[0];
+            if (target->type == "Identifier") {
+                Typed result = emitBinary(binary, emitLoad(target->value), value);
+                CType type = variableType(target->value);
+                line(variable(target->value) + " = " + (type == CT_DYN ? box(result) : result.code) + ";");
+            } else if (target->type == "AttributeAccess") {
+                auto parts = semanticChildren(target);
+                string object = temp("o"), current = temp("v");
+                line("{");
+                line("    Value " + object + " = " + box(emitExpression(parts[0])) + ";");
+                line("    Value " + current + " = getAttribute(" + object + ", " + cppString(parts[1]->value) + ");");
+                line("    setAttribute(" + object + ", " + cppString(parts[1]->value) + ", binaryOp(" + binaryName(binary) +
+                     ", " + current + ", " + box(value) + "));");
+                line("}");
+            } else if (target->type == "Subscript") {
+                auto parts = semanticChildren(target);
+                string container = temp("c"), index = temp("i"), current = temp("v");
+                line("{");
+                line("    Value " + container + " = " + box(emitExpression(parts[0])) + ";");
+                line("    Value " + index + " = " + box(emitExpression(parts[1])) + ";");
+                line("    Value " + current + " = getItem(" + container + ", " + index + ");");
+                line("    setItem(" + container + ", " + index + ", binaryOp(" + binaryName(binary) + ", " + current +
+                     ", " + box(value) + "));");
+                line("}");
+            } else {
+                compileError("illegal expression for augmented assignment");
+            }
+        }
+
+        void emitIf(const shared_ptr<ParseTreeNode>& node) {
+            auto parts = semanticChildren(node);
+            // parts: condition, Suite, then any ElifClause and an optional ElseClause
+            line("if (" + truth(emitExpression(parts[0])) + ") {");
+            indent++;
+            emitBlock(parts[1]);
+            indent--;
+            for (size_t k = 2; k < parts.size(); k++) {
+                if (parts[k]->type == "ElifClause") {
+                    auto clause = semanticChildren(parts[k]);
+                    // Nested rather than 'else if' so the condition may use temporaries
+                    line("} else {");
+                    indent++;
+                    line("if (" + truth(emitExpression(clause[0])) + ") {");
+                    indent++;
+                    emitBlock(clause[1]);
+                    indent--;
+                } else {
+                    line("} else {");
+                    indent++;
+                    emitBlock(findChild(parts[k], "Suite"));
+                    indent--;
+                }
+            }
+            for (size_t k = 2; k < parts.size(); k++) {
+                if (parts[k]->type == "ElifClause") {
+                    line("}");
+                    indent--;
+                }
+            }
+            line("}");
+        }
+
+        void emitFor(const shared_ptr<ParseTreeNode>& node) {
+            auto parts = semanticChildren(node);
+            // parts: loop variable, iterable, Suite
+            string name = parts[0]->value;
+            line("{");
+            indent++;
+            if (variableType(name) == CT_INT) {
+                // Proven range() of ints: count natively
+                auto args = semanticChildren(findChild(parts[1], "Arguments"));
+                string start = temp("start"), stop = temp("stop"), step = temp("step"), counter = temp("n");
+                line("long long " + start + " = " + (args.size() > 1 ? emitExpression(args[0]).code : "0") + ";");
+                line("long long " + stop + " = " + emitExpression(args.size() > 1 ? args[1] : args[0]).code + ";");
+                line("long long " + step + " = " + (args.size() > 2 ? emitExpression(args[2]).code : "1") + ";");
+                line("if (" + step + " == 0) runtimeError(\"ValueError: range() arg 3 must not be zero\");");
+                line("for (long long " + counter + " = " + start + "; " + step + " > 0 ? " + counter + " < " + stop + " : " +
+                     counter + " > " + stop + "; " + counter + " += " + step + ") {");
+                indent++;
+                line(variable(name) + " = " + counter + ";");
+            } else {
+                string iterator = temp("it"), item = temp("item");
+                line("Value " + iterator + " = makeIterator(" + box(emitExpression(parts[1])) + ");");
+                line("Value " + item + ";");
+                line("while (iteratorNext(asIter(" + iterator + "), " + item + ")) {");
+                indent++;
+                line(variable(name) + " = " + item + ";");
+            }
+            emitBlock(parts[2]);
+            indent--;
+            line("}");
+            indent--;
+            line("}");
+        }
+
+        void emitClassDefinition(const shared_ptr<ParseTreeNode>& node) {
+            string name = findChild(node, "Identifier")->value;
+            auto parent = findChild(node, "Parent");
+            string cls = temp("cls");
+            line("{");
+            indent++;
+            line("Value " + cls + " = makeClass(" + cppString(name) + ", " +
+                 (parent ? box(emitLoad(parent->value)) : "Value::none()") + ");");
+            for (const auto& statement : findChild(node, "Suite")->children) {
+                if (statement->type == "FunctionDefinition") {
+                    int index = functionIndex.at(statement.get());
+                    const FunctionInfo& info = functions[index];
+                    line("setAttribute(" + cls + ", " + cppString(info.name) + ", makeFunction(" + cppString(info.name) + ", " +
+                         to_string(info.params.size()) + ", " + to_string(index) + "));");
+                } else if (statement->type == "Assignment" && findChild(statement, "AssignOp")->value == "=" &&
+                           semanticChildren(findChild(statement, "IdentifierList")).size() == 1 &&
+                           semanticChildren(findChild(statement, "IdentifierList"))[0]->type == "Identifier") {
+                    string attr = semanticChildren(findChild(statement, "IdentifierList"))[0]->value;
+                    line("setAttribute(" + cls + ", " + cppString(attr) + ", " +
+                         box(emitExpression(semanticChildren(statement).back())) + ");");
+                } else if (statement->type != "PassStatement") {
+                    compileError("unsupported statement " + statement->type + " in class body");
+                }
+            }
+            line(variable(name) + " = " + cls + ";");
+            indent--;
+            line("}");
+        }
+
+        void emitFunction(int index) {
+            const FunctionInfo& info = functions[index];
+            Scope state;
+            state.isModule = false;
+            vector<string> bound = info.params;
+            auto suite = findChild(info.node, "Suite");
+            collectBoundNames(suite, bound);
+            for (const auto& name : bound) state.locals.insert(name);
+            for (const auto& param : info.params) state.params.insert(param);
+            vector<Binding> bindings;
+            collectBindings(suite, bindings);
+            inferNatives(state, suite, bindings);
+
+            scope = &state;
+            string signature = "Value " + info.cppName + "(";
+            for (size_t k = 0; k < info.params.size(); k++) signature += (k ? ", Value l_" : "Value l_") + info.params[k];
+            line(signature + ") {");
+            indent++;
+            line("CallDepthGuard guard_;");
+            vector<string> declared(state.locals.begin(), state.locals.end());
+            sort(declared.begin(), declared.end());
+            for (const auto& name : declared) {
+                if (state.params.count(name)) continue;
+                CType type = variableType(name);
+                line(string(cppTypeName(type)) + " l_" + name + (type == CT_DYN ? "" : type == CT_STR ? "" : " = 0") + ";");
+            }
+            emitBlock(suite);
+            line("return Value::none();");
+            indent--;
+            line("}");
+            line("");
+            scope = nullptr;
+        }
+
+        // ---- Expressions ----
+
+        static const char* binaryName(BinaryOperator op) {
+            static const char* names[] = {"BIN_ADD", "BIN_SUB", "BIN_MUL", "BIN_DIV", "BIN_FLOORDIV", "BIN_MOD"};
+            return names[op];
+        }
+
+        static CType binaryType(BinaryOperator op, CType a, CType b) {
+            bool numeric = (a == CT_INT || a == CT_FLOAT) && (b == CT_INT || b == CT_FLOAT);
+            if (a == CT_INT && b == CT_INT) return op == BIN_DIV ? CT_FLOAT : CT_INT;
+            if (numeric) return CT_FLOAT;
+            if (op == BIN_ADD && a == CT_STR && b == CT_STR) return CT_STR;
+            return CT_DYN;
+        }
+
+        Typed emitBinary(BinaryOperator op, const Typed& left, const Typed& right) {
+            CType type = binaryType(op, left.type, right.type);
+            return combine({left, right}, type, [op, type](const vector<Typed>& v) -> string {
+                const string& a = v[0].code;
+                const string& b = v[1].code;
+                if (type == CT_INT) {
+                    static const char* helpers[] = {"addInt", "subInt", "mulInt", "", "floorDivInt", "modInt"};
+                    return string(helpers[op]) + "(" + a + ", " + b + ")";
+                }
+                if (type == CT_FLOAT && v[0].type == CT_INT && v[1].type == CT_INT) return "divInt(" + a + ", " + b + ")";
+                if (type == CT_FLOAT) {
+                    string x = v[0].type == CT_INT ? "(double)" + a : a;
+                    string y = v[1].type == CT_INT ? "(double)" + b : b;
+                    switch (op) {
+                        case BIN_ADD: return "(" + x + " + " + y + ")";
+                        case BIN_SUB: return "(" + x + " - " + y + ")";
+                        case BIN_MUL: return "(" + x + " * " + y + ")";
+                        case BIN_DIV: return "divFloat(" + x + ", " + y + ")";
+                        case BIN_FLOORDIV: return "floorDivFloat(" + x + ", " + y + ")";
+                        case BIN_MOD: return "modFloat(" + x + ", " + y + ")";
+                    }
+                }
+                if (type == CT_STR) return "(" + a + " + " + b + ")";
+                return string("binaryFast(") + binaryName(op) + ", " + box(v[0]) + ", " + box(v[1]) + ")";
+            });
+        }
+
+        Typed emitComparison(const string& op, const Typed& left, const Typed& right) {
+            return combine({left, right}, CT_BOOL, [op](const vector<Typed>& v) -> string {
+                bool numeric = (v[0].type == CT_INT || v[0].type == CT_FLOAT) && (v[1].type == CT_INT || v[1].type == CT_FLOAT);
+                bool strings = v[0].type == CT_STR && v[1].type == CT_STR;
+                bool bools = v[0].type == CT_BOOL && v[1].type == CT_BOOL;
+                if (op == "in") return "containsValue(" + box(v[1]) + ", " + box(v[0]) + ")";
+                if (op == "not in") return "!containsValue(" + box(v[1]) + ", " + box(v[0]) + ")";
+                if (numeric || strings || (bools && (op == "==" || op == "!="))) {
+                    string a = v[0].code, b = v[1].code;
+                    if (numeric && v[0].type != v[1].type) {
+                        if (v[0].type == CT_INT) a = "(double)" + a;
+                        else b = "(double)" + b;
+                    }
+                    return "(" + a + " " + op + " " + b + ")";
+                }
+                if (op == "==") return "valuesEqual(" + box(v[0]) + ", " + box(v[1]) + ")";
+                if (op == "!=") return "!valuesEqual(" + box(v[0]) + ", " + box(v[1]) + ")";
+                return "(compareFast(" + box(v[0]) + ", " + box(v[1]) + ", \"" + op + "\") " + op + " 0)";
+            });
+        }
+
+        Typed emitLiteral(const shared_ptr<ParseTreeNode>& node) {
+            const LiteralValue& literal = literalOf(node);
+            if (literal.kind == LIT_FSTRING || literal.kind == LIT_INVALID) {
+                vector<Typed> parts;
+                for (const auto& segment : formattedSegments(literal)) {
+                    if (!segment.isExpression) {
+                        parts.push_back(constant(stringValue(segment.text), CT_STR));
+                        continue;
+                    }
+                    auto expression = parseEmbeddedExpression(segment.text);
+                    if (!expression) compileError("invalid f-string expression '" + segment.text + "'");
+                    Typed value = emitExpression(expression);
+                    parts.push_back({"formatWithSpec(" + box(value) + ", " + cppString(segment.formatSpec) + ")", CT_STR,
+                                     value.hasCall, false});
+                }
+                if (parts.empty()) return constant("string()", CT_STR);
+                return combine(parts, CT_STR, [](const vector<Typed>& v) {
+                    string code = "(string()";
+                    for (const auto& part : v) code += " + " + part.code;
+                    return code + ")";
+                });
+            }
+            if (literal.kind == LIT_STRING) return constant(stringValue(literal.text), CT_STR);
+            Value number = literalConstant(literal);
+            if (number.kind == V_INT) return constant(to_string(number.i) + "LL", CT_INT);
+            if (!isfinite(number.f)) return constant("HUGE_VAL", CT_FLOAT);
+            char buffer[64];
+            snprintf(buffer, sizeof(buffer), "%.17g", number.f);
+            string code = buffer;
+            if (code.find_first_of(".e") == string::npos) code += ".0";
+            return constant(code, CT_FLOAT);
+        }
+
+        vector<Typed> emitArguments(const shared_ptr<ParseTreeNode>& args) {
+            vector<Typed> emitted;
+            if (!args) return emitted;
+            for (const auto& arg : semanticChildren(args)) emitted.push_back(emitExpression(arg));
+            return emitted;
+        }
+
+        static string bracedBoxes(const vector<Typed>& values, size_t first) {
+            string code = "{";
+            for (size_t k = first; k < values.size(); k++) code += (k > first ? ", " : "") + box(values[k]);
+            return code + "}";
+        }
+
+        Typed emitMethodCall(const Typed& object, const string& name, const vector<Typed>& args) {
+            vector<Typed> operands = {object};
+            operands.insert(operands.end(), args.begin(), args.end());
+            Typed call = combine(operands, CT_DYN, [name](const vector<Typed>& v) {
+                string code = "callMethodWith(" + box(v[0]) + ", " + cppString(name);
+                return code + (v.size() > 1 ? ", " + bracedBoxes(v, 1) : "") + ")";
+            });
+            call.hasCall = true;
+            return call;
+        }
+
+        Typed emitCall(const shared_ptr<ParseTreeNode>& callee, const vector<Typed>& args) {
+            Typed call;
+            int builtin = callee->type == "Identifier" ? builtinId(callee->value) : -1;
+            if (builtin >= 0) {
+                string name = callee->value;
+                string function = "builtinTable()[" + to_string(builtin) + "].function";
+                call = combine(args, CT_DYN, [function](const vector<Typed>& v) {
+                    return "callWith(" + function + (v.empty() ? "" : ", " + bracedBoxes(v, 0)) + ")";
+                });
+                // Builtins with a fixed result type hand it back unboxed
+                if (name == "len" || name == "int") call = {call.code + ".i", CT_INT, true, false};
+                else if (name == "float") call = {call.code + ".f", CT_FLOAT, true, false};
+                else if (name == "str" || name == "input") call = {"unboxStr(" + call.code + ")", CT_STR, true, false};
+                else if (name == "bool") call = {call.code + ".b", CT_BOOL, true, false};
+            } else if (callee->type == "Identifier" && directCalls.count(callee->value) &&
+                       (scope->isModule || !scope->locals.count(callee->value)) &&
+                       functions[directCalls.at(callee->value)].params.size() == args.size()) {
+                // A module function that is never rebound: call the C++ function directly
+                string cppName = functions[directCalls.at(callee->value)].cppName;
+                Typed check = emitLoad(callee->value);
+                call = combine(args, CT_DYN, [cppName, check](const vector<Typed>& v) {
+                    string code = "(" + check.code + ", " + cppName + "(";
+                    for (size_t k = 0; k < v.size(); k++) code += (k ? ", " : "") + box(v[k]);
+                    return code + "))";
+                });
+            } else {
+                vector<Typed> operands = {emitExpression(callee)};
+                operands.insert(operands.end(), args.begin(), args.end());
+                call = combine(operands, CT_DYN, [](const vector<Typed>& v) {
+                    return "callValueWith(" + box(v[0]) + (v.size() > 1 ? ", " + bracedBoxes(v, 1) : "") + ")";
+                });
+            }
+            call.hasCall = true;
+            call.stable = false;
+            return call;
+        }
+
+        Typed emitExpression(const shared_ptr<ParseTreeNode>& node) {
+            const string& type = node->type;
+            if (type == "Literal") return emitLiteral(node);
+            if (type == "Identifier") return emitLoad(node->value);
+            if (type == "Keyword") {
+                if (node->value == "True") return constant("true", CT_BOOL);
+                if (node->value == "False") return constant("false", CT_BOOL);
+                if (node->value == "None") return constant("Value::none()", CT_DYN);
+                compileError("unexpected keyword '" + node->value + "'");
+            }
+            if (type == "ParenExpr") return emitExpression(semanticChildren(node)[0]);
+            if (type == "List" || type == "Tuple" || (type == "ExpressionList" && !isArithChain(node))) {
+                vector<Typed> items;
+                bool anyCall = false;
+                for (const auto& item : semanticChildren(node)) {
+                    items.push_back(emitExpression(item));
+                    anyCall = anyCall || items.back().hasCall;
+                }
+                string kind = type == "List" ? "V_LIST" : "V_TUPLE";
+                return {"makeList(vector<Value>" + bracedBoxes(items, 0) + ", " + kind + ")", CT_DYN, anyCall, false};
+            }
+            if (type == "Dict") {
+                vector<Typed> entries;
+                bool anyCall = false;
+                for (const auto& pair : semanticChildren(node)) {
+                    for (const auto& part : semanticChildren(pair)) {
+                        entries.push_back(emitExpression(part));
+                        anyCall = anyCall || entries.back().hasCall;
+                    }
+                }
+                if (entries.empty()) return {"makeDict()", CT_DYN, false, false};
+                return {"makeDictFrom(" + bracedBoxes(entries, 0) + ")", CT_DYN, anyCall, false};
+            }
+            if (type == "ExpressionList") {
+                auto items = semanticChildren(node);
+                Typed result = emitExpression(items[0]);
+                for (size_t k = 1; k + 1 < items.size(); k += 2) {
+                    BinaryOperator op;
+                    if (!binaryOperatorFromString(items[k]->value, op)) compileError("unsupported operator " + items[k]->value);
+                    result = emitBinary(op, result, emitExpression(items[k + 1]));
+                }
+                return result;
+            }
+            if (type == "BinaryOp") {
+                auto operands = semanticChildren(node);
+                if (operands.size() != 2) compileError("malformed binary operation");
+                Typed left = emitExpression(operands[0]);
+                Typed right = emitExpression(operands[1]);
+                if (node->value == "and" || node->value == "or") {
+                    bool isAnd = node->value == "and";
+                    if (left.type == CT_BOOL && right.type == CT_BOOL) {
+                        return {"(" + left.code + (isAnd ? " && " : " || ") + right.code + ")", CT_BOOL,
+                                left.hasCall || right.hasCall, false};
+                    }
+                    // The right operand runs only when needed, so it stays inside the lambda
+                    string code = "[&]() -> Value { Value t_ = " + box(left) + "; return truthy(t_) ? " +
+                                  (isAnd ? box(right) + " : t_" : "t_ : " + box(right)) + "; }()";
+                    return {code, CT_DYN, left.hasCall || right.hasCall, false};
+                }
+                BinaryOperator op;
+                if (!binaryOperatorFromString(node->value, op)) compileError("unsupported operator " + node->value);
+                return emitBinary(op, left, right);
+            }
+            if (type == "UnaryOp") {
+                Typed operand = emitExpression(semanticChildren(node)[0]);
+                const string& op = node->value;
+                if (op == "not") return {"(!" + truth(operand) + ")", CT_BOOL, operand.hasCall, false};
+                if (operand.type == CT_INT && op == "-") {
+                    if (operand.stable && !operand.hasCall && operand.code.back() == 'L') return constant("(-" + operand.code + ")", CT_INT);
+                    return {"negInt(" + operand.code + ")", CT_INT, operand.hasCall, false};
+                }
+                if (operand.type == CT_FLOAT && op == "-") return {"(-" + operand.code + ")", CT_FLOAT, operand.hasCall, false};
+                if ((operand.type == CT_INT || operand.type == CT_FLOAT) && op == "+") return operand;
+                if (operand.type == CT_INT && op == "~") return {"(~" + operand.code + ")", CT_INT, operand.hasCall, false};
+                return {"unaryOp(" + cppString(op) + ", " + box(operand) + ")", CT_DYN, operand.hasCall, false};
+            }
+            if (type == "Comparison") {
+                auto parts = semanticChildren(node);
+                return emitComparison(parts[1]->value, emitExpression(parts[0]), emitExpression(parts[2]));
+            }
+            if (type == "TernaryOp") {
+                auto parts = semanticChildren(node);
+                // parts: value if true, condition, value if false
+                Typed then = emitExpression(parts[0]);
+                Typed condition = emitExpression(parts[1]);
+                Typed otherwise = emitExpression(parts[2]);
+                bool anyCall = then.hasCall || condition.hasCall || otherwise.hasCall;
+                if (then.type == otherwise.type) {
+                    return {"(" + truth(condition) + " ? " + then.code + " : " + otherwise.code + ")", then.type, anyCall, false};
+                }
+                return {"(" + truth(condition) + " ? " + box(then) + " : " + box(otherwise) + ")", CT_DYN, anyCall, false};
+            }
+            if (type == "AttributeAccess") {
+                auto parts = semanticChildren(node);
+                Typed object = emitExpression(parts[0]);
+                return {"getAttribute(" + box(object) + ", " + cppString(parts[1]->value) + ")", CT_DYN, object.hasCall, false};
+            }
+            if (type == "Subscript") {
+                auto parts = semanticChildren(node);
+                Typed subscript = combine({emitExpression(parts[0]), emitExpression(parts[1])}, CT_DYN, [](const vector<Typed>& v) {
+                    if (v[1].type == CT_INT) return "subscriptInt(" + box(v[0]) + ", " + v[1].code + ")";
+                    return "getItem(" + box(v[0]) + ", " + box(v[1]) + ")";
+                });
+                subscript.stable = false;
+                return subscript;
+            }
+            if (type == "FunctionCall") {
+                auto callee = semanticChildren(node)[0];
+                vector<Typed> args = emitArguments(findChild(node, "Arguments"));
+                if (callee->type == "AttributeAccess") {
+                    auto parts = semanticChildren(callee);
+                    return emitMethodCall(emitExpression(parts[0]), parts[1]->value, args);
+                }
+                return emitCall(callee, args);
+            }
+            if (type == "FunctionCallStatement") {
+                auto callee = node->children[0];
+                vector<Typed> args = emitArguments(findChild(node, "Arguments"));
+                if (callee->type == "DottedName") {
+                    vector<string> names;
+                    for (const auto& part : callee->children) {
+                        if (part->type == "NamePart") names.push_back(part->value);
+                    }
+                    Typed object = emitLoad(names[0]);
+                    for (size_t k = 1; k + 1 < names.size(); k++) {
+                        object = {"getAttribute(" + box(object) + ", " + cppString(names[k]) + ")", CT_DYN, object.hasCall, false};
+                    }
+                    return emitMethodCall(object, names.back(), args);
+                }
+                return emitCall(callee, args);
+            }
+            compileError("unsupported expression " + type);
+        }
+
+    public:
+        CppTranspiler(const vector<Identifier>& symbolTable, const string& source)
+            : symbols(symbolTable), sourceName(source) {}
+
+        string transpile(const shared_ptr<ParseTreeNode>& program) {
+            collectFunctions(program);
+            collectBoundNames(program, moduleNames);
+            unordered_map<string, int> bindCount;
+            for (const auto& name : moduleNames) {
+                moduleBound.insert(name);
+                bindCount[name]++;
+            }
+            for (const auto& statement : program->children) {
+                if (statement->type != "FunctionDefinition") continue;
+                string name = findChild(statement, "Identifier")->value;
+                if (bindCount[name] == 1) directCalls[name] = functionIndex.at(statement.get());
+            }
+
+            // Module variables the functions read; a call must not run before these are assigned
+            for (const auto& info : functions) {
+                auto suite = findChild(info.node, "Suite");
+                vector<string> bound = info.params;
+                collectBoundNames(suite, bound);
+                unordered_set<string> locals(bound.begin(), bound.end());
+                visitReads(suite, [&](const string& name) {
+                    if (!locals.count(name) && moduleBound.count(name)) functionGlobalReads.insert(name);
+                }, []() {});
+            }
+
+            moduleScope.isModule = true;
+            vector<Binding> bindings;
+            collectBindings(program, bindings);
+            inferNatives(moduleScope, program, bindings);
+
+            ostringstream out;
+            out << "// Generated from " << sourceName << " by parser --emit-cpp\n";
+            out << "#include \"transpile_support.h\"\n\n";
+
+            vector<string> globals(moduleBound.begin(), moduleBound.end());
+            sort(globals.begin(), globals.end());
+            for (const auto& name : globals) {
+                auto native = moduleScope.natives.find(name);
+                CType type = native == moduleScope.natives.end() ? CT_DYN : native->second;
+                out << cppTypeName(type) << " g_" << name << (type == CT_DYN || type == CT_STR ? "" : " = 0") << ";\n";
+            }
+            out << "\n";
+            for (const auto& info : functions) {
+                out << "Value " << info.cppName << "(";
+                for (size_t k = 0; k < info.params.size(); k++) out << (k ? ", Value" : "Value");
+                out << ");\n";
+            }
+            out << "\n";
+
+            for (size_t k = 0; k < functions.size(); k++) emitFunction(k);
+
+            line("Value invokeFunction(int index, Value* args) {");
+            line("    switch (index) {");
+            for (size_t k = 0; k < functions.size(); k++) {
+                string call = functions[k].cppName + "(";
+                for (size_t p = 0; p < functions[k].params.size(); p++) call += (p ? ", args[" : "args[") + to_string(p) + "]";
+                line("        case " + to_string(k) + ": return " + call + ");");
+            }
+            line("    }");
+            line("    runtimeError(\"internal error: bad function index\");");
+            line("}");
+            line("");
+
+            scope = &moduleScope;
+            line("void moduleBody() {");
+            indent++;
+            emitBlock(program);
+            indent--;
+            line("}");
+            line("");
+            line("int main() {");
+            line("    return runTranspiled(moduleBody);");
+            line("}");
+            scope = nullptr;
+
+            out << body.str();
+            return out.str();
+        }
+};
+
+// Prints the program as C++; returns the process exit status
+int emitCpp(const shared_ptr<ParseTreeNode>& tree, const vector<Identifier>& symbols, const string& sourceName) {
+    try {
+        cout << CppTranspiler(symbols, sourceName).transpile(tree);
+    } catch (const runtime_error& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,817 @@
+#include <memory>
+#include <vector>
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <iostream>
+#include <algorithm>
+using namespace std;
+
+// Flow-sensitive type inference over the parse tree. Types use the symbol table's names ("int",
+// "float", "string", "bool", "None", "list", "tuple", "dict", "set", "range", "function", "class"),
+// a class name stands for its instances, "unknown" for a value that may have more than one type,
+// and the empty string for a point no value reaches (yet).
+
+const string TYPE_UNKNOWN = "unknown";
+
+string joinTypes(const string& a, const string& b) {
+    if (a.empty()) return b;
+    if (b.empty() || a == b) return a;
+    return TYPE_UNKNOWN;
+}
+
+class TypeInference {
+    private:
+        typedef unordered_map<string, string> TypeEnv;
+
+        // Types of the names bound so far on one path through a function
+        struct FlowState {
+            TypeEnv vars;
+            bool reachable = true;
+        };
+
+        struct FunctionSummary {
+            string name;
+            int owner = -1;                 // class for methods
+            shared_ptr<ParseTreeNode> node; // the program for the module body
+            vector<string> params;
+            vector<string> paramTypes;      // join of the arguments at every resolved call
+            unordered_set<string> locals;
+            TypeEnv localTypes;             // join of every type each local took
+            string returnType;
+            unordered_set<int> callers;
+            bool escapes = false;           // may be called from places the analysis cannot see
+        };
+
+        struct ClassSummary {
+            string name;
+            string parent;
+            unordered_map<string, int> methods;
+            TypeEnv classAttributes;    // assigned in the class body
+            TypeEnv instanceAttributes; // assigned through instances of exactly this class
+        };
+
+        vector<FunctionSummary> functions; // functions[0] is the module body
+        vector<ClassSummary> classes;
+        unordered_map<string, int> moduleFunctions; // module functions and classes bound exactly once
+        unordered_map<string, int> moduleClasses;
+        unordered_map<const ParseTreeNode*, int> classOfNode;
+        unordered_set<string> moduleBound;
+        unordered_set<string> unknownAttributes; // assigned through receivers of unknown type
+
+        deque<int> worklist;
+        vector<bool> queued;
+        int current = 0;
+        bool sharedStateChanged = false; // module variables or attributes, which every function may read
+        vector<vector<FlowState>> breakStates;
+        vector<vector<FlowState>> continueStates;
+
+        void enqueue(int index) {
+            if (queued[index]) return;
+            queued[index] = true;
+            worklist.push_back(index);
+        }
+
+        static FlowState joinStates(const FlowState& a, const FlowState& b) {
+            if (!a.reachable) return b;
+            if (!b.reachable) return a;
+            FlowState result = a;
+            for (const auto& entry : b.vars) result.vars[entry.first] = joinTypes(result.vars[entry.first], entry.second);
+            return result;
+        }
+
+        static bool sameState(const FlowState& a, const FlowState& b) {
+            return a.reachable == b.reachable && a.vars == b.vars;
+        }
+
+        static bool joinInto(string& target, const string& type) {
+            string joined = joinTypes(target, type);
+            if (joined == target) return false;
+            target = joined;
+            return true;
+        }
+
+        // Types at a point only grow while the analysis runs, so joining keeps the final one; it
+        // also gives leaves the parser interned and shared the join over all their uses
+        static void annotate(const shared_ptr<ParseTreeNode>& node, const string& type) {
+            node->inferredType = joinTypes(node->inferredType, type);
+        }
+
+        // ---- Collecting functions and classes ----
+
+        void collectDefinitions(const shared_ptr<ParseTreeNode>& node, int function, int cls,
+                                unordered_map<string, vector<int>>& moduleDefs,
+                                unordered_map<string, vector<int>>& classDefs) {
+            for (const auto& child : node->children) {
+                if (child->type == "FunctionDefinition") {
+                    int index = functions.size();
+                    functions.emplace_back();
+                    FunctionSummary& summary = functions.back();
+                    summary.name = findChild(child, "Identifier")->value;
+                    summary.owner = cls;
+                    summary.node = child;
+                    for (const auto& param : findChild(child, "Parameters")->children) {
+                        if (param->type == "Parameter") summary.params.push_back(param->value);
+                    }
+                    summary.paramTypes.resize(summary.params.size());
+                    vector<string> bound = summary.params;
+                    collectBoundNames(findChild(child, "Suite"), bound);
+                    summary.locals.insert(bound.begin(), bound.end());
+
+                    if (cls >= 0) classes[cls].methods[summary.name] = index;
+                    else if (function == 0) moduleDefs[summary.name].push_back(index);
+                    else summary.escapes = true;
+                    collectDefinitions(findChild(child, "Suite"), index, -1, moduleDefs, classDefs);
+                } else if (child->type == "ClassDefinition") {
+                    int index = classes.size();
+                    classes.emplace_back();
+                    classes.back().name = findChild(child, "Identifier")->value;
+                    auto parent = findChild(child, "Parent");
+                    if (parent) classes.back().parent = parent->value;
+                    classOfNode[child.get()] = index;
+                    if (function == 0 && cls < 0) classDefs[classes.back().name].push_back(index);
+                    collectDefinitions(findChild(child, "Suite"), function, index, moduleDefs, classDefs);
+                } else {
+                    collectDefinitions(child, function, cls, moduleDefs, classDefs);
+                }
+            }
+        }
+
+        void markEscaping(int index) {
+            FunctionSummary& function = functions[index];
+            if (function.escapes) return;
+            function.escapes = true;
+            enqueue(index);
+        }
+
+        // Methods of a receiver the analysis cannot resolve may be any method with that name
+        void escapeMethods(const string& name) {
+            for (const auto& cls : classes) {
+                auto method = cls.methods.find(name);
+                if (method != cls.methods.end()) markEscaping(method->second);
+            }
+        }
+
+        // A function or class named anywhere except as the callee of a call can be called with
+        // arguments the analysis never sees
+        void findEscapingReferences(const shared_ptr<ParseTreeNode>& node) {
+            if (node->type == "Identifier") {
+                auto function = moduleFunctions.find(node->value);
+                if (function != moduleFunctions.end()) functions[function->second].escapes = true;
+                auto cls = moduleClasses.find(node->value);
+                if (cls != moduleClasses.end()) {
+                    auto init = classes[cls->second].methods.find("__init__");
+                    if (init != classes[cls->second].methods.end()) functions[init->second].escapes = true;
+                }
+                return;
+            }
+            size_t first = 0;
+            if (node->type == "FunctionDefinition" || node->type == "ClassDefinition" || node->type == "ForStatement") {
+                first = 1; // the name being bound
+            } else if (node->type == "FunctionCall" && semanticChildren(node)[0]->type == "Identifier") {
+                for (const auto& child : node->children) {
+                    if (child->type == "Arguments") findEscapingReferences(child);
+                }
+                return;
+            } else if (node->type == "FunctionCallStatement" && node->children[0]->type == "Identifier") {
+                first = 1;
+            } else if (node->type == "IdentifierList") {
+                for (const auto& child : node->children) {
+                    if (child->type != "Identifier") findEscapingReferences(child);
+                }
+                return;
+            }
+            auto children = semanticChildren(node);
+            for (size_t k = first; k < children.size(); k++) findEscapingReferences(children[k]);
+        }
+
+        // ---- Name lookup and binding ----
+
+        bool isLocal(const string& name) {
+            return current != 0 && functions[current].locals.count(name);
+        }
+
+        string lookupName(const string& name, FlowState& state) {
+            if (current == 0 || isLocal(name)) {
+                auto found = state.vars.find(name);
+                if (found != state.vars.end()) return found->second;
+                if (current != 0) return "";
+            }
+            if (current != 0) {
+                auto global = functions[0].localTypes.find(name);
+                if (global != functions[0].localTypes.end()) return global->second;
+            }
+            if (!moduleBound.count(name) && findBuiltin(name) >= 0) return "function";
+            return "";
+        }
+
+        void bindName(const string& name, const string& type, FlowState& state) {
+            state.vars[name] = type;
+            if (joinInto(functions[current].localTypes[name], type) && current == 0) sharedStateChanged = true;
+        }
+
+        int resolveClass(const string& name) {
+            auto found = moduleClasses.find(name);
+            return found == moduleClasses.end() ? -1 : found->second;
+        }
+
+        int findMethod(int cls, const string& name) {
+            for (int depth = 0; cls >= 0 && depth < (int)classes.size(); depth++) {
+                auto method = classes[cls].methods.find(name);
+                if (method != classes[cls].methods.end()) return method->second;
+                if (classes[cls].parent.empty()) return -1;
+                cls = resolveClass(classes[cls].parent);
+            }
+            return -1;
+        }
+
+        string attributeType(const string& receiver, const string& name) {
+            if (receiver.empty()) return "";
+            int cls = resolveClass(receiver);
+            if (cls < 0 || unknownAttributes.count(name)) return TYPE_UNKNOWN;
+            string type;
+            auto own = classes[cls].instanceAttributes.find(name);
+            if (own != classes[cls].instanceAttributes.end()) type = own->second;
+            for (int c = cls, depth = 0; c >= 0 && depth < (int)classes.size(); depth++) {
+                auto attribute = classes[c].classAttributes.find(name);
+                if (attribute != classes[c].classAttributes.end()) type = joinTypes(type, attribute->second);
+                if (classes[c].methods.count(name)) type = joinTypes(type, "function");
+                if (classes[c].parent.empty()) break;
+                c = resolveClass(classes[c].parent);
+                if (c < 0) return TYPE_UNKNOWN;
+            }
+            return type;
+        }
+
+        void storeAttribute(const string& receiver, const string& name, const string& type) {
+            if (receiver.empty()) return;
+            int cls = resolveClass(receiver);
+            if (cls < 0) {
+                if (unknownAttributes.insert(name).second) sharedStateChanged = true;
+                return;
+            }
+            if (joinInto(classes[cls].instanceAttributes[name], type)) sharedStateChanged = true;
+        }
+
+        void storeTarget(const shared_ptr<ParseTreeNode>& target, const string& type, FlowState& state) {
+            if (target->type == "Identifier") {
+                bindName(target->value, type, state);
+                return;
+            }
+            auto parts = semanticChildren(target);
+            if (target->type == "AttributeAccess") {
+                storeAttribute(analyzeExpression(parts[0], state), parts[1]->value, type);
+                return;
+            }
+            for (const auto& part : parts) analyzeExpression(part, state);
+        }
+
+        // ---- Calls ----
+
+        string callFunction(int index, const vector<string>& args) {
+            FunctionSummary& callee = functions[index];
+            callee.callers.insert(current);
+            if (!callee.escapes && args.size() == callee.params.size()) {
+                bool changed = false;
+                for (size_t k = 0; k < args.size(); k++) changed = joinInto(callee.paramTypes[k], args[k]) || changed;
+                if (changed) enqueue(index);
+            }
+            return callee.returnType;
+        }
+
+        static string builtinResult(const string& name) {
+            static const unordered_map<string, string> results = {
+                {"print", "None"}, {"input", "string"}, {"lower", "string"}, {"upper", "string"},
+                {"len", "int"}, {"range", "range"}, {"str", "string"}, {"int", "int"}, {"float", "float"},
+                {"bool", "bool"}, {"list", "list"}, {"dict", "dict"}, {"set", "set"}, {"tuple", "tuple"}};
+            auto found = results.find(name);
+            return found == results.end() ? TYPE_UNKNOWN : found->second;
+        }
+
+        // Mirrors the methods callNativeMethod implements
+        static string nativeMethodResult(const string& receiver, const string& name) {
+            if (receiver == "string") {
+                if (name == "upper" || name == "lower" || name == "strip" || name == "replace" || name == "join") return "string";
+                if (name == "startswith" || name == "endswith") return "bool";
+                if (name == "find") return "int";
+                if (name == "split") return "list";
+            } else if (receiver == "list") {
+                if (name == "append" || name == "insert" || name == "extend" || name == "reverse" || name == "sort") return "None";
+                if (name == "index" || name == "count") return "int";
+            } else if (receiver == "dict") {
+                if (name == "keys" || name == "values" || name == "items") return "list";
+                if (name == "update") return "None";
+            } else if (receiver == "set") {
+                if (name == "add") return "None";
+            }
+            return TYPE_UNKNOWN;
+        }
+
+        static bool isNativeType(const string& type) {
+            return type == "string" || type == "list" || type == "tuple" || type == "dict" || type == "set" ||
+                   type == "int" || type == "float" || type == "bool" || type == "None" || type == "range";
+        }
+
+        string callMethod(const string& receiver, const string& name, vector<string> args) {
+            if (receiver.empty()) return "";
+            int cls = resolveClass(receiver);
+            if (cls >= 0) {
+                if (unknownAttributes.count(name) || classes[cls].instanceAttributes.count(name)) return TYPE_UNKNOWN;
+                int method = findMethod(cls, name);
+                if (method < 0) return TYPE_UNKNOWN;
+                args.insert(args.begin(), receiver);
+                return callFunction(method, args);
+            }
+            if (isNativeType(receiver)) return nativeMethodResult(receiver, name);
+            escapeMethods(name);
+            return TYPE_UNKNOWN;
+        }
+
+        vector<string> analyzeArguments(const shared_ptr<ParseTreeNode>& node, FlowState& state) {
+            vector<string> args;
+            auto arguments = findChild(node, "Arguments");
+            if (!arguments) return args;
+            for (const auto& arg : semanticChildren(arguments)) args.push_back(analyzeExpression(arg, state));
+            return args;
+        }
+
+        string analyzeCall(const shared_ptr<ParseTreeNode>& node, FlowState& state) {
+            shared_ptr<ParseTreeNode> callee = node->type == "FunctionCall" ? semanticChildren(node)[0] : node->children[0];
+
+            if (callee->type == "AttributeAccess" || callee->type == "DottedName") {
+                string receiver;
+                string method;
+                if (callee->type == "AttributeAccess") {
+                    auto parts = semanticChildren(callee);
+                    receiver = analyzeExpression(parts[0], state);
+                    method = parts[1]->value;
+                } else {
+                    vector<string> names;
+                    for (const auto& part : callee->children) {
+                        if (part->type == "NamePart") names.push_back(part->value);
+                    }
+                    receiver = lookupName(names[0], state);
+                    for (size_t k = 1; k + 1 < names.size(); k++) receiver = attributeType(receiver, names[k]);
+                    method = names.back();
+                }
+                vector<string> args = analyzeArguments(node, state);
+                annotate(callee, "function");
+                return callMethod(receiver, method, args);
+            }
+
+            vector<string> args = analyzeArguments(node, state);
+            if (callee->type == "Identifier" && !isLocal(callee->value)) {
+                const string& name = callee->value;
+                auto function = moduleFunctions.find(name);
+                if (function != moduleFunctions.end()) {
+                    annotate(callee, "function");
+                    return callFunction(function->second, args);
+                }
+                int cls = resolveClass(name);
+                if (cls >= 0) {
+                    annotate(callee, "class");
+                    int init = findMethod(cls, "__init__");
+                    if (init >= 0) {
+                        args.insert(args.begin(), name);
+                        callFunction(init, args);
+                    }
+                    return name;
+                }
+                if (!moduleBound.count(name) && findBuiltin(name) >= 0) {
+                    annotate(callee, "function");
+                    return builtinResult(name);
+                }
+            }
+            return analyzeExpression(callee, state).empty() ? "" : TYPE_UNKNOWN;
+        }
+
+        // ---- Expressions ----
+
+        static bool isIntLike(const string& type) { return type == "int" || type == "bool"; }
+
+        static string arithmeticType(const string& op, const string& a, const string& b) {
+            if (a.empty() || b.empty()) return "";
+            bool numeric = (isIntLike(a) || a == "float") && (isIntLike(b) || b == "float");
+            if (numeric) {
+                if (op == "/" || a == "float" || b == "float") return "float";
+                return "int";
+            }
+            bool aSequence = a == "string" || a == "list" || a == "tuple";
+            bool bSequence = b == "string" || b == "list" || b == "tuple";
+            if (op == "+" && a == b && aSequence) return a;
+            if (op == "*" && aSequence && isIntLike(b)) return a;
+            if (op == "*" && bSequence && isIntLike(a)) return b;
+            return TYPE_UNKNOWN;
+        }
+
+        static string literalType(const LiteralValue& literal) {
+            switch (literal.kind) {
+                case LIT_INT:
+                case LIT_BIG_INT: return "int";
+                case LIT_FLOAT: return "float";
+                default: return "string";
+            }
+        }
+
+        string analyzeExpression(const shared_ptr<ParseTreeNode>& node, FlowState& state) {
+            string type = expressionType(node, state);
+            annotate(node, type);
+            return type;
+        }
+
+        string expressionType(const shared_ptr<ParseTreeNode>& node, FlowState& state) {
+            const string& type = node->type;
+            if (type == "Literal") {
+                const LiteralValue& literal = literalOf(node);
+                // Calls inside replacement fields still pass arguments
+                for (const auto& segment : literal.segments) {
+                    if (!segment.isExpression) continue;
+                    auto expression = parseEmbeddedExpression(segment.text);
+                    if (expression) analyzeExpression(expression, state);
+                }
+                return literalType(literal);
+            }
+            if (type == "Identifier") return lookupName(node->value, state);
+            if (type == "Keyword") {
+                if (node->value == "True" || node->value == "False") return "bool";
+                if (node->value == "None") return "None";
+                return TYPE_UNKNOWN;
+            }
+            if (type == "ParenExpr") return analyzeExpression(semanticChildren(node)[0], state);
+            if (type == "List" || type == "Tuple" || (type == "ExpressionList" && !isArithChain(node))) {
+                for (const auto& item : semanticChildren(node)) analyzeExpression(item, state);
+                return type == "List" ? "list" : "tuple";
+            }
+            if (type == "Dict") {
+                for (const auto& pair : semanticChildren(node)) {
+                    for (const auto& part : semanticChildren(pair)) analyzeExpression(part, state);
+                }
+                return "dict";
+            }
+            if (type == "ExpressionList") {
+                auto items = semanticChildren(node);
+                string result = analyzeExpression(items[0], state);
+                for (size_t k = 1; k + 1 < items.size(); k += 2) {
+                    result = arithmeticType(items[k]->value, result, analyzeExpression(items[k + 1], state));
+                }
+                return result;
+            }
+            if (type == "BinaryOp") {
+                auto operands = semanticChildren(node);
+                if (operands.size() != 2) return TYPE_UNKNOWN;
+                string left = analyzeExpression(operands[0], state);
+                string right = analyzeExpression(operands[1], state);
+                if (node->value == "and" || node->value == "or") return joinTypes(left, right);
+                return arithmeticType(node->value, left, right);
+            }
+            if (type == "UnaryOp") {
+                string operand = analyzeExpression(semanticChildren(node)[0], state);
+                if (node->value == "not") return "bool";
+                if (operand.empty()) return "";
+                if (isIntLike(operand)) return "int";
+                if (operand == "float" && node->value != "~") return "float";
+                return TYPE_UNKNOWN;
+            }
+            if (type == "Comparison") {
+                for (const auto& part : semanticChildren(node)) {
+                    if (part->type != "ComparisonOp") analyzeExpression(part, state);
+                }
+                return "bool";
+            }
+            if (type == "TernaryOp") {
+                auto parts = semanticChildren(node);
+                analyzeExpression(parts[1], state);
+                return joinTypes(analyzeExpression(parts[0], state), analyzeExpression(parts[2], state));
+            }
+            if (type == "AttributeAccess") {
+                auto parts = semanticChildren(node);
+                string receiver = analyzeExpression(parts[0], state);
+                // A method read without calling it becomes a bound method that can go anywhere
+                if (!receiver.empty() && resolveClass(receiver) < 0 && !isNativeType(receiver)) escapeMethods(parts[1]->value);
+                if (resolveClass(receiver) >= 0) {
+                    int method = findMethod(resolveClass(receiver), parts[1]->value);
+                    if (method >= 0) markEscaping(method);
+                }
+                return attributeType(receiver, parts[1]->value);
+            }
+            if (type == "Subscript") {
+                auto parts = semanticChildren(node);
+                string container = analyzeExpression(parts[0], state);
+                analyzeExpression(parts[1], state);
+                if (container.empty()) return "";
+                return container == "string" ? "string" : TYPE_UNKNOWN;
+            }
+            if (type == "FunctionCall" || type == "FunctionCallStatement") return analyzeCall(node, state);
+            return TYPE_UNKNOWN;
+        }
+
+        // ---- Statements ----
+
+        static string elementType(const string& iterable) {
+            if (iterable.empty()) return "";
+            if (iterable == "range") return "int";
+            if (iterable == "string") return "string";
+            return TYPE_UNKNOWN;
+        }
+
+        void analyzeBlock(const shared_ptr<ParseTreeNode>& block, FlowState& state) {
+            for (const auto& statement : block->children) {
+                if (!state.reachable) return;
+                analyzeStatement(statement, state);
+            }
+        }
+
+        // Runs 'body' from the loop head until the state at the head stops changing; the result is
+        // the state on leaving the loop
+        template <typename Body>
+        FlowState analyzeLoop(const FlowState& entry, Body body) {
+            FlowState head = entry;
+            for (;;) {
+                breakStates.emplace_back();
+                continueStates.emplace_back();
+                FlowState iteration = head;
+                body(iteration);
+                FlowState next = joinStates(head, iteration);
+                for (const auto& state : continueStates.back()) next = joinStates(next, state);
+                vector<FlowState> breaks = move(breakStates.back());
+                breakStates.pop_back();
+                continueStates.pop_back();
+                if (sameState(next, head)) {
+                    FlowState exit = head;
+                    for (const auto& state : breaks) exit = joinStates(exit, state);
+                    return exit;
+                }
+                head = next;
+            }
+        }
+
+        void analyzeIf(const shared_ptr<ParseTreeNode>& node, FlowState& state) {
+            auto parts = semanticChildren(node);
+            // parts: condition, Suite, then any ElifClause and an optional ElseClause
+            analyzeExpression(parts[0], state);
+            FlowState result;
+            result.reachable = false;
+            FlowState branch = state;
+            analyzeBlock(parts[1], branch);
+            result = joinStates(result, branch);
+
+            bool hasElse = false;
+            for (size_t k = 2; k < parts.size(); k++) {
+                if (parts[k]->type == "ElifClause") {
+                    auto clause = semanticChildren(parts[k]);
+                    analyzeExpression(clause[0], state);
+                    branch = state;
+                    analyzeBlock(clause[1], branch);
+                } else {
+                    hasElse = true;
+                    branch = state;
+                    analyzeBlock(findChild(parts[k], "Suite"), branch);
+                }
+                result = joinStates(result, branch);
+            }
+            state = hasElse ? result : joinStates(result, state);
+        }
+
+        void analyzeAssignment(const shared_ptr<ParseTreeNode>& node, FlowState& state) {
+            auto targets = semanticChildren(findChild(node, "IdentifierList"));
+            string op = findChild(node, "AssignOp")->value;
+            auto valueNode = semanticChildren(node).back();
+            // Unpacking a display of the same length keeps each item's type
+            bool display = targets.size() > 1 && (valueNode->type == "Tuple" || valueNode->type == "List" ||
+                                                  (valueNode->type == "ExpressionList" && !isArithChain(valueNode)));
+            vector<string> itemTypes;
+            string value;
+            if (display) {
+                for (const auto& item : semanticChildren(valueNode)) itemTypes.push_back(analyzeExpression(item, state));
+                value = valueNode->type == "List" ? "list" : "tuple";
+                annotate(valueNode, value);
+            } else {
+                value = analyzeExpression(valueNode, state);
+            }
+
+            if (op != "=") {
+                string binary = op.substr(0, op.size() - 1);
+                auto target = targets[0];
+                string before;
+                if (target->type == "Identifier") {
+                    before = lookupName(target->value, state);
+                } else if (target->type == "AttributeAccess") {
+                    auto parts = semanticChildren(target);
+                    before = attributeType(analyzeExpression(parts[0], state), parts[1]->value);
+                } else {
+                    before = analyzeExpression(target, state);
+                }
+                string result = arithmeticType(binary, before, value);
+                annotate(target, result);
+                storeTarget(target, result, state);
+                return;
+            }
+
+            if (targets.size() == 1) {
+                annotate(targets[0], value);
+                storeTarget(targets[0], value, state);
+                return;
+            }
+            for (size_t k = 0; k < targets.size(); k++) {
+                string type = value.empty() ? "" : itemTypes.size() == targets.size() ? itemTypes[k] : TYPE_UNKNOWN;
+                annotate(targets[k], type);
+                storeTarget(targets[k], type, state);
+            }
+        }
+
+        void analyzeClassBody(const shared_ptr<ParseTreeNode>& node, FlowState& state) {
+            auto found = classOfNode.find(node.get());
+            if (found == classOfNode.end()) return;
+            ClassSummary& cls = classes[found->second];
+            for (const auto& statement : findChild(node, "Suite")->children) {
+                if (statement->type != "Assignment") continue;
+                auto targets = semanticChildren(findChild(statement, "IdentifierList"));
+                string value = analyzeExpression(semanticChildren(statement).back(), state);
+                if (targets.size() == 1 && targets[0]->type == "Identifier") {
+                    annotate(targets[0], value);
+                    if (joinInto(cls.classAttributes[targets[0]->value], value)) sharedStateChanged = true;
+                }
+            }
+        }
+
+        void analyzeStatement(const shared_ptr<ParseTreeNode>& node, FlowState& state) {
+            const string& type = node->type;
+            if (type == "ExpressionStatement") {
+                analyzeExpression(semanticChildren(node)[0], state);
+            } else if (type == "FunctionCallStatement") {
+                analyzeExpression(node, state);
+            } else if (type == "Assignment") {
+                analyzeAssignment(node, state);
+            } else if (type == "IfStatement") {
+                analyzeIf(node, state);
+            } else if (type == "WhileStatement") {
+                auto parts = semanticChildren(node);
+                analyzeExpression(parts[0], state);
+                state = analyzeLoop(state, [&](FlowState& iteration) {
+                    analyzeBlock(parts[1], iteration);
+                    if (iteration.reachable) analyzeExpression(parts[0], iteration);
+                });
+            } else if (type == "ForStatement") {
+                auto parts = semanticChildren(node);
+                // parts: loop variable, iterable, Suite
+                string item = elementType(analyzeExpression(parts[1], state));
+                annotate(parts[0], item);
+                state = analyzeLoop(state, [&](FlowState& iteration) {
+                    bindName(parts[0]->value, item, iteration);
+                    analyzeBlock(parts[2], iteration);
+                });
+            } else if (type == "FunctionDefinition") {
+                bindName(findChild(node, "Identifier")->value, "function", state);
+            } else if (type == "ClassDefinition") {
+                analyzeClassBody(node, state);
+                bindName(findChild(node, "Identifier")->value, "class", state);
+            } else if (type == "ReturnStatement") {
+                auto parts = semanticChildren(node);
+                string value = parts.empty() ? "None" : analyzeExpression(parts[0], state);
+                joinInto(functions[current].returnType, value);
+                state.reachable = false;
+            } else if (type == "BreakStatement" || type == "ContinueStatement") {
+                if (!breakStates.empty()) {
+                    (type == "BreakStatement" ? breakStates : continueStates).back().push_back(state);
+                }
+                state.reachable = false;
+            } else if (type == "Suite") {
+                analyzeBlock(node, state);
+            }
+        }
+
+        void analyzeFunction(int index) {
+            current = index;
+            FunctionSummary& function = functions[index];
+            string returnBefore = function.returnType;
+            FlowState state;
+            for (size_t k = 0; k < function.params.size(); k++) {
+                if (function.escapes) function.paramTypes[k] = TYPE_UNKNOWN;
+                bindName(function.params[k], function.paramTypes[k], state);
+            }
+            analyzeBlock(index == 0 ? function.node : findChild(function.node, "Suite"), state);
+            if (index != 0 && state.reachable) joinInto(function.returnType, "None");
+
+            if (function.returnType != returnBefore) {
+                for (int caller : function.callers) enqueue(caller);
+            }
+        }
+
+    public:
+        // Runs the analysis to a fixed point; the types end up on the tree's nodes
+        void analyze(const shared_ptr<ParseTreeNode>& program) {
+            functions.assign(1, FunctionSummary());
+            functions[0].name = "<module>";
+            functions[0].node = program;
+            vector<string> bound;
+            collectBoundNames(program, bound);
+            functions[0].locals.insert(bound.begin(), bound.end());
+            unordered_map<string, int> bindings;
+            for (const auto& name : bound) bindings[name]++;
+            moduleBound = functions[0].locals;
+
+            unordered_map<string, vector<int>> moduleDefs;
+            unordered_map<string, vector<int>> classDefs;
+            collectDefinitions(program, 0, -1, moduleDefs, classDefs);
+            for (const auto& entry : moduleDefs) {
+                if (entry.second.size() == 1 && bindings[entry.first] == 1) moduleFunctions[entry.first] = entry.second[0];
+                else for (int index : entry.second) functions[index].escapes = true;
+            }
+            for (const auto& entry : classDefs) {
+                if (entry.second.size() == 1 && bindings[entry.first] == 1) moduleClasses[entry.first] = entry.second[0];
+            }
+            for (size_t cls = 0; cls < classes.size(); cls++) {
+                if (moduleClasses.count(classes[cls].name) && moduleClasses[classes[cls].name] == (int)cls) continue;
+                for (const auto& method : classes[cls].methods) functions[method.second].escapes = true;
+            }
+            findEscapingReferences(program);
+            for (auto& function : functions) {
+                if (function.escapes) function.paramTypes.assign(function.params.size(), TYPE_UNKNOWN);
+            }
+
+            queued.assign(functions.size(), false);
+            for (size_t k = 0; k < functions.size(); k++) enqueue(k);
+            while (!worklist.empty()) {
+                int index = worklist.front();
+                worklist.pop_front();
+                queued[index] = false;
+                sharedStateChanged = false;
+                analyzeFunction(index);
+                if (sharedStateChanged) {
+                    for (size_t k = 0; k < functions.size(); k++) enqueue(k);
+                }
+            }
+        }
+
+        // The lexer files a variable under the function it first appears in, or under "global"
+        // once it shows up anywhere else
+        string symbolType(const Identifier& symbol) const {
+            if (symbol.type == "function" || symbol.type == "class") return symbol.type;
+            string type;
+            auto module = functions[0].localTypes.find(symbol.name);
+            if (symbol.Scope == "global" && module != functions[0].localTypes.end()) {
+                type = module->second;
+            } else {
+                for (size_t k = 1; k < functions.size(); k++) {
+                    if (symbol.Scope != "global" && functions[k].name != symbol.Scope) continue;
+                    auto local = functions[k].localTypes.find(symbol.name);
+                    if (local != functions[k].localTypes.end()) type = joinTypes(type, local->second);
+                }
+                for (const auto& cls : classes) {
+                    if (cls.name != symbol.Scope) continue;
+                    auto attribute = cls.classAttributes.find(symbol.name);
+                    if (attribute != cls.classAttributes.end()) type = joinTypes(type, attribute->second);
+                }
+            }
+            // The lexer's scope tracking can leave a module variable under the last 'def' it saw
+            if (type.empty() && module != functions[0].localTypes.end()) type = module->second;
+            return type.empty() ? TYPE_UNKNOWN : type;
+        }
+
+        void annotateSymbols(Lexer& lexer) const {
+            const vector<Identifier>& symbols = lexer.getsymbols();
+            for (size_t k = 0; k < symbols.size(); k++) lexer.setSymbolType(k, symbolType(symbols[k]));
+        }
+
+        // Signatures and local types of every function, for --types
+        void printSummary(ostream& out) const {
+            auto shown = [](const string& type) { return type.empty() ? TYPE_UNKNOWN : type; };
+            out << "--- Inferred Types ---" << endl;
+            for (size_t k = 0; k < functions.size(); k++) {
+                const FunctionSummary& function = functions[k];
+                unordered_set<string> params(function.params.begin(), function.params.end());
+                if (k == 0) {
+                    out << function.name << endl;
+                } else {
+                    out << (function.owner >= 0 ? classes[function.owner].name + "." : "") << function.name << "(";
+                    for (size_t p = 0; p < function.params.size(); p++) {
+                        out << (p ? ", " : "") << function.params[p] << ": " << shown(function.paramTypes[p]);
+                    }
+                    out << ") -> " << shown(function.returnType) << endl;
+                }
+                vector<string> names;
+                for (const auto& local : function.localTypes) {
+                    if (!params.count(local.first)) names.push_back(local.first);
+                }
+                sort(names.begin(), names.end());
+                for (const auto& name : names) out << "    " << name << ": " << shown(function.localTypes.at(name)) << endl;
+            }
+            for (const auto& cls : classes) {
+                vector<string> names;
+                for (const auto& attribute : cls.instanceAttributes) names.push_back(attribute.first);
+                sort(names.begin(), names.end());
+                for (const auto& name : names) {
+                    out << cls.name << "." << name << ": " << shown(cls.instanceAttributes.at(name)) << endl;
+                }
+            }
+        }
+};
+
+// Runs the pass over the tree and writes the inferred types into the lexer's symbol table
+void inferTypes(const shared_ptr<ParseTreeNode>& tree, Lexer& lexer, bool printSummary = false) {
+    TypeInference inference;
+    inference.analyze(tree);
+    inference.annotateSymbols(lexer);
+    if (printSummary) inference.printSummary(cout);
+}
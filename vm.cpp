@@ -0,0 +1,1221 @@
+#include <unordered_map>
+#include <unordered_set>
+using namespace std;
+
+// Bytecode backend: BytecodeCompiler lowers the parse tree into compact per-function bytecode
+// (one opcode byte followed by little-endian operands) and VirtualMachine runs it on a value stack.
+
+// X(name, operand bytes)
+#define VM_OPCODES(X) \
+    X(CONST, 2) X(NONE, 0) X(TRUE, 0) X(FALSE, 0) \
+    X(LOAD_LOCAL, 2) X(STORE_LOCAL, 2) X(LOAD_GLOBAL, 2) X(STORE_GLOBAL, 2) X(LOAD_BUILTIN, 2) \
+    X(LOAD_ATTR, 2) X(STORE_ATTR, 2) X(LOAD_SUBSCR, 0) X(STORE_SUBSCR, 0) \
+    X(POP, 0) X(DUP, 0) X(DUP2, 0) X(ROT2, 0) X(ROT3, 0) \
+    X(ADD, 0) X(SUB, 0) X(MUL, 0) X(DIV, 0) X(FLOORDIV, 0) X(MOD, 0) \
+    X(NEG, 0) X(POS, 0) X(INVERT, 0) X(NOT, 0) \
+    X(LT, 0) X(GT, 0) X(EQ, 0) X(NE, 0) X(LE, 0) X(GE, 0) X(IN, 0) X(NOT_IN, 0) \
+    X(JUMP, 4) X(JUMP_IF_FALSE, 4) X(JUMP_IF_FALSE_OR_POP, 4) X(JUMP_IF_TRUE_OR_POP, 4) \
+    X(GET_ITER, 0) X(FOR_ITER, 4) \
+    X(BUILD_LIST, 2) X(BUILD_TUPLE, 2) X(BUILD_DICT, 2) X(BUILD_STRING, 2) X(FORMAT, 2) X(UNPACK, 2) \
+    X(MAKE_CLASS, 4) X(CALL, 2) X(CALL_METHOD, 4) X(RETURN, 0)
+
+enum OpCode : uint8_t {
+#define X(name, bytes) OP_##name,
+    VM_OPCODES(X)
+#undef X
+    OP_COUNT
+};
+
+const char* opcodeName(uint8_t op) {
+    static const char* names[] = {
+#define X(name, bytes) #name,
+        VM_OPCODES(X)
+#undef X
+    };
+    return op < OP_COUNT ? names[op] : "???";
+}
+
+int opcodeOperandBytes(uint8_t op) {
+    static const int sizes[] = {
+#define X(name, bytes) bytes,
+        VM_OPCODES(X)
+#undef X
+    };
+    return op < OP_COUNT ? sizes[op] : 0;
+}
+
+struct CodeObject {
+    string name;
+    vector<uint8_t> code;
+    int arity = 0;
+    int numLocals = 0;
+    int maxStack = 0;
+    vector<string> localNames;
+};
+
+struct BytecodeModule {
+    vector<CodeObject> functions; // functions[0] is the module body
+    vector<Value> constants;
+    vector<string> names;         // attribute names, method names and format specs
+    vector<string> globalNames;
+};
+
+class BytecodeCompiler {
+    private:
+        struct LoopContext {
+            size_t continueTarget;
+            bool isFor;
+            vector<size_t> breakJumps;
+        };
+
+        struct FunctionState {
+            int codeIndex;
+            bool isModule;
+            unordered_map<string, int> locals;
+            int depth = 0;
+            vector<LoopContext> loops;
+        };
+
+        BytecodeModule module;
+        const vector<Identifier>& symbols;
+        unordered_map<string, int> globalSlots;
+        unordered_set<string> moduleBound;
+        unordered_map<string, int> constantIndex;
+        unordered_map<string, int> nameIndex;
+        FunctionState* current = nullptr;
+
+        [[noreturn]] void compileError(const string& message) {
+            throw runtime_error("Compile Error: " + message);
+        }
+
+        CodeObject& code() {
+            return module.functions[current->codeIndex];
+        }
+
+        void adjust(int stackEffect) {
+            current->depth += stackEffect;
+            if (current->depth > code().maxStack) code().maxStack = current->depth;
+        }
+
+        void emitU16(int value) {
+            if (value < 0 || value > 0xFFFF) compileError("operand out of range (too many names or constants)");
+            code().code.push_back(value & 0xFF);
+            code().code.push_back((value >> 8) & 0xFF);
+        }
+
+        void emitU32At(size_t offset, uint32_t value) {
+            for (int k = 0; k < 4; k++) code().code[offset + k] = (value >> (8 * k)) & 0xFF;
+        }
+
+        void emit(OpCode op, int stackEffect) {
+            code().code.push_back(op);
+            adjust(stackEffect);
+        }
+
+        void emit(OpCode op, int arg, int stackEffect) {
+            emit(op, stackEffect);
+            emitU16(arg);
+        }
+
+        void emit(OpCode op, int arg1, int arg2, int stackEffect) {
+            emit(op, stackEffect);
+            emitU16(arg1);
+            emitU16(arg2);
+        }
+
+        // Emits a jump with a placeholder target; returns the operand offset for patchJump
+        size_t emitJump(OpCode op, int stackEffect) {
+            emit(op, stackEffect);
+            size_t at = code().code.size();
+            code().code.insert(code().code.end(), 4, 0);
+            return at;
+        }
+
+        void patchJump(size_t at) {
+            emitU32At(at, (uint32_t)code().code.size());
+        }
+
+        void emitJumpTo(OpCode op, size_t target, int stackEffect) {
+            emitU32At(emitJump(op, stackEffect), (uint32_t)target);
+        }
+
+        int addConstant(const string& key, const Value& value) {
+            auto it = constantIndex.find(key);
+            if (it != constantIndex.end()) return it->second;
+            int index = module.constants.size();
+            module.constants.push_back(value);
+            constantIndex[key] = index;
+            return index;
+        }
+
+        int addName(const string& name) {
+            auto it = nameIndex.find(name);
+            if (it != nameIndex.end()) return it->second;
+            int index = module.names.size();
+            module.names.push_back(name);
+            nameIndex[name] = index;
+            return index;
+        }
+
+        int globalSlot(const string& name) {
+            auto it = globalSlots.find(name);
+            if (it != globalSlots.end()) return it->second;
+            int slot = module.globalNames.size();
+            module.globalNames.push_back(name);
+            globalSlots[name] = slot;
+            return slot;
+        }
+
+        void compileLoad(const string& name) {
+            if (!current->isModule) {
+                auto it = current->locals.find(name);
+                if (it != current->locals.end()) {
+                    emit(OP_LOAD_LOCAL, it->second, 1);
+                    return;
+                }
+            }
+            int builtin = findBuiltin(name);
+            if (builtin >= 0 && !moduleBound.count(name)) {
+                emit(OP_LOAD_BUILTIN, builtin, 1);
+            } else {
+                emit(OP_LOAD_GLOBAL, globalSlot(name), 1);
+            }
+        }
+
+        void compileStoreName(const string& name) {
+            if (!current->isModule) {
+                emit(OP_STORE_LOCAL, current->locals.at(name), -1);
+            } else {
+                emit(OP_STORE_GLOBAL, globalSlot(name), -1);
+            }
+        }
+
+        // Stores the value on top of the stack into an assignment target
+        void compileStoreTarget(const shared_ptr<ParseTreeNode>& target) {
+            if (target->type == "Identifier") {
+                compileStoreName(target->value);
+            } else if (target->type == "AttributeAccess") {
+                auto parts = semanticChildren(target);
+                compileExpression(parts[0]);
+                emit(OP_STORE_ATTR, addName(parts[1]->value), -2);
+            } else if (target->type == "Subscript") {
+                auto parts = semanticChildren(target);
+                compileExpression(parts[0]);
+                compileExpression(parts[1]);
+                emit(OP_STORE_SUBSCR, -3);
+            } else {
+                compileError("cannot assign to " + target->type);
+            }
+        }
+
+        // ---- Statements ----
+
+        void compileBlock(const shared_ptr<ParseTreeNode>& block) {
+            for (const auto& statement : block->children) compileStatement(statement);
+        }
+
+        void compileStatement(const shared_ptr<ParseTreeNode>& node) {
+            const string& type = node->type;
+            if (type == "ExpressionStatement") {
+                compileExpression(semanticChildren(node)[0]);
+                emit(OP_POP, -1);
+            } else if (type == "FunctionCallStatement") {
+                compileExpression(node);
+                emit(OP_POP, -1);
+            } else if (type == "Assignment") {
+                compileAssignment(node);
+            } else if (type == "IfStatement") {
+                compileIf(node);
+            } else if (type == "WhileStatement") {
+                compileWhile(node);
+            } else if (type == "ForStatement") {
+                compileFor(node);
+            } else if (type == "FunctionDefinition") {
+                compileFunctionDefinition(node);
+                compileStoreName(findChild(node, "Identifier")->value);
+            } else if (type == "ClassDefinition") {
+                compileClassDefinition(node);
+            } else if (type == "ReturnStatement") {
+                if (current->isModule) compileError("'return' outside function");
+                auto parts = semanticChildren(node);
+                if (parts.empty()) emit(OP_NONE, 1);
+                else compileExpression(parts[0]);
+                emit(OP_RETURN, -1);
+            } else if (type == "BreakStatement") {
+                if (current->loops.empty()) compileError("'break' outside loop");
+                LoopContext& loop = current->loops.back();
+                if (loop.isFor) emit(OP_POP, -1);
+                loop.breakJumps.push_back(emitJump(OP_JUMP, 0));
+                if (loop.isFor) adjust(1);
+            } else if (type == "ContinueStatement") {
+                if (current->loops.empty()) compileError("'continue' not properly in loop");
+                emitJumpTo(OP_JUMP, current->loops.back().continueTarget, 0);
+            } else if (type == "PassStatement") {
+                // nothing to do
+            } else if (type == "Suite") {
+                compileBlock(node);
+            } else if (type == "ImportStatement") {
+                compileError("import is not supported by the bytecode VM");
+            } else {
+                compileError("unsupported statement " + type);
+            }
+        }
+
+        void compileAssignment(const shared_ptr<ParseTreeNode>& node) {
+            auto targets = semanticChildren(findChild(node, "IdentifierList"));
+            auto parts = semanticChildren(node);
+            string op = findChild(node, "AssignOp")->value;
+            auto value = parts.back();
+
+            if (op == "=") {
+                if (targets.size() == 1) {
+                    compileExpression(value);
+                    compileStoreTarget(targets[0]);
+                    return;
+                }
+                compileExpression(value);
+                emit(OP_UNPACK, targets.size(), (int)targets.size() - 1);
+                for (const auto& target : targets) compileStoreTarget(target);
+                return;
+            }
+
+            BinaryOperator binary;
+            if (targets.size() != 1 || !binaryOperatorFromString(op.substr(0, op.size() - 1), binary)) {
+                compileError("illegal expression for augmented assignment");
+            }
+            OpCode arith = arithmeticOpcode(binary);
+            auto target = targets[0];
+            if (target->type == "Identifier") {
+                compileLoad(target->value);
+                compileExpression(value);
+                emit(arith, -1);
+                compileStoreName(target->value);
+            } else if (target->type == "AttributeAccess") {
+                auto attr = semanticChildren(target);
+                int name = addName(attr[1]->value);
+                compileExpression(attr[0]);
+                emit(OP_DUP, 1);
+                emit(OP_LOAD_ATTR, name, 0);
+                compileExpression(value);
+                emit(arith, -1);
+                emit(OP_ROT2, 0);
+                emit(OP_STORE_ATTR, name, -2);
+            } else if (target->type == "Subscript") {
+                auto sub = semanticChildren(target);
+                compileExpression(sub[0]);
+                compileExpression(sub[1]);
+                emit(OP_DUP2, 2);
+                emit(OP_LOAD_SUBSCR, -1);
+                compileExpression(value);
+                emit(arith, -1);
+                emit(OP_ROT3, 0);
+                emit(OP_STORE_SUBSCR, -3);
+            } else {
+                compileError("illegal expression for augmented assignment");
+            }
+        }
+
+        void compileConditionalBranch(const shared_ptr<ParseTreeNode>& condition, const shared_ptr<ParseTreeNode>& suite,
+                                      bool more, vector<size_t>& endJumps) {
+            compileExpression(condition);
+            size_t skip = emitJump(OP_JUMP_IF_FALSE, -1);
+            compileBlock(suite);
+            if (more) endJumps.push_back(emitJump(OP_JUMP, 0));
+            patchJump(skip);
+        }
+
+        void compileIf(const shared_ptr<ParseTreeNode>& node) {
+            auto parts = semanticChildren(node);
+            // parts: condition, Suite, then any ElifClause and an optional ElseClause
+            vector<size_t> endJumps;
+            compileConditionalBranch(parts[0], parts[1], parts.size() > 2, endJumps);
+            for (size_t k = 2; k < parts.size(); k++) {
+                if (parts[k]->type == "ElifClause") {
+                    auto clause = semanticChildren(parts[k]);
+                    compileConditionalBranch(clause[0], clause[1], k + 1 < parts.size(), endJumps);
+                } else {
+                    compileBlock(findChild(parts[k], "Suite"));
+                }
+            }
+            for (size_t jump : endJumps) patchJump(jump);
+        }
+
+        void compileWhile(const shared_ptr<ParseTreeNode>& node) {
+            auto parts = semanticChildren(node);
+            size_t loopStart = code().code.size();
+            compileExpression(parts[0]);
+            size_t exit = emitJump(OP_JUMP_IF_FALSE, -1);
+            current->loops.push_back({loopStart, false, {}});
+            compileBlock(parts[1]);
+            emitJumpTo(OP_JUMP, loopStart, 0);
+            patchJump(exit);
+            for (size_t jump : current->loops.back().breakJumps) patchJump(jump);
+            current->loops.pop_back();
+        }
+
+        void compileFor(const shared_ptr<ParseTreeNode>& node) {
+            auto parts = semanticChildren(node);
+            // parts: loop variable, iterable, Suite
+            compileExpression(parts[1]);
+            emit(OP_GET_ITER, 0);
+            size_t loopStart = code().code.size();
+            size_t exit = emitJump(OP_FOR_ITER, 1);
+            compileStoreName(parts[0]->value);
+            current->loops.push_back({loopStart, true, {}});
+            compileBlock(parts[2]);
+            emitJumpTo(OP_JUMP, loopStart, 0);
+            patchJump(exit);
+            adjust(-1); // FOR_ITER pops the exhausted iterator
+            for (size_t jump : current->loops.back().breakJumps) patchJump(jump);
+            current->loops.pop_back();
+        }
+
+        // Compiles the body into a new code object and pushes the function as a constant
+        void compileFunctionDefinition(const shared_ptr<ParseTreeNode>& node) {
+            string name = findChild(node, "Identifier")->value;
+            vector<string> params;
+            for (const auto& param : findChild(node, "Parameters")->children) {
+                if (param->type == "Parameter") params.push_back(param->value);
+            }
+
+            int index = module.functions.size();
+            module.functions.emplace_back();
+            module.functions[index].name = name;
+            module.functions[index].arity = params.size();
+
+            FunctionState state;
+            state.codeIndex = index;
+            state.isModule = false;
+            vector<string> bound = params;
+            auto body = findChild(node, "Suite");
+            collectBoundNames(body, bound);
+            for (const auto& local : bound) {
+                if (!state.locals.count(local)) {
+                    int slot = state.locals.size();
+                    state.locals[local] = slot;
+                    module.functions[index].localNames.push_back(local);
+                }
+            }
+
+            FunctionState* saved = current;
+            current = &state;
+            compileBlock(body);
+            emit(OP_NONE, 1);
+            emit(OP_RETURN, -1);
+            code().numLocals = state.locals.size();
+            current = saved;
+
+            emit(OP_CONST, addConstant("f:" + to_string(index), makeFunction(name, params.size(), index)), 1);
+        }
+
+        // Class bodies may hold methods and plain attribute assignments
+        void compileClassDefinition(const shared_ptr<ParseTreeNode>& node) {
+            string name = findChild(node, "Identifier")->value;
+            auto parent = findChild(node, "Parent");
+            if (parent) compileLoad(parent->value);
+            else emit(OP_NONE, 1);
+
+            int count = 0;
+            for (const auto& statement : findChild(node, "Suite")->children) {
+                if (statement->type == "FunctionDefinition") {
+                    emit(OP_CONST, addConstant("s:" + findChild(statement, "Identifier")->value,
+                                               makeString(findChild(statement, "Identifier")->value)), 1);
+                    compileFunctionDefinition(statement);
+                    count++;
+                } else if (statement->type == "Assignment" && findChild(statement, "AssignOp")->value == "=" &&
+                           semanticChildren(findChild(statement, "IdentifierList")).size() == 1 &&
+                           semanticChildren(findChild(statement, "IdentifierList"))[0]->type == "Identifier") {
+                    string attr = semanticChildren(findChild(statement, "IdentifierList"))[0]->value;
+                    emit(OP_CONST, addConstant("s:" + attr, makeString(attr)), 1);
+                    compileExpression(semanticChildren(statement).back());
+                    count++;
+                } else if (statement->type != "PassStatement") {
+                    compileError("unsupported statement " + statement->type + " in class body");
+                }
+            }
+            emit(OP_MAKE_CLASS, addName(name), count, -2 * count);
+            compileStoreName(name);
+        }
+
+        // ---- Expressions ----
+
+        OpCode arithmeticOpcode(BinaryOperator op) {
+            switch (op) {
+                case BIN_ADD: return OP_ADD;
+                case BIN_SUB: return OP_SUB;
+                case BIN_MUL: return OP_MUL;
+                case BIN_DIV: return OP_DIV;
+                case BIN_FLOORDIV: return OP_FLOORDIV;
+                case BIN_MOD: return OP_MOD;
+            }
+            return OP_ADD;
+        }
+
+        void compileBinary(const string& op) {
+            BinaryOperator binary;
+            if (!binaryOperatorFromString(op, binary)) compileError("unsupported operator " + op);
+            emit(arithmeticOpcode(binary), -1);
+        }
+
+        void compileArguments(const shared_ptr<ParseTreeNode>& args, int& argc) {
+            argc = 0;
+            if (!args) return;
+            for (const auto& arg : semanticChildren(args)) {
+                compileExpression(arg);
+                argc++;
+            }
+        }
+
+        void compileLiteral(const shared_ptr<ParseTreeNode>& node) {
+            const LiteralValue& literal = literalOf(node);
+            if (literal.kind == LIT_FSTRING || literal.kind == LIT_INVALID) {
+                int parts = 0;
+                for (const auto& segment : formattedSegments(literal)) {
+                    if (segment.isExpression) {
+                        auto expression = parseEmbeddedExpression(segment.text);
+                        if (!expression) compileError("invalid f-string expression '" + segment.text + "'");
+                        compileExpression(expression);
+                        emit(OP_FORMAT, addName(segment.formatSpec), 0);
+                    } else {
+                        emit(OP_CONST, addConstant("s:" + segment.text, makeString(segment.text)), 1);
+                    }
+                    parts++;
+                }
+                if (parts == 0) emit(OP_CONST, addConstant("s:", makeString("")), 1);
+                else if (parts > 1) emit(OP_BUILD_STRING, parts, 1 - parts);
+                return;
+            }
+            if (literal.kind == LIT_STRING) {
+                emit(OP_CONST, addConstant("s:" + literal.text, makeString(literal.text)), 1);
+                return;
+            }
+            Value number = literalConstant(literal);
+            string key = (number.kind == V_INT ? "i:" : "d:") + node->value;
+            emit(OP_CONST, addConstant(key, number), 1);
+        }
+
+        void compileExpression(const shared_ptr<ParseTreeNode>& node) {
+            const string& type = node->type;
+            if (type == "Literal") {
+                compileLiteral(node);
+            } else if (type == "Identifier") {
+                compileLoad(node->value);
+            } else if (type == "Keyword") {
+                if (node->value == "True") emit(OP_TRUE, 1);
+                else if (node->value == "False") emit(OP_FALSE, 1);
+                else if (node->value == "None") emit(OP_NONE, 1);
+                else compileError("unexpected keyword '" + node->value + "'");
+            } else if (type == "ParenExpr") {
+                compileExpression(semanticChildren(node)[0]);
+            } else if (type == "List" || type == "Tuple") {
+                auto items = semanticChildren(node);
+                for (const auto& item : items) compileExpression(item);
+                emit(type == "List" ? OP_BUILD_LIST : OP_BUILD_TUPLE, items.size(), 1 - (int)items.size());
+            } else if (type == "Dict") {
+                auto pairs = semanticChildren(node);
+                for (const auto& pair : pairs) {
+                    auto kv = semanticChildren(pair);
+                    compileExpression(kv[0]);
+                    compileExpression(kv[1]);
+                }
+                emit(OP_BUILD_DICT, pairs.size(), 1 - 2 * (int)pairs.size());
+            } else if (type == "ExpressionList") {
+                auto items = semanticChildren(node);
+                if (isArithChain(node)) {
+                    compileExpression(items[0]);
+                    for (size_t k = 1; k + 1 < items.size(); k += 2) {
+                        compileExpression(items[k + 1]);
+                        compileBinary(items[k]->value);
+                    }
+                } else {
+                    for (const auto& item : items) compileExpression(item);
+                    emit(OP_BUILD_TUPLE, items.size(), 1 - (int)items.size());
+                }
+            } else if (type == "BinaryOp") {
+                auto operands = semanticChildren(node);
+                if (operands.size() != 2) compileError("malformed binary operation");
+                compileExpression(operands[0]);
+                if (node->value == "and" || node->value == "or") {
+                    size_t end = emitJump(node->value == "and" ? OP_JUMP_IF_FALSE_OR_POP : OP_JUMP_IF_TRUE_OR_POP, -1);
+                    compileExpression(operands[1]);
+                    patchJump(end);
+                } else {
+                    compileExpression(operands[1]);
+                    compileBinary(node->value);
+                }
+            } else if (type == "UnaryOp") {
+                compileExpression(semanticChildren(node)[0]);
+                if (node->value == "-") emit(OP_NEG, 0);
+                else if (node->value == "+") emit(OP_POS, 0);
+                else if (node->value == "~") emit(OP_INVERT, 0);
+                else emit(OP_NOT, 0);
+            } else if (type == "Comparison") {
+                auto parts = semanticChildren(node);
+                compileExpression(parts[0]);
+                compileExpression(parts[2]);
+                const string& op = parts[1]->value;
+                if (op == "<") emit(OP_LT, -1);
+                else if (op == ">") emit(OP_GT, -1);
+                else if (op == "==") emit(OP_EQ, -1);
+                else if (op == "!=") emit(OP_NE, -1);
+                else if (op == "<=") emit(OP_LE, -1);
+                else if (op == "in") emit(OP_IN, -1);
+                else if (op == "not in") emit(OP_NOT_IN, -1);
+                else emit(OP_GE, -1);
+            } else if (type == "TernaryOp") {
+                auto parts = semanticChildren(node);
+                // parts: value if true, condition, value if false
+                compileExpression(parts[1]);
+                size_t otherwise = emitJump(OP_JUMP_IF_FALSE, -1);
+                compileExpression(parts[0]);
+                size_t end = emitJump(OP_JUMP, 0);
+                adjust(-1);
+                patchJump(otherwise);
+                compileExpression(parts[2]);
+                patchJump(end);
+            } else if (type == "AttributeAccess") {
+                auto parts = semanticChildren(node);
+                compileExpression(parts[0]);
+                emit(OP_LOAD_ATTR, addName(parts[1]->value), 0);
+            } else if (type == "Subscript") {
+                auto parts = semanticChildren(node);
+                compileExpression(parts[0]);
+                compileExpression(parts[1]);
+                emit(OP_LOAD_SUBSCR, -1);
+            } else if (type == "FunctionCall") {
+                auto callee = semanticChildren(node)[0];
+                int argc;
+                if (callee->type == "AttributeAccess") {
+                    auto parts = semanticChildren(callee);
+                    compileExpression(parts[0]);
+                    compileArguments(findChild(node, "Arguments"), argc);
+                    emit(OP_CALL_METHOD, addName(parts[1]->value), argc, -argc);
+                } else {
+                    compileExpression(callee);
+                    compileArguments(findChild(node, "Arguments"), argc);
+                    emit(OP_CALL, argc, -argc);
+                }
+            } else if (type == "FunctionCallStatement") {
+                auto callee = node->children[0];
+                int argc;
+                if (callee->type == "DottedName") {
+                    vector<string> names;
+                    for (const auto& part : callee->children) {
+                        if (part->type == "NamePart") names.push_back(part->value);
+                    }
+                    compileLoad(names[0]);
+                    for (size_t k = 1; k + 1 < names.size(); k++) emit(OP_LOAD_ATTR, addName(names[k]), 0);
+                    compileArguments(findChild(node, "Arguments"), argc);
+                    emit(OP_CALL_METHOD, addName(names.back()), argc, -argc);
+                } else {
+                    compileLoad(callee->value);
+                    compileArguments(findChild(node, "Arguments"), argc);
+                    emit(OP_CALL, argc, -argc);
+                }
+            } else {
+                compileError("unsupported expression " + type);
+            }
+        }
+
+    public:
+        BytecodeCompiler(const vector<Identifier>& symbolTable) : symbols(symbolTable) {}
+
+        BytecodeModule compile(const shared_ptr<ParseTreeNode>& program) {
+            // Global slots are numbered in symbol table order; anything else gets a slot on first use
+            for (const auto& symbol : symbols) {
+                if (symbol.Scope == "global") globalSlot(symbol.name);
+            }
+            vector<string> bound;
+            collectBoundNames(program, bound);
+            for (const auto& name : bound) {
+                moduleBound.insert(name);
+                globalSlot(name);
+            }
+
+            module.functions.emplace_back();
+            module.functions[0].name = "<module>";
+            FunctionState state;
+            state.codeIndex = 0;
+            state.isModule = true;
+            current = &state;
+            compileBlock(program);
+            emit(OP_NONE, 1);
+            emit(OP_RETURN, -1);
+            current = nullptr;
+            return move(module);
+        }
+};
+
+void disassemble(const BytecodeModule& module, ostream& out) {
+    for (const auto& function : module.functions) {
+        out << "== " << function.name << " (arity " << function.arity << ", locals " << function.numLocals
+            << ", max stack " << function.maxStack << ", " << function.code.size() << " bytes) ==" << endl;
+        const auto& code = function.code;
+        for (size_t pc = 0; pc < code.size();) {
+            uint8_t op = code[pc];
+            out << "  " << setw(6) << pc << "  " << left << setw(22) << opcodeName(op) << right;
+            int bytes = opcodeOperandBytes(op);
+            if (bytes == 2) {
+                int arg = code[pc + 1] | (code[pc + 2] << 8);
+                out << arg;
+                if (op == OP_CONST) out << "  (" << toRepr(module.constants[arg]) << ")";
+                else if (op == OP_LOAD_LOCAL || op == OP_STORE_LOCAL) out << "  (" << function.localNames[arg] << ")";
+                else if (op == OP_LOAD_GLOBAL || op == OP_STORE_GLOBAL) out << "  (" << module.globalNames[arg] << ")";
+                else if (op == OP_LOAD_BUILTIN) out << "  (" << builtinTable()[arg].name << ")";
+                else if (op == OP_LOAD_ATTR || op == OP_STORE_ATTR) out << "  (" << module.names[arg] << ")";
+            } else if (bytes == 4 && (op == OP_MAKE_CLASS || op == OP_CALL_METHOD)) {
+                int name = code[pc + 1] | (code[pc + 2] << 8);
+                int count = code[pc + 3] | (code[pc + 4] << 8);
+                out << module.names[name] << ", " << count;
+            } else if (bytes == 4) {
+                uint32_t target = code[pc + 1] | (code[pc + 2] << 8) | (code[pc + 3] << 16) | ((uint32_t)code[pc + 4] << 24);
+                out << "-> " << target;
+            }
+            out << endl;
+            pc += 1 + bytes;
+        }
+    }
+}
+
+// Computed-goto dispatch where the compiler supports labels as values, a switch otherwise
+#if defined(__GNUC__) || defined(__clang__)
+#define VM_USE_COMPUTED_GOTO 1
+#endif
+
+class VirtualMachine {
+    private:
+        struct Frame {
+            const CodeObject* code;
+            const uint8_t* ip;
+            Value* base;       // first local slot
+            Value* resultSlot; // where the return value goes (the callee's slot)
+            bool constructor;  // __init__ call: the result is the new instance
+        };
+
+        static const size_t maxFrames = 1000;
+
+        const BytecodeModule& module;
+        vector<Value> stack;
+        vector<Value> globals;
+        vector<Frame> frames;
+
+        [[noreturn]] void arityError(const string& name, int expected, int given) {
+            runtimeError("TypeError: " + name + "() takes " + to_string(expected) +
+                         " positional arguments but " + to_string(given) + " were given");
+        }
+
+        // Pushes a frame whose first locals already hold the arguments
+        void pushFrame(int index, Value* base, Value* resultSlot, bool constructor) {
+            const CodeObject& code = module.functions[index];
+            if (frames.size() >= maxFrames ||
+                base + code.numLocals + code.maxStack > stack.data() + stack.size()) {
+                runtimeError("RecursionError: maximum recursion depth exceeded");
+            }
+            frames.push_back({&code, code.code.data(), base, resultSlot, constructor});
+        }
+
+    public:
+        VirtualMachine(const BytecodeModule& m, size_t stackSize = 1 << 18)
+            : module(m), stack(stackSize), globals(m.globalNames.size()) {
+            for (size_t slot = 0; slot < globals.size(); slot++) {
+                if (module.globalNames[slot] == "__name__") globals[slot] = makeString("__main__");
+            }
+        }
+
+        void run() {
+            const Value* constants = module.constants.data();
+            const vector<string>& names = module.names;
+            const vector<BuiltinEntry>& builtins = builtinTable();
+
+            pushFrame(0, stack.data(), stack.data(), false);
+            const uint8_t* codeStart = frames.back().ip;
+            const uint8_t* ip = codeStart;
+            Value* base = frames.back().base;
+            Value* sp = base + frames.back().code->numLocals;
+
+            Value* callee = nullptr;
+            int argc = 0;
+
+#define READ_U16() (ip += 2, (int)(ip[-2] | (ip[-1] << 8)))
+#define READ_U32() (ip += 4, (uint32_t)ip[-4] | ((uint32_t)ip[-3] << 8) | ((uint32_t)ip[-2] << 16) | ((uint32_t)ip[-1] << 24))
+#define ENTER_FRAME() do { codeStart = ip = frames.back().ip; base = frames.back().base; \
+                           sp = base + frames.back().code->numLocals; } while (0)
+#define POP_TO(slot) do { Value* target_ = (slot); while (sp > target_) (--sp)->reset(); } while (0)
+
+#ifdef VM_USE_COMPUTED_GOTO
+            // A computed goto does not run destructors, so handlers close the scope of
+            // any local that owns resources before dispatching
+            static void* dispatchTable[] = {
+#define X(name, bytes) &&op_##name,
+                VM_OPCODES(X)
+#undef X
+            };
+#define DISPATCH() goto *dispatchTable[*ip++]
+#define TARGET(name) op_##name:
+            DISPATCH();
+#else
+#define DISPATCH() continue
+#define TARGET(name) case OP_##name:
+            for (;;) switch (*ip++) {
+#endif
+
+            TARGET(CONST) {
+                *sp++ = constants[READ_U16()];
+                DISPATCH();
+            }
+            TARGET(NONE) {
+                *sp++ = Value::none();
+                DISPATCH();
+            }
+            TARGET(TRUE) {
+                *sp++ = Value::boolean(true);
+                DISPATCH();
+            }
+            TARGET(FALSE) {
+                *sp++ = Value::boolean(false);
+                DISPATCH();
+            }
+            TARGET(LOAD_LOCAL) {
+                int slot = READ_U16();
+                if (base[slot].kind == V_UNDEF) {
+                    runtimeError("UnboundLocalError: local variable '" + frames.back().code->localNames[slot] +
+                                 "' referenced before assignment");
+                }
+                *sp++ = base[slot];
+                DISPATCH();
+            }
+            TARGET(STORE_LOCAL) {
+                base[READ_U16()] = move(*--sp);
+                DISPATCH();
+            }
+            TARGET(LOAD_GLOBAL) {
+                int slot = READ_U16();
+                if (globals[slot].kind == V_UNDEF) {
+                    runtimeError("NameError: name '" + module.globalNames[slot] + "' is not defined");
+                }
+                *sp++ = globals[slot];
+                DISPATCH();
+            }
+            TARGET(STORE_GLOBAL) {
+                globals[READ_U16()] = move(*--sp);
+                DISPATCH();
+            }
+            TARGET(LOAD_BUILTIN) {
+                *sp++ = Value::builtinFunction(READ_U16());
+                DISPATCH();
+            }
+            TARGET(LOAD_ATTR) {
+                sp[-1] = getAttribute(sp[-1], names[READ_U16()]);
+                DISPATCH();
+            }
+            TARGET(STORE_ATTR) {
+                setAttribute(sp[-1], names[READ_U16()], sp[-2]);
+                POP_TO(sp - 2);
+                DISPATCH();
+            }
+            TARGET(LOAD_SUBSCR) {
+                if (sp[-2].kind == V_LIST && sp[-1].kind == V_INT) {
+                    const vector<Value>& items = asList(sp[-2])->items;
+                    long long index = sp[-1].i;
+                    if (index >= 0 && index < (long long)items.size()) {
+                        sp[-2] = Value(items[index]);
+                        (--sp)->reset();
+                        DISPATCH();
+                    }
+                }
+                sp[-2] = getItem(sp[-2], sp[-1]);
+                (--sp)->reset();
+                DISPATCH();
+            }
+            TARGET(STORE_SUBSCR) {
+                if (sp[-2].kind == V_LIST && sp[-1].kind == V_INT) {
+                    vector<Value>& items = asList(sp[-2])->items;
+                    long long index = sp[-1].i;
+                    if (index >= 0 && index < (long long)items.size()) {
+                        items[index] = move(sp[-3]);
+                        POP_TO(sp - 3);
+                        DISPATCH();
+                    }
+                }
+                setItem(sp[-2], sp[-1], sp[-3]);
+                POP_TO(sp - 3);
+                DISPATCH();
+            }
+            TARGET(POP) {
+                (--sp)->reset();
+                DISPATCH();
+            }
+            TARGET(DUP) {
+                sp[0] = sp[-1];
+                sp++;
+                DISPATCH();
+            }
+            TARGET(DUP2) {
+                sp[0] = sp[-2];
+                sp[1] = sp[-1];
+                sp += 2;
+                DISPATCH();
+            }
+            TARGET(ROT2) {
+                swap(sp[-1], sp[-2]);
+                DISPATCH();
+            }
+            TARGET(ROT3) {
+                {
+                    Value top = move(sp[-1]);
+                    sp[-1] = move(sp[-2]);
+                    sp[-2] = move(sp[-3]);
+                    sp[-3] = move(top);
+                }
+                DISPATCH();
+            }
+
+#define INT_FAST_BINARY(opName, overflowBuiltin, binary) \
+            TARGET(opName) { \
+                Value& a = sp[-2]; \
+                Value& b = sp[-1]; \
+                long long result; \
+                if (a.kind == V_INT && b.kind == V_INT && !overflowBuiltin(a.i, b.i, &result)) a.i = result; \
+                else a = binaryOp(binary, a, b); \
+                (--sp)->reset(); \
+                DISPATCH(); \
+            }
+            INT_FAST_BINARY(ADD, __builtin_add_overflow, BIN_ADD)
+            INT_FAST_BINARY(SUB, __builtin_sub_overflow, BIN_SUB)
+            INT_FAST_BINARY(MUL, __builtin_mul_overflow, BIN_MUL)
+#undef INT_FAST_BINARY
+
+            TARGET(DIV) {
+                sp[-2] = binaryOp(BIN_DIV, sp[-2], sp[-1]);
+                (--sp)->reset();
+                DISPATCH();
+            }
+            TARGET(FLOORDIV) {
+                if (sp[-2].kind == V_INT && sp[-1].kind == V_INT) sp[-2] = intArithmetic(BIN_FLOORDIV, sp[-2].i, sp[-1].i);
+                else sp[-2] = binaryOp(BIN_FLOORDIV, sp[-2], sp[-1]);
+                (--sp)->reset();
+                DISPATCH();
+            }
+            TARGET(MOD) {
+                if (sp[-2].kind == V_INT && sp[-1].kind == V_INT) sp[-2] = intArithmetic(BIN_MOD, sp[-2].i, sp[-1].i);
+                else sp[-2] = binaryOp(BIN_MOD, sp[-2], sp[-1]);
+                (--sp)->reset();
+                DISPATCH();
+            }
+            TARGET(NEG) {
+                if (sp[-1].kind == V_INT && sp[-1].i != LLONG_MIN) sp[-1].i = -sp[-1].i;
+                else sp[-1] = unaryOp("-", sp[-1]);
+                DISPATCH();
+            }
+            TARGET(POS) {
+                sp[-1] = unaryOp("+", sp[-1]);
+                DISPATCH();
+            }
+            TARGET(INVERT) {
+                sp[-1] = unaryOp("~", sp[-1]);
+                DISPATCH();
+            }
+            TARGET(NOT) {
+                sp[-1] = Value::boolean(!truthy(sp[-1]));
+                DISPATCH();
+            }
+
+#define COMPARE(opName, cppOp, symbol) \
+            TARGET(opName) { \
+                Value& a = sp[-2]; \
+                Value& b = sp[-1]; \
+                if (a.kind == V_INT && b.kind == V_INT) a = Value::boolean(a.i cppOp b.i); \
+                else a = Value::boolean(compareValues(a, b, symbol) cppOp 0); \
+                (--sp)->reset(); \
+                DISPATCH(); \
+            }
+            COMPARE(LT, <, "<")
+            COMPARE(GT, >, ">")
+            COMPARE(LE, <=, "<=")
+            COMPARE(GE, >=, ">=")
+#undef COMPARE
+
+            TARGET(EQ) {
+                sp[-2] = Value::boolean(valuesEqual(sp[-2], sp[-1]));
+                (--sp)->reset();
+                DISPATCH();
+            }
+            TARGET(NE) {
+                sp[-2] = Value::boolean(!valuesEqual(sp[-2], sp[-1]));
+                (--sp)->reset();
+                DISPATCH();
+            }
+            TARGET(IN) {
+                sp[-2] = Value::boolean(containsValue(sp[-1], sp[-2]));
+                (--sp)->reset();
+                DISPATCH();
+            }
+            TARGET(NOT_IN) {
+                sp[-2] = Value::boolean(!containsValue(sp[-1], sp[-2]));
+                (--sp)->reset();
+                DISPATCH();
+            }
+            TARGET(JUMP) {
+                uint32_t target = READ_U32();
+                ip = codeStart + target;
+                DISPATCH();
+            }
+            TARGET(JUMP_IF_FALSE) {
+                uint32_t target = READ_U32();
+                --sp;
+                bool condition = sp->kind == V_BOOL ? sp->b : truthy(*sp);
+                sp->reset();
+                if (!condition) ip = codeStart + target;
+                DISPATCH();
+            }
+            TARGET(JUMP_IF_FALSE_OR_POP) {
+                uint32_t target = READ_U32();
+                if (!truthy(sp[-1])) ip = codeStart + target;
+                else (--sp)->reset();
+                DISPATCH();
+            }
+            TARGET(JUMP_IF_TRUE_OR_POP) {
+                uint32_t target = READ_U32();
+                if (truthy(sp[-1])) ip = codeStart + target;
+                else (--sp)->reset();
+                DISPATCH();
+            }
+            TARGET(GET_ITER) {
+                sp[-1] = makeIterator(sp[-1]);
+                DISPATCH();
+            }
+            TARGET(FOR_ITER) {
+                uint32_t target = READ_U32();
+                IterObject* it = asIter(sp[-1]);
+                if (it->sequence.kind == V_RANGE) {
+                    RangeObject* range = asRange(it->sequence);
+                    if (range->step > 0 ? it->current < range->stop : it->current > range->stop) {
+                        *sp++ = Value::integer(it->current);
+                        it->current += range->step;
+                        DISPATCH();
+                    }
+                } else if (iteratorNext(it, *sp)) {
+                    sp++;
+                    DISPATCH();
+                }
+                (--sp)->reset();
+                ip = codeStart + target;
+                DISPATCH();
+            }
+            TARGET(BUILD_LIST) {
+                int count = READ_U16();
+                {
+                    vector<Value> items(make_move_iterator(sp - count), make_move_iterator(sp));
+                    sp -= count;
+                    *sp++ = makeList(move(items));
+                }
+                DISPATCH();
+            }
+            TARGET(BUILD_TUPLE) {
+                int count = READ_U16();
+                {
+                    vector<Value> items(make_move_iterator(sp - count), make_move_iterator(sp));
+                    sp -= count;
+                    *sp++ = makeList(move(items), V_TUPLE);
+                }
+                DISPATCH();
+            }
+            TARGET(BUILD_DICT) {
+                int count = READ_U16();
+                {
+                    Value dict = makeDict();
+                    Value* first = sp - 2 * count;
+                    for (int k = 0; k < count; k++) {
+                        hashValue(first[2 * k]);
+                        asDict(dict)->set(first[2 * k], first[2 * k + 1]);
+                    }
+                    POP_TO(first);
+                    *sp++ = move(dict);
+                }
+                DISPATCH();
+            }
+            TARGET(BUILD_STRING) {
+                int count = READ_U16();
+                {
+                    string text;
+                    for (Value* part = sp - count; part < sp; part++) text += toStr(*part);
+                    POP_TO(sp - count);
+                    *sp++ = makeString(move(text));
+                }
+                DISPATCH();
+            }
+            TARGET(FORMAT) {
+                sp[-1] = makeString(formatWithSpec(sp[-1], names[READ_U16()]));
+                DISPATCH();
+            }
+            TARGET(UNPACK) {
+                int count = READ_U16();
+                {
+                    Value sequence = move(*--sp);
+                    vector<Value> items = collectItems(sequence);
+                    if ((int)items.size() != count) {
+                        runtimeError("ValueError: expected " + to_string(count) + " values to unpack, got " + to_string(items.size()));
+                    }
+                    for (int k = count - 1; k >= 0; k--) *sp++ = move(items[k]);
+                }
+                DISPATCH();
+            }
+            TARGET(MAKE_CLASS) {
+                const string& className = names[READ_U16()];
+                int count = READ_U16();
+                {
+                    Value* first = sp - 2 * count;
+                    Value cls = makeClass(className, first[-1]);
+                    for (int k = 0; k < count; k++) {
+                        setAttribute(cls, asStr(first[2 * k])->s, first[2 * k + 1]);
+                    }
+                    POP_TO(first - 1);
+                    *sp++ = move(cls);
+                }
+                DISPATCH();
+            }
+            TARGET(CALL) {
+                argc = READ_U16();
+                callee = sp - argc - 1;
+                goto call_value;
+            }
+            TARGET(CALL_METHOD) {
+                const string& method = names[READ_U16()];
+                argc = READ_U16();
+                callee = sp - argc - 1;
+                if (callee->kind == V_INSTANCE) {
+                    InstanceObject* instance = asInstance(*callee);
+                    if (!instance->attributes.count(method)) {
+                        Value* attr = findClassAttribute(instance->cls, method);
+                        if (attr && attr->kind == V_FUNC) {
+                            // The instance already sits where 'self' belongs
+                            FunctionObject* function = asFunction(*attr);
+                            if (function->arity != argc + 1) arityError(function->name, function->arity - 1, argc);
+                            frames.back().ip = ip;
+                            pushFrame(function->index, callee, callee, false);
+                            ENTER_FRAME();
+                            DISPATCH();
+                        }
+                    }
+                    *callee = getAttribute(*callee, method);
+                    goto call_value;
+                }
+                if (callee->kind == V_CLASS) {
+                    *callee = getAttribute(*callee, method);
+                    goto call_value;
+                }
+                {
+                    Value result = callNativeMethod(*callee, method, callee + 1, argc);
+                    POP_TO(callee);
+                    *sp++ = move(result);
+                }
+                DISPATCH();
+            }
+            TARGET(RETURN) {
+                {
+                    Value result = move(*--sp);
+                    Frame& frame = frames.back();
+                    if (frame.constructor) result = frame.base[0];
+                    Value* slot = frame.resultSlot;
+                    POP_TO(slot);
+                    *sp++ = move(result);
+                }
+                frames.pop_back();
+                if (frames.empty()) {
+                    POP_TO(stack.data());
+                    return;
+                }
+                codeStart = frames.back().code->code.data();
+                ip = frames.back().ip;
+                base = frames.back().base;
+                DISPATCH();
+            }
+
+            // Shared call sequence: 'callee' points at the callable, its 'argc' arguments follow it
+            call_value: {
+                switch (callee->kind) {
+                    case V_FUNC: {
+                        FunctionObject* function = asFunction(*callee);
+                        if (function->arity != argc) arityError(function->name, function->arity, argc);
+                        frames.back().ip = ip;
+                        pushFrame(function->index, callee + 1, callee, false);
+                        ENTER_FRAME();
+                        break;
+                    }
+                    case V_BUILTIN: {
+                        Value result = builtins[callee->builtin].function(callee + 1, argc);
+                        POP_TO(callee);
+                        *sp++ = move(result);
+                        break;
+                    }
+                    case V_BOUND: {
+                        Value function = asBound(*callee)->function;
+                        *callee = asBound(*callee)->self;
+                        FunctionObject* target = asFunction(function);
+                        if (target->arity != argc + 1) arityError(target->name, target->arity - 1, argc);
+                        frames.back().ip = ip;
+                        pushFrame(target->index, callee, callee, false);
+                        ENTER_FRAME();
+                        break;
+                    }
+                    case V_CLASS: {
+                        Value instance = makeInstance(*callee);
+                        Value* init = findClassAttribute(*callee, "__init__");
+                        if (init && init->kind == V_FUNC) {
+                            FunctionObject* function = asFunction(*init);
+                            if (function->arity != argc + 1) arityError(function->name, function->arity - 1, argc);
+                            *callee = move(instance);
+                            frames.back().ip = ip;
+                            pushFrame(function->index, callee, callee, true);
+                            ENTER_FRAME();
+                        } else {
+                            if (argc != 0) runtimeError("TypeError: " + asClass(*callee)->name + "() takes no arguments");
+                            *callee = move(instance);
+                        }
+                        break;
+                    }
+                    default:
+                        runtimeError("TypeError: '" + typeName(*callee) + "' object is not callable");
+                }
+                DISPATCH();
+            }
+
+#ifndef VM_USE_COMPUTED_GOTO
+                default:
+                    runtimeError("internal error: bad opcode");
+            }
+#endif
+#undef READ_U16
+#undef READ_U32
+#undef ENTER_FRAME
+#undef POP_TO
+#undef DISPATCH
+#undef TARGET
+        }
+};
+
+// Compiles the tree to bytecode and runs it; returns the process exit status
+int runBytecode(const shared_ptr<ParseTreeNode>& tree, const vector<Identifier>& symbols, bool showBytecode) {
+    BytecodeModule module;
+    try {
+        module = BytecodeCompiler(symbols).compile(tree);
+    } catch (const runtime_error& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    if (showBytecode) {
+        disassemble(module, cout);
+        return 0;
+    }
+
+    VirtualMachine vm(module);
+    try {
+        vm.run();
+    } catch (const runtime_error& e) {
+        cout.flush();
+        cerr << "Runtime Error: " << e.what() << endl;
+        return 1;
+    }
+    cout.flush();
+    return 0;
+}